@@ -0,0 +1,59 @@
+#include "pch.h"
+#include "benchmarks.h"
+#include "../Core/monotonic_clock.h"
+#include <fstream>
+#include <iostream>
+
+/// <summary>
+/// Headless benchmarks of the cpu side of the samples, no window and no device.
+/// --filter <text>     only the benchmarks whose name/param=value contains text
+/// --out <file>        where the json results go, benchmark_results.json by default
+/// --min-time <s>      seconds each benchmark samples for, at least
+/// --assets <folder>   where the glb files are, assets by default
+/// --quick             one small variant of each benchmark
+/// </summary>
+int main(int argc, char** argv)
+{
+    benchmarks::RunnerSettings settings;
+    benchmarks::SuiteOptions options;
+    std::string output = "benchmark_results.json";
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            settings.filter = argv[++i];
+        }
+        else if (arg == "--out" && hasValue) {
+            output = argv[++i];
+        }
+        else if (arg == "--min-time" && hasValue) {
+            settings.minSeconds = std::stod(argv[++i]);
+        }
+        else if (arg == "--assets" && hasValue) {
+            options.assetsFolder = argv[++i];
+        }
+        else if (arg == "--quick") {
+            options.quick = true;
+            settings.minSeconds = 0.1;
+        }
+        else {
+            std::cerr << "unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "clock: " << common::MonotonicClock::GetSourceName() << std::endl;
+    benchmarks::BenchmarkRunner runner(settings);
+    benchmarks::RunTransformBenchmarks(runner, options);
+    benchmarks::RunSkinningBenchmarks(runner, options);
+    benchmarks::RunMeshLoadingBenchmarks(runner, options);
+    benchmarks::RunAllocatorBenchmarks(runner, options);
+
+    std::ofstream file(output);
+    if (!file) {
+        std::cerr << "could not write " << output << std::endl;
+        return 1;
+    }
+    runner.WriteJson(file);
+    std::cout << runner.GetResults().size() << " benchmarks written to " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "pch.h"
+#include "benchmarks.h"
+#include "../Core/slot_allocator.h"
+#include "../Core/descriptor_allocator.h"
+#include "../Core/memory_pool.h"
+#include "../Core/tlsf_allocator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /// <summary>
+    /// The order in which the churn benchmarks free what they allocated, so that the free lists get
+    /// scrambled like they do when objects come and go.
+    /// </summary>
+    std::vector<uint32_t> ShuffledOrder(uint32_t count, uint32_t seed)
+    {
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; i++) {
+            order[i] = i;
+        }
+        std::mt19937 rng(seed);
+        std::shuffle(order.begin(), order.end(), rng);
+        return order;
+    }
+
+    /// <summary>
+    /// Sizes of resources placed in heaps: mostly small buffers and textures, a few big ones. The distribution
+    /// is what makes the TLSF blocks split and merge.
+    /// </summary>
+    std::vector<uint64_t> RandomSizes(uint32_t count, uint64_t minSize, uint64_t maxSize, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<uint64_t> sizes(count);
+        for (uint64_t& size : sizes) {
+            //log uniform, as many 64KB as 1MB resources
+            const double t = unit(rng);
+            size = static_cast<uint64_t>(minSize * std::pow(static_cast<double>(maxSize) / minSize, t));
+        }
+        return sizes;
+    }
+
+    /// <summary>
+    /// Allocates all sizes and frees a random half of them, leaving the holes that the fragmented benchmarks
+    /// allocate into. Returns the offsets that are still allocated.
+    /// </summary>
+    std::vector<uint64_t> Fragment(common::TlsfAllocator& allocator, const std::vector<uint64_t>& sizes, uint32_t seed)
+    {
+        std::vector<uint64_t> offsets;
+        for (uint64_t size : sizes) {
+            offsets.push_back(allocator.Allocate(size));
+        }
+        const std::vector<uint32_t> order = ShuffledOrder(static_cast<uint32_t>(offsets.size()), seed);
+        std::vector<uint64_t> kept;
+        for (uint32_t i = 0; i < order.size(); i++) {
+            if (i % 2 == 0) {
+                allocator.Free(offsets[order[i]]);
+            }
+            else {
+                kept.push_back(offsets[order[i]]);
+            }
+        }
+        return kept;
+    }
+}
+
+void benchmarks::RunAllocatorBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options)
+{
+    using namespace transforms;
+    const std::vector<uint32_t> counts = options.quick ?
+        std::vector<uint32_t>{ 1024 } : std::vector<uint32_t>{ 256, 1024, 8192 };
+    constexpr uint32_t SLOTS_PER_BLOCK = 1024;
+    constexpr uint32_t DESCRIPTORS_PER_PAGE = 256;
+    constexpr uint32_t PAGE_COUNT = 64;
+    constexpr uint32_t TRANSIENT_PER_FRAME = 1024;
+    constexpr uint32_t RANGE_SIZE = 8;
+    constexpr uint32_t FRAME_COUNT = 2;
+
+    for (uint32_t count : counts) {
+        const Parameters parameters{ {"count", count} };
+        const std::vector<uint32_t> order = ShuffledOrder(count, count);
+        if (runner.Matches("SlotAllocatorChurn", parameters)) {
+            SlotAllocator allocator(SLOTS_PER_BLOCK, (count + SLOTS_PER_BLOCK - 1) / SLOTS_PER_BLOCK);
+            std::vector<SlotHandle> handles(count);
+            runner.Run("SlotAllocatorChurn", parameters, count, [&allocator, &handles, &order]() {
+                for (SlotHandle& handle : handles) {
+                    handle = allocator.Allocate();
+                }
+                for (uint32_t i : order) {
+                    allocator.Free(handles[i]);
+                }
+            });
+        }
+        if (runner.Matches("DescriptorAllocatorChurn", parameters)) {
+            DescriptorAllocator allocator(16, DESCRIPTORS_PER_PAGE, PAGE_COUNT, TRANSIENT_PER_FRAME, FRAME_COUNT);
+            std::vector<DescriptorHandle> handles(count);
+            runner.Run("DescriptorAllocatorChurn", parameters, count, [&allocator, &handles, &order]() {
+                for (DescriptorHandle& handle : handles) {
+                    handle = allocator.Allocate();
+                }
+                for (uint32_t i : order) {
+                    allocator.Free(handles[i]);
+                }
+            });
+        }
+        const uint32_t ranges = count / RANGE_SIZE;
+        const Parameters rangeParameters{ {"count", count}, {"rangeSize", RANGE_SIZE} };
+        if (ranges > 0 && runner.Matches("DescriptorAllocatorRanges", rangeParameters)) {
+            DescriptorAllocator allocator(16, DESCRIPTORS_PER_PAGE, PAGE_COUNT, TRANSIENT_PER_FRAME, FRAME_COUNT);
+            std::vector<DescriptorHandle> handles(ranges);
+            const std::vector<uint32_t> rangeOrder = ShuffledOrder(ranges, count);
+            runner.Run("DescriptorAllocatorRanges", rangeParameters, ranges, [&allocator, &handles, &rangeOrder]() {
+                for (DescriptorHandle& handle : handles) {
+                    handle = allocator.AllocateRange(RANGE_SIZE);
+                }
+                for (uint32_t i : rangeOrder) {
+                    allocator.Free(handles[i]);
+                }
+            });
+        }
+        if (count <= TRANSIENT_PER_FRAME && runner.Matches("DescriptorAllocatorTransient", parameters)) {
+            DescriptorAllocator allocator(16, DESCRIPTORS_PER_PAGE, PAGE_COUNT, TRANSIENT_PER_FRAME, FRAME_COUNT);
+            uint32_t frame = 0;
+            runner.Run("DescriptorAllocatorTransient", parameters, count, [&allocator, &frame, count]() {
+                allocator.BeginFrame(frame);
+                frame = (frame + 1) % FRAME_COUNT;
+                uint32_t last = 0;
+                for (uint32_t i = 0; i < count; i++) {
+                    last = allocator.AllocateTransient(1);
+                }
+                DoNotOptimize(&last);
+            });
+        }
+
+        //placed resources: 4KB to 4MB in a heap that fits them all twice, with the 64KB granularity of d3d12
+        constexpr uint64_t HEAP_GRANULARITY = 64 * 1024;
+        const std::vector<uint64_t> sizes = RandomSizes(count, 4 * 1024, 4 * 1024 * 1024, count);
+        uint64_t totalSize = 0;
+        for (uint64_t size : sizes) {
+            totalSize += (size + HEAP_GRANULARITY - 1) / HEAP_GRANULARITY * HEAP_GRANULARITY;
+        }
+        if (runner.Matches("TlsfAllocatorChurn", parameters)) {
+            common::TlsfAllocator allocator(totalSize * 2, HEAP_GRANULARITY);
+            std::vector<uint64_t> offsets(count);
+            runner.Run("TlsfAllocatorChurn", parameters, count, [&allocator, &offsets, &sizes, &order]() {
+                for (uint32_t i = 0; i < sizes.size(); i++) {
+                    offsets[i] = allocator.Allocate(sizes[i]);
+                }
+                for (uint32_t i : order) {
+                    allocator.Free(offsets[i]);
+                }
+            });
+        }
+        if (runner.Matches("TlsfAllocatorFragmented", parameters)) {
+            //a heap that fits the allocations exactly, a random half of them freed: all the free space is in
+            //holes. New allocations go into them, and the ones that don't fit anywhere fail, which is what the
+            //fragmentation costs
+            common::TlsfAllocator allocator(totalSize, HEAP_GRANULARITY);
+            Fragment(allocator, sizes, count);
+            const float fragmentation = allocator.GetFragmentation();
+            const uint32_t freeRegions = allocator.GetFreeRegionCount();
+            const std::vector<uint64_t> refill = RandomSizes(count / 2, 4 * 1024, 4 * 1024 * 1024, count + 1);
+            std::vector<uint64_t> offsets(refill.size());
+            uint32_t failed = 0;
+            for (uint32_t i = 0; i < refill.size(); i++) {
+                offsets[i] = allocator.Allocate(refill[i]);
+                failed += offsets[i] == common::TlsfAllocator::INVALID_OFFSET ? 1 : 0;
+            }
+            const Parameters counters{ {"fragmentation", fragmentation},
+                {"freeRegions", static_cast<double>(freeRegions)},
+                {"failedAllocations", static_cast<double>(failed)} };
+            for (uint64_t offset : offsets) {
+                if (offset != common::TlsfAllocator::INVALID_OFFSET) {
+                    allocator.Free(offset);
+                }
+            }
+            runner.Run("TlsfAllocatorFragmented", parameters, refill.size(), [&allocator, &offsets, &refill]() {
+                for (uint32_t i = 0; i < refill.size(); i++) {
+                    offsets[i] = allocator.Allocate(refill[i]);
+                }
+                for (uint64_t offset : offsets) {
+                    if (offset != common::TlsfAllocator::INVALID_OFFSET) {
+                        allocator.Free(offset);
+                    }
+                }
+            }, counters);
+        }
+        if (runner.Matches("MemoryPoolCoreChurn", parameters)) {
+            //blocks of 64MB as the gpu allocator makes them, they stay after the first iteration adds them
+            common::MemoryPoolCore pool(64 * 1024 * 1024, HEAP_GRANULARITY);
+            std::vector<common::PoolAllocation> allocations(count);
+            auto allocateAll = [&pool, &allocations, &sizes]() {
+                for (uint32_t i = 0; i < sizes.size(); i++) {
+                    allocations[i] = pool.Allocate(sizes[i]);
+                    if (!allocations[i].IsValid()) {
+                        allocations[i] = pool.AllocateInBlock(pool.AddBlock(sizes[i]), sizes[i]);
+                    }
+                }
+            };
+            allocateAll();
+            const std::vector<uint32_t> halfOrder = ShuffledOrder(count, count + 2);
+            for (uint32_t i = 0; i < count / 2; i++) {
+                pool.Free(allocations[halfOrder[i]]);
+            }
+            const common::PoolStats stats = pool.GetStats();
+            const Parameters counters{ {"blocks", static_cast<double>(stats.blockCount)},
+                {"halfFreedFragmentation", stats.fragmentation} };
+            for (uint32_t i = count / 2; i < count; i++) {
+                pool.Free(allocations[halfOrder[i]]);
+            }
+            runner.Run("MemoryPoolCoreChurn", parameters, count, [&pool, &allocations, &order, &allocateAll]() {
+                allocateAll();
+                for (uint32_t i : order) {
+                    pool.Free(allocations[i]);
+                }
+            }, counters);
+        }
+    }
+}
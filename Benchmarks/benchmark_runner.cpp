@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "benchmark_runner.h"
+#include "../Core/monotonic_clock.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    volatile const void* gSink = nullptr;
+
+    void WriteJsonString(std::ostream& out, const std::string& s)
+    {
+        out << '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+}
+
+void benchmarks::DoNotOptimize(const void* value)
+{
+    gSink = value;
+}
+
+benchmarks::BenchmarkRunner::BenchmarkRunner(const RunnerSettings& settings)
+    :settings(settings)
+{
+}
+
+std::string benchmarks::BenchmarkRunner::FullName(const std::string& name, const Parameters& parameters)
+{
+    std::stringstream ss;
+    ss << name;
+    for (const auto& [key, value] : parameters) {
+        ss << '/' << key << '=' << value;
+    }
+    return ss.str();
+}
+
+bool benchmarks::BenchmarkRunner::Matches(const std::string& name, const Parameters& parameters) const
+{
+    return settings.filter.empty() || FullName(name, parameters).find(settings.filter) != std::string::npos;
+}
+
+void benchmarks::BenchmarkRunner::Run(const std::string& name, const Parameters& parameters,
+    uint64_t itemsPerIteration, const std::function<void()>& body, const Parameters& counters)
+{
+    using common::MonotonicClock;
+    if (!Matches(name, parameters)) {
+        return;
+    }
+    //warm up, and find how many iterations make a sample long enough
+    uint64_t start = MonotonicClock::Now();
+    body();
+    const double warmupNs = MonotonicClock::ToSeconds(MonotonicClock::Now() - start) * 1.0e9;
+    const double minSampleNs = settings.minSampleMicroseconds * 1.0e3;
+    const uint64_t iterationsPerSample = warmupNs >= minSampleNs ? 1 :
+        static_cast<uint64_t>(std::ceil(minSampleNs / std::max(warmupNs, 1.0)));
+
+    std::vector<double> samples;
+    const uint64_t runStart = MonotonicClock::Now();
+    while (samples.size() < settings.maxSamples) {
+        start = MonotonicClock::Now();
+        for (uint64_t i = 0; i < iterationsPerSample; i++) {
+            body();
+        }
+        const uint64_t end = MonotonicClock::Now();
+        samples.push_back(MonotonicClock::ToSeconds(end - start) * 1.0e9 / iterationsPerSample);
+        if (samples.size() >= settings.minSamples && MonotonicClock::ToSeconds(end - runStart) >= settings.minSeconds) {
+            break;
+        }
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.itemsPerIteration = itemsPerIteration;
+    result.samples = static_cast<uint32_t>(samples.size());
+    result.iterationsPerSample = iterationsPerSample;
+    double sum = 0;
+    for (double s : samples) {
+        sum += s;
+    }
+    result.meanNs = sum / samples.size();
+    double squares = 0;
+    for (double s : samples) {
+        squares += (s - result.meanNs) * (s - result.meanNs);
+    }
+    result.stdDevNs = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0.0;
+    std::sort(samples.begin(), samples.end());
+    result.minNs = samples.front();
+    result.maxNs = samples.back();
+    result.medianNs = samples[samples.size() / 2];
+    result.p95Ns = samples[std::min(samples.size() - 1, static_cast<size_t>(std::ceil(0.95 * samples.size())) - 1)];
+    result.itemsPerSecond = result.medianNs > 0 ? itemsPerIteration * 1.0e9 / result.medianNs : 0.0;
+    result.counters = counters;
+    results.push_back(result);
+
+    std::cout << FullName(name, parameters) << ": median " << result.medianNs / 1.0e3 << " us, p95 "
+        << result.p95Ns / 1.0e3 << " us, " << result.itemsPerSecond << " items/s (" << result.samples << " samples)";
+    for (const auto& [key, value] : counters) {
+        std::cout << ", " << key << ' ' << value;
+    }
+    std::cout << std::endl;
+}
+
+void benchmarks::BenchmarkRunner::WriteJson(std::ostream& out) const
+{
+    const std::streamsize oldPrecision = out.precision(9);
+    out << "{\n  \"clock\": ";
+    WriteJsonString(out, common::MonotonicClock::GetSourceName());
+    out << ",\n  \"benchmarks\": [";
+    for (size_t r = 0; r < results.size(); r++) {
+        const BenchmarkResult& result = results[r];
+        out << (r == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        WriteJsonString(out, result.name);
+        out << ", \"parameters\": {";
+        for (size_t p = 0; p < result.parameters.size(); p++) {
+            out << (p == 0 ? "" : ", ");
+            WriteJsonString(out, result.parameters[p].first);
+            out << ": " << result.parameters[p].second;
+        }
+        out << "}, \"itemsPerIteration\": " << result.itemsPerIteration
+            << ", \"samples\": " << result.samples
+            << ", \"iterationsPerSample\": " << result.iterationsPerSample
+            << ", \"minNs\": " << result.minNs
+            << ", \"medianNs\": " << result.medianNs
+            << ", \"meanNs\": " << result.meanNs
+            << ", \"p95Ns\": " << result.p95Ns
+            << ", \"maxNs\": " << result.maxNs
+            << ", \"stdDevNs\": " << result.stdDevNs
+            << ", \"itemsPerSecond\": " << result.itemsPerSecond
+            << ", \"counters\": {";
+        for (size_t c = 0; c < result.counters.size(); c++) {
+            out << (c == 0 ? "" : ", ");
+            WriteJsonString(out, result.counters[c].first);
+            out << ": " << result.counters[c].second;
+        }
+        out << "}}";
+    }
+    out << "\n  ]\n}\n";
+    out.precision(oldPrecision);
+}
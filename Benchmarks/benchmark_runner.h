@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchmarks
+{
+    /// <summary>
+    /// Named numbers that tell runs of the same benchmark apart, like the entity count of the scene.
+    /// </summary>
+    using Parameters = std::vector<std::pair<std::string, double>>;
+
+    /// <summary>
+    /// The time of one iteration of a benchmark, over all its samples.
+    /// </summary>
+    struct BenchmarkResult
+    {
+        std::string name;
+        Parameters parameters;
+        uint64_t itemsPerIteration = 1;
+        uint32_t samples = 0;
+        uint64_t iterationsPerSample = 1;
+        double minNs = 0;
+        double medianNs = 0;
+        double meanNs = 0;
+        double p95Ns = 0;
+        double maxNs = 0;
+        double stdDevNs = 0;
+        double itemsPerSecond = 0;
+        /// <summary>
+        /// What the benchmark measured besides time, like the size of what it built. Not in the name.
+        /// </summary>
+        Parameters counters;
+    };
+
+    struct RunnerSettings
+    {
+        /// <summary>
+        /// Each benchmark keeps sampling until it ran this long and has minSamples samples.
+        /// </summary>
+        double minSeconds = 0.5;
+        uint32_t minSamples = 10;
+        uint32_t maxSamples = 10000;
+        /// <summary>
+        /// A sample repeats the iteration until it's at least this long, so that tiny bodies aren't all
+        /// clock overhead.
+        /// </summary>
+        double minSampleMicroseconds = 50.0;
+        /// <summary>
+        /// Only benchmarks whose full name (name/param=value/...) contains it run. Empty runs all.
+        /// </summary>
+        std::string filter;
+    };
+
+    /// <summary>
+    /// Times benchmark bodies on MonotonicClock and collects the results, which go out as JSON so that runs
+    /// can be compared between commits.
+    /// </summary>
+    class BenchmarkRunner
+    {
+    public:
+        explicit BenchmarkRunner(const RunnerSettings& settings);
+        /// <summary>
+        /// Whether a benchmark would run with this filter; lets callers skip expensive setup.
+        /// </summary>
+        bool Matches(const std::string& name, const Parameters& parameters) const;
+        /// <summary>
+        /// Runs body once to warm up, then in samples until the settings are satisfied. itemsPerIteration
+        /// is how much work one call of body does (entities, bones...), for the throughput. counters go
+        /// out with the result.
+        /// </summary>
+        void Run(const std::string& name, const Parameters& parameters, uint64_t itemsPerIteration,
+            const std::function<void()>& body, const Parameters& counters = {});
+        const std::vector<BenchmarkResult>& GetResults() const { return results; }
+        void WriteJson(std::ostream& out) const;
+    private:
+        static std::string FullName(const std::string& name, const Parameters& parameters);
+        const RunnerSettings settings;
+        std::vector<BenchmarkResult> results;
+    };
+
+    /// <summary>
+    /// Keeps the compiler from throwing away a result that is never read.
+    /// </summary>
+    void DoNotOptimize(const void* value);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include "benchmark_runner.h"
+
+namespace benchmarks
+{
+    struct SuiteOptions
+    {
+        /// <summary>
+        /// Smaller scenes and fewer variants, for a quick check that everything still runs.
+        /// </summary>
+        bool quick = false;
+        /// <summary>
+        /// Where the glb files for the mesh loading benchmarks are.
+        /// </summary>
+        std::string assetsFolder = "assets";
+    };
+    /// <summary>
+    /// UpdateAllTransforms, per-object data packing and ShadowDataDataUploadSystem over synthetic scenes.
+    /// </summary>
+    void RunTransformBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options);
+    /// <summary>
+    /// skinning::Animation time update and keyframe sampling, pose evaluation, crowd animation and its LOD,
+    /// cpu skinning and skin import.
+    /// </summary>
+    void RunSkinningBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options);
+    /// <summary>
+    /// common::LoadMeshes on the sample assets.
+    /// </summary>
+    void RunMeshLoadingBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options);
+    /// <summary>
+    /// SlotAllocator and DescriptorAllocator, the bookkeeping under the descriptor heaps, and TlsfAllocator and
+    /// MemoryPoolCore, the one under the gpu memory heaps.
+    /// </summary>
+    void RunAllocatorBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options);
+}
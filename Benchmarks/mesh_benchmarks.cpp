@@ -0,0 +1,33 @@
+#include "pch.h"
+#include "benchmarks.h"
+#include "../Core/mesh_load.h"
+#include <filesystem>
+#include <iostream>
+
+void benchmarks::RunMeshLoadingBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options)
+{
+    const std::vector<std::string> files = options.quick ?
+        std::vector<std::string>{ "monkey.glb" } :
+        std::vector<std::string>{ "cube.glb", "sphere.glb", "monkey.glb", "capoeira.glb" };
+    for (size_t f = 0; f < files.size(); f++) {
+        //the parameters are numbers, so the file goes in the name. Items are vertices.
+        const std::string name = "LoadMeshes/" + files[f];
+        if (!runner.Matches(name, {})) {
+            continue;
+        }
+        const std::filesystem::path path = std::filesystem::path(options.assetsFolder) / files[f];
+        if (!std::filesystem::exists(path)) {
+            std::cout << name << ": skipped, " << path.string() << " not found" << std::endl;
+            continue;
+        }
+        const std::string filename = path.string();
+        uint64_t vertices = 0;
+        for (const common::MeshData& mesh : common::LoadMeshes(filename)) {
+            vertices += mesh.vertices.size();
+        }
+        runner.Run(name, {}, vertices, [&filename]() {
+            auto meshes = common::LoadMeshes(filename);
+            DoNotOptimize(meshes.data());
+        });
+    }
+}
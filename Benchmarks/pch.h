@@ -0,0 +1,14 @@
+#pragma once
+//the benchmarks run on Core alone, nothing from Windows nor D3D12 in here
+#include <DirectXMath.h>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <functional>
+#include <memory>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <sstream>
+#include <random>
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "scene_generator.h"
+#include "../Core/components.h"
+#include "../Core/point_light_shadow_camera.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t MATERIAL_COUNT = 8;
+    //roughly the fan out of the sample's scene, 1 root for this many entities
+    constexpr uint32_t ENTITIES_PER_ROOT = 64;
+}
+
+benchmarks::SyntheticScene benchmarks::GenerateScene(entt::registry& registry, const SyntheticSceneSettings& settings)
+{
+    using namespace transforms::components;
+    std::mt19937 rng(settings.seed);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<std::shared_ptr<BSDFMaterial>> materials;
+    for (uint32_t m = 0; m < MATERIAL_COUNT; m++) {
+        auto material = std::make_shared<BSDFMaterial>();
+        material->name = "synthetic_" + std::to_string(m);
+        material->idInFile = m;
+        material->baseColor = DirectX::XMFLOAT4(unit(rng), unit(rng), unit(rng), 1.0f);
+        material->metallicFactor = unit(rng);
+        material->roughnessFactor = unit(rng);
+        material->emissiveColor = DirectX::XMFLOAT3(0, 0, 0);
+        material->opacity = 1.0f;
+        material->refracti = 1.45f;
+        materials.push_back(material);
+    }
+
+    SyntheticScene scene;
+    const uint32_t depth = std::max(settings.depth, 1u);
+    const uint32_t roots = depth == 1 ? settings.entities :
+        std::clamp(settings.entities / ENTITIES_PER_ROOT, 1u, std::max(settings.entities, 1u));
+    //the entities that can still take children, with their level
+    std::vector<std::pair<entt::entity, uint32_t>> parents;
+    for (uint32_t i = 0; i < settings.entities; i++) {
+        const entt::entity entity = registry.create();
+        Transform transform;
+        transform.position = DirectX::XMFLOAT3(position(rng), position(rng), position(rng));
+        transform.rotationAsEulers = DirectX::XMFLOAT3(angle(rng), angle(rng), angle(rng));
+        const float scale = 0.5f + unit(rng);
+        transform.scale = DirectX::XMFLOAT3(scale, scale, scale);
+        registry.emplace<Transform>(entity, transform);
+
+        Hierarchy hierarchy;
+        uint32_t level = 0;
+        if (i >= roots && !parents.empty()) {
+            std::uniform_int_distribution<size_t> pick(0, parents.size() - 1);
+            const auto [parent, parentLevel] = parents[pick(rng)];
+            hierarchy.parent = parent;
+            registry.get<Hierarchy>(parent).AddChild(entity);
+            level = parentLevel + 1;
+        }
+        registry.emplace<Hierarchy>(entity, hierarchy);
+        if (level + 1 < depth) {
+            parents.push_back({ entity, level });
+        }
+        scene.depth = std::max(scene.depth, level + 1);
+
+        Renderable renderable{};
+        renderable.uniformBufferId = i;
+        renderable.mNumberOfIndices = 36;
+        registry.emplace<Renderable>(entity, renderable);
+        registry.emplace<std::shared_ptr<BSDFMaterial>>(entity, materials[i % MATERIAL_COUNT]);
+        scene.entities.push_back(entity);
+    }
+
+    for (uint32_t l = 0; l < settings.lights; l++) {
+        const entt::entity entity = registry.create();
+        Transform transform;
+        transform.position = DirectX::XMFLOAT3(position(rng), position(rng), position(rng));
+        registry.emplace<Transform>(entity, transform);
+        PointLight light{};
+        light.name = L"synthetic_light_" + std::to_wstring(l);
+        light.attenuationConstant = 1.0f;
+        light.attenuationLinear = 0.09f;
+        light.attenuationQuadratic = 0.032f;
+        light.ColorDiffuse = DirectX::XMFLOAT4(1, 1, 1, 1);
+        light.ColorSpecular = DirectX::XMFLOAT4(1, 1, 1, 1);
+        light.ColorAmbient = DirectX::XMFLOAT4(0.1f, 0.1f, 0.1f, 1);
+        registry.emplace<PointLight>(entity, light);
+        registry.emplace<std::shared_ptr<transforms::PointLightShadowCamera>>(entity,
+            std::make_shared<transforms::PointLightShadowCamera>());
+        scene.lights.push_back(entity);
+    }
+    return scene;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <entt/entt.hpp>
+
+namespace benchmarks
+{
+    struct SyntheticSceneSettings
+    {
+        uint32_t entities = 1000;
+        /// <summary>
+        /// Levels of the transform hierarchy. 1 is a flat scene where every entity is a root.
+        /// </summary>
+        uint32_t depth = 4;
+        /// <summary>
+        /// Point lights, each with the cameras of a shadow map. There are no gpu resources, only the math.
+        /// </summary>
+        uint32_t lights = 4;
+        uint32_t seed = 1;
+    };
+
+    struct SyntheticScene
+    {
+        /// <summary>
+        /// The renderables, parents always before their children.
+        /// </summary>
+        std::vector<entt::entity> entities;
+        std::vector<entt::entity> lights;
+        /// <summary>
+        /// The deepest level that got an entity, can be less than the settings ask on small scenes.
+        /// </summary>
+        uint32_t depth = 0;
+    };
+
+    /// <summary>
+    /// Fills the registry with the same components that TransformsAndManyObjects builds from its scene
+    /// file: renderables with a Transform, a Hierarchy and a shared BSDFMaterial, and point lights with
+    /// the PointLightShadowCamera that their CubeMapShadowMap derives from. Same settings, same scene.
+    /// </summary>
+    SyntheticScene GenerateScene(entt::registry& registry, const SyntheticSceneSettings& settings);
+}
@@ -0,0 +1,1289 @@
+#include "pch.h"
+#include "benchmarks.h"
+#include "../Skinning/entities.h"
+#include "../Core/animation_compression.h"
+#include "../Core/animation_import.h"
+#include "../Core/animation_lod.h"
+#include "../Core/skeleton.h"
+#include "../Core/cpu_skinning.h"
+#include "../Core/crowd_animation.h"
+#include "../Core/skin_import.h"
+#include "../Core/worker_pool.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <set>
+
+namespace
+{
+    constexpr float DELTA_TIME = 1.0f / 60.0f;
+    constexpr float BAKE_RATE = 60.0f;
+    const std::vector<std::string> SAMPLING_VARIANTS = {
+        "AnimationSampling/linear", "AnimationSampling", "AnimationSampling/seek", "AnimationSampling/baked",
+        "AnimationSampling/compressed" };
+
+    bool MatchesSampling(const benchmarks::BenchmarkRunner& runner, const std::string& suffix,
+        const benchmarks::Parameters& parameters)
+    {
+        return std::any_of(SAMPLING_VARIANTS.begin(), SAMPLING_VARIANTS.end(),
+            [&runner, &suffix, &parameters](const std::string& name) { return runner.Matches(name + suffix, parameters); });
+    }
+
+    /// <summary>
+    /// keyframeCount keyframes at 30 per second, like the ones the fbx importer makes.
+    /// </summary>
+    std::vector<skinning::Keyframe> MakeKeyframes(uint32_t keyframeCount, std::mt19937& rng)
+    {
+        using namespace DirectX;
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<skinning::Keyframe> keyframes;
+        for (uint32_t k = 0; k < keyframeCount; k++) {
+            skinning::Keyframe keyframe;
+            keyframe.time = k / 30.0f;
+            keyframe.position = XMFLOAT3(unit(rng), unit(rng), unit(rng));
+            keyframe.scale = XMFLOAT3(1, 1, 1);
+            XMVECTOR rotation = XMQuaternionNormalize(XMVectorSet(unit(rng), unit(rng), unit(rng), 1.0f));
+            XMStoreFloat4(&keyframe.rotation, rotation);
+            keyframes.push_back(keyframe);
+        }
+        return keyframes;
+    }
+
+    skinning::Animation MakeAnimation(const std::vector<skinning::Keyframe>& keyframes)
+    {
+        skinning::Animation animation;
+        animation.ticksPerSecond = 30.0f;
+        animation.duration = static_cast<float>(keyframes.size());
+        animation.tracks = skinning::MakeTracks(keyframes);
+        return animation;
+    }
+
+    /// <summary>
+    /// How skinning::Animation sampled before the tracks: merged keyframes, scanned from the first one on
+    /// every sample. The baseline the other variants are measured against.
+    /// </summary>
+    struct LinearScanAnimation
+    {
+        std::vector<skinning::Keyframe> keyframes;
+        float currentTime = 0;
+        void Update(float deltaTime)
+        {
+            currentTime += deltaTime;
+            if (!keyframes.empty()) {
+                const float duration = keyframes.back().time;
+                if (currentTime > duration) {
+                    currentTime = fmod(currentTime, duration);
+                }
+            }
+        }
+        DirectX::XMMATRIX GetTransform() const
+        {
+            using namespace DirectX;
+            const skinning::Keyframe* prevKeyframe = nullptr;
+            const skinning::Keyframe* nextKeyframe = nullptr;
+            for (size_t i = 0; i < keyframes.size(); ++i) {
+                if (keyframes[i].time >= currentTime) {
+                    nextKeyframe = &keyframes[i];
+                    prevKeyframe = &keyframes[i > 0 ? i - 1 : 0];
+                    break;
+                }
+            }
+            if (!prevKeyframe || !nextKeyframe) {
+                return XMMatrixIdentity();
+            }
+            const float t = (currentTime - prevKeyframe->time) / (nextKeyframe->time - prevKeyframe->time);
+            const XMVECTOR pos = XMVectorLerp(XMLoadFloat3(&prevKeyframe->position),
+                XMLoadFloat3(&nextKeyframe->position), t);
+            const XMVECTOR scale = XMVectorLerp(XMLoadFloat3(&prevKeyframe->scale),
+                XMLoadFloat3(&nextKeyframe->scale), t);
+            const XMVECTOR rot = XMQuaternionSlerp(XMLoadFloat4(&prevKeyframe->rotation),
+                XMLoadFloat4(&nextKeyframe->rotation), t);
+            return XMMatrixScalingFromVector(scale) * XMMatrixRotationQuaternion(rot) *
+                XMMatrixTranslationFromVector(pos);
+        }
+    };
+
+    /// <summary>
+    /// The tracks as keyframes for the linear scan: one at every time any track has a key.
+    /// </summary>
+    std::vector<skinning::Keyframe> MakeKeyframes(const common::TransformTracks& tracks)
+    {
+        using namespace DirectX;
+        std::set<float> times(tracks.position.times.begin(), tracks.position.times.end());
+        times.insert(tracks.rotation.times.begin(), tracks.rotation.times.end());
+        times.insert(tracks.scale.times.begin(), tracks.scale.times.end());
+        std::vector<skinning::Keyframe> keyframes;
+        common::TransformCursors cursors;
+        for (float time : times) {
+            XMVECTOR position, rotation, scale;
+            common::SampleTransform(tracks, time, cursors, position, rotation, scale);
+            skinning::Keyframe keyframe;
+            keyframe.time = time;
+            XMStoreFloat3(&keyframe.position, position);
+            XMStoreFloat4(&keyframe.rotation, rotation);
+            XMStoreFloat3(&keyframe.scale, scale);
+            keyframes.push_back(keyframe);
+        }
+        return keyframes;
+    }
+
+    /// <summary>
+    /// A channel of a compressed clip, played like skinning::Animation.
+    /// </summary>
+    struct CompressedAnimation
+    {
+        const common::CompressedClip* clip;
+        uint32_t channel;
+        float currentTime = 0;
+        common::TransformCursors cursors{};
+        void Update(float deltaTime)
+        {
+            currentTime += deltaTime;
+            if (clip->duration > 0 && currentTime > clip->duration) {
+                currentTime = fmod(currentTime, clip->duration);
+            }
+        }
+        DirectX::XMMATRIX GetTransform()
+        {
+            using namespace DirectX;
+            XMVECTOR position, rotation, scale;
+            common::SampleTransform(*clip, channel, currentTime, cursors, position, rotation, scale);
+            return XMMatrixScalingFromVector(scale) * XMMatrixRotationQuaternion(rotation) *
+                XMMatrixTranslationFromVector(position);
+        }
+    };
+
+    /// <summary>
+    /// The first animation of the file and, for each of its channels, the channel of the parent bone.
+    /// </summary>
+    common::AnimationClip LoadFirstAnimation(const std::string& filename, std::vector<int32_t>& parents)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(filename.c_str(), 0);
+        if (!scene || !scene->HasAnimations()) {
+            return {};
+        }
+        common::AnimationClip clip = common::ImportAnimation(*scene->mAnimations[0]);
+        parents.assign(clip.channels.size(), -1);
+        std::unordered_map<std::string, int32_t> channels;
+        for (size_t c = 0; c < clip.channels.size(); c++) {
+            channels[clip.channels[c].nodeName] = static_cast<int32_t>(c);
+        }
+        //nodes without a channel pass their parent on to their children
+        std::function<void(const aiNode*, int32_t)> visit = [&](const aiNode* node, int32_t parent) {
+            auto it = channels.find(node->mName.C_Str());
+            if (it != channels.end()) {
+                parents[it->second] = parent;
+                parent = it->second;
+            }
+            for (unsigned int i = 0; i < node->mNumChildren; i++) {
+                visit(node->mChildren[i], parent);
+            }
+        };
+        visit(scene->mRootNode, -1);
+        return clip;
+    }
+
+    /// <summary>
+    /// A channel with keyCount keys in each of its three arrays, at the same times: one per tick, at 30
+    /// ticks per second.
+    /// </summary>
+    std::unique_ptr<aiNodeAnim> MakeChannel(uint32_t keyCount)
+    {
+        auto channel = std::make_unique<aiNodeAnim>();
+        channel->mNumPositionKeys = keyCount;
+        channel->mPositionKeys = new aiVectorKey[keyCount];
+        channel->mNumRotationKeys = keyCount;
+        channel->mRotationKeys = new aiQuatKey[keyCount];
+        channel->mNumScalingKeys = keyCount;
+        channel->mScalingKeys = new aiVectorKey[keyCount];
+        for (uint32_t k = 0; k < keyCount; k++) {
+            const double time = k;
+            channel->mPositionKeys[k] = aiVectorKey(time, aiVector3D(0.1f * k, 0, 0));
+            channel->mRotationKeys[k] = aiQuatKey(time, aiQuaternion(aiVector3D(0, 1, 0), 0.01f * k));
+            channel->mScalingKeys[k] = aiVectorKey(time, aiVector3D(1, 1, 1));
+        }
+        return channel;
+    }
+
+    /// <summary>
+    /// How LoadAnimations read a channel before the tracks: the rotation and scale keys merged into the
+    /// position keyframes with a linear search each, then a sort.
+    /// </summary>
+    std::vector<skinning::Keyframe> MergeKeys(const aiNodeAnim& channel)
+    {
+        using skinning::Keyframe;
+        std::vector<Keyframe> keyframes;
+        for (unsigned int k = 0; k < channel.mNumPositionKeys; ++k) {
+            const aiVectorKey& key = channel.mPositionKeys[k];
+            keyframes.push_back({ static_cast<float>(key.mTime),
+                DirectX::XMFLOAT3(key.mValue.x, key.mValue.y, key.mValue.z),
+                DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) });
+        }
+        for (unsigned int k = 0; k < channel.mNumRotationKeys; ++k) {
+            const aiQuatKey& key = channel.mRotationKeys[k];
+            const DirectX::XMFLOAT4 rotation(key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w);
+            auto it = std::find_if(keyframes.begin(), keyframes.end(), [&key](const Keyframe& kf) {
+                return std::abs(kf.time - static_cast<float>(key.mTime)) < 0.001f;
+            });
+            if (it != keyframes.end()) {
+                it->rotation = rotation;
+            }
+            else {
+                keyframes.push_back({ static_cast<float>(key.mTime), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f),
+                    DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), rotation });
+            }
+        }
+        for (unsigned int k = 0; k < channel.mNumScalingKeys; ++k) {
+            const aiVectorKey& key = channel.mScalingKeys[k];
+            const DirectX::XMFLOAT3 scale(key.mValue.x, key.mValue.y, key.mValue.z);
+            auto it = std::find_if(keyframes.begin(), keyframes.end(), [&key](const Keyframe& kf) {
+                return std::abs(kf.time - static_cast<float>(key.mTime)) < 0.001f;
+            });
+            if (it != keyframes.end()) {
+                it->scale = scale;
+            }
+            else {
+                keyframes.push_back({ static_cast<float>(key.mTime), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f),
+                    scale, DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) });
+            }
+        }
+        std::sort(keyframes.begin(), keyframes.end(), [](const Keyframe& a, const Keyframe& b) {
+            return a.time < b.time;
+        });
+        return keyframes;
+    }
+
+    /// <summary>
+    /// Plays every animation one frame forward and samples it, one item per bone.
+    /// </summary>
+    template<typename AnimationType>
+    void RunSampling(benchmarks::BenchmarkRunner& runner, const std::string& name,
+        const benchmarks::Parameters& parameters, std::vector<AnimationType>& animations)
+    {
+        std::vector<DirectX::XMMATRIX> pose(animations.size());
+        runner.Run(name, parameters, animations.size(), [&animations, &pose]() {
+            for (size_t b = 0; b < animations.size(); b++) {
+                animations[b].Update(DELTA_TIME);
+                pose[b] = animations[b].GetTransform();
+            }
+            benchmarks::DoNotOptimize(pose.data());
+        });
+    }
+
+    /// <summary>
+    /// The sampling variants over the same bones: the old linear scan, the tracks with their cursors, random
+    /// seeks that take the binary search, the tracks baked at BAKE_RATE and the clip compressed with the
+    /// default settings. parents are for the compression, empty makes every bone a root.
+    /// </summary>
+    void RunSamplingVariants(benchmarks::BenchmarkRunner& runner, const std::string& suffix,
+        const benchmarks::Parameters& parameters, const std::vector<common::TransformTracks>& bones,
+        const std::vector<std::vector<skinning::Keyframe>>& keyframes, const std::vector<int32_t>& parents)
+    {
+        if (runner.Matches("AnimationSampling/linear" + suffix, parameters)) {
+            std::vector<LinearScanAnimation> animations;
+            for (const auto& k : keyframes) {
+                animations.push_back({ k });
+            }
+            RunSampling(runner, "AnimationSampling/linear" + suffix, parameters, animations);
+        }
+        std::vector<skinning::Animation> animations;
+        for (const common::TransformTracks& tracks : bones) {
+            skinning::Animation animation;
+            animation.tracks = tracks;
+            animations.push_back(animation);
+        }
+        if (runner.Matches("AnimationSampling" + suffix, parameters)) {
+            RunSampling(runner, "AnimationSampling" + suffix, parameters, animations);
+        }
+        if (runner.Matches("AnimationSampling/seek" + suffix, parameters)) {
+            float endTime = 0;
+            for (const common::TransformTracks& tracks : bones) {
+                endTime = std::max(endTime, tracks.GetEndTime());
+            }
+            std::mt19937 rng(static_cast<uint32_t>(bones.size()));
+            std::uniform_real_distribution<float> seek(0.0f, endTime);
+            std::vector<float> times(1024);
+            for (float& time : times) {
+                time = seek(rng);
+            }
+            size_t next = 0;
+            std::vector<DirectX::XMMATRIX> pose(animations.size());
+            runner.Run("AnimationSampling/seek" + suffix, parameters, animations.size(),
+                [&animations, &pose, &times, &next]() {
+                const float time = times[next++ % times.size()];
+                for (size_t b = 0; b < animations.size(); b++) {
+                    animations[b].currentTime = time;
+                    pose[b] = animations[b].GetTransform();
+                }
+                benchmarks::DoNotOptimize(pose.data());
+            });
+        }
+        if (runner.Matches("AnimationSampling/baked" + suffix, parameters)) {
+            for (skinning::Animation& animation : animations) {
+                animation.Reset();
+                animation.Bake(BAKE_RATE);
+            }
+            RunSampling(runner, "AnimationSampling/baked" + suffix, parameters, animations);
+        }
+        if (runner.Matches("AnimationSampling/compressed" + suffix, parameters)) {
+            common::AnimationClip clip;
+            for (const common::TransformTracks& tracks : bones) {
+                clip.channels.push_back({ "", tracks });
+                clip.duration = std::max(clip.duration, tracks.GetEndTime());
+            }
+            const common::CompressedClip compressed = common::CompressClip(clip, parents);
+            std::vector<CompressedAnimation> compressedAnimations;
+            for (uint32_t c = 0; c < compressed.channels.size(); c++) {
+                compressedAnimations.push_back({ &compressed, c });
+            }
+            RunSampling(runner, "AnimationSampling/compressed" + suffix, parameters, compressedAnimations);
+        }
+    }
+
+    size_t CountKeys(const common::AnimationClip& clip)
+    {
+        size_t keys = 0;
+        for (const common::AnimationChannel& channel : clip.channels) {
+            keys += channel.tracks.position.times.size() + channel.tracks.rotation.times.size() +
+                channel.tracks.scale.times.size();
+        }
+        return keys;
+    }
+
+    /// <summary>
+    /// The components the bones had when each one was an entity, before common::Skeleton.
+    /// </summary>
+    struct EntityBoneTransform
+    {
+        DirectX::XMVECTOR position;
+        DirectX::XMVECTOR scale;
+        DirectX::XMVECTOR rotation;
+    };
+    struct EntityBoneTPoseMatrix
+    {
+        DirectX::XMMATRIX offsetMatrix;
+    };
+    struct EntityBoneParent
+    {
+        entt::entity parent = entt::null;
+    };
+    struct EntityBoneChildren
+    {
+        std::vector<entt::entity> children;
+    };
+    struct EntityBoneId
+    {
+        int nodeID;
+    };
+
+    /// <summary>
+    /// boneCount bones with random local transforms, each parented to one of the few bones before it so
+    /// that the tree has chains and branches like a rig.
+    /// </summary>
+    std::vector<common::SkeletonBone> MakeSkeletonBones(uint32_t boneCount, std::mt19937& rng)
+    {
+        using namespace DirectX;
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<common::SkeletonBone> bones(boneCount);
+        for (uint32_t b = 0; b < boneCount; b++) {
+            bones[b].name = "bone_" + std::to_string(b);
+            bones[b].parent = b == 0 ? -1 : static_cast<int32_t>(b - 1 - rng() % std::min(b, 4u));
+            bones[b].position = XMFLOAT3(unit(rng), unit(rng), unit(rng));
+            XMStoreFloat4(&bones[b].rotation, XMQuaternionNormalize(XMVectorSet(unit(rng), unit(rng), unit(rng), 1.0f)));
+        }
+        return bones;
+    }
+
+    /// <summary>
+    /// The bones as the loader made them before common::Skeleton: an entity per bone, with its children.
+    /// Returns the root.
+    /// </summary>
+    entt::entity CreateBoneEntities(entt::registry& registry, const std::vector<common::SkeletonBone>& bones)
+    {
+        using namespace DirectX;
+        std::vector<entt::entity> entities;
+        for (uint32_t b = 0; b < bones.size(); b++) {
+            const entt::entity entity = registry.create();
+            registry.emplace<EntityBoneTransform>(entity, EntityBoneTransform{ XMLoadFloat3(&bones[b].position),
+                XMLoadFloat3(&bones[b].scale), XMLoadFloat4(&bones[b].rotation) });
+            registry.emplace<EntityBoneTPoseMatrix>(entity, EntityBoneTPoseMatrix{ XMMatrixIdentity() });
+            registry.emplace<EntityBoneId>(entity, EntityBoneId{ static_cast<int>(b) });
+            registry.emplace<EntityBoneChildren>(entity);
+            registry.emplace<EntityBoneParent>(entity);
+            entities.push_back(entity);
+        }
+        for (uint32_t b = 1; b < bones.size(); b++) {
+            registry.get<EntityBoneParent>(entities[b]).parent = entities[bones[b].parent];
+            registry.get<EntityBoneChildren>(entities[bones[b].parent]).children.push_back(entities[b]);
+        }
+        return entities[0];
+    }
+
+    /// <summary>
+    /// What the per-bone components of a character weighed, the entity ids in the sparse sets included.
+    /// </summary>
+    size_t GetBoneEntitiesMemorySize(const entt::registry& registry)
+    {
+        const auto view = registry.view<const EntityBoneChildren>();
+        size_t bytes = 0;
+        for (const entt::entity entity : view) {
+            bytes += sizeof(EntityBoneTransform) + sizeof(EntityBoneTPoseMatrix) + sizeof(EntityBoneParent) +
+                sizeof(EntityBoneChildren) + sizeof(EntityBoneId) + 5 * 2 * sizeof(entt::entity) +
+                view.get<const EntityBoneChildren>(entity).children.capacity() * sizeof(entt::entity);
+        }
+        return bytes;
+    }
+
+    /// <summary>
+    /// The pose evaluation of the bone entities: depth first from the root, through the components of each.
+    /// </summary>
+    void EvaluateBoneEntities(entt::registry& registry, entt::entity entity, DirectX::FXMMATRIX parentModel,
+        std::vector<DirectX::XMFLOAT4X4>& skinMatrices)
+    {
+        using namespace DirectX;
+        const EntityBoneTransform& transform = registry.get<EntityBoneTransform>(entity);
+        const XMMATRIX model = XMMatrixScalingFromVector(transform.scale) *
+            XMMatrixRotationQuaternion(transform.rotation) * XMMatrixTranslationFromVector(transform.position) *
+            parentModel;
+        XMStoreFloat4x4(&skinMatrices[registry.get<EntityBoneId>(entity).nodeID],
+            registry.get<EntityBoneTPoseMatrix>(entity).offsetMatrix * model);
+        for (entt::entity child : registry.get<EntityBoneChildren>(entity).children) {
+            EvaluateBoneEntities(registry, child, model, skinMatrices);
+        }
+    }
+
+    /// <summary>
+    /// vertexCount vertices around the origin, each bound to four of jointCount joints with weights that add up
+    /// to one, and a palette of rotations and translations for them.
+    /// </summary>
+    struct SkinnedMeshData
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT4> tangents;
+        std::vector<common::SkinInfluences> influences;
+        std::vector<DirectX::XMFLOAT4X4> skinMatrices;
+        common::SkinningSource GetSource() const
+        {
+            return { positions.data(), normals.data(), tangents.data(), influences.data(),
+                static_cast<uint32_t>(positions.size()) };
+        }
+    };
+    SkinnedMeshData MakeSkinnedMesh(uint32_t vertexCount, uint32_t jointCount, std::mt19937& rng)
+    {
+        using namespace DirectX;
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+        SkinnedMeshData mesh;
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            mesh.positions.push_back(XMFLOAT3(unit(rng), unit(rng), unit(rng)));
+            XMFLOAT3 normal;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(unit(rng), unit(rng), unit(rng), 0.0f)));
+            mesh.normals.push_back(normal);
+            mesh.tangents.push_back(XMFLOAT4(normal.y, -normal.x, 0.0f, 1.0f));
+            common::SkinInfluences influences;
+            float total = 0;
+            for (int i = 0; i < 4; i++) {
+                influences.joints[i] = static_cast<uint16_t>(rng() % jointCount);
+                influences.weights[i] = weight(rng);
+                total += influences.weights[i];
+            }
+            for (int i = 0; i < 4; i++) {
+                influences.weights[i] /= total;
+            }
+            mesh.influences.push_back(influences);
+        }
+        for (uint32_t j = 0; j < jointCount; j++) {
+            XMFLOAT4X4 skinMatrix;
+            XMStoreFloat4x4(&skinMatrix, XMMatrixRotationQuaternion(XMQuaternionNormalize(
+                XMVectorSet(unit(rng), unit(rng), unit(rng), 1.0f))) * XMMatrixTranslation(unit(rng), unit(rng), unit(rng)));
+            mesh.skinMatrices.push_back(skinMatrix);
+        }
+        return mesh;
+    }
+
+    /// <summary>
+    /// A mesh of vertexCount vertices and boneCount bones named bone_n, each vertex weighted by 4 of them.
+    /// </summary>
+    std::unique_ptr<aiMesh> MakeWeightedMesh(uint32_t vertexCount, uint32_t boneCount, std::mt19937& rng)
+    {
+        std::vector<std::vector<aiVertexWeight>> boneWeights(boneCount);
+        std::uniform_real_distribution<float> weight(0.05f, 1.0f);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            const uint32_t firstBone = rng() % boneCount;
+            for (uint32_t i = 0; i < 4; i++) {
+                boneWeights[(firstBone + i * 7) % boneCount].push_back(aiVertexWeight(v, weight(rng)));
+            }
+        }
+        auto mesh = std::make_unique<aiMesh>();
+        mesh->mNumVertices = vertexCount;
+        mesh->mNumBones = boneCount;
+        mesh->mBones = new aiBone*[boneCount];
+        for (uint32_t b = 0; b < boneCount; b++) {
+            aiBone* bone = new aiBone();
+            bone->mName = aiString("bone_" + std::to_string(b));
+            bone->mNumWeights = static_cast<unsigned int>(boneWeights[b].size());
+            bone->mWeights = new aiVertexWeight[bone->mNumWeights];
+            std::copy(boneWeights[b].begin(), boneWeights[b].end(), bone->mWeights);
+            mesh->mBones[b] = bone;
+        }
+        return mesh;
+    }
+
+    /// <summary>
+    /// How ProcessMesh read the weights before common::ImportInfluences: for every vertex, every weight of
+    /// every bone, and the id of each bone by a search of the names.
+    /// </summary>
+    void ImportInfluencesNested(const aiMesh& mesh, const std::vector<std::string>& boneNames,
+        std::vector<common::SkinInfluences>& influences)
+    {
+        influences.assign(mesh.mNumVertices, common::SkinInfluences{});
+        for (unsigned int i = 0; i < mesh.mNumVertices; i++) {
+            int weightsSet = 0;
+            for (unsigned int j = 0; j < mesh.mNumBones; j++) {
+                const aiBone* bone = mesh.mBones[j];
+                const std::string boneName = bone->mName.C_Str();
+                uint16_t boneId = 0;
+                for (size_t k = 0; k < boneNames.size(); k++) {
+                    if (boneNames[k] == boneName) {
+                        boneId = static_cast<uint16_t>(k);
+                        break;
+                    }
+                }
+                for (unsigned int k = 0; k < bone->mNumWeights; k++) {
+                    const aiVertexWeight& weight = bone->mWeights[k];
+                    if (weight.mVertexId == i && weightsSet < 4) {
+                        influences[i].joints[weightsSet] = boneId;
+                        influences[i].weights[weightsSet] = weight.mWeight;
+                        weightsSet++;
+                    }
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// A scene like the ones the fbx and glb rigs import as: the root, an armature node, boneCount bone nodes
+    /// in a tree under it and meshCount mesh nodes, each mesh with all the bones.
+    /// </summary>
+    std::unique_ptr<aiScene> MakeRigScene(uint32_t boneCount, uint32_t meshCount, std::mt19937& rng)
+    {
+        auto scene = std::make_unique<aiScene>();
+        scene->mRootNode = new aiNode("RootNode");
+        aiNode* armature = new aiNode("Armature");
+        std::vector<aiNode*> bones;
+        std::vector<std::vector<aiNode*>> children(boneCount + 1);
+        for (uint32_t b = 0; b < boneCount; b++) {
+            bones.push_back(new aiNode("mixamorig:bone_" + std::to_string(b)));
+            const uint32_t parent = b == 0 ? boneCount : b - 1 - rng() % std::min(b, 4u);
+            children[parent].push_back(bones.back());
+        }
+        bones.push_back(armature);
+        for (uint32_t b = 0; b <= boneCount; b++) {
+            if (!children[b].empty()) {
+                bones[b]->addChildren(static_cast<unsigned int>(children[b].size()), children[b].data());
+            }
+        }
+        std::vector<aiNode*> rootChildren;
+        scene->mNumMeshes = meshCount;
+        scene->mMeshes = new aiMesh*[meshCount];
+        for (uint32_t m = 0; m < meshCount; m++) {
+            rootChildren.push_back(new aiNode("mesh_" + std::to_string(m)));
+            aiMesh* mesh = new aiMesh();
+            mesh->mNumBones = boneCount;
+            mesh->mBones = new aiBone*[boneCount];
+            for (uint32_t b = 0; b < boneCount; b++) {
+                mesh->mBones[b] = new aiBone();
+                mesh->mBones[b]->mName = bones[b]->mName;
+            }
+            scene->mMeshes[m] = mesh;
+        }
+        rootChildren.push_back(armature);
+        scene->mRootNode->addChildren(static_cast<unsigned int>(rootChildren.size()), rootChildren.data());
+        return scene;
+    }
+
+    /// <summary>
+    /// The helpers of skinned_mesh.cpp before common::SceneBoneIndex: every node compared with every bone of
+    /// every mesh, through std::strings.
+    /// </summary>
+    bool IsNodeReallyBoneScan(const aiNode* node, const aiScene* scene)
+    {
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            const aiMesh* m = scene->mMeshes[i];
+            for (unsigned int j = 0; j < m->mNumBones; j++) {
+                const std::string meshBoneName = m->mBones[j]->mName.C_Str();
+                const std::string myBoneName = node->mName.C_Str();
+                if (meshBoneName == myBoneName)
+                    return true;
+            }
+        }
+        return false;
+    }
+    aiBone* GetBoneScan(const std::string& myBoneName, const aiScene* scene)
+    {
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            const aiMesh* m = scene->mMeshes[i];
+            for (unsigned int j = 0; j < m->mNumBones; j++) {
+                const std::string meshBoneName = m->mBones[j]->mName.C_Str();
+                if (meshBoneName == myBoneName)
+                    return m->mBones[j];
+            }
+        }
+        return nullptr;
+    }
+    aiNode* FindArmatureRootScan(aiNode* rootNode, const aiScene* scene)
+    {
+        for (unsigned int i = 0; i < rootNode->mNumChildren; i++) {
+            aiNode* child = rootNode->mChildren[i];
+            for (unsigned int j = 0; j < scene->mNumMeshes; j++) {
+                const aiMesh* mesh = scene->mMeshes[j];
+                for (unsigned int k = 0; k < mesh->mNumBones; k++) {
+                    if (std::string(mesh->mBones[k]->mName.C_Str()) == std::string(child->mName.C_Str())) {
+                        return child;
+                    }
+                }
+            }
+            aiNode* result = FindArmatureRootScan(child, scene);
+            if (result) {
+                return result;
+            }
+        }
+        return nullptr;
+    }
+
+    /// <summary>
+    /// What LoadBoneHierarchy asks of the helpers: from the armature root down, whether each node is a bone and
+    /// then its aiBone. Returns how many bones it found.
+    /// </summary>
+    template<typename IsBone, typename GetBone>
+    uint32_t VisitBones(aiNode* node, const IsBone& isBone, const GetBone& getBone)
+    {
+        if (!node || !isBone(node)) {
+            return 0;
+        }
+        uint32_t found = getBone(node) ? 1 : 0;
+        for (unsigned int i = 0; i < node->mNumChildren; i++) {
+            found += VisitBones(node->mChildren[i], isBone, getBone);
+        }
+        return found;
+    }
+
+    /// <summary>
+    /// A clip of the skeleton with keyCount keys on every bone, at 30 per second.
+    /// </summary>
+    common::AnimationClip MakeSkeletonClip(const common::Skeleton& skeleton, uint32_t keyCount, std::mt19937& rng)
+    {
+        common::AnimationClip clip;
+        clip.duration = (keyCount - 1) / 30.0f;
+        for (uint32_t b = 0; b < skeleton.GetBoneCount(); b++) {
+            clip.channels.push_back({ skeleton.names[b], skinning::MakeTracks(MakeKeyframes(keyCount, rng)) });
+        }
+        return clip;
+    }
+
+    /// <summary>
+    /// A crowd as the entity per bone model had it: every character with its own bone entities, each with
+    /// its Bone, its BoneHierarchy and an Animation with a copy of the tracks of its channel.
+    /// </summary>
+    struct EntityCrowd
+    {
+        entt::registry registry;
+        std::vector<std::vector<entt::entity>> characters;
+        std::vector<DirectX::XMFLOAT4X4> modelMatrices;
+        std::vector<DirectX::XMFLOAT4X4> skinMatrices;
+        EntityCrowd(const common::Skeleton& skeleton, const std::vector<common::AnimationClip>& clips,
+            uint32_t characterCount)
+        {
+            for (uint32_t c = 0; c < characterCount; c++) {
+                const common::AnimationClip& clip = clips[c % clips.size()];
+                std::vector<entt::entity> bones;
+                for (uint32_t b = 0; b < skeleton.GetBoneCount(); b++) {
+                    const entt::entity entity = registry.create();
+                    skinning::Bone bone{};
+                    bone.id = b;
+                    bone.name = skeleton.names[b];
+                    bone.offsetMatrix = DirectX::XMMatrixIdentity();
+                    bone.localRotation = DirectX::XMQuaternionIdentity();
+                    registry.emplace<skinning::Bone>(entity, bone);
+                    const int32_t parent = skeleton.parents[b];
+                    registry.emplace<skinning::BoneHierarchy>(entity,
+                        skinning::BoneHierarchy{ parent >= 0 ? bones[parent] : entt::null });
+                    skinning::Animation& animation = registry.emplace<skinning::Animation>(entity);
+                    animation.tracks = clip.channels[b].tracks;
+                    animation.currentTime = c * DELTA_TIME;
+                    bones.push_back(entity);
+                }
+                characters.push_back(std::move(bones));
+            }
+            modelMatrices.resize(skeleton.GetBoneCount());
+            skinMatrices.resize(skeleton.GetBoneCount());
+        }
+        /// <summary>
+        /// The frame: each bone samples its animation into the Bone, then the bones go to model space through
+        /// their parents, all of it through registry lookups.
+        /// </summary>
+        void Update(float deltaTime)
+        {
+            using namespace DirectX;
+            for (const std::vector<entt::entity>& bones : characters) {
+                for (entt::entity entity : bones) {
+                    registry.get<skinning::Animation>(entity).Update(deltaTime);
+                    skinning::UpdateBoneFromAnimation(registry, entity);
+                }
+                for (entt::entity entity : bones) {
+                    const skinning::Bone& bone = registry.get<skinning::Bone>(entity);
+                    XMMATRIX model = bone.GetLocalTransform();
+                    const entt::entity parent = registry.get<skinning::BoneHierarchy>(entity).parent;
+                    if (parent != entt::null) {
+                        model = model * XMLoadFloat4x4(&modelMatrices[registry.get<skinning::Bone>(parent).id]);
+                    }
+                    XMStoreFloat4x4(&modelMatrices[bone.id], model);
+                    XMStoreFloat4x4(&skinMatrices[bone.id], model);
+                }
+            }
+        }
+    };
+
+    /// <summary>
+    /// A crowd as common::Pose arrays: the clips and the skeleton shared, a pose, cursors and skin matrices
+    /// per character. Characters play the clips in turn, so neighbours play different ones.
+    /// </summary>
+    struct PoseCrowd
+    {
+        const common::Skeleton& skeleton;
+        const std::vector<common::AnimationClip>& clips;
+        std::vector<std::vector<int32_t>> clipBones;
+        std::vector<common::Pose> poses;
+        std::vector<std::vector<common::TransformCursors>> cursors;
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> skinMatrices;
+        std::vector<float> times;
+        std::vector<common::CrowdCharacter> characters;
+        PoseCrowd(const common::Skeleton& skeleton, const std::vector<common::AnimationClip>& clips,
+            uint32_t characterCount)
+            : skeleton(skeleton), clips(clips), poses(characterCount, skeleton.restPose), cursors(characterCount),
+            skinMatrices(characterCount), times(characterCount)
+        {
+            for (const common::AnimationClip& clip : clips) {
+                clipBones.push_back(common::BindClip(skeleton, clip));
+            }
+            for (uint32_t c = 0; c < characterCount; c++) {
+                times[c] = c * DELTA_TIME;
+            }
+        }
+        void Advance(float deltaTime)
+        {
+            for (uint32_t c = 0; c < times.size(); c++) {
+                times[c] = fmod(times[c] + deltaTime, clips[c % clips.size()].duration);
+            }
+        }
+        /// <summary>
+        /// What AnimateSkeletons did before the batching: each character samples its whole clip and evaluates
+        /// its pose, in entity order.
+        /// </summary>
+        void UpdatePerCharacter(float deltaTime, std::vector<DirectX::XMFLOAT4X4>& modelMatrices)
+        {
+            Advance(deltaTime);
+            for (uint32_t c = 0; c < times.size(); c++) {
+                const uint32_t clip = c % clips.size();
+                common::SampleClip(clips[clip], clipBones[clip], times[c], cursors[c], poses[c]);
+                common::ComputeModelMatrices(skeleton, poses[c], modelMatrices);
+                common::ComputeSkinMatrices(skeleton, modelMatrices, skinMatrices[c]);
+            }
+        }
+        void Update(common::WorkerPool& workerPool, float deltaTime)
+        {
+            Advance(deltaTime);
+            characters.clear();
+            for (uint32_t c = 0; c < times.size(); c++) {
+                const uint32_t clip = c % clips.size();
+                characters.push_back({ &skeleton, &clips[clip], &clipBones[clip], times[c], &cursors[c], &poses[c],
+                    &skinMatrices[c] });
+            }
+            common::AnimateCrowd(workerPool, characters);
+        }
+    };
+
+    /// <summary>
+    /// The crowd with animation LOD, characters of random screen sizes, a fraction of them visible.
+    /// </summary>
+    struct LodCrowd : PoseCrowd
+    {
+        common::AnimationLodSettings settings;
+        std::array<std::vector<std::vector<int32_t>>, common::ANIMATION_LOD_TIER_COUNT> tierClipBones;
+        std::vector<float> screenSizes;
+        std::vector<bool> visible;
+        std::vector<common::AnimationLodState> states;
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> previous;
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> next;
+        std::vector<common::LodCrowdCharacter> lodCharacters;
+        LodCrowd(const common::Skeleton& skeleton, const std::vector<common::AnimationClip>& clips,
+            uint32_t characterCount, double visibleFraction, uint32_t farBoneDepth, std::mt19937& rng)
+            : PoseCrowd(skeleton, clips, characterCount), states(characterCount), previous(characterCount),
+            next(characterCount)
+        {
+            settings.maxBoneDepth[static_cast<uint32_t>(common::AnimationLodTier::Every4thFrame)] = farBoneDepth;
+            const std::vector<uint32_t> depths = common::ComputeBoneDepths(skeleton);
+            for (const std::vector<int32_t>& channelBones : clipBones) {
+                tierClipBones[2].push_back(common::ReduceChannelBones(channelBones, depths, farBoneDepth));
+            }
+            std::uniform_real_distribution<float> size(0.02f, 0.5f);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            for (uint32_t c = 0; c < characterCount; c++) {
+                screenSizes.push_back(size(rng));
+                visible.push_back(unit(rng) < visibleFraction);
+            }
+        }
+        void UpdateLod(common::WorkerPool& workerPool, float deltaTime)
+        {
+            Advance(deltaTime);
+            lodCharacters.clear();
+            for (uint32_t c = 0; c < times.size(); c++) {
+                const uint32_t clip = c % clips.size();
+                common::LodCrowdCharacter character;
+                character.character = { &skeleton, &clips[clip], &clipBones[clip], times[c], &cursors[c], &poses[c],
+                    &skinMatrices[c] };
+                character.settings = &settings;
+                character.tierChannelBones[2] = &tierClipBones[2][clip];
+                character.screenSize = screenSizes[c];
+                character.visible = visible[c];
+                character.phase = c;
+                character.state = &states[c];
+                character.previous = &previous[c];
+                character.next = &next[c];
+                lodCharacters.push_back(character);
+            }
+            common::AnimateCrowdLod(workerPool, lodCharacters, deltaTime);
+        }
+        /// <summary>
+        /// The evaluations a frame averages over the 4 frames of the slowest tier, the refreshes of the first
+        /// frame left out.
+        /// </summary>
+        double GetEvaluationsPerFrame() const
+        {
+            uint32_t evaluations = 0;
+            for (uint32_t c = 0; c < times.size(); c++) {
+                common::AnimationLodState state;
+                for (uint32_t frame = 0; frame < 5; frame++) {
+                    const common::AnimationLodTier tier = common::SelectLodTier(settings, screenSizes[c], state.tier);
+                    const common::AnimationLodStep step = common::AdvanceAnimationLod(state, tier, visible[c], c);
+                    evaluations += frame > 0 && step.evaluate ? 1 : 0;
+                }
+            }
+            return evaluations / 4.0;
+        }
+    };
+
+    /// <summary>
+    /// The largest difference of any coordinate of the positions and normals.
+    /// </summary>
+    double MaxDifference(const std::vector<DirectX::XMFLOAT3>& a, const std::vector<DirectX::XMFLOAT3>& b)
+    {
+        double difference = 0;
+        for (size_t v = 0; v < a.size(); v++) {
+            difference = std::max({ difference, static_cast<double>(std::abs(a[v].x - b[v].x)),
+                static_cast<double>(std::abs(a[v].y - b[v].y)), static_cast<double>(std::abs(a[v].z - b[v].z)) });
+        }
+        return difference;
+    }
+}
+
+void benchmarks::RunSkinningBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options)
+{
+    const std::vector<uint32_t> boneCounts = options.quick ?
+        std::vector<uint32_t>{ 64 } : std::vector<uint32_t>{ 32, 64, 128 };
+    const std::vector<uint32_t> keyframeCounts = options.quick ?
+        std::vector<uint32_t>{ 100 } : std::vector<uint32_t>{ 10, 100, 1000 };
+
+    for (uint32_t bones : boneCounts) {
+        for (uint32_t keyframes : keyframeCounts) {
+            const Parameters parameters{ {"bones", bones}, {"keyframes", keyframes} };
+            if (MatchesSampling(runner, "", parameters)) {
+                std::mt19937 rng(bones * 7919u + keyframes);
+                std::vector<std::vector<skinning::Keyframe>> boneKeyframes;
+                std::vector<common::TransformTracks> boneTracks;
+                for (uint32_t b = 0; b < bones; b++) {
+                    boneKeyframes.push_back(MakeKeyframes(keyframes, rng));
+                    boneTracks.push_back(skinning::MakeTracks(boneKeyframes.back()));
+                }
+                RunSamplingVariants(runner, "", parameters, boneTracks, boneKeyframes, {});
+            }
+            if (runner.Matches("UpdateBoneFromAnimation", parameters)) {
+                //the path the Skinning sample takes, through the registry and with the decompose
+                std::mt19937 rng(bones * 7919u + keyframes);
+                entt::registry registry;
+                std::vector<entt::entity> entities;
+                for (uint32_t b = 0; b < bones; b++) {
+                    const entt::entity entity = registry.create();
+                    skinning::Bone bone{};
+                    bone.id = b;
+                    bone.name = "bone_" + std::to_string(b);
+                    bone.offsetMatrix = DirectX::XMMatrixIdentity();
+                    bone.localRotation = DirectX::XMQuaternionIdentity();
+                    registry.emplace<skinning::Bone>(entity, bone);
+                    registry.emplace<skinning::Animation>(entity, MakeAnimation(MakeKeyframes(keyframes, rng)));
+                    entities.push_back(entity);
+                }
+                runner.Run("UpdateBoneFromAnimation", parameters, bones, [&registry, &entities]() {
+                    for (entt::entity entity : entities) {
+                        registry.get<skinning::Animation>(entity).Update(DELTA_TIME);
+                        skinning::UpdateBoneFromAnimation(registry, entity);
+                    }
+                });
+            }
+        }
+    }
+
+    //a character's pose to skin matrices, one item per bone. The counter is what a character owns of it:
+    //the bone entities before, the pose and its skin matrices now
+    for (uint32_t bones : boneCounts) {
+        const Parameters parameters{ {"bones", bones} };
+        if (!runner.Matches("PoseEvaluation/entities", parameters) && !runner.Matches("PoseEvaluation", parameters)) {
+            continue;
+        }
+        std::mt19937 rng(bones);
+        const std::vector<common::SkeletonBone> skeletonBones = MakeSkeletonBones(bones, rng);
+        std::vector<DirectX::XMFLOAT4X4> skinMatrices(bones);
+        if (runner.Matches("PoseEvaluation/entities", parameters)) {
+            entt::registry registry;
+            const entt::entity root = CreateBoneEntities(registry, skeletonBones);
+            const Parameters counters{ {"bytesPerCharacter", static_cast<double>(GetBoneEntitiesMemorySize(registry))} };
+            runner.Run("PoseEvaluation/entities", parameters, bones, [&registry, root, &skinMatrices]() {
+                EvaluateBoneEntities(registry, root, DirectX::XMMatrixIdentity(), skinMatrices);
+                DoNotOptimize(skinMatrices.data());
+            }, counters);
+        }
+        if (runner.Matches("PoseEvaluation", parameters)) {
+            std::vector<uint32_t> jointBones(bones);
+            std::iota(jointBones.begin(), jointBones.end(), 0u);
+            DirectX::XMFLOAT4X4 identity;
+            DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+            const common::Skeleton skeleton = common::BuildSkeleton(skeletonBones, jointBones,
+                std::vector<DirectX::XMFLOAT4X4>(bones, identity));
+            const common::Pose pose = skeleton.restPose;
+            std::vector<DirectX::XMFLOAT4X4> modelMatrices;
+            const Parameters counters{ {"bytesPerCharacter",
+                static_cast<double>(pose.GetMemorySize() + skinMatrices.size() * sizeof(DirectX::XMFLOAT4X4))} };
+            runner.Run("PoseEvaluation", parameters, bones, [&skeleton, &pose, &modelMatrices, &skinMatrices]() {
+                common::ComputeModelMatrices(skeleton, pose, modelMatrices);
+                common::ComputeSkinMatrices(skeleton, modelMatrices, skinMatrices);
+                DoNotOptimize(skinMatrices.data());
+            }, counters);
+        }
+    }
+
+    //cpu skinning, one item per vertex. The kernels run on the calling thread, so their items/s are vertices
+    //per second per core; the parallel runs use the fastest kernel on all the threads of the pool. The
+    //simd kernels report how far they end up from the scalar reference
+    const std::vector<uint32_t> vertexCounts = options.quick ?
+        std::vector<uint32_t>{ 100000 } : std::vector<uint32_t>{ 10000, 100000, 1000000 };
+    const std::vector<common::SkinningKernel> kernels{ common::SkinningKernel::Scalar, common::SkinningKernel::SSE,
+        common::SkinningKernel::AVX2 };
+    std::unique_ptr<common::WorkerPool> workerPool;
+    for (uint32_t vertices : vertexCounts) {
+        for (const std::string method : { "linearBlend", "dualQuaternion" }) {
+            const std::string name = "CpuSkinning/" + method;
+            const bool dualQuaternion = method == "dualQuaternion";
+            const Parameters parameters{ {"vertices", vertices} };
+            const bool anyKernel = std::any_of(kernels.begin(), kernels.end(),
+                [&runner, &name, &parameters](common::SkinningKernel kernel) {
+                    return runner.Matches(name + "/" + common::GetSkinningKernelName(kernel), parameters);
+                });
+            if (!anyKernel && !runner.Matches(name + "/parallel", parameters)) {
+                continue;
+            }
+            std::mt19937 rng(vertices);
+            const SkinnedMeshData mesh = MakeSkinnedMesh(vertices, 64, rng);
+            std::vector<common::DualQuaternion> palette;
+            common::ComputeDualQuaternions(mesh.skinMatrices, palette);
+            const common::SkinningSource source = mesh.GetSource();
+            std::vector<DirectX::XMFLOAT3> positions(vertices), normals(vertices);
+            std::vector<DirectX::XMFLOAT4> tangents(vertices);
+            const common::SkinningTarget target{ positions.data(), normals.data(), tangents.data() };
+            auto skin = [&mesh, &palette, &source, &target, dualQuaternion](common::SkinningKernel kernel) {
+                if (dualQuaternion) {
+                    common::SkinDualQuaternion(kernel, palette.data(), source, target, 0, source.vertexCount);
+                }
+                else {
+                    common::SkinLinearBlend(kernel, mesh.skinMatrices.data(), source, target, 0, source.vertexCount);
+                }
+            };
+            skin(common::SkinningKernel::Scalar);
+            const std::vector<DirectX::XMFLOAT3> referencePositions = positions;
+            const std::vector<DirectX::XMFLOAT3> referenceNormals = normals;
+            for (common::SkinningKernel kernel : kernels) {
+                const std::string kernelName = name + "/" + common::GetSkinningKernelName(kernel);
+                if (!runner.Matches(kernelName, parameters)) {
+                    continue;
+                }
+                if (!common::IsSkinningKernelSupported(kernel)) {
+                    std::cout << kernelName << ": skipped, not supported by this cpu" << std::endl;
+                    continue;
+                }
+                skin(kernel);
+                const Parameters counters{ {"maxErrorVsScalar", std::max(MaxDifference(positions, referencePositions),
+                    MaxDifference(normals, referenceNormals))} };
+                runner.Run(kernelName, parameters, vertices, [&skin, kernel, &positions]() {
+                    skin(kernel);
+                    DoNotOptimize(positions.data());
+                }, counters);
+            }
+            if (!workerPool) {
+                workerPool = std::make_unique<common::WorkerPool>();
+            }
+            const Parameters parallelParameters{ {"vertices", vertices}, {"threads", workerPool->GetConcurrency()} };
+            if (!runner.Matches(name + "/parallel", parallelParameters)) {
+                continue;
+            }
+            const common::SkinningKernel kernel = common::GetFastestSkinningKernel();
+            runner.Run(name + "/parallel", parallelParameters, vertices,
+                [&workerPool, &mesh, &palette, &source, &target, kernel, dualQuaternion, &positions]() {
+                    if (dualQuaternion) {
+                        common::SkinDualQuaternion(*workerPool, kernel, palette.data(), source, target);
+                    }
+                    else {
+                        common::SkinLinearBlend(*workerPool, kernel, mesh.skinMatrices.data(), source, target);
+                    }
+                    DoNotOptimize(positions.data());
+                });
+        }
+    }
+
+    //the weights of a mesh into 4 influences per vertex, one item per weight. The nested loop is
+    //vertices x weights, it only runs on the smaller meshes
+    const std::vector<uint32_t> weightedVertexCounts = options.quick ?
+        std::vector<uint32_t>{ 2000 } : std::vector<uint32_t>{ 1000, 4000, 16000 };
+    for (uint32_t vertices : weightedVertexCounts) {
+        const Parameters parameters{ {"vertices", vertices}, {"bones", 64} };
+        const bool nested = vertices <= 4000 && runner.Matches("SkinWeightImport/nested", parameters);
+        if (!nested && !runner.Matches("SkinWeightImport", parameters)) {
+            continue;
+        }
+        std::mt19937 rng(vertices);
+        const std::unique_ptr<aiMesh> mesh = MakeWeightedMesh(vertices, 64, rng);
+        std::vector<std::string> boneNames;
+        std::vector<uint16_t> joints;
+        for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+            boneNames.push_back(mesh->mBones[b]->mName.C_Str());
+            joints.push_back(static_cast<uint16_t>(b));
+        }
+        const uint64_t weights = vertices * 4ull;
+        std::vector<common::SkinInfluences> influences;
+        if (nested) {
+            runner.Run("SkinWeightImport/nested", parameters, weights, [&mesh, &boneNames, &influences]() {
+                ImportInfluencesNested(*mesh, boneNames, influences);
+                DoNotOptimize(influences.data());
+            });
+        }
+        runner.Run("SkinWeightImport", parameters, weights, [&mesh, &joints, &influences]() {
+            common::ImportInfluences(*mesh, joints, influences);
+            DoNotOptimize(influences.data());
+        });
+    }
+
+    //the bone lookups of loading a rig, one item per bone. The index is built inside the timed body, it's
+    //built once per scene when loading
+    const std::vector<uint32_t> rigMeshCounts = options.quick ? std::vector<uint32_t>{ 3 } : std::vector<uint32_t>{ 1, 3 };
+    for (uint32_t meshes : rigMeshCounts) {
+        const uint32_t bones = 200;
+        const Parameters parameters{ {"bones", bones}, {"meshes", meshes} };
+        if (!runner.Matches("SceneBoneLookup/scan", parameters) && !runner.Matches("SceneBoneLookup", parameters)) {
+            continue;
+        }
+        std::mt19937 rng(bones + meshes);
+        const std::unique_ptr<aiScene> scene = MakeRigScene(bones, meshes, rng);
+        const aiScene* rig = scene.get();
+        if (runner.Matches("SceneBoneLookup/scan", parameters)) {
+            runner.Run("SceneBoneLookup/scan", parameters, bones, [rig]() {
+                const uint32_t found = VisitBones(FindArmatureRootScan(rig->mRootNode, rig),
+                    [rig](const aiNode* node) { return IsNodeReallyBoneScan(node, rig); },
+                    [rig](const aiNode* node) { return GetBoneScan(node->mName.C_Str(), rig); });
+                DoNotOptimize(&found);
+            });
+        }
+        if (runner.Matches("SceneBoneLookup", parameters)) {
+            runner.Run("SceneBoneLookup", parameters, bones, [rig]() {
+                const common::SceneBoneIndex boneIndex(*rig);
+                const uint32_t found = VisitBones(boneIndex.GetArmatureRoot(),
+                    [&boneIndex](const aiNode* node) { return boneIndex.IsBone(node); },
+                    [&boneIndex](const aiNode* node) {
+                        return boneIndex.FindBone(std::string_view(node->mName.data, node->mName.length));
+                    });
+                DoNotOptimize(&found);
+            });
+        }
+    }
+
+    //a crowd playing 4 clips, one item per bone of every character. The entity per bone model only runs on the
+    //smaller crowds, every bone has its own copy of the keys there. batched is the grouping by clip on the
+    //calling thread alone, the plain one is the same on all the threads of the pool
+    const std::vector<uint32_t> crowdSizes = options.quick ?
+        std::vector<uint32_t>{ 100 } : std::vector<uint32_t>{ 1, 10, 100, 1000 };
+    std::unique_ptr<common::WorkerPool> serialPool;
+    for (uint32_t characters : crowdSizes) {
+        const uint32_t bones = 64;
+        const uint32_t clipCount = 4;
+        const Parameters parameters{ {"characters", characters}, {"bones", bones}, {"clips", clipCount} };
+        if (!workerPool) {
+            workerPool = std::make_unique<common::WorkerPool>();
+        }
+        const Parameters parallelParameters{ {"characters", characters}, {"bones", bones}, {"clips", clipCount},
+            {"threads", workerPool->GetConcurrency()} };
+        const bool entities = characters <= 100 && runner.Matches("CrowdAnimation/entities", parameters);
+        const bool serial = runner.Matches("CrowdAnimation/perCharacter", parameters) ||
+            runner.Matches("CrowdAnimation/batched", parameters);
+        const bool parallel = runner.Matches("CrowdAnimation", parallelParameters);
+        if (!entities && !serial && !parallel) {
+            continue;
+        }
+        std::mt19937 rng(characters);
+        std::vector<uint32_t> jointBones(bones);
+        std::iota(jointBones.begin(), jointBones.end(), 0u);
+        DirectX::XMFLOAT4X4 identity;
+        DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+        const common::Skeleton skeleton = common::BuildSkeleton(MakeSkeletonBones(bones, rng), jointBones,
+            std::vector<DirectX::XMFLOAT4X4>(bones, identity));
+        std::vector<common::AnimationClip> clips;
+        for (uint32_t c = 0; c < clipCount; c++) {
+            clips.push_back(MakeSkeletonClip(skeleton, 60, rng));
+        }
+        const uint64_t items = static_cast<uint64_t>(characters) * bones;
+        if (entities) {
+            EntityCrowd crowd(skeleton, clips, characters);
+            runner.Run("CrowdAnimation/entities", parameters, items, [&crowd]() {
+                crowd.Update(DELTA_TIME);
+                DoNotOptimize(crowd.skinMatrices.data());
+            });
+        }
+        PoseCrowd crowd(skeleton, clips, characters);
+        if (runner.Matches("CrowdAnimation/perCharacter", parameters)) {
+            std::vector<DirectX::XMFLOAT4X4> modelMatrices;
+            runner.Run("CrowdAnimation/perCharacter", parameters, items, [&crowd, &modelMatrices]() {
+                crowd.UpdatePerCharacter(DELTA_TIME, modelMatrices);
+                DoNotOptimize(crowd.skinMatrices.data());
+            });
+        }
+        if (runner.Matches("CrowdAnimation/batched", parameters)) {
+            if (!serialPool) {
+                serialPool = std::make_unique<common::WorkerPool>(0);
+            }
+            runner.Run("CrowdAnimation/batched", parameters, items, [&crowd, &serialPool]() {
+                crowd.Update(*serialPool, DELTA_TIME);
+                DoNotOptimize(crowd.skinMatrices.data());
+            });
+        }
+        if (parallel) {
+            runner.Run("CrowdAnimation", parallelParameters, items, [&crowd, &workerPool]() {
+                crowd.Update(*workerPool, DELTA_TIME);
+                DoNotOptimize(crowd.skinMatrices.data());
+            });
+        }
+    }
+
+    //the same crowd with animation LOD, one item per bone of every character as above so that the items/s
+    //compare. Screen sizes are spread over the three tiers, the farthest drops the bones below depth 8
+    const std::vector<double> visibleFractions = options.quick ?
+        std::vector<double>{ 0.5 } : std::vector<double>{ 1.0, 0.5, 0.1 };
+    for (double visibleFraction : visibleFractions) {
+        const uint32_t characters = 1000;
+        const uint32_t bones = 64;
+        if (!workerPool) {
+            workerPool = std::make_unique<common::WorkerPool>();
+        }
+        const Parameters parameters{ {"characters", characters}, {"bones", bones}, {"visible", visibleFraction},
+            {"threads", workerPool->GetConcurrency()} };
+        if (!runner.Matches("CrowdAnimationLod", parameters)) {
+            continue;
+        }
+        std::mt19937 rng(characters);
+        std::vector<uint32_t> jointBones(bones);
+        std::iota(jointBones.begin(), jointBones.end(), 0u);
+        DirectX::XMFLOAT4X4 identity;
+        DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+        const common::Skeleton skeleton = common::BuildSkeleton(MakeSkeletonBones(bones, rng), jointBones,
+            std::vector<DirectX::XMFLOAT4X4>(bones, identity));
+        std::vector<common::AnimationClip> clips;
+        for (uint32_t c = 0; c < 4; c++) {
+            clips.push_back(MakeSkeletonClip(skeleton, 60, rng));
+        }
+        LodCrowd crowd(skeleton, clips, characters, visibleFraction, 8, rng);
+        const Parameters counters{ {"evaluationsPerFrame", crowd.GetEvaluationsPerFrame()} };
+        runner.Run("CrowdAnimationLod", parameters, static_cast<uint64_t>(characters) * bones, [&crowd, &workerPool]() {
+            crowd.UpdateLod(*workerPool, DELTA_TIME);
+            DoNotOptimize(crowd.skinMatrices.data());
+        }, counters);
+    }
+
+    const std::vector<uint32_t> importKeyCounts = options.quick ?
+        std::vector<uint32_t>{ 1000 } : std::vector<uint32_t>{ 100, 1000, 10000 };
+    for (uint32_t keys : importKeyCounts) {
+        //items are keys, of the three arrays
+        const Parameters parameters{ {"keys", keys} };
+        if (!runner.Matches("AnimationImport/merged", parameters) && !runner.Matches("AnimationImport", parameters)) {
+            continue;
+        }
+        const std::unique_ptr<aiNodeAnim> channel = MakeChannel(keys);
+        runner.Run("AnimationImport/merged", parameters, keys * 3ull, [&channel]() {
+            auto keyframes = MergeKeys(*channel);
+            DoNotOptimize(keyframes.data());
+        });
+        runner.Run("AnimationImport", parameters, keys * 3ull, [&channel]() {
+            auto tracks = common::ImportTracks(*channel, 30.0);
+            DoNotOptimize(tracks.rotation.values.data());
+        });
+    }
+
+    //the same variants on the clip of the sample, the parameters are numbers so the file goes in the name
+    const std::string capoeira = "/capoeira.glb";
+    const std::vector<double> maxErrors = options.quick ?
+        std::vector<double>{ 0.1 } : std::vector<double>{ 0.01, 0.1, 1.0 };
+    const bool compression = std::any_of(maxErrors.begin(), maxErrors.end(), [&runner, &capoeira](double maxError) {
+        return runner.Matches("AnimationCompression" + capoeira, { {"maxError", maxError} });
+    });
+    if (!MatchesSampling(runner, capoeira, {}) && !compression) {
+        return;
+    }
+    const std::filesystem::path path = std::filesystem::path(options.assetsFolder) / "capoeira.glb";
+    std::vector<int32_t> parents;
+    common::AnimationClip clip;
+    if (std::filesystem::exists(path)) {
+        clip = LoadFirstAnimation(path.string(), parents);
+    }
+    if (clip.channels.empty()) {
+        std::cout << "AnimationSampling" << capoeira << ": skipped, no animation in " << path.string() << std::endl;
+        return;
+    }
+    std::vector<common::TransformTracks> bones;
+    std::vector<std::vector<skinning::Keyframe>> keyframes;
+    for (const common::AnimationChannel& channel : clip.channels) {
+        bones.push_back(channel.tracks);
+        keyframes.push_back(MakeKeyframes(channel.tracks));
+    }
+    RunSamplingVariants(runner, capoeira, {}, bones, keyframes, parents);
+
+    //items are the keys of the clip; the counters are what the compression is for: how much smaller the
+    //clip gets and how far the vertices end up, in the units of the clip, centimetres
+    for (double maxError : maxErrors) {
+        const Parameters parameters{ {"maxError", maxError} };
+        if (!runner.Matches("AnimationCompression" + capoeira, parameters)) {
+            continue;
+        }
+        common::ClipCompressionSettings settings;
+        settings.maxError = static_cast<float>(maxError);
+        const common::CompressedClip compressed = common::CompressClip(clip, parents, settings);
+        const Parameters counters{
+            {"bytes", static_cast<double>(common::GetMemorySize(clip))},
+            {"compressedBytes", static_cast<double>(compressed.GetMemorySize())},
+            {"ratio", static_cast<double>(common::GetMemorySize(clip)) / compressed.GetMemorySize()},
+            {"keptKeys", static_cast<double>(compressed.keys.size())},
+            {"measuredError", common::MeasureCompressionError(clip, compressed, parents, settings)} };
+        runner.Run("AnimationCompression" + capoeira, parameters, CountKeys(clip), [&clip, &parents, &settings]() {
+            auto result = common::CompressClip(clip, parents, settings);
+            DoNotOptimize(result.keys.data());
+        }, counters);
+    }
+}
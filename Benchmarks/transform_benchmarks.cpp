@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "benchmarks.h"
+#include "scene_generator.h"
+#include "../Core/components.h"
+#include "../Core/per_object_data_upload_system.h"
+#include "../Core/ShadowDataUpdateSystem.h"
+#include "../Core/cpu_uniform_buffer.h"
+#include "../Core/script_runner_system.h"
+
+namespace
+{
+    //the frames in flight TransformsAndManyObjects starts with
+    constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+    /// <summary>
+    /// A behavior about as cheap as they get, so that the benchmark measures the dispatch.
+    /// </summary>
+    struct Spinner
+    {
+        float angle = 0;
+        float speed = 1;
+        void Update(float deltaTime, entt::entity, entt::registry&) {
+            angle += speed * deltaTime;
+        }
+    };
+}
+
+void benchmarks::RunTransformBenchmarks(BenchmarkRunner& runner, const SuiteOptions& options)
+{
+    using namespace transforms::components;
+    const std::vector<uint32_t> entityCounts = options.quick ?
+        std::vector<uint32_t>{ 1000 } : std::vector<uint32_t>{ 100, 1000, 10000 };
+    const std::vector<uint32_t> depths = options.quick ?
+        std::vector<uint32_t>{ 4 } : std::vector<uint32_t>{ 1, 4, 16 };
+    const std::vector<uint32_t> lightCounts = options.quick ?
+        std::vector<uint32_t>{ 4 } : std::vector<uint32_t>{ 1, 4, MAX_LIGHTS };
+
+    for (uint32_t entities : entityCounts) {
+        for (uint32_t depth : depths) {
+            const Parameters parameters{ {"entities", entities}, {"depth", depth} };
+            if (!runner.Matches("UpdateAllTransforms", parameters)) {
+                continue;
+            }
+            entt::registry registry;
+            SyntheticSceneSettings settings;
+            settings.entities = entities;
+            settings.depth = depth;
+            settings.lights = 0;
+            GenerateScene(registry, settings);
+            runner.Run("UpdateAllTransforms", parameters, entities, [&registry]() {
+                UpdateAllTransforms(registry);
+            });
+        }
+    }
+
+    for (uint32_t entities : entityCounts) {
+        const Parameters parameters{ {"entities", entities} };
+        if (!runner.Matches("PerObjectDataUpload", parameters)) {
+            continue;
+        }
+        entt::registry registry;
+        SyntheticSceneSettings settings;
+        settings.entities = entities;
+        settings.lights = 0;
+        GenerateScene(registry, settings);
+        UpdateAllTransforms(registry);
+        transforms::CpuUniformBuffer<transforms::PerObjectData> buffer(FRAMES_IN_FLIGHT, entities);
+        auto renderables = registry.view<Renderable, Transform, std::shared_ptr<BSDFMaterial>>();
+        runner.Run("PerObjectDataUpload", parameters, entities, [&renderables, &buffer]() {
+            transforms::PerObjectDataUploadSystem(renderables, &buffer, 0);
+            DoNotOptimize(buffer.GetData(0));
+        });
+    }
+
+    for (uint32_t lights : lightCounts) {
+        const Parameters parameters{ {"lights", lights} };
+        if (!runner.Matches("ShadowDataDataUpload", parameters)) {
+            continue;
+        }
+        entt::registry registry;
+        SyntheticSceneSettings settings;
+        settings.entities = 0;
+        settings.lights = lights;
+        GenerateScene(registry, settings);
+        UpdateAllTransforms(registry);
+        transforms::CpuUniformBuffer<transforms::ShadowMapConstants> buffer(FRAMES_IN_FLIGHT, lights * 6);
+        auto shadowMaps = registry.view<Transform, PointLight, std::shared_ptr<transforms::PointLightShadowCamera>>();
+        runner.Run("ShadowDataDataUpload", parameters, lights, [&shadowMaps, &buffer]() {
+            transforms::ShadowDataDataUploadSystem(shadowMaps, &buffer, 0);
+            DoNotOptimize(buffer.GetData(0));
+        });
+    }
+
+    //the same behavior as a typed one, and through the std::function of a Script
+    for (uint32_t entities : entityCounts) {
+        for (const char* dispatch : { "typed", "function" }) {
+            const std::string name = std::string("ScriptDispatch/") + dispatch;
+            const Parameters parameters{ {"entities", entities} };
+            if (!runner.Matches(name, parameters)) {
+                continue;
+            }
+            const bool typed = std::string(dispatch) == "typed";
+            entt::registry registry;
+            for (uint32_t i = 0; i < entities; i++) {
+                const entt::entity e = registry.create();
+                registry.emplace<Spinner>(e);
+                if (!typed) {
+                    Script script;
+                    script.execute = [](float deltaTime, entt::entity self, entt::registry& registry) {
+                        registry.get<Spinner>(self).Update(deltaTime, self, registry);
+                    };
+                    registry.emplace<Script>(e, script);
+                }
+            }
+            transforms::systems::ScriptRunner scripts;
+            if (typed) {
+                scripts.Register<Spinner>();
+            }
+            runner.Run(name, parameters, entities, [&scripts, &registry]() {
+                scripts.Run(registry, 1.0f / 60.0f);
+                DoNotOptimize(&registry);
+            });
+        }
+    }
+}
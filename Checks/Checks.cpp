@@ -0,0 +1,37 @@
+#include "pch.h"
+#include "checks.h"
+#include <iostream>
+
+/// <summary>
+/// Checks of Core that need neither a window nor a device. Exits with 1 if any check failed.
+/// --filter <text>     only the checks whose name contains text
+/// </summary>
+int main(int argc, char** argv)
+{
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else {
+            std::cerr << "unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    checks::CheckRunner runner(filter, std::cout);
+    checks::RunSkinningChecks(runner);
+    checks::RunAnimationLodChecks(runner);
+    checks::RunAllocatorChecks(runner);
+    checks::RunDeferredReleaseChecks(runner);
+    checks::RunDescriptorChecks(runner);
+    checks::RunRecordingPlanChecks(runner);
+
+    std::cout << runner.GetRunCount() << " checks, " << runner.GetFailedCount() << " failed, "
+        << runner.GetSkippedCount() << " skipped" << std::endl;
+    if (runner.GetRunCount() == 0) {
+        std::cerr << "no check matches " << filter << std::endl;
+        return 1;
+    }
+    return runner.GetFailedCount() > 0 ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+#include "pch.h"
+#include "checks.h"
+#include "../Core/memory_pool.h"
+#include "../Core/tlsf_allocator.h"
+#include <map>
+
+namespace
+{
+    constexpr uint32_t STEP_COUNT = 5000;
+
+    /// <summary>
+    /// Mostly allocations smaller than a few granules, now and then one of a good part of the heap, so that
+    /// both the splits of small blocks and the failures of big ones happen.
+    /// </summary>
+    uint64_t RandomSize(std::mt19937& rng, uint64_t granularity, uint64_t heapSize)
+    {
+        if (rng() % 16 == 0) {
+            return 1 + rng() % (heapSize / 4);
+        }
+        return 1 + rng() % (granularity * 8);
+    }
+
+    /// <summary>
+    /// Whether [offset, offset + size) overlaps an allocation of live, which is offset -> size.
+    /// </summary>
+    bool Overlaps(const std::map<uint64_t, uint64_t>& live, uint64_t offset, uint64_t size)
+    {
+        const auto next = live.lower_bound(offset);
+        if (next != live.end() && next->first < offset + size) {
+            return true;
+        }
+        if (next != live.begin()) {
+            const auto previous = std::prev(next);
+            return previous->first + previous->second > offset;
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Random allocations and frees, about as many of each, with every invariant of the allocator checked
+    /// after each step: Validate, alignment, bounds, no overlaps and the used bytes.
+    /// </summary>
+    void CheckTlsfRandomized(checks::CheckRunner& runner, uint64_t heapSize, uint64_t granularity, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        common::TlsfAllocator allocator(heapSize, granularity);
+        std::map<uint64_t, uint64_t> live;
+        std::vector<uint64_t> offsets;
+        uint64_t used = 0;
+        for (uint32_t step = 0; step < STEP_COUNT; step++) {
+            const std::string at = "step " + std::to_string(step);
+            if (offsets.empty() || rng() % 100 < 55) {
+                const uint64_t size = RandomSize(rng, granularity, heapSize);
+                const uint64_t largestFree = allocator.GetLargestFreeRegion();
+                const uint64_t offset = allocator.Allocate(size);
+                if (offset == common::TlsfAllocator::INVALID_OFFSET) {
+                    runner.Expect(largestFree < allocator.AlignedSize(size), at + ": " + std::to_string(size) +
+                        " bytes failed with a free region of " + std::to_string(largestFree));
+                }
+                else {
+                    const uint64_t alignedSize = allocator.AlignedSize(size);
+                    runner.Expect(offset % granularity == 0, at + ": unaligned offset " + std::to_string(offset));
+                    runner.Expect(offset + alignedSize <= allocator.GetSize(), at + ": allocation past the end of the heap");
+                    runner.Expect(!Overlaps(live, offset, alignedSize), at + ": allocation at " +
+                        std::to_string(offset) + " overlaps another one");
+                    live[offset] = alignedSize;
+                    offsets.push_back(offset);
+                    used += alignedSize;
+                }
+            }
+            else {
+                const size_t index = rng() % offsets.size();
+                const uint64_t offset = offsets[index];
+                allocator.Free(offset);
+                used -= live[offset];
+                live.erase(offset);
+                offsets[index] = offsets.back();
+                offsets.pop_back();
+            }
+            if (!runner.Expect(allocator.Validate(), at + ": Validate failed")) {
+                return;
+            }
+            runner.Expect(allocator.GetUsed() == used, at + ": used " + std::to_string(allocator.GetUsed()) +
+                ", expected " + std::to_string(used));
+            runner.Expect(allocator.GetAllocationCount() == live.size(), at + ": wrong allocation count");
+        }
+        //with everything freed the neighbours must have merged back into a single region
+        for (uint64_t offset : offsets) {
+            allocator.Free(offset);
+        }
+        runner.Expect(allocator.Validate(), "Validate failed after freeing everything");
+        runner.Expect(allocator.IsEmpty(), "not empty after freeing everything");
+        runner.Expect(allocator.GetFreeRegionCount() == 1 && allocator.GetLargestFreeRegion() == allocator.GetSize(),
+            "the free regions didn't merge back into one");
+    }
+
+    /// <summary>
+    /// Random allocations, frees and defragmentations on a pool, blocks added when nothing fits. Each
+    /// allocation must be inside its block and overlap nothing, and the stats must add up.
+    /// </summary>
+    void CheckMemoryPoolRandomized(checks::CheckRunner& runner, uint32_t seed)
+    {
+        constexpr uint64_t BLOCK_SIZE = 1024 * 1024;
+        constexpr uint64_t GRANULARITY = 4096;
+        std::mt19937 rng(seed);
+        common::MemoryPoolCore pool(BLOCK_SIZE, GRANULARITY);
+        std::map<uint32_t, std::map<uint64_t, uint64_t>> live;
+        std::vector<common::PoolAllocation> allocations;
+        auto add = [&](const common::PoolAllocation& allocation, const std::string& at) {
+            std::map<uint64_t, uint64_t>& block = live[allocation.block];
+            runner.Expect(allocation.offset % GRANULARITY == 0, at + ": unaligned offset");
+            runner.Expect(allocation.offset + allocation.size <= pool.GetBlockSize(allocation.block),
+                at + ": allocation past the end of its block");
+            runner.Expect(!Overlaps(block, allocation.offset, allocation.size), at + ": allocation in block " +
+                std::to_string(allocation.block) + " at " + std::to_string(allocation.offset) + " overlaps another one");
+            block[allocation.offset] = allocation.size;
+            allocations.push_back(allocation);
+        };
+        auto remove = [&](size_t index) {
+            const common::PoolAllocation allocation = allocations[index];
+            pool.Free(allocation);
+            live[allocation.block].erase(allocation.offset);
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+        };
+        for (uint32_t step = 0; step < STEP_COUNT; step++) {
+            const std::string at = "step " + std::to_string(step);
+            const uint32_t action = rng() % 100;
+            if (allocations.empty() || action < 55) {
+                //a few are bigger than a block and get one of their own
+                const uint64_t size = RandomSize(rng, GRANULARITY, BLOCK_SIZE * 5);
+                common::PoolAllocation allocation = pool.Allocate(size);
+                if (!allocation.IsValid()) {
+                    allocation = pool.AllocateInBlock(pool.AddBlock(size), size);
+                }
+                if (!runner.Expect(allocation.IsValid(), at + ": a new block had no room for " + std::to_string(size))) {
+                    return;
+                }
+                add(allocation, at);
+            }
+            else if (action < 97) {
+                remove(rng() % allocations.size());
+            }
+            else if (action < 99) {
+                //moves the way the gpu allocator does: the destinations are allocated, then the sources freed
+                const std::vector<common::DefragmentationMove> moves = pool.PlanDefragmentation(allocations,
+                    BLOCK_SIZE / 2);
+                for (const common::DefragmentationMove& move : moves) {
+                    add(move.to, at);
+                    for (size_t i = 0; i < allocations.size(); i++) {
+                        if (allocations[i].block == move.from.block && allocations[i].offset == move.from.offset) {
+                            remove(i);
+                            break;
+                        }
+                    }
+                }
+            }
+            else {
+                for (uint32_t block : pool.ReleaseEmptyBlocks(1)) {
+                    runner.Expect(live[block].empty(), at + ": released block " + std::to_string(block) +
+                        " had allocations");
+                    live.erase(block);
+                }
+            }
+            uint64_t used = 0;
+            for (const auto& block : live) {
+                for (const auto& allocation : block.second) {
+                    used += allocation.second;
+                }
+            }
+            const common::PoolStats stats = pool.GetStats();
+            runner.Expect(stats.usedBytes == used, at + ": used " + std::to_string(stats.usedBytes) + ", expected " +
+                std::to_string(used));
+            runner.Expect(stats.allocationCount == allocations.size(), at + ": wrong allocation count");
+        }
+        while (!allocations.empty()) {
+            remove(allocations.size() - 1);
+        }
+        pool.ReleaseEmptyBlocks(0);
+        const common::PoolStats stats = pool.GetStats();
+        runner.Expect(stats.blockCount == 0 && stats.reservedBytes == 0, "blocks left after releasing all of them");
+    }
+}
+
+void checks::RunAllocatorChecks(CheckRunner& runner)
+{
+    runner.Run("Allocator/TlsfRandomized/small", [&runner]() {
+        CheckTlsfRandomized(runner, 1024 * 1024, 256, 1);
+    });
+    runner.Run("Allocator/TlsfRandomized/heap", [&runner]() {
+        //the d3d12 placement alignment, in a heap of the size the gpu allocator uses
+        CheckTlsfRandomized(runner, 64 * 1024 * 1024, 64 * 1024, 2);
+    });
+    runner.Run("Allocator/TlsfRandomized/unaligned", [&runner]() {
+        //a heap that isn't a power of two, nor a multiple of it
+        CheckTlsfRandomized(runner, 3 * 1000 * 1000 + 768, 256, 3);
+    });
+    runner.Run("Allocator/MemoryPoolRandomized", [&runner]() { CheckMemoryPoolRandomized(runner, 4); });
+}
@@ -0,0 +1,257 @@
+#include "pch.h"
+#include "checks.h"
+#include "../Core/animation_lod.h"
+#include "../Core/worker_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    using common::AnimationLodTier;
+
+    constexpr float DELTA_TIME = 1.0f / 60.0f;
+    constexpr uint32_t BLEND_FRAME_COUNT = 200;
+    //what the blend between two evaluations may differ from evaluating every frame
+    constexpr double BLEND_TOLERANCE = 1e-5;
+    constexpr uint32_t CHAIN_BONE_COUNT = 8;
+
+    std::string GetTierName(AnimationLodTier tier)
+    {
+        const char* names[] = { "EveryFrame", "Every2ndFrame", "Every4thFrame" };
+        return names[static_cast<uint32_t>(tier)];
+    }
+
+    void ExpectTier(checks::CheckRunner& runner, const common::AnimationLodSettings& settings, float screenSize,
+        AnimationLodTier current, AnimationLodTier expected)
+    {
+        const AnimationLodTier tier = common::SelectLodTier(settings, screenSize, current);
+        runner.Expect(tier == expected, "screen size " + std::to_string(screenSize) + " from " +
+            GetTierName(current) + " gave " + GetTierName(tier) + ", expected " + GetTierName(expected));
+    }
+
+    /// <summary>
+    /// A chain of bones, each one moving and turning slowly over a 10 second clip. The translations are linear in
+    /// time, so a blend evaluated at the wrong time or with the wrong weight shows, and the rotations are slow
+    /// enough for the lerp of the matrices to stay close to the slerp.
+    /// </summary>
+    struct ChainCharacter
+    {
+        common::Skeleton skeleton;
+        common::AnimationClip clip;
+        std::vector<int32_t> channelBones;
+
+        ChainCharacter()
+        {
+            using namespace DirectX;
+            std::vector<common::SkeletonBone> bones(CHAIN_BONE_COUNT);
+            for (uint32_t b = 0; b < CHAIN_BONE_COUNT; b++) {
+                bones[b].name = "bone_" + std::to_string(b);
+                bones[b].parent = static_cast<int32_t>(b) - 1;
+                bones[b].position = XMFLOAT3(0, 0.5f, 0);
+            }
+            std::vector<uint32_t> jointBones(CHAIN_BONE_COUNT);
+            std::iota(jointBones.begin(), jointBones.end(), 0u);
+            XMFLOAT4X4 identity;
+            XMStoreFloat4x4(&identity, XMMatrixIdentity());
+            skeleton = common::BuildSkeleton(bones, jointBones,
+                std::vector<XMFLOAT4X4>(CHAIN_BONE_COUNT, identity));
+            clip.duration = 10.0f;
+            for (uint32_t b = 0; b < CHAIN_BONE_COUNT; b++) {
+                common::TransformTracks tracks;
+                tracks.position.times = { 0.0f, clip.duration };
+                tracks.position.values = { XMFLOAT3(0, 0.5f, 0), XMFLOAT3(1.0f, 0.5f, -0.5f * b) };
+                XMFLOAT4 start, end;
+                XMStoreFloat4(&start, XMQuaternionIdentity());
+                XMStoreFloat4(&end, XMQuaternionRotationRollPitchYaw(0.02f * b, 0.03f, 0.0f));
+                tracks.rotation.times = { 0.0f, clip.duration };
+                tracks.rotation.values = { start, end };
+                clip.channels.push_back({ bones[b].name, tracks });
+            }
+            channelBones = common::BindClip(skeleton, clip);
+        }
+    };
+
+    /// <summary>
+    /// The screen size of a character at a frame of the blend check, it goes over all the tiers and back, with
+    /// an off-screen gap in the far tier. 0 means not visible.
+    /// </summary>
+    float GetScheduledScreenSize(uint32_t frame)
+    {
+        if (frame < 40) {
+            return 0.5f;
+        }
+        if (frame < 80) {
+            return 0.1f;
+        }
+        if (frame < 120 || (frame >= 140 && frame < 170)) {
+            return 0.03f;
+        }
+        if (frame < 140) {
+            return 0;
+        }
+        return 0.5f;
+    }
+
+    void CheckHysteresis(checks::CheckRunner& runner)
+    {
+        common::AnimationLodSettings settings;
+        //moving to a coarser tier takes the plain thresholds
+        ExpectTier(runner, settings, 0.2f, AnimationLodTier::EveryFrame, AnimationLodTier::EveryFrame);
+        ExpectTier(runner, settings, 0.19f, AnimationLodTier::EveryFrame, AnimationLodTier::Every2ndFrame);
+        ExpectTier(runner, settings, 0.08f, AnimationLodTier::Every2ndFrame, AnimationLodTier::Every2ndFrame);
+        ExpectTier(runner, settings, 0.079f, AnimationLodTier::Every2ndFrame, AnimationLodTier::Every4thFrame);
+        ExpectTier(runner, settings, 0.05f, AnimationLodTier::EveryFrame, AnimationLodTier::Every4thFrame);
+        //moving to a finer one takes them 15% higher
+        ExpectTier(runner, settings, 0.22f, AnimationLodTier::Every2ndFrame, AnimationLodTier::Every2ndFrame);
+        ExpectTier(runner, settings, 0.231f, AnimationLodTier::Every2ndFrame, AnimationLodTier::EveryFrame);
+        ExpectTier(runner, settings, 0.09f, AnimationLodTier::Every4thFrame, AnimationLodTier::Every4thFrame);
+        ExpectTier(runner, settings, 0.093f, AnimationLodTier::Every4thFrame, AnimationLodTier::Every2ndFrame);
+        ExpectTier(runner, settings, 0.25f, AnimationLodTier::Every4thFrame, AnimationLodTier::EveryFrame);
+        //a character wobbling around each border switches once, not every frame
+        for (const float threshold : { settings.everyFrameScreenSize, settings.every2ndFrameScreenSize }) {
+            AnimationLodTier tier = threshold == settings.everyFrameScreenSize ? AnimationLodTier::EveryFrame :
+                AnimationLodTier::Every2ndFrame;
+            uint32_t switches = 0;
+            for (uint32_t frame = 0; frame < 20; frame++) {
+                const float screenSize = threshold * (frame % 2 == 0 ? 0.97f : 1.05f);
+                const AnimationLodTier next = common::SelectLodTier(settings, screenSize, tier);
+                switches += next != tier ? 1 : 0;
+                tier = next;
+            }
+            runner.Expect(switches == 1, "a character at the " + std::to_string(threshold) + " border switched " +
+                std::to_string(switches) + " times");
+        }
+    }
+
+    void CheckPhaseStagger(checks::CheckRunner& runner)
+    {
+        for (const AnimationLodTier tier : { AnimationLodTier::Every2ndFrame, AnimationLodTier::Every4thFrame }) {
+            const uint32_t interval = common::GetUpdateInterval(tier);
+            std::vector<common::AnimationLodState> states(interval);
+            std::vector<uint32_t> lastEvaluation(interval, 0);
+            for (uint32_t frame = 0; frame < 4 * interval; frame++) {
+                uint32_t evaluations = 0;
+                for (uint32_t phase = 0; phase < interval; phase++) {
+                    const common::AnimationLodStep step = common::AdvanceAnimationLod(states[phase], tier, true, phase);
+                    if (frame == 0) {
+                        //all of them start with a refresh, then each one has its own frame
+                        runner.Expect(step.refresh && step.evaluate, "the first frame didn't refresh");
+                        continue;
+                    }
+                    if (!step.evaluate) {
+                        const uint32_t sinceEvaluation = frame - lastEvaluation[phase];
+                        runner.ExpectNear(step.blend, static_cast<double>(sinceEvaluation) / states[phase].span,
+                            1e-6, GetTierName(tier) + " blend at frame " + std::to_string(frame));
+                        continue;
+                    }
+                    evaluations++;
+                    runner.Expect(!step.refresh, GetTierName(tier) + " refreshed in the same tier");
+                    runner.Expect(step.lookahead == interval, GetTierName(tier) + " looked " +
+                        std::to_string(step.lookahead) + " frames ahead");
+                    const uint32_t expected = lastEvaluation[phase] == 0 ? interval - phase % interval : interval;
+                    runner.Expect(frame - lastEvaluation[phase] == expected, GetTierName(tier) + " phase " +
+                        std::to_string(phase) + " evaluated " + std::to_string(frame - lastEvaluation[phase]) +
+                        " frames after the last time, expected " + std::to_string(expected));
+                    lastEvaluation[phase] = frame;
+                }
+                runner.Expect(frame == 0 || evaluations == 1, GetTierName(tier) + " frame " + std::to_string(frame) +
+                    " had " + std::to_string(evaluations) + " evaluations, the phases should spread them one a frame");
+            }
+        }
+    }
+
+    void CheckRefresh(checks::CheckRunner& runner)
+    {
+        common::AnimationLodState state;
+        common::AnimationLodStep step = common::AdvanceAnimationLod(state, AnimationLodTier::Every2ndFrame, true, 0);
+        runner.Expect(step.refresh, "the first frame in a tier didn't refresh");
+        for (uint32_t frame = 0; frame < 5; frame++) {
+            step = common::AdvanceAnimationLod(state, AnimationLodTier::Every2ndFrame, true, 0);
+            runner.Expect(!step.refresh, "refreshed while staying in the tier");
+        }
+        //off-screen it costs nothing, and it starts over when it comes back
+        for (uint32_t frame = 0; frame < 3; frame++) {
+            step = common::AdvanceAnimationLod(state, AnimationLodTier::Every2ndFrame, false, 0);
+            runner.Expect(step.skip && !step.evaluate && !step.refresh, "an invisible character wasn't skipped");
+        }
+        step = common::AdvanceAnimationLod(state, AnimationLodTier::Every2ndFrame, true, 0);
+        runner.Expect(step.refresh && step.evaluate, "didn't refresh on re-entry");
+        step = common::AdvanceAnimationLod(state, AnimationLodTier::Every2ndFrame, true, 0);
+        runner.Expect(!step.refresh, "refreshed twice on re-entry");
+        //a tier change discards the blend in flight
+        step = common::AdvanceAnimationLod(state, AnimationLodTier::Every4thFrame, true, 0);
+        runner.Expect(step.refresh && step.evaluate && step.lookahead == 4, "didn't refresh on the tier change");
+        //the full rate tier evaluates into the shown matrices, there's nothing to refresh
+        step = common::AdvanceAnimationLod(state, AnimationLodTier::EveryFrame, true, 0);
+        runner.Expect(step.evaluate && !step.refresh && step.lookahead == 0, "the full rate tier blended");
+        step = common::AdvanceAnimationLod(state, AnimationLodTier::Every2ndFrame, true, 0);
+        runner.Expect(step.refresh, "didn't refresh going back to a blended tier");
+    }
+
+    void CheckBlendAgainstFullRate(checks::CheckRunner& runner)
+    {
+        const ChainCharacter chain;
+        common::AnimationLodSettings settings;
+        common::WorkerPool workerPool(2);
+        constexpr uint32_t CHARACTER_COUNT = 4;
+        std::vector<common::AnimationLodState> states(CHARACTER_COUNT);
+        std::vector<std::vector<common::TransformCursors>> cursors(CHARACTER_COUNT);
+        std::vector<common::Pose> poses(CHARACTER_COUNT, chain.skeleton.restPose);
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> shown(CHARACTER_COUNT);
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> previous(CHARACTER_COUNT);
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> next(CHARACTER_COUNT);
+        std::vector<std::vector<common::TransformCursors>> referenceCursors(CHARACTER_COUNT);
+        std::vector<common::Pose> referencePoses(CHARACTER_COUNT, chain.skeleton.restPose);
+        std::vector<std::vector<DirectX::XMFLOAT4X4>> reference(CHARACTER_COUNT);
+        double maxError = 0;
+        uint32_t comparedFrames = 0;
+        for (uint32_t frame = 0; frame < BLEND_FRAME_COUNT; frame++) {
+            std::vector<common::LodCrowdCharacter> characters;
+            std::vector<common::CrowdCharacter> fullRate;
+            for (uint32_t c = 0; c < CHARACTER_COUNT; c++) {
+                const float time = frame * DELTA_TIME + c * 0.1f;
+                //each character a few frames off the others, so they cross the borders at different phases
+                const float screenSize = GetScheduledScreenSize(frame + c * 3);
+                common::LodCrowdCharacter character;
+                character.character = { &chain.skeleton, &chain.clip, &chain.channelBones, time, &cursors[c],
+                    &poses[c], &shown[c] };
+                character.settings = &settings;
+                character.screenSize = screenSize;
+                character.visible = screenSize > 0;
+                character.phase = c;
+                character.state = &states[c];
+                character.previous = &previous[c];
+                character.next = &next[c];
+                characters.push_back(character);
+                fullRate.push_back({ &chain.skeleton, &chain.clip, &chain.channelBones, time, &referenceCursors[c],
+                    &referencePoses[c], &reference[c] });
+            }
+            common::AnimateCrowdLod(workerPool, characters, DELTA_TIME);
+            common::AnimateCrowd(workerPool, fullRate);
+            for (uint32_t c = 0; c < CHARACTER_COUNT; c++) {
+                if (!characters[c].visible) {
+                    continue;
+                }
+                comparedFrames++;
+                for (size_t j = 0; j < reference[c].size(); j++) {
+                    const float* a = &shown[c][j].m[0][0];
+                    const float* b = &reference[c][j].m[0][0];
+                    for (int i = 0; i < 16; i++) {
+                        maxError = std::max(maxError, static_cast<double>(std::abs(a[i] - b[i])));
+                    }
+                }
+            }
+        }
+        runner.Expect(comparedFrames > BLEND_FRAME_COUNT, "too few visible frames to compare");
+        runner.ExpectNear(maxError, 0.0, BLEND_TOLERANCE, "largest difference of a skin matrix element");
+    }
+}
+
+void checks::RunAnimationLodChecks(CheckRunner& runner)
+{
+    runner.Run("AnimationLod/Hysteresis", [&runner]() { CheckHysteresis(runner); });
+    runner.Run("AnimationLod/PhaseStagger", [&runner]() { CheckPhaseStagger(runner); });
+    runner.Run("AnimationLod/Refresh", [&runner]() { CheckRefresh(runner); });
+    runner.Run("AnimationLod/BlendVsFullRate", [&runner]() { CheckBlendAgainstFullRate(runner); });
+}
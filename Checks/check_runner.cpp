@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "check_runner.h"
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+    //a check that fails in a loop says the first few, the rest only count
+    constexpr uint32_t MAX_REPORTED_FAILURES = 10;
+}
+
+checks::CheckRunner::CheckRunner(const std::string& filter, std::ostream& out)
+    :filter(filter), out(out)
+{
+}
+
+bool checks::CheckRunner::Matches(const std::string& name) const
+{
+    return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void checks::CheckRunner::Run(const std::string& name, const std::function<void()>& body)
+{
+    if (!Matches(name)) {
+        return;
+    }
+    current = name;
+    currentFailures = 0;
+    currentSkipped = false;
+    runCount++;
+    try {
+        body();
+    }
+    catch (const std::exception& e) {
+        Expect(false, std::string("threw ") + e.what());
+    }
+    if (currentSkipped) {
+        skippedCount++;
+        return;
+    }
+    if (currentFailures > 0) {
+        failedCount++;
+        out << "[FAIL] " << name << ": " << currentFailures << " failed expectations" << std::endl;
+        return;
+    }
+    out << "[ OK ] " << name << std::endl;
+}
+
+bool checks::CheckRunner::Expect(bool condition, const std::string& what)
+{
+    if (condition) {
+        return true;
+    }
+    currentFailures++;
+    if (currentFailures <= MAX_REPORTED_FAILURES) {
+        out << "       " << current << ": " << what << std::endl;
+    }
+    return false;
+}
+
+bool checks::CheckRunner::ExpectNear(double actual, double expected, double tolerance, const std::string& what)
+{
+    std::ostringstream message;
+    message << what << ": " << actual << ", expected " << expected << " within " << tolerance;
+    return Expect(std::abs(actual - expected) <= tolerance, message.str());
+}
+
+void checks::CheckRunner::Skip(const std::string& why)
+{
+    currentSkipped = true;
+    out << "[SKIP] " << current << ": " << why << std::endl;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace checks
+{
+    /// <summary>
+    /// Runs named checks and counts the ones that failed. A check fails when one of its Expect calls does, or
+    /// when it throws. The process exits with an error if any failed, so that ctest and scripts see it.
+    /// </summary>
+    class CheckRunner
+    {
+    public:
+        /// <summary>
+        /// Only the checks whose name contains filter run, an empty one runs all.
+        /// </summary>
+        CheckRunner(const std::string& filter, std::ostream& out);
+        bool Matches(const std::string& name) const;
+        /// <summary>
+        /// Runs body if name matches the filter. It reports through Expect and ExpectNear.
+        /// </summary>
+        void Run(const std::string& name, const std::function<void()>& body);
+        /// <summary>
+        /// Fails the running check with what if condition is false. Returns condition.
+        /// </summary>
+        bool Expect(bool condition, const std::string& what);
+        /// <summary>
+        /// Fails the running check unless actual is within tolerance of expected.
+        /// </summary>
+        bool ExpectNear(double actual, double expected, double tolerance, const std::string& what);
+        /// <summary>
+        /// Fails the running check unless body throws an Exception.
+        /// </summary>
+        template<typename Exception>
+        bool ExpectThrows(const std::function<void()>& body, const std::string& what)
+        {
+            try {
+                body();
+            }
+            catch (const Exception&) {
+                return true;
+            }
+            return Expect(false, what + " didn't throw");
+        }
+        /// <summary>
+        /// Ends the running check as skipped, for the ones this machine can't run, like a kernel the cpu lacks.
+        /// </summary>
+        void Skip(const std::string& why);
+        uint32_t GetRunCount() const { return runCount; }
+        uint32_t GetFailedCount() const { return failedCount; }
+        uint32_t GetSkippedCount() const { return skippedCount; }
+    private:
+        const std::string filter;
+        std::ostream& out;
+        std::string current;
+        uint32_t currentFailures = 0;
+        bool currentSkipped = false;
+        uint32_t runCount = 0;
+        uint32_t failedCount = 0;
+        uint32_t skippedCount = 0;
+    };
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "check_runner.h"
+
+namespace checks
+{
+    /// <summary>
+    /// The SSE, AVX2 and parallel skinning against the scalar kernel.
+    /// </summary>
+    void RunSkinningChecks(CheckRunner& runner);
+    /// <summary>
+    /// The tiers, phases and refreshes of the animation LOD, and its blends against evaluating every frame.
+    /// </summary>
+    void RunAnimationLodChecks(CheckRunner& runner);
+    /// <summary>
+    /// TlsfAllocator and MemoryPoolCore through random allocations and frees, validated after every step.
+    /// </summary>
+    void RunAllocatorChecks(CheckRunner& runner);
+    /// <summary>
+    /// DeferredReleaseQueue and RecyclerCore on a fake timeline: nothing goes before its value, in order after.
+    /// </summary>
+    void RunDeferredReleaseChecks(CheckRunner& runner);
+    /// <summary>
+    /// DescriptorAllocator: stale handles, range reuse, the transient regions and running out of space. SlotAllocator:
+    /// stale handles, reuse, blocks and the high water mark.
+    /// </summary>
+    void RunDescriptorChecks(CheckRunner& runner);
+    /// <summary>
+    /// RecordingPlan's split of the passes in segments, and ParallelCommandRecorder's lists on the recording device.
+    /// </summary>
+    void RunRecordingPlanChecks(CheckRunner& runner);
+}
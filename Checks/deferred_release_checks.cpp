@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "checks.h"
+#include "../Core/deferred_release.h"
+#include "../Core/recycler_core.h"
+#include <algorithm>
+
+namespace
+{
+    /// <summary>
+    /// A timeline the check moves by hand, standing in for the d3d fence.
+    /// </summary>
+    class FakeTimeline : public common::FenceTimeline
+    {
+    public:
+        uint64_t GetCompletedValue() const override { return completed; }
+        uint64_t GetNextValue() const override { return next; }
+        uint64_t completed = 0;
+        uint64_t next = 1;
+    };
+
+    /// <summary>
+    /// An object that says when it's released: the last copy going away writes its id to the log.
+    /// </summary>
+    using TrackedObject = std::shared_ptr<uint32_t>;
+    TrackedObject MakeTracked(uint32_t id, std::shared_ptr<std::vector<uint32_t>> releaseLog)
+    {
+        return TrackedObject(new uint32_t(id), [releaseLog](uint32_t* object) {
+            releaseLog->push_back(*object);
+            delete object;
+        });
+    }
+
+    /// <summary>
+    /// Random releases, some at values older than the last one, and a timeline that advances by random
+    /// steps. After each Collect, what was released must have had its value reached, everything that was
+    /// reached must be released, and the releases must be in the order they were queued.
+    /// </summary>
+    void CheckDeferredReleaseQueue(checks::CheckRunner& runner)
+    {
+        std::mt19937 rng(5);
+        FakeTimeline timeline;
+        auto releaseLog = std::make_shared<std::vector<uint32_t>>();
+        common::DeferredReleaseQueue<TrackedObject> queue(timeline);
+        //the value each item was queued with, and the one it waits for after the queue bumped it
+        std::vector<uint64_t> requested;
+        std::vector<uint64_t> effective;
+        for (uint32_t frame = 0; frame < 500; frame++) {
+            const uint32_t releases = rng() % 4;
+            for (uint32_t r = 0; r < releases; r++) {
+                const uint32_t id = static_cast<uint32_t>(requested.size());
+                uint64_t value = timeline.next;
+                if (rng() % 4 == 0) {
+                    //a resource whose last use was a few submissions ago
+                    value -= std::min<uint64_t>(value - 1, rng() % 3);
+                    queue.Release(MakeTracked(id, releaseLog), value);
+                }
+                else {
+                    queue.Release(MakeTracked(id, releaseLog));
+                }
+                requested.push_back(value);
+                effective.push_back(effective.empty() ? value : std::max(effective.back(), value));
+            }
+            timeline.next++;
+            //the gpu lags behind, at most a few submissions
+            const uint64_t completed = std::min(timeline.next - 1, timeline.completed + rng() % 3);
+            timeline.completed = std::max(timeline.completed, completed);
+            const size_t releasedBefore = releaseLog->size();
+            const size_t collected = queue.Collect();
+            runner.Expect(collected == releaseLog->size() - releasedBefore, "Collect miscounted");
+            const std::string at = "frame " + std::to_string(frame);
+            for (size_t i = releasedBefore; i < releaseLog->size(); i++) {
+                const uint32_t id = (*releaseLog)[i];
+                runner.Expect(id == i, at + ": released " + std::to_string(id) + " out of order, expected " +
+                    std::to_string(i));
+                runner.Expect(requested[id] <= timeline.completed, at + ": released " + std::to_string(id) +
+                    " waiting for " + std::to_string(requested[id]) + " with the timeline at " +
+                    std::to_string(timeline.completed));
+            }
+            const size_t reached = std::upper_bound(effective.begin(), effective.end(), timeline.completed) -
+                effective.begin();
+            runner.Expect(releaseLog->size() == reached, at + ": " + std::to_string(releaseLog->size()) +
+                " released, " + std::to_string(reached) + " had their value reached");
+            runner.Expect(queue.GetPendingCount() == requested.size() - reached, at + ": wrong pending count");
+        }
+        timeline.completed = timeline.next - 1;
+        queue.Collect();
+        runner.Expect(releaseLog->size() == requested.size() && queue.GetPendingCount() == 0,
+            "items left once the timeline reached everything");
+    }
+
+    /// <summary>
+    /// Objects and upload buffers through RecyclerCore: neither is released nor pooled before its value,
+    /// a pooled buffer is handed out again, and a full class drops what comes back.
+    /// </summary>
+    void CheckRecyclerCore(checks::CheckRunner& runner)
+    {
+        FakeTimeline timeline;
+        auto releaseLog = std::make_shared<std::vector<uint32_t>>();
+        constexpr size_t MAX_PER_CLASS = 2;
+        common::RecyclerCore<TrackedObject, TrackedObject> recycler(timeline, 256, MAX_PER_CLASS);
+
+        recycler.DeferRelease(MakeTracked(0, releaseLog));
+        recycler.DeferRelease(MakeTracked(1, releaseLog), 3);
+        recycler.DeferRelease(MakeTracked(2, releaseLog), 2);
+        recycler.Collect();
+        runner.Expect(releaseLog->empty(), "released before the timeline moved");
+        timeline.completed = 1;
+        recycler.Collect();
+        runner.Expect(*releaseLog == std::vector<uint32_t>{ 0 }, "only the object of value 1 should be released");
+        timeline.completed = 2;
+        recycler.Collect();
+        //2 was queued after 3, it waits for it
+        runner.Expect(releaseLog->size() == 1, "released ahead of an older item");
+        timeline.completed = 3;
+        recycler.Collect();
+        runner.Expect(*releaseLog == std::vector<uint32_t>({ 0, 1, 2 }), "not released in queue order");
+
+        const uint64_t classSize = recycler.GetUploadClassSize(1000);
+        runner.Expect(classSize == 1024, "a 1000 byte upload should be in the 1024 class");
+        runner.Expect(!recycler.TakeUploadBuffer(1000).has_value(), "the empty pool handed out a buffer");
+        releaseLog->clear();
+        for (uint32_t id = 10; id < 13; id++) {
+            recycler.RecycleUploadBuffer(MakeTracked(id, releaseLog), classSize, 5);
+        }
+        timeline.completed = 4;
+        recycler.Collect();
+        runner.Expect(!recycler.TakeUploadBuffer(1000).has_value(), "a buffer was pooled before its copy was done");
+        runner.Expect(recycler.GetPendingCount() == 3, "the buffers should still be pending");
+        timeline.completed = 5;
+        recycler.Collect();
+        //the class keeps two, the third is dropped
+        runner.Expect(*releaseLog == std::vector<uint32_t>{ 12 }, "the full class should drop the last buffer");
+        runner.Expect(recycler.GetUploadPoolStats().discarded == 1, "the dropped buffer wasn't counted");
+        const std::optional<TrackedObject> pooled = recycler.TakeUploadBuffer(700);
+        runner.Expect(pooled.has_value() && (**pooled == 10 || **pooled == 11),
+            "a pooled buffer of the class wasn't handed out again");
+        runner.Expect(!recycler.TakeUploadBuffer(4000).has_value(), "a bigger class took a smaller buffer");
+        recycler.Clear();
+        runner.Expect(releaseLog->size() == 2, "Clear didn't drop the pooled buffer");
+    }
+}
+
+void checks::RunDeferredReleaseChecks(CheckRunner& runner)
+{
+    runner.Run("DeferredRelease/Queue", [&runner]() { CheckDeferredReleaseQueue(runner); });
+    runner.Run("DeferredRelease/RecyclerCore", [&runner]() { CheckRecyclerCore(runner); });
+}
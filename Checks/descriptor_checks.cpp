@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "checks.h"
+#include "../Core/descriptor_allocator.h"
+#include "../Core/slot_allocator.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    using transforms::DescriptorAllocator;
+    using transforms::DescriptorHandle;
+    using transforms::SlotAllocator;
+    using transforms::SlotHandle;
+
+    void CheckStaleHandles(checks::CheckRunner& runner)
+    {
+        DescriptorAllocator allocator(0, 8, 2, 4, 2);
+        const DescriptorHandle first = allocator.Allocate();
+        runner.Expect(allocator.IsAlive(first), "a new handle isn't alive");
+        allocator.Free(first);
+        runner.Expect(!allocator.IsAlive(first), "a freed handle is still alive");
+        runner.ExpectThrows<std::runtime_error>([&]() { allocator.Free(first); }, "freeing a handle twice");
+        //the free list hands the slot out again, with the generation bumped
+        const DescriptorHandle second = allocator.Allocate();
+        runner.Expect(second.index == first.index, "the freed slot wasn't reused");
+        runner.Expect(second.generation != first.generation, "the reused slot kept its generation");
+        runner.Expect(!allocator.IsAlive(first) && allocator.IsAlive(second),
+            "the old handle is alive again, or the new one isn't");
+        runner.ExpectThrows<std::runtime_error>([&]() { allocator.Free(first); }, "freeing the stale handle");
+        runner.Expect(allocator.IsAlive(second), "freeing the stale handle freed the new one");
+        const DescriptorHandle at = allocator.HandleAt(second.index);
+        runner.Expect(at.index == second.index && at.generation == second.generation && at.count == 1,
+            "HandleAt didn't give the live handle");
+        DescriptorHandle wrongCount = second;
+        wrongCount.count = 2;
+        runner.Expect(!allocator.IsAlive(wrongCount), "a handle with the wrong count is alive");
+        runner.Expect(!allocator.IsAlive(DescriptorHandle()), "the invalid handle is alive");
+    }
+
+    void CheckRangeReuse(checks::CheckRunner& runner)
+    {
+        DescriptorAllocator allocator(2, 8, 3, 4, 2);
+        const DescriptorHandle a = allocator.AllocateRange(4);
+        const DescriptorHandle single = allocator.Allocate();
+        const DescriptorHandle b = allocator.AllocateRange(3);
+        runner.Expect(a.index == 2 && single.index == 6 && b.index == 7, "the first page wasn't filled in order");
+        //the page still has a live descriptor, the freed range only goes to the free list as single slots
+        allocator.Free(a);
+        const DescriptorHandle c = allocator.AllocateRange(4);
+        runner.Expect(c.index == 10, "a range was taken from a page with a live descriptor in it, at " +
+            std::to_string(c.index));
+        runner.Expect(allocator.GetPagesOpened() == 2, "the range didn't open the second page");
+        //once the page is empty it's untouched space again, the whole of it fits a range
+        allocator.Free(single);
+        allocator.Free(b);
+        const DescriptorHandle d = allocator.AllocateRange(8);
+        runner.Expect(d.index == a.index, "the emptied page wasn't reused for a range");
+        runner.Expect(!allocator.IsAlive(a), "the old range handle is alive again");
+        runner.Expect(allocator.IsAlive(c) && allocator.IsAlive(d), "a live range isn't alive");
+        runner.Expect(allocator.GetPersistentInUse() == 12, "in use " +
+            std::to_string(allocator.GetPersistentInUse()) + ", expected 12");
+    }
+
+    void CheckTransient(checks::CheckRunner& runner)
+    {
+        constexpr uint32_t RESERVED = 2;
+        constexpr uint32_t PER_PAGE = 4;
+        constexpr uint32_t PAGES = 2;
+        constexpr uint32_t PER_FRAME = 5;
+        constexpr uint32_t FRAMES = 2;
+        DescriptorAllocator allocator(RESERVED, PER_PAGE, PAGES, PER_FRAME, FRAMES);
+        const uint32_t transientStart = RESERVED + PER_PAGE * PAGES;
+        runner.Expect(allocator.GetCapacity() == transientStart + PER_FRAME * FRAMES, "wrong capacity");
+        std::vector<DescriptorHandle> persistent;
+        for (uint32_t i = 0; i < PER_PAGE * PAGES; i++) {
+            persistent.push_back(allocator.Allocate());
+        }
+        for (uint32_t round = 0; round < 3; round++) {
+            for (uint32_t frame = 0; frame < FRAMES; frame++) {
+                allocator.BeginFrame(frame);
+                const uint32_t regionStart = transientStart + frame * PER_FRAME;
+                const uint32_t first = allocator.AllocateTransient(3);
+                const uint32_t second = allocator.AllocateTransient(2);
+                //every BeginFrame rewinds the region of its frame
+                runner.Expect(first == regionStart && second == regionStart + 3, "frame " + std::to_string(frame) +
+                    " got " + std::to_string(first) + " and " + std::to_string(second) + ", its region starts at " +
+                    std::to_string(regionStart));
+                for (const DescriptorHandle& handle : persistent) {
+                    runner.Expect(handle.index + handle.count <= first, "a transient range overlaps a persistent one");
+                }
+                runner.ExpectThrows<std::runtime_error>([&]() { allocator.AllocateTransient(1); },
+                    "allocating past the region of the frame");
+            }
+        }
+        runner.Expect(allocator.GetTransientHighWater() == PER_FRAME, "high water " +
+            std::to_string(allocator.GetTransientHighWater()) + ", expected " + std::to_string(PER_FRAME));
+        runner.ExpectThrows<std::out_of_range>([&]() { allocator.BeginFrame(FRAMES); }, "beginning a frame past the last");
+    }
+
+    void CheckOutOfSpace(checks::CheckRunner& runner)
+    {
+        DescriptorAllocator allocator(0, 4, 2, 4, 1);
+        std::vector<DescriptorHandle> handles;
+        for (uint32_t i = 0; i < 8; i++) {
+            handles.push_back(allocator.Allocate());
+        }
+        runner.ExpectThrows<std::runtime_error>([&]() { allocator.Allocate(); }, "allocating from full pages");
+        runner.ExpectThrows<std::runtime_error>([&]() { allocator.AllocateRange(2); }, "a range from full pages");
+        runner.ExpectThrows<std::length_error>([&]() { allocator.AllocateRange(5); }, "a range bigger than a page");
+        runner.ExpectThrows<std::invalid_argument>([&]() { allocator.AllocateRange(0); }, "an empty range");
+        //the failures changed nothing
+        runner.Expect(allocator.GetPersistentInUse() == 8, "a failed allocation changed the count in use");
+        for (const DescriptorHandle& handle : handles) {
+            runner.Expect(allocator.IsAlive(handle), "a failed allocation killed a live handle");
+        }
+        allocator.Free(handles[5]);
+        const DescriptorHandle again = allocator.Allocate();
+        runner.Expect(again.index == handles[5].index, "the slot freed from full pages wasn't reused");
+    }
+
+    /// <summary>
+    /// Random singles, ranges and frees: the live handles never overlap and the count in use adds up.
+    /// </summary>
+    void CheckRandomized(checks::CheckRunner& runner)
+    {
+        constexpr uint32_t PER_PAGE = 16;
+        constexpr uint32_t PAGES = 8;
+        DescriptorAllocator allocator(4, PER_PAGE, PAGES, 4, 2);
+        std::mt19937 rng(6);
+        std::vector<DescriptorHandle> live;
+        std::vector<bool> taken(4 + PER_PAGE * PAGES, false);
+        uint32_t inUse = 0;
+        for (uint32_t step = 0; step < 5000; step++) {
+            const std::string at = "step " + std::to_string(step);
+            if (live.empty() || rng() % 100 < 55) {
+                const uint32_t count = rng() % 3 == 0 ? 1 + rng() % 6 : 1;
+                DescriptorHandle handle;
+                try {
+                    handle = allocator.AllocateRange(count);
+                }
+                catch (const std::runtime_error&) {
+                    continue;
+                }
+                for (uint32_t i = 0; i < count; i++) {
+                    runner.Expect(handle.index + i >= 4, at + ": a handle in the reserved descriptors");
+                    runner.Expect(!taken[handle.index + i], at + ": descriptor " + std::to_string(handle.index + i) +
+                        " handed out twice");
+                    taken[handle.index + i] = true;
+                }
+                live.push_back(handle);
+                inUse += count;
+            }
+            else {
+                const size_t index = rng() % live.size();
+                allocator.Free(live[index]);
+                for (uint32_t i = 0; i < live[index].count; i++) {
+                    taken[live[index].index + i] = false;
+                }
+                inUse -= live[index].count;
+                live[index] = live.back();
+                live.pop_back();
+            }
+            runner.Expect(allocator.GetPersistentInUse() == inUse, at + ": wrong count in use");
+        }
+        for (const DescriptorHandle& handle : live) {
+            runner.Expect(allocator.IsAlive(handle), "a live handle isn't alive");
+        }
+    }
+
+    void CheckSlotReuse(checks::CheckRunner& runner)
+    {
+        SlotAllocator allocator(4, 2);
+        const SlotHandle first = allocator.Allocate();
+        runner.Expect(allocator.Free(first), "freeing a live slot failed");
+        runner.Expect(!allocator.IsAlive(first), "a freed slot is still alive");
+        runner.Expect(!allocator.Free(first), "a slot was freed twice");
+        const SlotHandle second = allocator.Allocate();
+        runner.Expect(second.index == first.index && second.generation != first.generation,
+            "the freed slot wasn't reused with a new generation");
+        runner.Expect(!allocator.Free(first), "the stale handle freed the slot that reused it");
+        runner.Expect(allocator.IsAlive(second) && allocator.GetUsed() == 1, "the reused slot isn't alive");
+        runner.Expect(!allocator.IsAlive(SlotHandle()) && !allocator.Free(SlotHandle()), "the invalid handle is alive");
+    }
+
+    void CheckSlotBlocks(checks::CheckRunner& runner)
+    {
+        SlotAllocator allocator(4, 2);
+        std::vector<SlotHandle> handles;
+        for (uint32_t i = 0; i < 4; i++) {
+            handles.push_back(allocator.Allocate());
+        }
+        runner.Expect(allocator.GetBlockCount() == 1, "a block was opened before the first one was full");
+        handles.push_back(allocator.Allocate());
+        runner.Expect(allocator.GetBlockCount() == 2 && handles.back().index == 4,
+            "the second block wasn't opened when the first one filled up");
+        for (uint32_t i = 0; i < 3; i++) {
+            handles.push_back(allocator.Allocate());
+        }
+        const SlotHandle full = allocator.Allocate();
+        runner.Expect(!full.IsValid(), "allocated past the last block");
+        runner.Expect(allocator.GetBlockCount() == 2 && allocator.GetUsed() == 8, "the failed allocation changed counts");
+        runner.Expect(allocator.Free(handles[2]), "freeing from full blocks failed");
+        runner.Expect(allocator.Allocate().index == handles[2].index, "the slot freed from full blocks wasn't reused");
+    }
+
+    void CheckSlotHighWaterAndReset(checks::CheckRunner& runner)
+    {
+        SlotAllocator allocator(8, 4);
+        std::mt19937 rng(8);
+        std::vector<SlotHandle> live;
+        uint32_t highWater = 0;
+        for (uint32_t step = 0; step < 2000; step++) {
+            if (live.empty() || rng() % 100 < 52) {
+                const SlotHandle handle = allocator.Allocate();
+                if (!handle.IsValid()) {
+                    runner.Expect(live.size() == allocator.GetCapacity(), "an allocation failed with free slots");
+                    continue;
+                }
+                for (const SlotHandle& other : live) {
+                    if (!runner.Expect(other.index != handle.index, "slot " + std::to_string(handle.index) +
+                        " handed out twice")) {
+                        return;
+                    }
+                }
+                live.push_back(handle);
+            }
+            else {
+                const size_t index = rng() % live.size();
+                runner.Expect(allocator.Free(live[index]), "freeing a live slot failed");
+                live[index] = live.back();
+                live.pop_back();
+            }
+            highWater = std::max(highWater, static_cast<uint32_t>(live.size()));
+            runner.Expect(allocator.GetUsed() == live.size(), "wrong used count");
+            runner.Expect(allocator.GetHighWaterMark() == highWater, "high water " +
+                std::to_string(allocator.GetHighWaterMark()) + ", expected " + std::to_string(highWater));
+        }
+        //everything becomes stale, the high water mark stays for sizing
+        allocator.Reset();
+        for (const SlotHandle& handle : live) {
+            runner.Expect(!allocator.IsAlive(handle), "a handle survived Reset");
+        }
+        runner.Expect(allocator.GetUsed() == 0 && allocator.GetHighWaterMark() == highWater,
+            "Reset didn't empty the slots, or lost the high water mark");
+        const SlotHandle first = allocator.Allocate();
+        runner.Expect(first.index == 0, "the first slot after Reset isn't 0");
+        for (const SlotHandle& handle : live) {
+            if (handle.index == first.index) {
+                runner.Expect(handle.generation != first.generation, "a slot kept its generation across Reset");
+            }
+        }
+    }
+}
+
+void checks::RunDescriptorChecks(CheckRunner& runner)
+{
+    runner.Run("Descriptors/StaleHandle", [&runner]() { CheckStaleHandles(runner); });
+    runner.Run("Descriptors/RangeReuse", [&runner]() { CheckRangeReuse(runner); });
+    runner.Run("Descriptors/Transient", [&runner]() { CheckTransient(runner); });
+    runner.Run("Descriptors/OutOfSpace", [&runner]() { CheckOutOfSpace(runner); });
+    runner.Run("Descriptors/Randomized", [&runner]() { CheckRandomized(runner); });
+    runner.Run("Descriptors/SlotReuse", [&runner]() { CheckSlotReuse(runner); });
+    runner.Run("Descriptors/SlotBlocks", [&runner]() { CheckSlotBlocks(runner); });
+    runner.Run("Descriptors/SlotHighWaterAndReset", [&runner]() { CheckSlotHighWaterAndReset(runner); });
+}
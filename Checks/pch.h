@@ -0,0 +1,12 @@
+#pragma once
+//the checks run on Core alone, nothing from Windows nor D3D12 in here
+#include <DirectXMath.h>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <random>
@@ -0,0 +1,198 @@
+#include "pch.h"
+#include "checks.h"
+#include "../Core/parallel_command_recorder.h"
+#include "../Core/recording_gfx_device.h"
+#include "../Core/recording_plan.h"
+#include <algorithm>
+
+namespace
+{
+    using common::RecordingPlan;
+    using common::RecordingSegment;
+
+    /// <summary>
+    /// The cost Partition gives an item, zero cost items still cost something to record.
+    /// </summary>
+    uint64_t SegmentCost(const std::vector<uint64_t>& itemCosts, const RecordingSegment& segment)
+    {
+        uint64_t cost = 0;
+        for (uint32_t i = segment.firstItem; i < segment.firstItem + segment.itemCount; i++) {
+            cost += std::max<uint64_t>(itemCosts[i], 1);
+        }
+        return cost;
+    }
+
+    /// <summary>
+    /// The segments of a pass cover its items once each, in order; there are at most maxSegments of them and
+    /// none is cheaper than minSegmentCost unless the whole pass is.
+    /// </summary>
+    void ExpectPartition(checks::CheckRunner& runner, const std::vector<RecordingSegment>& segments, uint32_t pass,
+        const std::vector<uint64_t>& itemCosts, uint32_t maxSegments, uint64_t minSegmentCost, const std::string& what)
+    {
+        if (itemCosts.empty()) {
+            runner.Expect(segments.empty(), what + ": an empty pass has segments");
+            return;
+        }
+        runner.Expect(!segments.empty(), what + ": no segments");
+        runner.Expect(segments.size() <= std::max(maxSegments, 1u), what + ": " + std::to_string(segments.size()) +
+            " segments, at most " + std::to_string(std::max(maxSegments, 1u)));
+        uint32_t next = 0;
+        uint64_t total = 0;
+        for (const RecordingSegment& segment : segments) {
+            runner.Expect(segment.pass == pass, what + ": a segment of another pass");
+            runner.Expect(segment.itemCount > 0, what + ": an empty segment");
+            if (!runner.Expect(segment.firstItem == next, what + ": a segment starts at " +
+                std::to_string(segment.firstItem) + ", expected " + std::to_string(next))) {
+                return;
+            }
+            next = segment.firstItem + segment.itemCount;
+            if (!runner.Expect(next <= itemCosts.size(), what + ": a segment past the last item")) {
+                return;
+            }
+            total += SegmentCost(itemCosts, segment);
+        }
+        runner.Expect(next == itemCosts.size(), what + ": the segments end at " + std::to_string(next) + " of " +
+            std::to_string(itemCosts.size()) + " items");
+        if (minSegmentCost > 0 && total >= minSegmentCost) {
+            for (const RecordingSegment& segment : segments) {
+                runner.Expect(SegmentCost(itemCosts, segment) >= minSegmentCost, what + ": a segment of cost " +
+                    std::to_string(SegmentCost(itemCosts, segment)) + ", the minimum is " +
+                    std::to_string(minSegmentCost));
+            }
+        }
+        if (minSegmentCost > 0 && total < minSegmentCost) {
+            runner.Expect(segments.size() == 1, what + ": a pass cheaper than the minimum was split");
+        }
+    }
+
+    void CheckPartition(checks::CheckRunner& runner)
+    {
+        //the cases that are easy to get wrong, then random ones
+        struct Case
+        {
+            std::vector<uint64_t> costs;
+            uint32_t maxSegments;
+            uint64_t minSegmentCost;
+        };
+        std::vector<Case> cases = {
+            { {}, 4, 0 },
+            { { 5 }, 4, 0 },
+            { { 0, 0, 0, 0, 0, 0 }, 3, 0 },
+            { { 0, 0, 0, 0, 0, 0 }, 3, 4 },
+            { { 1, 100, 1 }, 3, 30 },
+            { { 100, 1, 1, 1 }, 4, 10 },
+            { { 1, 1, 1, 100 }, 4, 10 },
+            { { 3, 3, 3 }, 0, 0 },
+            { { 3, 3, 3 }, 8, 0 },
+            { { 3, 3, 3 }, 8, 100 },
+        };
+        std::mt19937 rng(9);
+        for (uint32_t i = 0; i < 2000; i++) {
+            Case random;
+            const uint32_t itemCount = rng() % 40;
+            for (uint32_t item = 0; item < itemCount; item++) {
+                //a few expensive items among cheap and free ones
+                const uint32_t kind = rng() % 10;
+                random.costs.push_back(kind < 2 ? 0 : kind < 9 ? 1 + rng() % 10 : 50 + rng() % 200);
+            }
+            random.maxSegments = rng() % 10;
+            random.minSegmentCost = rng() % 3 == 0 ? 0 : rng() % 100;
+            cases.push_back(random);
+        }
+        for (size_t c = 0; c < cases.size(); c++) {
+            const Case& test = cases[c];
+            const std::vector<RecordingSegment> segments = RecordingPlan::Partition(7, test.costs, test.maxSegments,
+                test.minSegmentCost);
+            ExpectPartition(runner, segments, 7, test.costs, test.maxSegments, test.minSegmentCost,
+                "case " + std::to_string(c));
+        }
+    }
+
+    void CheckPlan(checks::CheckRunner& runner)
+    {
+        RecordingPlan plan;
+        const std::vector<uint64_t> costs = { 4, 0, 9, 1, 1, 7, 3, 0, 2 };
+        runner.Expect(plan.AddSerialPass() == 0, "the first pass isn't 0");
+        runner.Expect(plan.AddParallelPass(costs, 3) == 1, "the parallel pass isn't 1");
+        runner.Expect(plan.AddParallelPass({}, 3) == 2, "the empty pass isn't 2");
+        runner.Expect(plan.AddSerialPass() == 3, "the last pass isn't 3");
+        runner.Expect(plan.GetPassCount() == 4, "wrong pass count");
+        const std::vector<RecordingSegment>& segments = plan.GetSegments();
+        //the serial passes are one segment of one item, the empty one has none, and the passes stay in order
+        runner.Expect(segments.front().pass == 0 && segments.front().itemCount == 1, "the first serial pass");
+        runner.Expect(segments.back().pass == 3 && segments.back().itemCount == 1, "the last serial pass");
+        std::vector<RecordingSegment> parallel;
+        for (const RecordingSegment& segment : segments) {
+            runner.Expect(segment.pass != 2, "the empty pass has a segment");
+            if (segment.pass == 1) {
+                parallel.push_back(segment);
+            }
+        }
+        for (size_t s = 1; s < segments.size(); s++) {
+            runner.Expect(segments[s - 1].pass <= segments[s].pass, "the segments aren't in pass order");
+        }
+        ExpectPartition(runner, parallel, 1, costs, 3, 0, "the parallel pass");
+        plan.Clear();
+        runner.Expect(plan.GetSegments().empty() && plan.GetPassCount() == 0, "Clear left something");
+    }
+
+    /// <summary>
+    /// Each list says which segment it recorded with three constants, in the order Record ran it.
+    /// </summary>
+    void RecordSegment(const RecordingSegment& segment, common::gfx::CommandList& list)
+    {
+        list.SetGraphicsRoot32BitConstant(0, segment.pass, 0);
+        list.SetGraphicsRoot32BitConstant(0, segment.firstItem, 1);
+        list.SetGraphicsRoot32BitConstant(0, segment.itemCount, 2);
+    }
+
+    void CheckRecord(checks::CheckRunner& runner)
+    {
+        common::gfx::RecordingDevice device;
+        common::WorkerPool workers(3);
+        constexpr uint32_t FRAME_COUNT = 2;
+        common::ParallelCommandRecorder recorder(device, workers, FRAME_COUNT);
+        RecordingPlan plan;
+        plan.AddSerialPass();
+        plan.AddParallelPass({ 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5 }, 6);
+        plan.AddParallelPass({}, 4);
+        plan.AddParallelPass({ 1, 0, 30, 2, 2, 2 }, 4, 5);
+        plan.AddSerialPass();
+        const std::vector<RecordingSegment>& segments = plan.GetSegments();
+        for (uint32_t round = 0; round < 3; round++) {
+            for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+                const std::vector<common::gfx::CommandList*> lists = recorder.Record(frame, plan, RecordSegment);
+                if (!runner.Expect(lists.size() == segments.size(), "a list per segment")) {
+                    return;
+                }
+                for (size_t s = 0; s < lists.size(); s++) {
+                    const auto& list = static_cast<const common::gfx::RecordingCommandList&>(*lists[s]);
+                    const std::vector<common::gfx::RecordedCommand>& commands = list.GetCommands();
+                    runner.Expect(list.IsClosed(), "list " + std::to_string(s) + " was left open");
+                    if (!runner.Expect(commands.size() == 3, "list " + std::to_string(s) + " has " +
+                        std::to_string(commands.size()) + " commands, a new recording should replace the last")) {
+                        continue;
+                    }
+                    runner.Expect(commands[0].args[1] == segments[s].pass && commands[1].args[1] == segments[s].firstItem &&
+                        commands[2].args[1] == segments[s].itemCount, "list " + std::to_string(s) +
+                        " recorded another segment, the lists must come in pass and segment order");
+                    for (size_t other = 0; other < s; other++) {
+                        runner.Expect(lists[other] != lists[s], "two segments share a list");
+                    }
+                }
+            }
+        }
+        //the pool grew on the first use of each frame and never again
+        runner.Expect(device.GetCreatedListCount() == segments.size() * FRAME_COUNT, "created " +
+            std::to_string(device.GetCreatedListCount()) + " lists, expected " +
+            std::to_string(segments.size() * FRAME_COUNT));
+        runner.Expect(recorder.Record(0, RecordingPlan(), RecordSegment).empty(), "an empty plan gave lists");
+    }
+}
+
+void checks::RunRecordingPlanChecks(CheckRunner& runner)
+{
+    runner.Run("RecordingPlan/Partition", [&runner]() { CheckPartition(runner); });
+    runner.Run("RecordingPlan/Plan", [&runner]() { CheckPlan(runner); });
+    runner.Run("RecordingPlan/Record", [&runner]() { CheckRecord(runner); });
+}
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "checks.h"
+#include "../Core/cpu_skinning.h"
+#include "../Core/worker_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //the SSE kernel does the scalar math in the same order, so it gives the same floats; AVX2 fuses the multiply
+    //adds and rounds differently
+    constexpr float SSE_TOLERANCE = 0.0f;
+    constexpr float AVX2_TOLERANCE = 5e-6f;
+    //odd, so the last chunk and the 4 and 8 wide loops have a tail
+    constexpr uint32_t VERTEX_COUNT = 1001;
+    constexpr uint32_t JOINT_COUNT = 64;
+    constexpr uint32_t PARALLEL_CHUNK_SIZE = 64;
+
+    struct SkinnedMeshData
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT4> tangents;
+        std::vector<common::SkinInfluences> influences;
+        std::vector<DirectX::XMFLOAT4X4> skinMatrices;
+        std::vector<common::DualQuaternion> palette;
+
+        common::SkinningSource GetSource() const
+        {
+            return { positions.data(), normals.data(), tangents.data(), influences.data(),
+                static_cast<uint32_t>(positions.size()) };
+        }
+    };
+
+    /// <summary>
+    /// Random vertices, each weighted by 4 random joints, and random rotation and translation skin matrices.
+    /// </summary>
+    SkinnedMeshData MakeSkinnedMesh(uint32_t vertexCount, uint32_t jointCount, std::mt19937& rng)
+    {
+        using namespace DirectX;
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+        SkinnedMeshData mesh;
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            mesh.positions.push_back(XMFLOAT3(unit(rng), unit(rng), unit(rng)));
+            XMFLOAT3 normal;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(unit(rng), unit(rng), unit(rng), 0.0f)));
+            mesh.normals.push_back(normal);
+            mesh.tangents.push_back(XMFLOAT4(normal.y, -normal.x, 0.0f, 1.0f));
+            common::SkinInfluences influences;
+            float total = 0;
+            for (int i = 0; i < 4; i++) {
+                influences.joints[i] = static_cast<uint16_t>(rng() % jointCount);
+                influences.weights[i] = weight(rng);
+                total += influences.weights[i];
+            }
+            for (int i = 0; i < 4; i++) {
+                influences.weights[i] /= total;
+            }
+            mesh.influences.push_back(influences);
+        }
+        for (uint32_t j = 0; j < jointCount; j++) {
+            XMFLOAT4X4 skinMatrix;
+            XMStoreFloat4x4(&skinMatrix, XMMatrixRotationQuaternion(XMQuaternionNormalize(
+                XMVectorSet(unit(rng), unit(rng), unit(rng), 1.0f))) * XMMatrixTranslation(unit(rng), unit(rng), unit(rng)));
+            mesh.skinMatrices.push_back(skinMatrix);
+        }
+        common::ComputeDualQuaternions(mesh.skinMatrices, mesh.palette);
+        return mesh;
+    }
+
+    struct SkinnedVertices
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT4> tangents;
+
+        explicit SkinnedVertices(uint32_t vertexCount)
+            :positions(vertexCount), normals(vertexCount), tangents(vertexCount)
+        {
+        }
+        common::SkinningTarget GetTarget()
+        {
+            return { positions.data(), normals.data(), tangents.data() };
+        }
+    };
+
+    float MaxDifference(const float* a, const float* b, size_t count)
+    {
+        float difference = 0;
+        for (size_t i = 0; i < count; i++) {
+            difference = std::max(difference, std::abs(a[i] - b[i]));
+        }
+        return difference;
+    }
+
+    /// <summary>
+    /// Fails the check if any component of any stream is further than tolerance from the reference.
+    /// </summary>
+    void ExpectSameVertices(checks::CheckRunner& runner, const SkinnedVertices& actual,
+        const SkinnedVertices& reference, float tolerance)
+    {
+        const size_t count = reference.positions.size();
+        runner.ExpectNear(MaxDifference(&actual.positions[0].x, &reference.positions[0].x, count * 3), 0.0, tolerance,
+            "positions");
+        runner.ExpectNear(MaxDifference(&actual.normals[0].x, &reference.normals[0].x, count * 3), 0.0, tolerance,
+            "normals");
+        runner.ExpectNear(MaxDifference(&actual.tangents[0].x, &reference.tangents[0].x, count * 4), 0.0, tolerance,
+            "tangents");
+    }
+
+    void Skin(const SkinnedMeshData& mesh, bool dualQuaternion, common::SkinningKernel kernel,
+        SkinnedVertices& vertices)
+    {
+        const common::SkinningSource source = mesh.GetSource();
+        if (dualQuaternion) {
+            common::SkinDualQuaternion(kernel, mesh.palette.data(), source, vertices.GetTarget(), 0,
+                source.vertexCount);
+        }
+        else {
+            common::SkinLinearBlend(kernel, mesh.skinMatrices.data(), source, vertices.GetTarget(), 0,
+                source.vertexCount);
+        }
+    }
+
+    void SkinParallel(common::WorkerPool& workerPool, const SkinnedMeshData& mesh, bool dualQuaternion,
+        common::SkinningKernel kernel, SkinnedVertices& vertices)
+    {
+        const common::SkinningSource source = mesh.GetSource();
+        if (dualQuaternion) {
+            common::SkinDualQuaternion(workerPool, kernel, mesh.palette.data(), source, vertices.GetTarget(),
+                PARALLEL_CHUNK_SIZE);
+        }
+        else {
+            common::SkinLinearBlend(workerPool, kernel, mesh.skinMatrices.data(), source, vertices.GetTarget(),
+                PARALLEL_CHUNK_SIZE);
+        }
+    }
+}
+
+void checks::RunSkinningChecks(CheckRunner& runner)
+{
+    std::mt19937 rng(7);
+    const SkinnedMeshData mesh = MakeSkinnedMesh(VERTEX_COUNT, JOINT_COUNT, rng);
+    common::WorkerPool workerPool(3);
+    const common::SkinningKernel kernels[] = { common::SkinningKernel::Scalar, common::SkinningKernel::SSE,
+        common::SkinningKernel::AVX2 };
+    for (bool dualQuaternion : { false, true }) {
+        const std::string method = dualQuaternion ? "DualQuaternion" : "LinearBlend";
+        SkinnedVertices reference(VERTEX_COUNT);
+        Skin(mesh, dualQuaternion, common::SkinningKernel::Scalar, reference);
+        for (common::SkinningKernel kernel : kernels) {
+            const std::string kernelName = common::GetSkinningKernelName(kernel);
+            if (kernel != common::SkinningKernel::Scalar) {
+                //the scalar kernel is the reference itself
+                runner.Run("Skinning/" + method + "/" + kernelName + "/VsScalar", [&]() {
+                    if (!common::IsSkinningKernelSupported(kernel)) {
+                        runner.Skip("not supported by this cpu");
+                        return;
+                    }
+                    SkinnedVertices vertices(VERTEX_COUNT);
+                    Skin(mesh, dualQuaternion, kernel, vertices);
+                    ExpectSameVertices(runner, vertices, reference,
+                        kernel == common::SkinningKernel::SSE ? SSE_TOLERANCE : AVX2_TOLERANCE);
+                });
+            }
+            runner.Run("Skinning/" + method + "/" + kernelName + "/ParallelVsSingle", [&]() {
+                if (!common::IsSkinningKernelSupported(kernel)) {
+                    runner.Skip("not supported by this cpu");
+                    return;
+                }
+                //the chunks only split the vertices, each one is skinned with the same math
+                SkinnedVertices single(VERTEX_COUNT);
+                Skin(mesh, dualQuaternion, kernel, single);
+                SkinnedVertices parallel(VERTEX_COUNT);
+                SkinParallel(workerPool, mesh, dualQuaternion, kernel, parallel);
+                ExpectSameVertices(runner, parallel, single, 0.0f);
+            });
+        }
+    }
+}
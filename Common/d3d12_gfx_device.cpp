@@ -0,0 +1,216 @@
+#include "pch.h"
+#include "d3d12_gfx_device.h"
+
+namespace
+{
+    ID3D12Resource* ToResource(common::gfx::ResourceHandle handle)
+    {
+        return reinterpret_cast<ID3D12Resource*>(handle.value);
+    }
+    D3D12_CPU_DESCRIPTOR_HANDLE ToD3D12(common::gfx::CpuDescriptor handle)
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE result;
+        result.ptr = static_cast<SIZE_T>(handle.ptr);
+        return result;
+    }
+}
+
+D3D12_RESOURCE_STATES common::gfx::ToD3D12(ResourceState state)
+{
+    switch (state) {
+    case ResourceState::Common:
+        return D3D12_RESOURCE_STATE_COMMON;
+    case ResourceState::RenderTarget:
+        return D3D12_RESOURCE_STATE_RENDER_TARGET;
+    case ResourceState::DepthWrite:
+        return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    case ResourceState::PixelShaderResource:
+        return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    case ResourceState::NonPixelShaderResource:
+        return D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    case ResourceState::CopySource:
+        return D3D12_RESOURCE_STATE_COPY_SOURCE;
+    case ResourceState::CopyDest:
+        return D3D12_RESOURCE_STATE_COPY_DEST;
+    case ResourceState::GenericRead:
+        return D3D12_RESOURCE_STATE_GENERIC_READ;
+    case ResourceState::Present:
+        return D3D12_RESOURCE_STATE_PRESENT;
+    }
+    assert(false);
+    return D3D12_RESOURCE_STATE_COMMON;
+}
+
+common::gfx::D3D12CommandList::D3D12CommandList(ID3D12Device* device, const std::wstring& name)
+{
+    HRESULT hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator));
+    assert(hr == S_OK);
+    hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&list));
+    assert(hr == S_OK);
+    list->SetName(name.c_str());
+    list->Close();
+}
+
+common::gfx::D3D12CommandList::D3D12CommandList(ID3D12GraphicsCommandList* list, ID3D12CommandAllocator* allocator)
+    :allocator(allocator), list(list)
+{
+}
+
+void common::gfx::D3D12CommandList::Reset()
+{
+    assert(allocator != nullptr);
+    HRESULT hr = allocator->Reset();
+    assert(hr == S_OK);
+    hr = list->Reset(allocator.Get(), nullptr);
+    assert(hr == S_OK);
+}
+
+void common::gfx::D3D12CommandList::Close()
+{
+    HRESULT hr = list->Close();
+    assert(hr == S_OK);
+}
+
+void common::gfx::D3D12CommandList::ResourceBarrier(ResourceHandle resource, ResourceState before, ResourceState after)
+{
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(ToResource(resource),
+        ToD3D12(before), ToD3D12(after));
+    list->ResourceBarrier(1, &barrier);
+}
+
+void common::gfx::D3D12CommandList::CopyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src,
+    uint64_t srcOffset, uint64_t numBytes)
+{
+    list->CopyBufferRegion(ToResource(dst), dstOffset, ToResource(src), srcOffset, numBytes);
+}
+
+void common::gfx::D3D12CommandList::SetGraphicsRootSignature(RootSignatureHandle rootSignature)
+{
+    list->SetGraphicsRootSignature(reinterpret_cast<ID3D12RootSignature*>(rootSignature.value));
+}
+
+void common::gfx::D3D12CommandList::SetPipelineState(PipelineHandle pipeline)
+{
+    list->SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(pipeline.value));
+}
+
+void common::gfx::D3D12CommandList::SetDescriptorHeap(DescriptorHeapHandle heap)
+{
+    ID3D12DescriptorHeap* heaps[] = { reinterpret_cast<ID3D12DescriptorHeap*>(heap.value) };
+    list->SetDescriptorHeaps(_countof(heaps), heaps);
+}
+
+void common::gfx::D3D12CommandList::SetGraphicsRootDescriptorTable(uint32_t rootParameter, GpuDescriptor baseDescriptor)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE handle;
+    handle.ptr = baseDescriptor.ptr;
+    list->SetGraphicsRootDescriptorTable(rootParameter, handle);
+}
+
+void common::gfx::D3D12CommandList::SetGraphicsRoot32BitConstant(uint32_t rootParameter, uint32_t value, uint32_t offset)
+{
+    list->SetGraphicsRoot32BitConstant(rootParameter, value, offset);
+}
+
+void common::gfx::D3D12CommandList::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+    switch (topology) {
+    case PrimitiveTopology::TriangleList:
+        list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        break;
+    case PrimitiveTopology::TriangleStrip:
+        list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        break;
+    case PrimitiveTopology::LineList:
+        list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+        break;
+    }
+}
+
+void common::gfx::D3D12CommandList::SetViewport(const Viewport& viewport)
+{
+    D3D12_VIEWPORT vp{ viewport.x, viewport.y, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+    list->RSSetViewports(1, &vp);
+}
+
+void common::gfx::D3D12CommandList::SetScissorRect(const Rect& rect)
+{
+    D3D12_RECT r{ rect.left, rect.top, rect.right, rect.bottom };
+    list->RSSetScissorRects(1, &r);
+}
+
+void common::gfx::D3D12CommandList::SetRenderTarget(CpuDescriptor rtv, CpuDescriptor dsv)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = ToD3D12(rtv);
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = ToD3D12(dsv);
+    list->OMSetRenderTargets(1, &rtvHandle, FALSE, dsv.ptr != 0 ? &dsvHandle : nullptr);
+}
+
+void common::gfx::D3D12CommandList::ClearRenderTarget(CpuDescriptor rtv, const std::array<float, 4>& color)
+{
+    list->ClearRenderTargetView(ToD3D12(rtv), color.data(), 0, nullptr);
+}
+
+void common::gfx::D3D12CommandList::ClearDepth(CpuDescriptor dsv, float depth)
+{
+    list->ClearDepthStencilView(ToD3D12(dsv), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void common::gfx::D3D12CommandList::SetVertexBuffer(const VertexBufferView& view)
+{
+    D3D12_VERTEX_BUFFER_VIEW vbv{ view.location, view.sizeInBytes, view.strideInBytes };
+    list->IASetVertexBuffers(0, 1, &vbv);
+}
+
+void common::gfx::D3D12CommandList::SetIndexBuffer(const IndexBufferView& view)
+{
+    D3D12_INDEX_BUFFER_VIEW ibv{ view.location, view.sizeInBytes,
+        view.index32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT };
+    list->IASetIndexBuffer(&ibv);
+}
+
+void common::gfx::D3D12CommandList::DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+    uint32_t startInstance)
+{
+    list->DrawInstanced(vertexCount, instanceCount, startVertex, startInstance);
+}
+
+void common::gfx::D3D12CommandList::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount,
+    uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    list->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void common::gfx::D3D12CommandList::BeginEvent(const wchar_t* name)
+{
+    list->BeginEvent(0, name, static_cast<UINT>((wcslen(name) + 1) * sizeof(wchar_t)));
+}
+
+void common::gfx::D3D12CommandList::EndEvent()
+{
+    list->EndEvent();
+}
+
+common::gfx::D3D12Device::D3D12Device(ID3D12Device* device)
+    :device(device)
+{
+}
+
+std::unique_ptr<common::gfx::CommandList> common::gfx::D3D12Device::CreateCommandList(const std::wstring& name)
+{
+    return std::make_unique<D3D12CommandList>(device.Get(), name);
+}
+
+void common::gfx::D3D12Device::CreateStructuredBufferView(CpuDescriptor dst, ResourceHandle buffer,
+    uint32_t numElements, uint32_t stride)
+{
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.Buffer.FirstElement = 0;
+    srvDesc.Buffer.NumElements = numElements;
+    srvDesc.Buffer.StructureByteStride = stride;
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+    device->CreateShaderResourceView(ToResource(buffer), &srvDesc, ToD3D12(dst));
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "pch.h"
+#include "../Core/gfx_device.h"
+
+namespace common::gfx
+{
+	//Conversions between the d3d12 types and the backend neutral ones.
+	inline ResourceHandle ToHandle(ID3D12Resource* resource) { return { reinterpret_cast<uint64_t>(resource) }; }
+	inline PipelineHandle ToHandle(ID3D12PipelineState* pipeline) { return { reinterpret_cast<uint64_t>(pipeline) }; }
+	inline RootSignatureHandle ToHandle(ID3D12RootSignature* rootSignature) { return { reinterpret_cast<uint64_t>(rootSignature) }; }
+	inline DescriptorHeapHandle ToHandle(ID3D12DescriptorHeap* heap) { return { reinterpret_cast<uint64_t>(heap) }; }
+	inline CpuDescriptor ToHandle(D3D12_CPU_DESCRIPTOR_HANDLE handle) { return { static_cast<uint64_t>(handle.ptr) }; }
+	inline GpuDescriptor ToHandle(D3D12_GPU_DESCRIPTOR_HANDLE handle) { return { handle.ptr }; }
+	inline VertexBufferView ToView(const D3D12_VERTEX_BUFFER_VIEW& view)
+	{
+		return { view.BufferLocation, view.SizeInBytes, view.StrideInBytes };
+	}
+	inline IndexBufferView ToView(const D3D12_INDEX_BUFFER_VIEW& view)
+	{
+		return { view.BufferLocation, view.SizeInBytes, view.Format == DXGI_FORMAT_R32_UINT };
+	}
+	inline Viewport ToViewport(const D3D12_VIEWPORT& viewport)
+	{
+		return { viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth };
+	}
+	inline Rect ToRect(const D3D12_RECT& rect)
+	{
+		return { static_cast<int32_t>(rect.left), static_cast<int32_t>(rect.top),
+			static_cast<int32_t>(rect.right), static_cast<int32_t>(rect.bottom) };
+	}
+	D3D12_RESOURCE_STATES ToD3D12(ResourceState state);
+
+	/// <summary>
+	/// A d3d12 command list behind the gfx interface. It either owns its list and allocator or wraps a list
+	/// that somebody else resets, like the context's main list.
+	/// </summary>
+	class D3D12CommandList : public CommandList
+	{
+	public:
+		/// <summary>
+		/// Creates a closed direct list and its allocator.
+		/// </summary>
+		D3D12CommandList(ID3D12Device* device, const std::wstring& name);
+		/// <summary>
+		/// Wraps list. Without an allocator Reset can't be used, the owner resets the list.
+		/// </summary>
+		explicit D3D12CommandList(ID3D12GraphicsCommandList* list, ID3D12CommandAllocator* allocator = nullptr);
+		ID3D12GraphicsCommandList* GetNative() const { return list.Get(); }
+
+		void Reset() override;
+		void Close() override;
+		void ResourceBarrier(ResourceHandle resource, ResourceState before, ResourceState after) override;
+		void CopyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset,
+			uint64_t numBytes) override;
+		void SetGraphicsRootSignature(RootSignatureHandle rootSignature) override;
+		void SetPipelineState(PipelineHandle pipeline) override;
+		void SetDescriptorHeap(DescriptorHeapHandle heap) override;
+		void SetGraphicsRootDescriptorTable(uint32_t rootParameter, GpuDescriptor baseDescriptor) override;
+		void SetGraphicsRoot32BitConstant(uint32_t rootParameter, uint32_t value, uint32_t offset) override;
+		void SetPrimitiveTopology(PrimitiveTopology topology) override;
+		void SetViewport(const Viewport& viewport) override;
+		void SetScissorRect(const Rect& rect) override;
+		void SetRenderTarget(CpuDescriptor rtv, CpuDescriptor dsv) override;
+		void ClearRenderTarget(CpuDescriptor rtv, const std::array<float, 4>& color) override;
+		void ClearDepth(CpuDescriptor dsv, float depth) override;
+		void SetVertexBuffer(const VertexBufferView& view) override;
+		void SetIndexBuffer(const IndexBufferView& view) override;
+		void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+			uint32_t startInstance) override;
+		void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+			int32_t baseVertex, uint32_t startInstance) override;
+		void BeginEvent(const wchar_t* name) override;
+		void EndEvent() override;
+	private:
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> list;
+	};
+
+	class D3D12Device : public Device
+	{
+	public:
+		explicit D3D12Device(ID3D12Device* device);
+		ID3D12Device* GetNative() const { return device.Get(); }
+		std::unique_ptr<CommandList> CreateCommandList(const std::wstring& name) override;
+		void CreateStructuredBufferView(CpuDescriptor dst, ResourceHandle buffer, uint32_t numElements,
+			uint32_t stride) override;
+	private:
+		Microsoft::WRL::ComPtr<ID3D12Device> device;
+	};
+}
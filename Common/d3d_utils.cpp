@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "d3d_utils.h"
-#include "concatenate.h"
+#include "../Core/concatenate.h"
+#include "gpu_memory_allocator.h"
+#include "resource_recycler.h"
 using Microsoft::WRL::ComPtr;
 
 
@@ -184,56 +186,112 @@ Microsoft::WRL::ComPtr<ID3D12Debug> common::CreateDebugLayer()
 }
 #endif
 
+namespace {
+    /// <summary>
+    /// A buffer in the default heap, in the common state. Placed in allocator when it's given.
+    /// </summary>
+    ComPtr<ID3D12Resource> CreateDefaultHeapBuffer(ID3D12Device* device, UINT64 size,
+        common::GpuMemoryAllocator* allocator)
+    {
+        ComPtr<ID3D12Resource> buffer;
+        CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+        if (allocator != nullptr) {
+            HRESULT hr = allocator->CreateResource(bufferDesc, D3D12_HEAP_TYPE_DEFAULT,
+                D3D12_RESOURCE_STATE_COMMON, nullptr, buffer);
+            assert(hr == S_OK);
+        }
+        else {
+            CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+            device->CreateCommittedResource(
+                &heapProps,
+                D3D12_HEAP_FLAG_NONE,
+                &bufferDesc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&buffer)
+            );
+        }
+        return buffer;
+    }
+    /// <summary>
+    /// Copies size bytes of data into the mappable uploadBuffer.
+    /// </summary>
+    void FillUploadBuffer(ID3D12Resource* uploadBuffer, const void* data, UINT64 size)
+    {
+        void* mappedData;
+        uploadBuffer->Map(0, nullptr, &mappedData);
+        memcpy(mappedData, data, size);
+        uploadBuffer->Unmap(0, nullptr);
+    }
+    /// <summary>
+    /// Records the copy from uploadBuffer to buffer and the transition to the vertex buffer state.
+    /// </summary>
+    void RecordBufferUpload(ID3D12GraphicsCommandList* lst, ID3D12Resource* buffer,
+        ID3D12Resource* uploadBuffer, UINT64 size)
+    {
+        lst->CopyBufferRegion(buffer, 0, uploadBuffer, 0, size);
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            buffer,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        );
+        lst->ResourceBarrier(1, &barrier);
+    }
+}
+
 Microsoft::WRL::ComPtr<ID3D12Resource> common::CreateGPUBufferAndCopyDataToIt(ID3D12Device* device,
     ID3D12CommandQueue* commandQueue,
     const void* data,
-    UINT64 size)
+    UINT64 size,
+    GpuMemoryAllocator* allocator)
 {
-    Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
-
-    // Create the default heap (GPU memory)
-    CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+    ComPtr<ID3D12Resource> buffer = CreateDefaultHeapBuffer(device, size, allocator);
+    // Create an upload heap (CPU memory), it lives until the copy is done
+    ComPtr<ID3D12Resource> uploadBuffer;
     CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
-    device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        nullptr,
-        IID_PPV_ARGS(&buffer)
-    );
-    Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
-    // Create an upload heap (CPU memory)
-    heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-    device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&uploadBuffer)
-    );
-
-    // Map and copy data to the upload heap
-    void* mappedData;
-    uploadBuffer->Map(0, nullptr, &mappedData);
-    memcpy(mappedData, data, size);
-    uploadBuffer->Unmap(0, nullptr);
-    // Copy data from the upload heap to the GPU heap
-    common::RunCommands(device, commandQueue, [&buffer, &uploadBuffer, size](auto lst) {
-        lst->CopyBufferRegion(buffer.Get(), 0, uploadBuffer.Get(), 0, size);
-
-        // Transition the buffer to the vertex buffer state
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            buffer.Get(),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+    if (allocator != nullptr) {
+        HRESULT hr = allocator->CreateResource(bufferDesc, D3D12_HEAP_TYPE_UPLOAD,
+            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, uploadBuffer);
+        assert(hr == S_OK);
+    }
+    else {
+        CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+        device->CreateCommittedResource(
+            &heapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&uploadBuffer)
         );
-        lst->ResourceBarrier(1, &barrier);
+    }
+    FillUploadBuffer(uploadBuffer.Get(), data, size);
+    // Copy data from the upload heap to the GPU heap and wait for it
+    common::RunCommands(device, commandQueue, [&buffer, &uploadBuffer, size](auto lst) {
+        RecordBufferUpload(lst.Get(), buffer.Get(), uploadBuffer.Get(), size);
     });
     return buffer;
 }
 
+Microsoft::WRL::ComPtr<ID3D12Resource> common::CreateGPUBufferAndCopyDataToIt(ID3D12Device* device,
+    ResourceRecycler& recycler,
+    const void* data,
+    UINT64 size,
+    GpuMemoryAllocator* allocator)
+{
+    ComPtr<ID3D12Resource> buffer = CreateDefaultHeapBuffer(device, size, allocator);
+    // the upload buffer comes from the recycler's pool, so it may be bigger than the data
+    ComPtr<ID3D12Resource> uploadBuffer = recycler.AcquireUploadBuffer(size);
+    FillUploadBuffer(uploadBuffer.Get(), data, size);
+    // no wait: whatever uses the buffer is submitted to the same queue, after the copy
+    const UINT64 uploadDone = common::SubmitCommands(device, recycler,
+        [&buffer, &uploadBuffer, size](ComPtr<ID3D12GraphicsCommandList> lst) {
+            RecordBufferUpload(lst.Get(), buffer.Get(), uploadBuffer.Get(), size);
+        });
+    recycler.RecycleUploadBuffer(uploadBuffer, uploadDone);
+    return buffer;
+}
+
 void common::RunCommands(
     ID3D12Device* device,
     ID3D12CommandQueue* commandQueue,
@@ -272,6 +330,47 @@ void common::RunCommands(
     assert(fenceEvent != nullptr);
     _fence->SetEventOnCompletion(fenceCompletitionValue, fenceEvent);
     WaitForSingleObject(fenceEvent, INFINITE);
+    CloseHandle(fenceEvent);
+}
+
+namespace {
+    /// <summary>
+    /// Creates a one time allocator and list, records callback in it and executes it.
+    /// </summary>
+    void RecordAndExecute(ID3D12Device* device, ID3D12CommandQueue* commandQueue,
+        std::function<void(ComPtr<ID3D12GraphicsCommandList>)>& callback,
+        ComPtr<ID3D12CommandAllocator>& cmdAllocator, ComPtr<ID3D12GraphicsCommandList>& cmdList)
+    {
+        HRESULT hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(&cmdAllocator));
+        assert(hr == S_OK);
+        //created open, no need to close and reset it
+        hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, cmdAllocator.Get(),
+            NULL, IID_PPV_ARGS(&cmdList));
+        assert(hr == S_OK);
+        static int submittedListNumber = 0;
+        std::wstring cmdListName = Concatenate(L"Submitted command list n ", ++submittedListNumber);
+        cmdList->SetName(cmdListName.c_str());
+        callback(cmdList);
+        cmdList->Close();
+        ID3D12CommandList* ppCommandLists[] = { cmdList.Get() };
+        commandQueue->ExecuteCommandLists(1, ppCommandLists);
+    }
+}
+
+UINT64 common::SubmitCommands(
+    ID3D12Device* device,
+    ResourceRecycler& recycler,
+    std::function<void(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>)> callback)
+{
+    assert(device != nullptr);
+    ComPtr<ID3D12CommandAllocator> cmdAllocator;
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    RecordAndExecute(device, recycler.GetFence().GetQueue(), callback, cmdAllocator, cmdList);
+    const UINT64 fenceValue = recycler.GetFence().Signal();
+    recycler.DeferRelease(cmdList, fenceValue);
+    recycler.DeferRelease(cmdAllocator, fenceValue);
+    return fenceValue;
 }
 
 std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> common::CreateCommandAllocators(int amount,
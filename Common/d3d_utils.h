@@ -2,6 +2,8 @@
 #include "pch.h"
 namespace common
 {
+	class GpuMemoryAllocator;
+	class ResourceRecycler;
 	class RenderTargetViewData
 	{
 	public:
@@ -100,10 +102,34 @@ namespace common
 		ID3D12Device* device,
 		ID3D12CommandQueue* commandQueue,
 		std::function<void(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>)> callback);
+	/// <summary>
+	/// Records and submits like RunCommands, but doesn't wait. The allocator and the list are handed to the
+	/// recycler and released when the gpu is done with them. Returns the fence value that marks the
+	/// end of the commands.
+	/// </summary>
+	UINT64 SubmitCommands(
+		ID3D12Device* device,
+		ResourceRecycler& recycler,
+		std::function<void(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>)> callback);
 	
+	/// <summary>
+	/// Creates a buffer in the default heap and uploads data to it. If allocator is given the buffer and
+	/// the upload buffer are placed resources from it, otherwise they are committed resources.
+	/// </summary>
 	Microsoft::WRL::ComPtr<ID3D12Resource> CreateGPUBufferAndCopyDataToIt(ID3D12Device* device,
 		ID3D12CommandQueue* commandQueue,
 		const void* data,
-		UINT64 size);
+		UINT64 size,
+		GpuMemoryAllocator* allocator = nullptr);
+	/// <summary>
+	/// Same as above but doesn't wait: the copy goes through SubmitCommands and the upload buffer, taken
+	/// from the recycler's pool, goes back to it once the copy is done. Work that reads the buffer must be
+	/// submitted to the recycler's queue.
+	/// </summary>
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateGPUBufferAndCopyDataToIt(ID3D12Device* device,
+		ResourceRecycler& recycler,
+		const void* data,
+		UINT64 size,
+		GpuMemoryAllocator* allocator = nullptr);
 
 }
@@ -0,0 +1,225 @@
+#include "pch.h"
+#include "gpu_memory_allocator.h"
+#include <atomic>
+#include <map>
+
+using Microsoft::WRL::ComPtr;
+
+struct common::GpuMemoryAllocator::Pool
+{
+    Pool(D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS category, UINT64 alignment, UINT64 blockSize)
+        :heapType(heapType), category(category), alignment(alignment), core(blockSize, alignment) {}
+    const D3D12_HEAP_TYPE heapType;
+    const D3D12_HEAP_FLAGS category;
+    const UINT64 alignment;
+    //recursive because a resource can die (and free its allocation) while we are inside the pool
+    std::recursive_mutex mutex;
+    MemoryPoolCore core;
+    //indexed by the core's block id
+    std::vector<ComPtr<ID3D12Heap>> heaps;
+    //not owning, the tracker removes the entry when the resource dies
+    std::unordered_map<ID3D12Resource*, PoolAllocation> live;
+};
+
+namespace {
+    // {6E3F1A52-8C1B-4D2E-9B7A-3F5C2D8E41A7}
+    const GUID AllocationTrackerGuid =
+    { 0x6e3f1a52, 0x8c1b, 0x4d2e, { 0x9b, 0x7a, 0x3f, 0x5c, 0x2d, 0x8e, 0x41, 0xa7 } };
+
+    /// <summary>
+    /// Attached to every placed resource as private data. D3D releases it when the resource is destroyed,
+    /// that's when the sub-allocation goes back to the pool. It holds the heap, so the heap can't die
+    /// before the resources placed in it.
+    /// </summary>
+    class AllocationTracker : public IUnknown
+    {
+    public:
+        AllocationTracker(std::shared_ptr<common::GpuMemoryAllocator::Pool> pool,
+            common::PoolAllocation allocation, ID3D12Resource* resource, ComPtr<ID3D12Heap> heap)
+            :pool(pool), allocation(allocation), resource(resource), heap(heap) {}
+        ~AllocationTracker()
+        {
+            std::lock_guard<std::recursive_mutex> lock(pool->mutex);
+            pool->live.erase(resource);
+            pool->core.Free(allocation);
+            //keep one spare block around so that churn doesn't create and destroy heaps all the time
+            for (uint32_t block : pool->core.ReleaseEmptyBlocks(1)) {
+                pool->heaps[block].Reset();
+            }
+        }
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount; }
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG count = --refCount;
+            if (count == 0) {
+                delete this;
+            }
+            return count;
+        }
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+        {
+            if (ppvObject == nullptr) {
+                return E_POINTER;
+            }
+            if (riid == __uuidof(IUnknown)) {
+                *ppvObject = static_cast<IUnknown*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+    private:
+        std::atomic<ULONG> refCount = 1;
+        std::shared_ptr<common::GpuMemoryAllocator::Pool> pool;
+        common::PoolAllocation allocation;
+        ID3D12Resource* resource;
+        ComPtr<ID3D12Heap> heap;
+    };
+
+    D3D12_HEAP_FLAGS CategoryOf(const D3D12_RESOURCE_DESC& desc)
+    {
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        }
+        if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+        }
+        return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    }
+
+    /// <summary>
+    /// Places the resource at allocation and attaches the tracker. The pool's mutex must be held.
+    /// </summary>
+    HRESULT Place(ID3D12Device* device, std::shared_ptr<common::GpuMemoryAllocator::Pool> pool,
+        const common::PoolAllocation& allocation, const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue, ComPtr<ID3D12Resource>& out)
+    {
+        ComPtr<ID3D12Heap> heap = pool->heaps[allocation.block];
+        HRESULT hr = device->CreatePlacedResource(heap.Get(), allocation.offset, &desc,
+            initialState, clearValue, IID_PPV_ARGS(&out));
+        if (FAILED(hr)) {
+            pool->core.Free(allocation);
+            return hr;
+        }
+        pool->live[out.Get()] = allocation;
+        AllocationTracker* tracker = new AllocationTracker(pool, allocation, out.Get(), heap);
+        hr = out->SetPrivateDataInterface(AllocationTrackerGuid, tracker);
+        tracker->Release(); //the resource holds it now
+        assert(hr == S_OK);
+        return S_OK;
+    }
+}
+
+common::GpuMemoryAllocator::GpuMemoryAllocator(ID3D12Device* device, UINT64 blockSize)
+    :device(device), blockSize(blockSize)
+{
+}
+
+std::shared_ptr<common::GpuMemoryAllocator::Pool> common::GpuMemoryAllocator::GetPool(
+    D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS category, UINT64 alignment)
+{
+    std::lock_guard<std::mutex> lock(poolsMutex);
+    for (auto& pool : pools) {
+        if (pool->heapType == heapType && pool->category == category && pool->alignment == alignment) {
+            return pool;
+        }
+    }
+    pools.push_back(std::make_shared<Pool>(heapType, category, alignment, blockSize));
+    return pools.back();
+}
+
+HRESULT common::GpuMemoryAllocator::CreateResource(const D3D12_RESOURCE_DESC& desc,
+    D3D12_HEAP_TYPE heapType,
+    D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue,
+    ComPtr<ID3D12Resource>& out)
+{
+    const D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &desc);
+    if (info.SizeInBytes == UINT64_MAX) {
+        return E_INVALIDARG;
+    }
+    std::shared_ptr<Pool> pool = GetPool(heapType, CategoryOf(desc), info.Alignment);
+    std::lock_guard<std::recursive_mutex> lock(pool->mutex);
+    PoolAllocation allocation = pool->core.Allocate(info.SizeInBytes);
+    if (!allocation.IsValid()) {
+        //no room, add a new heap (a dedicated one if the resource is bigger than a block)
+        const uint32_t block = pool->core.AddBlock(info.SizeInBytes);
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = pool->core.GetBlockSize(block);
+        heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(heapType);
+        heapDesc.Alignment = info.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ?
+            D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        heapDesc.Flags = pool->category;
+        ComPtr<ID3D12Heap> heap;
+        HRESULT hr = device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap));
+        if (FAILED(hr)) {
+            pool->core.RemoveBlock(block);
+            return hr;
+        }
+        if (pool->heaps.size() <= block) {
+            pool->heaps.resize(block + 1);
+        }
+        pool->heaps[block] = heap;
+        allocation = pool->core.AllocateInBlock(block, info.SizeInBytes);
+        assert(allocation.IsValid());
+    }
+    return Place(device, pool, allocation, desc, initialState, clearValue, out);
+}
+
+common::PoolStats common::GpuMemoryAllocator::GetStats() const
+{
+    std::vector<std::shared_ptr<Pool>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(poolsMutex);
+        snapshot = pools;
+    }
+    PoolStats total;
+    float weightedFragmentation = 0.0f;
+    for (auto& pool : snapshot) {
+        std::lock_guard<std::recursive_mutex> lock(pool->mutex);
+        PoolStats stats = pool->core.GetStats();
+        total.reservedBytes += stats.reservedBytes;
+        total.usedBytes += stats.usedBytes;
+        total.blockCount += stats.blockCount;
+        total.allocationCount += stats.allocationCount;
+        weightedFragmentation += stats.fragmentation * static_cast<float>(stats.reservedBytes - stats.usedBytes);
+    }
+    if (total.reservedBytes > total.usedBytes) {
+        total.fragmentation = weightedFragmentation / static_cast<float>(total.reservedBytes - total.usedBytes);
+    }
+    return total;
+}
+
+std::vector<common::GpuRelocation> common::GpuMemoryAllocator::Defragment(UINT64 maxBytes)
+{
+    std::vector<std::shared_ptr<Pool>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(poolsMutex);
+        snapshot = pools;
+    }
+    std::vector<GpuRelocation> relocations;
+    for (auto& pool : snapshot) {
+        if (pool->heapType != D3D12_HEAP_TYPE_DEFAULT || maxBytes == 0) {
+            continue;
+        }
+        std::lock_guard<std::recursive_mutex> lock(pool->mutex);
+        std::vector<PoolAllocation> live;
+        std::map<std::pair<uint32_t, uint64_t>, ID3D12Resource*> owners;
+        for (auto& [resource, allocation] : pool->live) {
+            live.push_back(allocation);
+            owners[{ allocation.block, allocation.offset }] = resource;
+        }
+        for (const DefragmentationMove& move : pool->core.PlanDefragmentation(live, maxBytes)) {
+            ID3D12Resource* source = owners[{ move.from.block, move.from.offset }];
+            const D3D12_RESOURCE_DESC desc = source->GetDesc();
+            GpuRelocation relocation;
+            relocation.source = source;
+            if (SUCCEEDED(Place(device, pool, move.to, desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, relocation.destination))) {
+                relocations.push_back(relocation);
+                maxBytes -= move.from.size;
+            }
+        }
+    }
+    return relocations;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "pch.h"
+#include <mutex>
+#include <unordered_map>
+#include "../Core/memory_pool.h"
+
+namespace common
+{
+	/// <summary>
+	/// A resource that got a new place during Defragment. The destination is in COPY_DEST state. The owner of
+	/// source copies it into destination (it's the one that knows the source state), starts using
+	/// destination and drops source, that gives the old memory back.
+	/// </summary>
+	struct GpuRelocation
+	{
+		ID3D12Resource* source = nullptr;
+		Microsoft::WRL::ComPtr<ID3D12Resource> destination;
+	};
+
+	/// <summary>
+	/// Sub-allocates placed resources from big ID3D12Heaps instead of paying for an implicit heap per
+	/// CreateCommittedResource. There's one pool per heap type, resource category (buffers, rt/ds textures,
+	/// other textures, so it works in resource heap tier 1) and alignment. Each pool is a MemoryPoolCore,
+	/// that does the bookkeeping with TLSF.
+	/// The sub-allocation goes back to its pool when the resource is destroyed, so callers just hold the
+	/// ComPtr as usual. Each resource also keeps its heap alive, so resources may outlive the allocator.
+	/// Thread safe.
+	/// </summary>
+	class GpuMemoryAllocator
+	{
+	public:
+		GpuMemoryAllocator(ID3D12Device* device, UINT64 blockSize = 64ull * 1024 * 1024);
+		/// <summary>
+		/// Same contract as CreateCommittedResource with D3D12_HEAP_FLAG_NONE. Resources bigger than the
+		/// block size get a block of their own.
+		/// </summary>
+		HRESULT CreateResource(const D3D12_RESOURCE_DESC& desc,
+			D3D12_HEAP_TYPE heapType,
+			D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE* clearValue,
+			Microsoft::WRL::ComPtr<ID3D12Resource>& out);
+		/// <summary>
+		/// Sum of all pools.
+		/// </summary>
+		PoolStats GetStats() const;
+		/// <summary>
+		/// Moves up to maxBytes out of the least used heaps, so they can be released once the sources are dropped.
+		/// Only default heap resources are moved, upload and readback ones are mapped by their owners.
+		/// </summary>
+		std::vector<GpuRelocation> Defragment(UINT64 maxBytes);
+		struct Pool;
+	private:
+		std::shared_ptr<Pool> GetPool(D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS category, UINT64 alignment);
+		ID3D12Device* device;
+		const UINT64 blockSize;
+		mutable std::mutex poolsMutex;
+		std::vector<std::shared_ptr<Pool>> pools;
+	};
+}
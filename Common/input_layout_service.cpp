@@ -115,3 +115,21 @@ std::vector<D3D12_INPUT_ELEMENT_DESC> common::input_layout_service::InstancedTra
     };
     return inputLayout;
 }
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> common::input_layout_service::SkinnedVertices()
+{
+    constexpr size_t vertexOffset = 0;
+    constexpr size_t normalsOffset = vertexOffset + sizeof(float) * 3;
+    constexpr size_t uvOffset = normalsOffset + sizeof(float) * 3;
+    constexpr size_t jointsOffset = uvOffset + sizeof(float) * 2;
+    constexpr size_t weightsOffset = jointsOffset + sizeof(uint16_t) * 4;
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, vertexOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, normalsOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+        { "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, uvOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+        { "BLENDINDICES", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, jointsOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+        { "BLENDWEIGHT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, weightsOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+    };
+    return inputLayout;
+}
@@ -9,6 +9,10 @@ namespace common
 		std::vector<D3D12_INPUT_ELEMENT_DESC> PositionsNormalsAndUVs();
 		std::vector<D3D12_INPUT_ELEMENT_DESC> DefaultVertexDataAndInstanceId();
 		std::vector<D3D12_INPUT_ELEMENT_DESC> InstancedTransform();
+		/// <summary>
+		/// Position, normal and uv, then the 4 joints as uint16 and their 4 weights as floats.
+		/// </summary>
+		std::vector<D3D12_INPUT_ELEMENT_DESC> SkinnedVertices();
 	}
 }
 
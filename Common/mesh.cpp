@@ -1,34 +1,64 @@
 #include "pch.h"
 #include "mesh.h"
-#include "vertex.h"
+#include "../Core/vertex.h"
 #include <locale>
-#include "concatenate.h"
+#include "../Core/concatenate.h"
 #include "d3d_utils.h"
 
 using Microsoft::WRL::ComPtr;
 
 
+namespace {
+    std::vector<common::Vertex> InterleaveVertices(const common::MeshData& data)
+    {
+        std::vector<common::Vertex> vertexes(data.vertices.size());
+        for (auto i = 0; i < data.vertices.size(); i++)
+        {
+            vertexes[i].pos = data.vertices[i];
+            vertexes[i].normal = data.normals[i];
+            vertexes[i].uv = data.uv[i];
+        }
+        return vertexes;
+    }
+}
+
 common::Mesh::Mesh(MeshData& data, 
     Microsoft::WRL::ComPtr<ID3D12Device> device,
-    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue):
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue,
+    GpuMemoryAllocator* allocator):
     mNumberOfIndices(static_cast<int>(data.indices.size())),
     name(multi2wide(data.name))
 {
-    std::vector<common::Vertex> vertexes(data.vertices.size());
-    for (auto i = 0; i < data.vertices.size(); i++)
-    {
-        vertexes[i].pos = data.vertices[i];
-        vertexes[i].normal = data.normals[i];
-        vertexes[i].uv = data.uv[i];
-    }
+    std::vector<common::Vertex> vertexes = InterleaveVertices(data);
 	int vBufferSize = static_cast<int>(vertexes.size()) * sizeof(common::Vertex);
     int iBufferSize = static_cast<int>(data.indices.size()) * sizeof(uint16_t);
 
-    mVertexBuffer = CreateGPUBufferAndCopyDataToIt(device.Get(), commandQueue.Get(), vertexes.data(), vBufferSize);
-    std::wstring vertex_w_name = Concatenate(multi2wide(data.name), "vertexBuffer");
+    mVertexBuffer = CreateGPUBufferAndCopyDataToIt(device.Get(), commandQueue.Get(), vertexes.data(), vBufferSize, allocator);
+    mIndexBuffer = CreateGPUBufferAndCopyDataToIt(device.Get(), commandQueue.Get(), data.indices.data(), iBufferSize, allocator);
+    CreateViews(vBufferSize, iBufferSize);
+}
+
+common::Mesh::Mesh(MeshData& data,
+    Microsoft::WRL::ComPtr<ID3D12Device> device,
+    ResourceRecycler& recycler,
+    GpuMemoryAllocator* allocator) :
+    mNumberOfIndices(static_cast<int>(data.indices.size())),
+    name(multi2wide(data.name))
+{
+    std::vector<common::Vertex> vertexes = InterleaveVertices(data);
+    int vBufferSize = static_cast<int>(vertexes.size()) * sizeof(common::Vertex);
+    int iBufferSize = static_cast<int>(data.indices.size()) * sizeof(uint16_t);
+
+    mVertexBuffer = CreateGPUBufferAndCopyDataToIt(device.Get(), recycler, vertexes.data(), vBufferSize, allocator);
+    mIndexBuffer = CreateGPUBufferAndCopyDataToIt(device.Get(), recycler, data.indices.data(), iBufferSize, allocator);
+    CreateViews(vBufferSize, iBufferSize);
+}
+
+void common::Mesh::CreateViews(int vBufferSize, int iBufferSize)
+{
+    std::wstring vertex_w_name = Concatenate(name, "vertexBuffer");
     mVertexBuffer->SetName(vertex_w_name.c_str());
-    mIndexBuffer = CreateGPUBufferAndCopyDataToIt(device.Get(), commandQueue.Get(), data.indices.data(), iBufferSize);
-    std::wstring index_w_name = Concatenate(multi2wide(data.name), "indexBuffer");
+    std::wstring index_w_name = Concatenate(name, "indexBuffer");
     mIndexBuffer->SetName(index_w_name.c_str());
 
     mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
@@ -1,14 +1,27 @@
 #pragma once
 #include "pch.h"
-#include "mesh_load.h"
+#include "../Core/mesh_load.h"
 namespace common
 {
+	class GpuMemoryAllocator;
+	class ResourceRecycler;
 	class Mesh
 	{
 	public:
+		/// <summary>
+		/// Uploads the mesh. The buffers come from allocator when it's given, else they are committed resources.
+		/// </summary>
 		Mesh(MeshData& data, 
 			Microsoft::WRL::ComPtr<ID3D12Device> device,
-			Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue );
+			Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue,
+			GpuMemoryAllocator* allocator = nullptr);
+		/// <summary>
+		/// Same but doesn't wait for the upload, the upload buffers go back to recycler's pool.
+		/// </summary>
+		Mesh(MeshData& data,
+			Microsoft::WRL::ComPtr<ID3D12Device> device,
+			ResourceRecycler& recycler,
+			GpuMemoryAllocator* allocator = nullptr);
 		D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const { return mVertexBufferView; }
 		D3D12_INDEX_BUFFER_VIEW IndexBufferView()const { return mIndexBufferView; }
 		int NumberOfIndices()const { return mNumberOfIndices; }
@@ -20,6 +33,10 @@ namespace common
 		Microsoft::WRL::ComPtr<ID3D12Resource> mIndexBuffer = nullptr;
 		D3D12_INDEX_BUFFER_VIEW mIndexBufferView{};
 		const int mNumberOfIndices;
+		/// <summary>
+		/// Fills the views once the buffers exist.
+		/// </summary>
+		void CreateViews(int vBufferSize, int iBufferSize);
 	};
 }
 
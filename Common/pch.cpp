@@ -3,8 +3,8 @@
 #include "pch.h"
 #include "mesh.h"
 #include "../Common/d3d_utils.h"
-#include "concatenate.h"
-#include "mathutils.h"
+#include "../Core/concatenate.h"
+#include "../Core/mathutils.h"
 // When you are using pre-compiled headers, this source file is necessary for compilation to succeed.
 
 Microsoft::WRL::ComPtr<ID3D12Resource> common::images::CreateImage(int textureWidth, int textureHeight, DXGI_FORMAT format,
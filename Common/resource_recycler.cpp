@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "resource_recycler.h"
+#include "gpu_memory_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+common::ResourceRecycler::ResourceRecycler(ID3D12Device* device, TimelineFence& fence, GpuMemoryAllocator* allocator)
+    :device(device), fence(fence), allocator(allocator), core(fence)
+{
+    assert(device != nullptr);
+}
+
+void common::ResourceRecycler::DeferRelease(ComPtr<IUnknown> object)
+{
+    if (object != nullptr) {
+        core.DeferRelease(std::move(object));
+    }
+}
+
+void common::ResourceRecycler::DeferRelease(ComPtr<IUnknown> object, UINT64 fenceValue)
+{
+    if (object != nullptr) {
+        core.DeferRelease(std::move(object), fenceValue);
+    }
+}
+
+ComPtr<ID3D12Resource> common::ResourceRecycler::AcquireUploadBuffer(UINT64 size)
+{
+    std::optional<ComPtr<ID3D12Resource>> pooled = core.TakeUploadBuffer(size);
+    if (pooled.has_value()) {
+        return *pooled;
+    }
+    //the buffer has the whole class size so that it can go back to the pool
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(core.GetUploadClassSize(size));
+    ComPtr<ID3D12Resource> buffer;
+    HRESULT hr;
+    if (allocator != nullptr) {
+        hr = allocator->CreateResource(desc, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr, buffer);
+    }
+    else {
+        CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+        hr = device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
+            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer));
+    }
+    assert(hr == S_OK);
+    buffer->SetName(L"Pooled Upload Buffer");
+    return buffer;
+}
+
+void common::ResourceRecycler::RecycleUploadBuffer(ComPtr<ID3D12Resource> buffer, UINT64 fenceValue)
+{
+    if (buffer != nullptr) {
+        //the width is the class size, AcquireUploadBuffer made it so
+        const UINT64 classSize = buffer->GetDesc().Width;
+        core.RecycleUploadBuffer(std::move(buffer), classSize, fenceValue);
+    }
+}
+
+void common::ResourceRecycler::Collect()
+{
+    core.Collect();
+}
+
+void common::ResourceRecycler::Clear()
+{
+    assert(fence.IsComplete(fence.GetLastSignaledValue()));
+    core.Clear();
+}
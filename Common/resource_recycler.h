@@ -0,0 +1,59 @@
+#pragma once
+#include "pch.h"
+#include "../Core/recycler_core.h"
+#include "timeline_fence.h"
+
+namespace common
+{
+	class GpuMemoryAllocator;
+
+	/// <summary>
+	/// Keeps d3d objects alive until the gpu is done with them and gives upload buffers a second life.
+	/// Instead of dropping the last ComPtr (and waiting for the gpu before it) the owner hands the object
+	/// here and it's released when the timeline passes the value it was queued with. Upload buffers
+	/// come back to a pool by size class instead of being released.
+	/// Collect must be called regularly, once per frame is enough. Not thread safe. The bookkeeping is
+	/// RecyclerCore's, this adds the creation of the upload buffers.
+	/// </summary>
+	class ResourceRecycler
+	{
+	public:
+		/// <summary>
+		/// allocator may be null, then upload buffers are committed resources.
+		/// </summary>
+		ResourceRecycler(ID3D12Device* device, TimelineFence& fence, GpuMemoryAllocator* allocator);
+		/// <summary>
+		/// Releases object once the work recorded so far is done.
+		/// </summary>
+		void DeferRelease(Microsoft::WRL::ComPtr<IUnknown> object);
+		/// <summary>
+		/// Releases object once the timeline reaches fenceValue.
+		/// </summary>
+		void DeferRelease(Microsoft::WRL::ComPtr<IUnknown> object, UINT64 fenceValue);
+		/// <summary>
+		/// An upload buffer in GENERIC_READ with at least size bytes, from the pool when possible.
+		/// </summary>
+		Microsoft::WRL::ComPtr<ID3D12Resource> AcquireUploadBuffer(UINT64 size);
+		/// <summary>
+		/// Gives back a buffer from AcquireUploadBuffer. It goes back to the pool when the timeline
+		/// reaches fenceValue, the copy that reads it must have been submitted before that signal.
+		/// </summary>
+		void RecycleUploadBuffer(Microsoft::WRL::ComPtr<ID3D12Resource> buffer, UINT64 fenceValue);
+		/// <summary>
+		/// Releases and recycles whatever the gpu is done with. Never waits.
+		/// </summary>
+		void Collect();
+		/// <summary>
+		/// Drops everything, pending or pooled. The gpu must be idle.
+		/// </summary>
+		void Clear();
+		size_t GetPendingCount() const { return core.GetPendingCount(); }
+		const SizeClassPoolStats& GetUploadPoolStats() const { return core.GetUploadPoolStats(); }
+		TimelineFence& GetFence() { return fence; }
+	private:
+		ID3D12Device* device;
+		TimelineFence& fence;
+		GpuMemoryAllocator* allocator;
+		RecyclerCore<Microsoft::WRL::ComPtr<IUnknown>, Microsoft::WRL::ComPtr<ID3D12Resource>> core;
+	};
+}
@@ -1,7 +1,7 @@
 #include "pch.h"
 #include "swapchain.h"
 #include "../Common/d3d_utils.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
 
 common::Swapchain::Swapchain(HWND hwnd, int w, int h, IDxContext&ctx) :
     rtvDescriptorSize(ctx.RtvDescriptorSize())
@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "timeline_fence.h"
+
+common::TimelineFence::TimelineFence(ID3D12Device* device, ID3D12CommandQueue* queue, const std::wstring& name)
+    :queue(queue)
+{
+    assert(device != nullptr);
+    assert(queue != nullptr);
+    HRESULT hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
+    assert(hr == S_OK);
+    fence->SetName(name.c_str());
+    //one event for the lifetime of the fence instead of one per wait
+    event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    assert(event != nullptr);
+}
+
+common::TimelineFence::~TimelineFence()
+{
+    if (event != nullptr) {
+        CloseHandle(event);
+    }
+}
+
+UINT64 common::TimelineFence::Signal()
+{
+    HRESULT hr = queue->Signal(fence.Get(), ++lastSignaledValue);
+    assert(hr == S_OK);
+    return lastSignaledValue;
+}
+
+uint64_t common::TimelineFence::GetCompletedValue() const
+{
+    completedValue = fence->GetCompletedValue();
+    return completedValue;
+}
+
+bool common::TimelineFence::IsComplete(UINT64 value) const
+{
+    return value <= completedValue || value <= GetCompletedValue();
+}
+
+void common::TimelineFence::WaitFor(UINT64 value)
+{
+    assert(value <= lastSignaledValue);
+    if (IsComplete(value)) {
+        return;
+    }
+    HRESULT hr = fence->SetEventOnCompletion(value, event);
+    assert(hr == S_OK);
+    WaitForSingleObject(event, INFINITE);
+    completedValue = value;
+}
+
+void common::TimelineFence::WaitIdle()
+{
+    WaitFor(Signal());
+}
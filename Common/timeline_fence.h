@@ -0,0 +1,45 @@
+#pragma once
+#include "pch.h"
+#include "../Core/deferred_release.h"
+
+namespace common
+{
+	/// <summary>
+	/// One fence per queue whose value only grows. Every submission that needs tracking signals the next
+	/// value, so "is this work done" is a single comparison with the completed value, and waits happen
+	/// only when the value we need wasn't reached yet.
+	/// </summary>
+	class TimelineFence : public FenceTimeline
+	{
+	public:
+		TimelineFence(ID3D12Device* device, ID3D12CommandQueue* queue, const std::wstring& name);
+		~TimelineFence();
+		TimelineFence(const TimelineFence&) = delete;
+		TimelineFence& operator=(const TimelineFence&) = delete;
+		/// <summary>
+		/// Signals the next value on the queue and returns it.
+		/// </summary>
+		UINT64 Signal();
+		uint64_t GetCompletedValue() const override;
+		uint64_t GetNextValue() const override { return lastSignaledValue + 1; }
+		UINT64 GetLastSignaledValue() const { return lastSignaledValue; }
+		bool IsComplete(UINT64 value) const;
+		/// <summary>
+		/// Blocks until value is reached. Returns at once if it already was.
+		/// </summary>
+		void WaitFor(UINT64 value);
+		/// <summary>
+		/// Signals and waits, after it everything submitted to the queue is done.
+		/// </summary>
+		void WaitIdle();
+		ID3D12Fence* Get()const { return fence.Get(); }
+		ID3D12CommandQueue* GetQueue()const { return queue; }
+	private:
+		Microsoft::WRL::ComPtr<ID3D12Fence> fence;
+		ID3D12CommandQueue* queue;
+		HANDLE event = nullptr;
+		UINT64 lastSignaledValue = 0;
+		//GetCompletedValue goes to the driver, so the last value we saw is cached
+		mutable UINT64 completedValue = 0;
+	};
+}
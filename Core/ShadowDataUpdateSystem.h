@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <DirectXMath.h>
+#include <entt/entt.hpp>
+#include "point_light_shadow_camera.h"
+#include "components.h"
+#include "cpu_profiler.h"
+namespace transforms {
+    /// <summary>
+    /// Writes the constants of the 6 faces of every shadow map. The buffer is anything with
+    /// SetValue(frameIndex, id, ShadowMapConstants), usually a UniformBufferForSRVs. The shadow map component
+    /// is a shared_ptr to a PointLightShadowCamera or to something derived from it, like CubeMapShadowMap.
+    /// </summary>
+    template<typename View, typename UniformBuffer>
+    void ShadowDataDataUploadSystem(View&& view, UniformBuffer* shadowMapUniformBuffer, uint32_t frameIndex) {
+        PROFILE_SCOPE("ShadowDataDataUploadSystem");
+        //TODO SHADOW: for each shadow and each of their 6 faces, calculate the view matrix, set the data, etc
+        uint32_t id = 0;
+        view.each(
+            [&shadowMapUniformBuffer, frameIndex, &id]
+            (   entt::entity e, 
+                const transforms::components::Transform& t, 
+                const transforms::components::PointLight& pl, 
+                const auto& sm)
+            {
+                const DirectX::XMFLOAT3 lightPosition = t.GetUpdatedWorldPosition();
+                sm->UpdateLightPosition(lightPosition);
+                for (uint32_t i = 0; i < PointLightShadowCamera::FACE_COUNT; i++) 
+                {
+                    transforms::ShadowMapConstants constants = {};
+                    DirectX::XMStoreFloat4x4(&constants.viewMatrix, XMMatrixTranspose(sm->GetViewMatrix(i)));
+                    DirectX::XMStoreFloat4x4(&constants.projMatrix, XMMatrixTranspose(sm->GetProjectionMatrix()));
+                    constants.lightPosition = lightPosition;
+                    constants.farPlane = sm->GetFarPlane();
+                    shadowMapUniformBuffer->SetValue(frameIndex, id, constants);
+                    id++;
+                }
+            }
+        );
+    }
+}
\ No newline at end of file
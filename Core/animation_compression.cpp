@@ -0,0 +1,630 @@
+#include "pch.h"
+#include "animation_compression.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    using namespace DirectX;
+
+    constexpr float ROTATION_STEPS = 32767.0f;
+    constexpr float VECTOR_STEPS = 65535.0f;
+    constexpr float TIME_STEPS = 65535.0f;
+    constexpr float RANGE_STEPS = 65535.0f;
+    /// <summary>
+    /// The part of the tolerance of a track the quantization of its keys may take, the rest is for the keys
+    /// that are removed.
+    /// </summary>
+    constexpr float QUANTIZATION_SHARE = 0.25f;
+    /// <summary>
+    /// Bisections of the scale of the error shares, in log space, CompressClip tries.
+    /// </summary>
+    constexpr uint32_t SHARE_SEARCH_STEPS = 6;
+
+    /// <summary>
+    /// The components of a rotation with the largest one positive, q and -q being the same rotation, and
+    /// the index of the largest one. The others are within +-1/sqrt(2).
+    /// </summary>
+    uint32_t SmallestThree(FXMVECTOR rotation, float components[4])
+    {
+        XMFLOAT4 q;
+        XMStoreFloat4(&q, XMQuaternionNormalize(rotation));
+        components[0] = q.x;
+        components[1] = q.y;
+        components[2] = q.z;
+        components[3] = q.w;
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; i++) {
+            if (std::fabs(components[i]) > std::fabs(components[largest])) {
+                largest = i;
+            }
+        }
+        if (components[largest] < 0) {
+            for (uint32_t i = 0; i < 4; i++) {
+                components[i] = -components[i];
+            }
+        }
+        return largest;
+    }
+
+    float ToUnit(float value, float minimum, float extent)
+    {
+        return extent > 0 ? std::clamp((value - minimum) / extent, 0.0f, 1.0f) : 0.0f;
+    }
+
+    /// <summary>
+    /// What a key is quantized in: the range of its track or of its block.
+    /// </summary>
+    struct KeyRange
+    {
+        XMFLOAT4 minimum;
+        XMFLOAT4 extent;
+    };
+
+    void PackRotation(FXMVECTOR rotation, const KeyRange& range, uint16_t value[3])
+    {
+        float components[4];
+        const uint32_t largest = SmallestThree(rotation, components);
+        const float minimum[4] = { range.minimum.x, range.minimum.y, range.minimum.z, range.minimum.w };
+        const float extent[4] = { range.extent.x, range.extent.y, range.extent.z, range.extent.w };
+        uint64_t bits = largest;
+        for (uint32_t i = 0; i < 4; i++) {
+            if (i != largest) {
+                const float unit = ToUnit(components[i], minimum[i], extent[i]);
+                bits = (bits << 15) | static_cast<uint64_t>(std::lround(unit * ROTATION_STEPS));
+            }
+        }
+        value[0] = static_cast<uint16_t>(bits >> 32);
+        value[1] = static_cast<uint16_t>(bits >> 16);
+        value[2] = static_cast<uint16_t>(bits);
+    }
+
+    XMVECTOR UnpackRotation(const uint16_t value[3], const KeyRange& range)
+    {
+        const uint64_t bits = (static_cast<uint64_t>(value[0]) << 32) | (static_cast<uint64_t>(value[1]) << 16) | value[2];
+        const uint32_t largest = static_cast<uint32_t>(bits >> 45) & 3;
+        const float minimum[4] = { range.minimum.x, range.minimum.y, range.minimum.z, range.minimum.w };
+        const float extent[4] = { range.extent.x, range.extent.y, range.extent.z, range.extent.w };
+        float components[4];
+        float sum = 0;
+        uint32_t shift = 30;
+        for (uint32_t i = 0; i < 4; i++) {
+            if (i != largest) {
+                const float unit = static_cast<float>((bits >> shift) & 0x7fff) / ROTATION_STEPS;
+                components[i] = minimum[i] + unit * extent[i];
+                sum += components[i] * components[i];
+                shift -= 15;
+            }
+        }
+        components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+        return XMVectorSet(components[0], components[1], components[2], components[3]);
+    }
+
+    void PackVector(FXMVECTOR vector, const KeyRange& range, uint16_t value[3])
+    {
+        XMFLOAT3 v;
+        XMStoreFloat3(&v, vector);
+        value[0] = static_cast<uint16_t>(std::lround(ToUnit(v.x, range.minimum.x, range.extent.x) * VECTOR_STEPS));
+        value[1] = static_cast<uint16_t>(std::lround(ToUnit(v.y, range.minimum.y, range.extent.y) * VECTOR_STEPS));
+        value[2] = static_cast<uint16_t>(std::lround(ToUnit(v.z, range.minimum.z, range.extent.z) * VECTOR_STEPS));
+    }
+
+    XMVECTOR UnpackVector(const uint16_t value[3], const KeyRange& range)
+    {
+        const XMVECTOR unit = XMVectorSet(value[0] / VECTOR_STEPS, value[1] / VECTOR_STEPS, value[2] / VECTOR_STEPS, 0);
+        return XMVectorMultiplyAdd(unit, XMLoadFloat4(&range.extent), XMLoadFloat4(&range.minimum));
+    }
+
+    KeyRange TrackRange(const common::CompressedTrack& track)
+    {
+        return { track.rangeMin, track.rangeExtent };
+    }
+
+    KeyRange UnpackRange(const common::PackedRange& packed, const common::CompressedTrack& track)
+    {
+        const XMVECTOR extent = XMLoadFloat4(&track.rangeExtent);
+        const XMVECTOR minimum = XMVectorSet(packed.minimum[0], packed.minimum[1], packed.minimum[2], packed.minimum[3]);
+        const XMVECTOR size = XMVectorSet(packed.extent[0], packed.extent[1], packed.extent[2], packed.extent[3]);
+        KeyRange range;
+        XMStoreFloat4(&range.minimum, XMVectorMultiplyAdd(XMVectorScale(minimum, 1.0f / RANGE_STEPS), extent,
+            XMLoadFloat4(&track.rangeMin)));
+        XMStoreFloat4(&range.extent, XMVectorMultiply(XMVectorScale(size, 1.0f / RANGE_STEPS), extent));
+        return range;
+    }
+
+    /// <summary>
+    /// The block range that holds minimum to maximum, in the range of the track.
+    /// </summary>
+    common::PackedRange PackRange(const float minimum[4], const float maximum[4], const common::CompressedTrack& track)
+    {
+        const float trackMin[4] = { track.rangeMin.x, track.rangeMin.y, track.rangeMin.z, track.rangeMin.w };
+        const float trackExtent[4] = { track.rangeExtent.x, track.rangeExtent.y, track.rangeExtent.z, track.rangeExtent.w };
+        common::PackedRange packed;
+        for (uint32_t i = 0; i < 4; i++) {
+            const float low = std::floor(ToUnit(minimum[i], trackMin[i], trackExtent[i]) * RANGE_STEPS);
+            const float start = trackMin[i] + low / RANGE_STEPS * trackExtent[i];
+            const float size = std::ceil(ToUnit(maximum[i], start, trackExtent[i]) * RANGE_STEPS);
+            packed.minimum[i] = static_cast<uint16_t>(low);
+            packed.extent[i] = static_cast<uint16_t>(std::min(size, RANGE_STEPS - low));
+        }
+        return packed;
+    }
+
+    /// <summary>
+    /// The bounds of each component over the keys first to last, excluded. A rotation component counts only
+    /// where it's one of the smallest three, the components that never are get 0.
+    /// </summary>
+    template<typename Value>
+    void ValueBounds(const common::AnimationTrack<Value>& track, uint32_t first, uint32_t last, float minimum[4],
+        float maximum[4])
+    {
+        bool seen[4] = { false, false, false, false };
+        for (uint32_t k = first; k < last; k++) {
+            float components[4] = { 0, 0, 0, 0 };
+            uint32_t largest = 4;
+            if constexpr (std::is_same_v<Value, XMFLOAT4>) {
+                largest = SmallestThree(XMLoadFloat4(&track.values[k]), components);
+            }
+            else {
+                components[0] = track.values[k].x;
+                components[1] = track.values[k].y;
+                components[2] = track.values[k].z;
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                if (i != largest) {
+                    minimum[i] = seen[i] ? std::min(minimum[i], components[i]) : components[i];
+                    maximum[i] = seen[i] ? std::max(maximum[i], components[i]) : components[i];
+                    seen[i] = true;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < 4; i++) {
+            if (!seen[i]) {
+                minimum[i] = 0;
+                maximum[i] = 0;
+            }
+        }
+    }
+
+    XMVECTOR Load(const XMFLOAT3& v) { return XMLoadFloat3(&v); }
+    XMVECTOR Load(const XMFLOAT4& v) { return XMLoadFloat4(&v); }
+
+    /// <summary>
+    /// How a track is quantized, interpolated and measured.
+    /// </summary>
+    struct TrackKind
+    {
+        bool rotation;
+        XMVECTOR defaultValue;
+        /// <summary>
+        /// How far the virtual vertices of the bone move between the two values.
+        /// </summary>
+        float (*error)(FXMVECTOR a, FXMVECTOR b, float distance);
+    };
+
+    float TranslationError(FXMVECTOR a, FXMVECTOR b, float)
+    {
+        return XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b)));
+    }
+
+    float RotationError(FXMVECTOR a, FXMVECTOR b, float distance)
+    {
+        //a point at distance moves 2 distance sin(angle / 2), never more than 2 distance |a - b| with b on the
+        //side of a. From the dot product it would drown in float precision below a milliradian
+        const XMVECTOR aligned = XMVectorGetX(XMQuaternionDot(a, b)) < 0 ? XMVectorNegate(b) : b;
+        return 2.0f * distance * XMVectorGetX(XMVector4Length(XMVectorSubtract(a, aligned)));
+    }
+
+    float ScaleError(FXMVECTOR a, FXMVECTOR b, float distance)
+    {
+        return distance * XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b)));
+    }
+
+    XMVECTOR Interpolate(const TrackKind& kind, FXMVECTOR a, FXMVECTOR b, float factor)
+    {
+        return kind.rotation ? XMQuaternionSlerp(a, b, factor) : XMVectorLerp(a, b, factor);
+    }
+
+    /// <summary>
+    /// The range key k of a track is quantized in.
+    /// </summary>
+    KeyRange RangeOfKey(const common::CompressedClip& clip, const common::CompressedTrack& track, uint32_t k)
+    {
+        if (track.rangeCount == 0) {
+            return TrackRange(track);
+        }
+        const uint32_t block = clip.keys[track.firstKey + k].time >> track.rangeShift;
+        return UnpackRange(clip.ranges[track.firstRange + block], track);
+    }
+
+    /// <summary>
+    /// The value of key k of a track.
+    /// </summary>
+    XMVECTOR Unpack(const TrackKind& kind, const common::CompressedClip& clip, const common::CompressedTrack& track,
+        uint32_t k)
+    {
+        const common::PackedKey& key = clip.keys[track.firstKey + k];
+        const KeyRange range = RangeOfKey(clip, track, k);
+        return kind.rotation ? UnpackRotation(key.value, range) : UnpackVector(key.value, range);
+    }
+
+    /// <summary>
+    /// Quantizes a track and keeps the keys that interpolation can't rebuild within tolerance, measured at
+    /// the times of the original keys. The keys are quantized in the range of the track, or of blocks of it
+    /// as small as needed for the quantization to stay within its share of the tolerance. Then greedy: each
+    /// kept key is followed by the farthest key whose segment holds all the keys in between.
+    /// </summary>
+    template<typename Value>
+    common::CompressedTrack CompressTrack(const common::AnimationTrack<Value>& source, const TrackKind& kind,
+        float tolerance, float distance, common::CompressedClip& clip)
+    {
+        common::CompressedTrack track;
+        track.firstKey = static_cast<uint32_t>(clip.keys.size());
+        track.firstRange = static_cast<uint32_t>(clip.ranges.size());
+        const uint32_t count = static_cast<uint32_t>(source.times.size());
+        if (count == 0) {
+            return track;
+        }
+        float minimum[4];
+        float maximum[4];
+        ValueBounds(source, 0, count, minimum, maximum);
+        track.rangeMin = XMFLOAT4(minimum[0], minimum[1], minimum[2], minimum[3]);
+        track.rangeExtent = XMFLOAT4(maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2],
+            maximum[3] - minimum[3]);
+        std::vector<common::PackedKey> packed(count);
+        for (uint32_t k = 0; k < count; k++) {
+            const float steps = clip.timeStep > 0 ? source.times[k] / clip.timeStep : 0.0f;
+            packed[k].time = static_cast<uint16_t>(std::lround(std::clamp(steps, 0.0f, TIME_STEPS)));
+        }
+        std::vector<XMVECTOR> values(count);
+        std::vector<common::PackedRange> ranges;
+        //shift 16 is the whole track, the times are 16 bits; never more blocks than keys
+        for (uint32_t shift = 16; ; shift--) {
+            const uint32_t blockCount = shift < 16 ? (packed.back().time >> shift) + 1u : 0u;
+            if (blockCount > count) {
+                break;
+            }
+            ranges.assign(blockCount, common::PackedRange{});
+            for (uint32_t first = 0, block = 0; block < blockCount; block++) {
+                uint32_t last = first;
+                while (last < count && (packed[last].time >> shift) == block) {
+                    last++;
+                }
+                ValueBounds(source, first, last, minimum, maximum);
+                ranges[block] = PackRange(minimum, maximum, track);
+                first = last;
+            }
+            float quantizationError = 0;
+            for (uint32_t k = 0; k < count; k++) {
+                const KeyRange range = blockCount > 0 ? UnpackRange(ranges[packed[k].time >> shift], track) :
+                    TrackRange(track);
+                if (kind.rotation) {
+                    PackRotation(Load(source.values[k]), range, packed[k].value);
+                    values[k] = UnpackRotation(packed[k].value, range);
+                }
+                else {
+                    PackVector(Load(source.values[k]), range, packed[k].value);
+                    values[k] = UnpackVector(packed[k].value, range);
+                }
+                quantizationError = std::max(quantizationError, kind.error(values[k], Load(source.values[k]), distance));
+            }
+            track.rangeShift = static_cast<uint16_t>(shift);
+            if (quantizationError <= tolerance * QUANTIZATION_SHARE || shift == 0) {
+                break;
+            }
+        }
+        const auto fits = [&](uint32_t first, uint32_t last) {
+            const float start = packed[first].time * clip.timeStep;
+            const float span = (packed[last].time - packed[first].time) * clip.timeStep;
+            for (uint32_t k = first + 1; k < last; k++) {
+                const float factor = span > 0 ? std::clamp((source.times[k] - start) / span, 0.0f, 1.0f) : 0.0f;
+                const XMVECTOR value = Interpolate(kind, values[first], values[last], factor);
+                if (kind.error(value, Load(source.values[k]), distance) > tolerance) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        const auto constant = [&](FXMVECTOR value) {
+            return std::all_of(source.values.begin(), source.values.end(), [&](const Value& v) {
+                return kind.error(value, Load(v), distance) <= tolerance;
+            });
+        };
+        const auto keep = [&](uint32_t k) {
+            clip.keys.push_back(packed[k]);
+            track.keyCount++;
+        };
+        if (constant(kind.defaultValue)) {
+            return track;
+        }
+        //the blocks are stored only for tracks that keep keys
+        track.rangeCount = static_cast<uint16_t>(ranges.size());
+        clip.ranges.insert(clip.ranges.end(), ranges.begin(), ranges.end());
+        keep(0);
+        if (constant(values[0])) {
+            return track;
+        }
+        uint32_t first = 0;
+        while (first + 1 < count) {
+            uint32_t last = first + 1;
+            while (last + 1 < count && fits(first, last + 1)) {
+                last++;
+            }
+            keep(last);
+            first = last;
+        }
+        return track;
+    }
+
+    XMVECTOR SampleCompressedTrack(const common::CompressedClip& clip, const common::CompressedTrack& track,
+        const TrackKind& kind, float time, common::TrackCursor& cursor)
+    {
+        if (track.keyCount == 0) {
+            return kind.defaultValue;
+        }
+        if (track.keyCount == 1) {
+            return Unpack(kind, clip, track, 0);
+        }
+        const common::PackedKey* keys = &clip.keys[track.firstKey];
+        const float steps = clip.timeStep > 0 ? time / clip.timeStep : 0.0f;
+        const uint32_t key = common::FindKey(track.keyCount, steps, cursor,
+            [keys](uint32_t k) { return static_cast<float>(keys[k].time); });
+        const float span = static_cast<float>(keys[key + 1].time - keys[key].time);
+        const float factor = span > 0 ? std::clamp((steps - keys[key].time) / span, 0.0f, 1.0f) : 0.0f;
+        return Interpolate(kind, Unpack(kind, clip, track, key), Unpack(kind, clip, track, key + 1), factor);
+    }
+
+    const TrackKind& PositionKind()
+    {
+        static const TrackKind kind{ false, XMVectorZero(), TranslationError };
+        return kind;
+    }
+
+    const TrackKind& RotationKind()
+    {
+        static const TrackKind kind{ true, XMQuaternionIdentity(), RotationError };
+        return kind;
+    }
+
+    const TrackKind& ScaleKind()
+    {
+        static const TrackKind kind{ false, XMVectorSplatOne(), ScaleError };
+        return kind;
+    }
+
+    /// <summary>
+    /// The parent of each channel, -1 when there's none or it isn't a channel.
+    /// </summary>
+    std::vector<int32_t> ValidParents(const std::vector<int32_t>& parents, size_t channelCount)
+    {
+        std::vector<int32_t> valid(channelCount, -1);
+        for (size_t c = 0; c < std::min(parents.size(), channelCount); c++) {
+            if (parents[c] >= 0 && static_cast<size_t>(parents[c]) < channelCount && static_cast<size_t>(parents[c]) != c) {
+                valid[c] = parents[c];
+            }
+        }
+        return valid;
+    }
+
+    /// <summary>
+    /// Channels with parents before children.
+    /// </summary>
+    std::vector<uint32_t> TopologicalOrder(const std::vector<int32_t>& parents)
+    {
+        std::vector<uint32_t> depth(parents.size(), 0);
+        for (size_t c = 0; c < parents.size(); c++) {
+            //a cycle is cut at the channel count
+            for (int32_t p = parents[c]; p >= 0 && depth[c] < parents.size(); p = parents[p]) {
+                depth[c]++;
+            }
+        }
+        std::vector<uint32_t> order(parents.size());
+        for (uint32_t c = 0; c < order.size(); c++) {
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&depth](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+        return order;
+    }
+
+    /// <summary>
+    /// The shortest gap between keys when every key is a whole number of them from 0, exported clips are
+    /// sampled at a frame rate, else 65535 steps over the clip.
+    /// </summary>
+    float GetTimeStep(const common::AnimationClip& clip)
+    {
+        float endTime = clip.duration;
+        float frame = std::numeric_limits<float>::max();
+        const auto forEachTimes = [&clip](auto visit) {
+            for (const common::AnimationChannel& channel : clip.channels) {
+                visit(channel.tracks.position.times);
+                visit(channel.tracks.rotation.times);
+                visit(channel.tracks.scale.times);
+            }
+        };
+        forEachTimes([&](const std::vector<float>& times) {
+            for (size_t k = 0; k < times.size(); k++) {
+                endTime = std::max(endTime, times[k]);
+                if (k > 0 && times[k] > times[k - 1]) {
+                    frame = std::min(frame, times[k] - times[k - 1]);
+                }
+            }
+        });
+        const float fallback = endTime / TIME_STEPS;
+        if (frame == std::numeric_limits<float>::max() || endTime / frame > TIME_STEPS) {
+            return fallback;
+        }
+        bool onFrames = true;
+        forEachTimes([&](const std::vector<float>& times) {
+            for (float time : times) {
+                const float frames = time / frame;
+                onFrames = onFrames && std::fabs(frames - std::round(frames)) < 0.001f;
+            }
+        });
+        return onFrames ? frame : fallback;
+    }
+
+    float RestLength(const common::AnimationChannel& channel)
+    {
+        const common::Vec3Track& position = channel.tracks.position;
+        return position.IsEmpty() ? 0.0f : XMVectorGetX(XMVector3Length(Load(position.values[0])));
+    }
+}
+
+size_t common::CompressedClip::GetMemorySize() const
+{
+    return keys.size() * sizeof(PackedKey) + ranges.size() * sizeof(PackedRange) +
+        channels.size() * 3 * sizeof(CompressedTrack);
+}
+
+common::CompressedClip common::CompressClip(const AnimationClip& clip, const std::vector<int32_t>& parents,
+    const ClipCompressionSettings& settings)
+{
+    const size_t channelCount = clip.channels.size();
+    const std::vector<int32_t> parent = ValidParents(parents, channelCount);
+    //how many bones the longest chain through each bone has, and how far its farthest descendant is
+    std::vector<uint32_t> depth(channelCount, 0);
+    std::vector<uint32_t> height(channelCount, 0);
+    std::vector<float> extent(channelCount, 0.0f);
+    for (size_t c = 0; c < channelCount; c++) {
+        uint32_t up = 0;
+        float length = RestLength(clip.channels[c]);
+        for (int32_t p = parent[c]; p >= 0 && up < channelCount; p = parent[p]) {
+            up++;
+            height[p] = std::max(height[p], up);
+            extent[p] = std::max(extent[p], length);
+            length += RestLength(clip.channels[p]);
+        }
+        depth[c] = up;
+    }
+
+    const float timeStep = GetTimeStep(clip);
+    const auto compress = [&](float shareScale) {
+        CompressedClip compressed;
+        compressed.name = clip.name;
+        compressed.duration = clip.duration;
+        compressed.timeStep = timeStep;
+        for (size_t c = 0; c < channelCount; c++) {
+            const TransformTracks& tracks = clip.channels[c].tracks;
+            const float tolerance = settings.maxError / (depth[c] + height[c] + 1) * shareScale;
+            const float distance = extent[c] + settings.virtualVertexDistance;
+            CompressedChannel channel;
+            channel.nodeName = clip.channels[c].nodeName;
+            channel.position = CompressTrack(tracks.position, PositionKind(), tolerance, distance, compressed);
+            channel.rotation = CompressTrack(tracks.rotation, RotationKind(), tolerance, distance, compressed);
+            channel.scale = CompressTrack(tracks.scale, ScaleKind(), tolerance, distance, compressed);
+            compressed.channels.push_back(channel);
+        }
+        compressed.keys.shrink_to_fit();
+        compressed.ranges.shrink_to_fit();
+        return compressed;
+    };
+    //a third of the share for each track keeps the vertices within maxError even when the errors of a whole
+    //chain add up, which they rarely do: the shares grow, up to the whole error, as long as the measure allows
+    float low = 1.0f / 3.0f;
+    float high = 1.0f;
+    for (size_t c = 0; c < channelCount; c++) {
+        high = std::max(high, static_cast<float>(depth[c] + height[c] + 1));
+    }
+    CompressedClip best = compress(low);
+    for (uint32_t step = 0; step < SHARE_SEARCH_STEPS; step++) {
+        const float shareScale = std::sqrt(low * high);
+        CompressedClip candidate = compress(shareScale);
+        if (MeasureCompressionError(clip, candidate, parents, settings) <= settings.maxError) {
+            best = std::move(candidate);
+            low = shareScale;
+        }
+        else {
+            high = shareScale;
+        }
+    }
+    return best;
+}
+
+void common::SampleTransform(const CompressedClip& clip, uint32_t channel, float time, TransformCursors& cursors,
+    DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale)
+{
+    const CompressedChannel& c = clip.channels[channel];
+    position = SampleCompressedTrack(clip, c.position, PositionKind(), time, cursors.position);
+    rotation = SampleCompressedTrack(clip, c.rotation, RotationKind(), time, cursors.rotation);
+    scale = SampleCompressedTrack(clip, c.scale, ScaleKind(), time, cursors.scale);
+}
+
+common::AnimationClip common::DecompressClip(const CompressedClip& clip)
+{
+    const auto decompress = [&clip](const CompressedTrack& track, const TrackKind& kind, auto& out) {
+        for (uint32_t k = 0; k < track.keyCount; k++) {
+            out.times.push_back(clip.keys[track.firstKey + k].time * clip.timeStep);
+            out.values.emplace_back();
+            if constexpr (std::is_same_v<std::decay_t<decltype(out)>, QuatTrack>) {
+                XMStoreFloat4(&out.values.back(), Unpack(kind, clip, track, k));
+            }
+            else {
+                XMStoreFloat3(&out.values.back(), Unpack(kind, clip, track, k));
+            }
+        }
+    };
+    AnimationClip result;
+    result.name = clip.name;
+    result.duration = clip.duration;
+    for (const CompressedChannel& channel : clip.channels) {
+        AnimationChannel decompressed;
+        decompressed.nodeName = channel.nodeName;
+        decompress(channel.position, PositionKind(), decompressed.tracks.position);
+        decompress(channel.rotation, RotationKind(), decompressed.tracks.rotation);
+        decompress(channel.scale, ScaleKind(), decompressed.tracks.scale);
+        result.channels.push_back(std::move(decompressed));
+    }
+    return result;
+}
+
+float common::MeasureCompressionError(const AnimationClip& clip, const CompressedClip& compressed,
+    const std::vector<int32_t>& parents, const ClipCompressionSettings& settings, float sampleRate)
+{
+    const size_t channelCount = std::min(clip.channels.size(), compressed.channels.size());
+    const std::vector<int32_t> parent = ValidParents(parents, channelCount);
+    const std::vector<uint32_t> order = TopologicalOrder(parent);
+    std::vector<TransformCursors> cursors(channelCount);
+    std::vector<TransformCursors> compressedCursors(channelCount);
+    std::vector<XMMATRIX> model(channelCount);
+    std::vector<XMMATRIX> compressedModel(channelCount);
+    const float d = settings.virtualVertexDistance;
+    const XMVECTOR vertices[4] = { XMVectorZero(), XMVectorSet(d, 0, 0, 0), XMVectorSet(0, d, 0, 0), XMVectorSet(0, 0, d, 0) };
+    const uint32_t sampleCount = static_cast<uint32_t>(std::ceil(clip.duration * sampleRate)) + 1;
+    float maxError = 0;
+    for (uint32_t s = 0; s < sampleCount; s++) {
+        const float time = std::min(s / sampleRate, clip.duration);
+        for (uint32_t c : order) {
+            XMVECTOR position, rotation, scale;
+            SampleTransform(clip.channels[c].tracks, time, cursors[c], position, rotation, scale);
+            model[c] = XMMatrixScalingFromVector(scale) * XMMatrixRotationQuaternion(rotation) *
+                XMMatrixTranslationFromVector(position);
+            SampleTransform(compressed, c, time, compressedCursors[c], position, rotation, scale);
+            compressedModel[c] = XMMatrixScalingFromVector(scale) * XMMatrixRotationQuaternion(rotation) *
+                XMMatrixTranslationFromVector(position);
+            if (parent[c] >= 0) {
+                model[c] = model[c] * model[parent[c]];
+                compressedModel[c] = compressedModel[c] * compressedModel[parent[c]];
+            }
+            for (const XMVECTOR& vertex : vertices) {
+                const XMVECTOR a = XMVector3Transform(vertex, model[c]);
+                const XMVECTOR b = XMVector3Transform(vertex, compressedModel[c]);
+                maxError = std::max(maxError, XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b))));
+            }
+        }
+    }
+    return maxError;
+}
+
+size_t common::GetMemorySize(const AnimationClip& clip)
+{
+    size_t bytes = 0;
+    for (const AnimationChannel& channel : clip.channels) {
+        const TransformTracks& tracks = channel.tracks;
+        bytes += tracks.position.times.size() * (sizeof(float) + sizeof(XMFLOAT3));
+        bytes += tracks.rotation.times.size() * (sizeof(float) + sizeof(XMFLOAT4));
+        bytes += tracks.scale.times.size() * (sizeof(float) + sizeof(XMFLOAT3));
+    }
+    return bytes;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "animation_track.h"
+
+namespace common
+{
+	struct ClipCompressionSettings
+	{
+		/// <summary>
+		/// How far a vertex may end up from where the uncompressed clip puts it, in the units of the clip: the
+		/// defaults are for centimetres, what the mixamo rigs are in. Error adds up down the hierarchy, so each
+		/// bone starts with a share, maxError over the bones of the longest chain through it; the shares are
+		/// then scaled up as long as MeasureCompressionError stays within maxError.
+		/// </summary>
+		float maxError = 0.1f;
+		/// <summary>
+		/// The error of a bone is measured on virtual vertices: at its descendants, and this far past the
+		/// farthest of them, where the skin is.
+		/// </summary>
+		float virtualVertexDistance = 3.0f;
+	};
+
+	/// <summary>
+	/// A key in 64 bits: the time, in steps of CompressedClip::timeStep, and the value in 48 bits. A rotation
+	/// is in smallest three: the index of the largest component in 2 bits and the other three in 15 bits
+	/// each, the largest one made positive and rebuilt from the unit length. A vector is 16 bits per
+	/// component. Both are quantized in the range of their track, a bone rarely turns far in a clip, or in
+	/// the range of their block of the track when that's too coarse.
+	/// </summary>
+	struct PackedKey
+	{
+		uint16_t time;
+		uint16_t value[3];
+	};
+
+	/// <summary>
+	/// The range of a block of a track, in 65535 steps of the range of the track: the minimum rounded down,
+	/// the extent rounded up.
+	/// </summary>
+	struct PackedRange
+	{
+		uint16_t minimum[4];
+		uint16_t extent[4];
+	};
+
+	struct CompressedTrack
+	{
+		uint32_t firstKey = 0;
+		/// <summary>
+		/// 0 is the default value of the track: no translation, no rotation, unit scale.
+		/// </summary>
+		uint32_t keyCount = 0;
+		/// <summary>
+		/// When the range of the track is too coarse for the error, a bone far from its vertices rotating, the
+		/// track is cut in blocks of 2^rangeShift time steps and the keys are quantized in the range of their
+		/// block, rangeCount of them in CompressedClip::ranges from firstRange. 0 blocks is the whole track.
+		/// </summary>
+		uint32_t firstRange = 0;
+		uint16_t rangeCount = 0;
+		uint16_t rangeShift = 0;
+		/// <summary>
+		/// The range of the keys: xyz of vectors, all four components of rotations.
+		/// </summary>
+		DirectX::XMFLOAT4 rangeMin = DirectX::XMFLOAT4(0, 0, 0, 0);
+		DirectX::XMFLOAT4 rangeExtent = DirectX::XMFLOAT4(0, 0, 0, 0);
+	};
+
+	struct CompressedChannel
+	{
+		std::string nodeName;
+		CompressedTrack position;
+		CompressedTrack rotation;
+		CompressedTrack scale;
+	};
+
+	/// <summary>
+	/// An AnimationClip with the keys that interpolation can rebuild within the error removed and the rest
+	/// quantized. The keys of all the tracks are in one array; it's sampled as it is, without decompressing
+	/// the clip first.
+	/// </summary>
+	struct CompressedClip
+	{
+		std::string name;
+		float duration = 0;
+		/// <summary>
+		/// Seconds per unit of PackedKey::time: the frame of the clip when its keys are on frames, which keeps
+		/// their times exact, and the clip in 65535 steps otherwise.
+		/// </summary>
+		float timeStep = 0;
+		std::vector<CompressedChannel> channels;
+		std::vector<PackedKey> keys;
+		std::vector<PackedRange> ranges;
+		/// <summary>
+		/// Bytes of the keys, the ranges and the tracks, without the names.
+		/// </summary>
+		size_t GetMemorySize() const;
+	};
+
+	/// <summary>
+	/// parents[c] is the channel of the parent bone of channel c, -1 for roots. Bones whose parent has no
+	/// channel count as roots; empty parents makes every channel a root.
+	/// </summary>
+	CompressedClip CompressClip(const AnimationClip& clip, const std::vector<int32_t>& parents,
+		const ClipCompressionSettings& settings = {});
+	/// <summary>
+	/// The transform of a channel at time, from the packed keys. The cursors work like the ones of the
+	/// uncompressed tracks, one set per channel.
+	/// </summary>
+	void SampleTransform(const CompressedClip& clip, uint32_t channel, float time, TransformCursors& cursors,
+		DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale);
+	/// <summary>
+	/// The kept keys back as float tracks, for tools and for checking the compression.
+	/// </summary>
+	AnimationClip DecompressClip(const CompressedClip& clip);
+	/// <summary>
+	/// The largest distance between a virtual vertex posed by the clip and by the compressed clip, over the
+	/// clip sampled at sampleRate. The vertices are the bones and points virtualVertexDistance away from
+	/// them on their axes.
+	/// </summary>
+	float MeasureCompressionError(const AnimationClip& clip, const CompressedClip& compressed,
+		const std::vector<int32_t>& parents, const ClipCompressionSettings& settings = {}, float sampleRate = 120.0f);
+	/// <summary>
+	/// Bytes of the times and values of the tracks, what CompressedClip::GetMemorySize compares to.
+	/// </summary>
+	size_t GetMemorySize(const AnimationClip& clip);
+}
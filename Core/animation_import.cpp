@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "animation_import.h"
+#include <assimp/scene.h>
+
+namespace
+{
+    //what assimp means by 0 ticks per second
+    constexpr double DEFAULT_TICKS_PER_SECOND = 25.0;
+
+    template<typename Key, typename Value, typename Convert>
+    void ImportKeys(const Key* keys, unsigned int count, double ticksPerSecond,
+        common::AnimationTrack<Value>& track, Convert convert)
+    {
+        track.times.reserve(count);
+        track.values.reserve(count);
+        for (unsigned int k = 0; k < count; k++) {
+            const float time = static_cast<float>(keys[k].mTime / ticksPerSecond);
+            if (!track.times.empty() && time < track.times.back()) {
+                continue;
+            }
+            track.times.push_back(time);
+            track.values.push_back(convert(keys[k].mValue));
+        }
+    }
+
+    DirectX::XMFLOAT3 ToFloat3(const aiVector3D& v)
+    {
+        return DirectX::XMFLOAT3(v.x, v.y, v.z);
+    }
+
+    DirectX::XMFLOAT4 ToFloat4(const aiQuaternion& q)
+    {
+        return DirectX::XMFLOAT4(q.x, q.y, q.z, q.w);
+    }
+}
+
+common::TransformTracks common::ImportTracks(const aiNodeAnim& channel, double ticksPerSecond)
+{
+    TransformTracks tracks;
+    ImportKeys(channel.mPositionKeys, channel.mNumPositionKeys, ticksPerSecond, tracks.position, ToFloat3);
+    ImportKeys(channel.mRotationKeys, channel.mNumRotationKeys, ticksPerSecond, tracks.rotation, ToFloat4);
+    ImportKeys(channel.mScalingKeys, channel.mNumScalingKeys, ticksPerSecond, tracks.scale, ToFloat3);
+    return tracks;
+}
+
+common::AnimationClip common::ImportAnimation(const aiAnimation& animation)
+{
+    const double ticksPerSecond = animation.mTicksPerSecond != 0.0 ?
+        animation.mTicksPerSecond : DEFAULT_TICKS_PER_SECOND;
+    AnimationClip clip;
+    clip.name = animation.mName.C_Str();
+    clip.duration = static_cast<float>(animation.mDuration / ticksPerSecond);
+    clip.channels.reserve(animation.mNumChannels);
+    for (unsigned int c = 0; c < animation.mNumChannels; c++) {
+        const aiNodeAnim& channel = *animation.mChannels[c];
+        clip.channels.push_back({ channel.mNodeName.C_Str(), ImportTracks(channel, ticksPerSecond) });
+    }
+    return clip;
+}
+
+std::vector<common::AnimationClip> common::ImportAnimations(const aiScene& scene)
+{
+    std::vector<AnimationClip> clips;
+    clips.reserve(scene.mNumAnimations);
+    for (unsigned int a = 0; a < scene.mNumAnimations; a++) {
+        clips.push_back(ImportAnimation(*scene.mAnimations[a]));
+    }
+    return clips;
+}
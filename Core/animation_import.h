@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "animation_track.h"
+
+struct aiAnimation;
+struct aiNodeAnim;
+struct aiScene;
+
+namespace common
+{
+	/// <summary>
+	/// The translation, rotation and scale keys of an assimp channel as tracks, times from ticks to seconds.
+	/// One pass over each of the three key arrays, the channels stay apart: no merging and no sort. Assimp
+	/// gives the keys in order; a key earlier than the one before it would break the search and is dropped.
+	/// </summary>
+	TransformTracks ImportTracks(const aiNodeAnim& channel, double ticksPerSecond);
+	/// <summary>
+	/// Every channel of the animation. Linear in the number of keys.
+	/// </summary>
+	AnimationClip ImportAnimation(const aiAnimation& animation);
+	std::vector<AnimationClip> ImportAnimations(const aiScene& scene);
+}
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "animation_lod.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <cmath>
+
+uint32_t common::GetUpdateInterval(AnimationLodTier tier)
+{
+    return 1u << static_cast<uint32_t>(tier);
+}
+
+float common::GetScreenSize(float height, float distance, float fovY)
+{
+    if (distance <= 0) {
+        return 1.0f;
+    }
+    return height / (2.0f * distance * std::tan(fovY * 0.5f));
+}
+
+common::AnimationLodTier common::SelectLodTier(const AnimationLodSettings& settings, float screenSize,
+    AnimationLodTier current)
+{
+    const float thresholds[] = { settings.everyFrameScreenSize, settings.every2ndFrameScreenSize };
+    uint32_t tier = 0;
+    while (tier < ANIMATION_LOD_TIER_COUNT - 1) {
+        //staying in a tier or moving to a coarser one takes the plain threshold, getting to a finer one more
+        const bool finer = tier < static_cast<uint32_t>(current);
+        const float threshold = finer ? thresholds[tier] * (1.0f + settings.hysteresis) : thresholds[tier];
+        if (screenSize >= threshold) {
+            break;
+        }
+        tier++;
+    }
+    return static_cast<AnimationLodTier>(tier);
+}
+
+std::vector<uint32_t> common::ComputeBoneDepths(const Skeleton& skeleton)
+{
+    //parents come first, their depth is known
+    std::vector<uint32_t> depths(skeleton.GetBoneCount(), 0);
+    for (uint32_t b = 0; b < skeleton.GetBoneCount(); b++) {
+        const int32_t parent = skeleton.parents[b];
+        depths[b] = parent >= 0 ? depths[parent] + 1 : 0;
+    }
+    return depths;
+}
+
+std::vector<int32_t> common::ReduceChannelBones(const std::vector<int32_t>& channelBones,
+    const std::vector<uint32_t>& boneDepths, uint32_t maxDepth)
+{
+    std::vector<int32_t> reduced = channelBones;
+    for (int32_t& bone : reduced) {
+        if (bone >= 0 && boneDepths[bone] > maxDepth) {
+            bone = -1;
+        }
+    }
+    return reduced;
+}
+
+common::AnimationLodStep common::AdvanceAnimationLod(AnimationLodState& state, AnimationLodTier tier, bool visible,
+    uint32_t phase)
+{
+    AnimationLodStep step;
+    if (!visible) {
+        //what it had is stale when it comes back
+        state.span = 0;
+        step.skip = true;
+        return step;
+    }
+    if (tier != state.tier) {
+        state.tier = tier;
+        state.span = 0;
+    }
+    const uint32_t interval = GetUpdateInterval(tier);
+    step.evaluate = true;
+    if (interval == 1) {
+        state.span = 0;
+        return step;
+    }
+    if (state.span == 0) {
+        //the first span is shortened by the phase, so that the characters of the tier don't all evaluate together
+        state.frame = 0;
+        state.span = interval - phase % interval;
+        step.refresh = true;
+        step.lookahead = state.span;
+        return step;
+    }
+    state.frame++;
+    if (state.frame >= state.span) {
+        state.frame = 0;
+        state.span = interval;
+        step.lookahead = interval;
+        return step;
+    }
+    step.evaluate = false;
+    step.blend = static_cast<float>(state.frame) / state.span;
+    return step;
+}
+
+void common::BlendSkinMatrices(const std::vector<DirectX::XMFLOAT4X4>& from,
+    const std::vector<DirectX::XMFLOAT4X4>& to, float blend, std::vector<DirectX::XMFLOAT4X4>& out)
+{
+    using namespace DirectX;
+    out.resize(from.size());
+    for (size_t j = 0; j < from.size(); j++) {
+        for (int r = 0; r < 4; r++) {
+            const XMVECTOR a = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(from[j].m[r]));
+            const XMVECTOR b = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(to[j].m[r]));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(out[j].m[r]), XMVectorLerp(a, b, blend));
+        }
+    }
+}
+
+void common::AnimateCrowdLod(WorkerPool& workerPool, std::vector<LodCrowdCharacter>& characters, float deltaTime)
+{
+    //the evaluations of now, into the shown or the previous matrices, and the ones ahead into the next
+    std::vector<CrowdCharacter> now;
+    std::vector<CrowdCharacter> ahead;
+    std::vector<std::pair<const LodCrowdCharacter*, float>> blends;
+    for (LodCrowdCharacter& lodCharacter : characters) {
+        const AnimationLodTier tier = SelectLodTier(*lodCharacter.settings, lodCharacter.screenSize,
+            lodCharacter.state->tier);
+        const AnimationLodStep step = AdvanceAnimationLod(*lodCharacter.state, tier, lodCharacter.visible,
+            lodCharacter.phase);
+        if (step.skip) {
+            continue;
+        }
+        CrowdCharacter character = lodCharacter.character;
+        const std::vector<int32_t>* tierChannelBones = lodCharacter.tierChannelBones[static_cast<uint32_t>(tier)];
+        if (character.clip && tierChannelBones) {
+            character.channelBones = tierChannelBones;
+        }
+        if (step.lookahead == 0) {
+            now.push_back(character);
+            continue;
+        }
+        if (step.refresh) {
+            //bones the tier doesn't sample go back to the rest pose instead of freezing where they were
+            *character.pose = character.skeleton->restPose;
+            CrowdCharacter previous = character;
+            previous.skinMatrices = lodCharacter.previous;
+            now.push_back(previous);
+        }
+        else if (step.evaluate) {
+            std::swap(*lodCharacter.previous, *lodCharacter.next);
+        }
+        if (step.evaluate) {
+            CrowdCharacter next = character;
+            next.skinMatrices = lodCharacter.next;
+            next.time += step.lookahead * deltaTime;
+            if (character.clip && character.clip->duration > 0) {
+                next.time = lodCharacter.looping ? std::fmod(next.time, character.clip->duration) :
+                    std::min(next.time, character.clip->duration);
+            }
+            ahead.push_back(next);
+        }
+        blends.emplace_back(&lodCharacter, step.blend);
+    }
+    AnimateCrowd(workerPool, now);
+    AnimateCrowd(workerPool, ahead);
+    const uint32_t chunkCount = static_cast<uint32_t>((blends.size() + CROWD_CHUNK_SIZE - 1) / CROWD_CHUNK_SIZE);
+    workerPool.ParallelFor(chunkCount, [&blends](uint32_t chunk) {
+        const size_t end = std::min(blends.size(), (chunk + 1) * static_cast<size_t>(CROWD_CHUNK_SIZE));
+        for (size_t i = chunk * static_cast<size_t>(CROWD_CHUNK_SIZE); i < end; i++) {
+            const LodCrowdCharacter& lodCharacter = *blends[i].first;
+            BlendSkinMatrices(*lodCharacter.previous, *lodCharacter.next, blends[i].second,
+                *lodCharacter.character.skinMatrices);
+        }
+    });
+}
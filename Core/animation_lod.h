@@ -0,0 +1,126 @@
+#pragma once
+#include <DirectXMath.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "crowd_animation.h"
+
+namespace common
+{
+	class WorkerPool;
+
+	/// <summary>
+	/// How often the animation of a character is evaluated. Between evaluations the skin matrices are blended
+	/// from the previous evaluation to the next one.
+	/// </summary>
+	enum class AnimationLodTier : uint8_t
+	{
+		EveryFrame,
+		Every2ndFrame,
+		Every4thFrame
+	};
+	constexpr uint32_t ANIMATION_LOD_TIER_COUNT = 3;
+	/// <summary>
+	/// Frames from one evaluation to the next: 1, 2 or 4.
+	/// </summary>
+	uint32_t GetUpdateInterval(AnimationLodTier tier);
+
+	struct AnimationLodSettings
+	{
+		/// <summary>
+		/// The smallest screen size of the first two tiers, smaller characters go to the next one.
+		/// </summary>
+		float everyFrameScreenSize = 0.2f;
+		float every2ndFrameScreenSize = 0.08f;
+		/// <summary>
+		/// A character goes back to a finer tier only when its screen size is this fraction above the threshold,
+		/// so that one at the border doesn't switch every frame.
+		/// </summary>
+		float hysteresis = 0.15f;
+		/// <summary>
+		/// The bones deeper than this, roots at 0, aren't sampled in the tier and keep the rest pose. Fingers
+		/// and the like in the far tiers.
+		/// </summary>
+		std::array<uint32_t, ANIMATION_LOD_TIER_COUNT> maxBoneDepth{ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+	};
+	/// <summary>
+	/// The height on the screen of something height tall at distance, as a fraction of the viewport height.
+	/// fovY in radians.
+	/// </summary>
+	float GetScreenSize(float height, float distance, float fovY);
+	/// <summary>
+	/// The tier of a character of that screen size that is in current now.
+	/// </summary>
+	AnimationLodTier SelectLodTier(const AnimationLodSettings& settings, float screenSize, AnimationLodTier current);
+
+	/// <summary>
+	/// The depth of each bone, roots at 0.
+	/// </summary>
+	std::vector<uint32_t> ComputeBoneDepths(const Skeleton& skeleton);
+	/// <summary>
+	/// channelBones without the bones deeper than maxDepth, their channels are -1.
+	/// </summary>
+	std::vector<int32_t> ReduceChannelBones(const std::vector<int32_t>& channelBones,
+		const std::vector<uint32_t>& boneDepths, uint32_t maxDepth);
+
+	/// <summary>
+	/// Where a character is between its evaluations. span 0 means there's nothing to blend from, the next
+	/// evaluation refreshes both ends.
+	/// </summary>
+	struct AnimationLodState
+	{
+		AnimationLodTier tier = AnimationLodTier::EveryFrame;
+		uint32_t frame = 0;
+		uint32_t span = 0;
+	};
+	/// <summary>
+	/// What a character does this frame. skip: nothing, it isn't visible. With lookahead 0 the animation is
+	/// evaluated into the shown matrices, as if there was no LOD. Otherwise, refresh evaluates the previous
+	/// end now; evaluate makes the next end the previous one, unless refreshed, and evaluates lookahead frames
+	/// ahead into the next end. What's shown is previous blended to next by blend.
+	/// </summary>
+	struct AnimationLodStep
+	{
+		bool skip = false;
+		bool refresh = false;
+		bool evaluate = false;
+		uint32_t lookahead = 0;
+		float blend = 0;
+	};
+	/// <summary>
+	/// One frame of a character in tier. An invisible character is skipped and refreshed when it's visible
+	/// again, and so is one that changes tier. phase, any number that differs between characters, spreads the
+	/// evaluations of a tier over its frames.
+	/// </summary>
+	AnimationLodStep AdvanceAnimationLod(AnimationLodState& state, AnimationLodTier tier, bool visible, uint32_t phase);
+	/// <summary>
+	/// from + (to - from) * blend, element by element. Over the few frames between evaluations the rotations
+	/// barely change and the lerp doesn't show.
+	/// </summary>
+	void BlendSkinMatrices(const std::vector<DirectX::XMFLOAT4X4>& from, const std::vector<DirectX::XMFLOAT4X4>& to,
+		float blend, std::vector<DirectX::XMFLOAT4X4>& out);
+
+	/// <summary>
+	/// A character of a crowd with animation LOD. character.time is now and character.skinMatrices what's shown;
+	/// previous and next are the two evaluations it's blended from. tierChannelBones replaces
+	/// character.channelBones in each tier where it isn't null, for the reduced bone sets.
+	/// </summary>
+	struct LodCrowdCharacter
+	{
+		CrowdCharacter character;
+		bool looping = true;
+		const AnimationLodSettings* settings = nullptr;
+		std::array<const std::vector<int32_t>*, ANIMATION_LOD_TIER_COUNT> tierChannelBones{};
+		float screenSize = 1;
+		bool visible = true;
+		uint32_t phase = 0;
+		AnimationLodState* state = nullptr;
+		std::vector<DirectX::XMFLOAT4X4>* previous = nullptr;
+		std::vector<DirectX::XMFLOAT4X4>* next = nullptr;
+	};
+	/// <summary>
+	/// A frame of the crowd: picks each character's tier, evaluates the ones that are due with AnimateCrowd,
+	/// deltaTime per frame of lookahead, and blends the rest. Invisible characters cost nothing.
+	/// </summary>
+	void AnimateCrowdLod(WorkerPool& workerPool, std::vector<LodCrowdCharacter>& characters, float deltaTime);
+}
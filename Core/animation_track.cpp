@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "animation_track.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    float KeyFactor(const std::vector<float>& times, uint32_t key, float time)
+    {
+        const float span = times[key + 1] - times[key];
+        if (span <= 0) {
+            return 0;
+        }
+        return std::clamp((time - times[key]) / span, 0.0f, 1.0f);
+    }
+
+    /// <summary>
+    /// The sample before time and how far time is to the next one. At least two samples.
+    /// </summary>
+    template<typename Value>
+    uint32_t UniformKey(const common::UniformTrack<Value>& track, float time, float& factor)
+    {
+        const float last = static_cast<float>(track.values.size() - 1);
+        const float position = std::clamp(time * track.sampleRate, 0.0f, last);
+        const uint32_t key = std::min(static_cast<uint32_t>(position), static_cast<uint32_t>(track.values.size() - 2));
+        factor = position - static_cast<float>(key);
+        return key;
+    }
+
+    template<typename Value>
+    common::UniformTrack<Value> ResampleTrack(const common::AnimationTrack<Value>& track, float sampleRate,
+        float endTime, DirectX::FXMVECTOR defaultValue)
+    {
+        assert(sampleRate > 0);
+        common::UniformTrack<Value> uniform;
+        uniform.sampleRate = sampleRate;
+        if (track.IsEmpty()) {
+            return uniform;
+        }
+        const uint32_t count = static_cast<uint32_t>(std::ceil(endTime * sampleRate)) + 1;
+        uniform.values.resize(count);
+        common::TrackCursor cursor;
+        for (uint32_t i = 0; i < count; i++) {
+            const DirectX::XMVECTOR value = common::SampleTrack(track, i / sampleRate, cursor, defaultValue);
+            if constexpr (std::is_same_v<Value, DirectX::XMFLOAT3>) {
+                DirectX::XMStoreFloat3(&uniform.values[i], value);
+            }
+            else {
+                DirectX::XMStoreFloat4(&uniform.values[i], value);
+            }
+        }
+        return uniform;
+    }
+}
+
+uint32_t common::FindKey(const std::vector<float>& times, float time, TrackCursor& cursor)
+{
+    return FindKey(static_cast<uint32_t>(times.size()), time, cursor, [&times](uint32_t key) { return times[key]; });
+}
+
+uint32_t common::FindKey(const std::vector<float>& times, float time)
+{
+    if (times.size() < 2) {
+        return 0;
+    }
+    //the first key after time, minus one, is the key before it
+    const auto next = std::upper_bound(times.begin() + 1, times.end() - 1, time);
+    return static_cast<uint32_t>(next - times.begin()) - 1;
+}
+
+DirectX::XMVECTOR common::SampleTrack(const Vec3Track& track, float time, TrackCursor& cursor,
+    DirectX::FXMVECTOR defaultValue)
+{
+    using namespace DirectX;
+    if (track.times.size() < 2) {
+        return track.IsEmpty() ? defaultValue : XMLoadFloat3(&track.values[0]);
+    }
+    const uint32_t key = FindKey(track.times, time, cursor);
+    return XMVectorLerp(XMLoadFloat3(&track.values[key]), XMLoadFloat3(&track.values[key + 1]),
+        KeyFactor(track.times, key, time));
+}
+
+DirectX::XMVECTOR common::SampleTrack(const QuatTrack& track, float time, TrackCursor& cursor,
+    DirectX::FXMVECTOR defaultValue)
+{
+    using namespace DirectX;
+    if (track.times.size() < 2) {
+        return track.IsEmpty() ? defaultValue : XMLoadFloat4(&track.values[0]);
+    }
+    const uint32_t key = FindKey(track.times, time, cursor);
+    return XMQuaternionSlerp(XMLoadFloat4(&track.values[key]), XMLoadFloat4(&track.values[key + 1]),
+        KeyFactor(track.times, key, time));
+}
+
+common::UniformVec3Track common::Resample(const Vec3Track& track, float sampleRate, float endTime)
+{
+    return ResampleTrack(track, sampleRate, endTime, DirectX::XMVectorZero());
+}
+
+common::UniformQuatTrack common::Resample(const QuatTrack& track, float sampleRate, float endTime)
+{
+    return ResampleTrack(track, sampleRate, endTime, DirectX::XMQuaternionIdentity());
+}
+
+DirectX::XMVECTOR common::SampleTrack(const UniformVec3Track& track, float time, DirectX::FXMVECTOR defaultValue)
+{
+    using namespace DirectX;
+    if (track.values.size() < 2) {
+        return track.values.empty() ? defaultValue : XMLoadFloat3(&track.values[0]);
+    }
+    float factor = 0;
+    const uint32_t key = UniformKey(track, time, factor);
+    return XMVectorLerp(XMLoadFloat3(&track.values[key]), XMLoadFloat3(&track.values[key + 1]), factor);
+}
+
+DirectX::XMVECTOR common::SampleTrack(const UniformQuatTrack& track, float time, DirectX::FXMVECTOR defaultValue)
+{
+    using namespace DirectX;
+    if (track.values.size() < 2) {
+        return track.values.empty() ? defaultValue : XMLoadFloat4(&track.values[0]);
+    }
+    float factor = 0;
+    const uint32_t key = UniformKey(track, time, factor);
+    return XMQuaternionSlerp(XMLoadFloat4(&track.values[key]), XMLoadFloat4(&track.values[key + 1]), factor);
+}
+
+float common::TransformTracks::GetEndTime() const
+{
+    return std::max({ position.GetEndTime(), rotation.GetEndTime(), scale.GetEndTime() });
+}
+
+common::UniformTransformTracks common::Resample(const TransformTracks& tracks, float sampleRate)
+{
+    const float endTime = tracks.GetEndTime();
+    UniformTransformTracks uniform;
+    uniform.position = Resample(tracks.position, sampleRate, endTime);
+    uniform.rotation = Resample(tracks.rotation, sampleRate, endTime);
+    uniform.scale = Resample(tracks.scale, sampleRate, endTime);
+    return uniform;
+}
+
+void common::SampleTransform(const TransformTracks& tracks, float time, TransformCursors& cursors,
+    DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale)
+{
+    using namespace DirectX;
+    position = SampleTrack(tracks.position, time, cursors.position, XMVectorZero());
+    rotation = SampleTrack(tracks.rotation, time, cursors.rotation, XMQuaternionIdentity());
+    scale = SampleTrack(tracks.scale, time, cursors.scale, XMVectorSplatOne());
+}
+
+void common::SampleTransform(const UniformTransformTracks& tracks, float time,
+    DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale)
+{
+    using namespace DirectX;
+    position = SampleTrack(tracks.position, time, XMVectorZero());
+    rotation = SampleTrack(tracks.rotation, time, XMQuaternionIdentity());
+    scale = SampleTrack(tracks.scale, time, XMVectorSplatOne());
+}
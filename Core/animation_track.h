@@ -0,0 +1,169 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// The keys of one channel of a bone: increasing times, in seconds, and the value at each. Translation,
+	/// rotation and scale are separate tracks, each with its own keys, the way the files have them.
+	/// </summary>
+	template<typename Value>
+	struct AnimationTrack
+	{
+		std::vector<float> times;
+		std::vector<Value> values;
+		bool IsEmpty() const { return times.empty(); }
+		float GetEndTime() const { return times.empty() ? 0.0f : times.back(); }
+	};
+	using Vec3Track = AnimationTrack<DirectX::XMFLOAT3>;
+	using QuatTrack = AnimationTrack<DirectX::XMFLOAT4>;
+
+	/// <summary>
+	/// Where a track was last sampled. Playback moves a key or two per frame, so the next search starts at
+	/// the cursor and steps forward; jumps, backwards too, fall back to a binary search.
+	/// </summary>
+	struct TrackCursor
+	{
+		uint32_t key = 0;
+	};
+
+	/// <summary>
+	/// Past this many keys from the cursor a binary search is cheaper than stepping.
+	/// </summary>
+	constexpr uint32_t MAX_CURSOR_STEPS = 4;
+
+	/// <summary>
+	/// The key k with timeOf(k) <= time < timeOf(k + 1), from 0 to count - 2: times before the first key give
+	/// 0 and times after the last one give the last pair. Moves the cursor there. For keys in any layout,
+	/// timeOf(k) is the time of key k in the units of time.
+	/// </summary>
+	template<typename TimeOf>
+	uint32_t FindKey(uint32_t count, float time, TrackCursor& cursor, TimeOf timeOf)
+	{
+		if (count < 2) {
+			return 0;
+		}
+		uint32_t key = cursor.key;
+		if (key + 1 < count && timeOf(key) <= time) {
+			for (uint32_t step = 0; step <= MAX_CURSOR_STEPS; step++) {
+				if (key + 2 >= count || time < timeOf(key + 1)) {
+					cursor.key = key;
+					return key;
+				}
+				key++;
+			}
+		}
+		//the first key after time, minus one, is the key before it
+		uint32_t first = 1;
+		uint32_t last = count - 1;
+		while (first < last) {
+			const uint32_t middle = first + (last - first) / 2;
+			if (timeOf(middle) <= time) {
+				first = middle + 1;
+			}
+			else {
+				last = middle;
+			}
+		}
+		cursor.key = first - 1;
+		return cursor.key;
+	}
+	/// <summary>
+	/// FindKey over the times of a track.
+	/// </summary>
+	uint32_t FindKey(const std::vector<float>& times, float time, TrackCursor& cursor);
+	/// <summary>
+	/// FindKey without a cursor, always the binary search. For random seeks.
+	/// </summary>
+	uint32_t FindKey(const std::vector<float>& times, float time);
+
+	/// <summary>
+	/// The track at time, lerped between its keys and clamped to the first and last ones. An empty track
+	/// gives defaultValue.
+	/// </summary>
+	DirectX::XMVECTOR SampleTrack(const Vec3Track& track, float time, TrackCursor& cursor,
+		DirectX::FXMVECTOR defaultValue);
+	/// <summary>
+	/// The rotation at time, slerped between its keys.
+	/// </summary>
+	DirectX::XMVECTOR SampleTrack(const QuatTrack& track, float time, TrackCursor& cursor,
+		DirectX::FXMVECTOR defaultValue);
+
+	/// <summary>
+	/// A track resampled at a fixed rate: sample i is the track at i / sampleRate. Finding the keys is a
+	/// multiplication, with no search and no cursor. Keys between the samples are lost, bake at a rate at
+	/// least as high as the source's.
+	/// </summary>
+	template<typename Value>
+	struct UniformTrack
+	{
+		float sampleRate = 0;
+		std::vector<Value> values;
+	};
+	using UniformVec3Track = UniformTrack<DirectX::XMFLOAT3>;
+	using UniformQuatTrack = UniformTrack<DirectX::XMFLOAT4>;
+
+	/// <summary>
+	/// Samples from 0 to endTime, the last one at or past it. An empty track stays empty.
+	/// </summary>
+	UniformVec3Track Resample(const Vec3Track& track, float sampleRate, float endTime);
+	UniformQuatTrack Resample(const QuatTrack& track, float sampleRate, float endTime);
+	DirectX::XMVECTOR SampleTrack(const UniformVec3Track& track, float time, DirectX::FXMVECTOR defaultValue);
+	DirectX::XMVECTOR SampleTrack(const UniformQuatTrack& track, float time, DirectX::FXMVECTOR defaultValue);
+
+	/// <summary>
+	/// The translation, rotation and scale tracks of a bone. Empty tracks are the identity.
+	/// </summary>
+	struct TransformTracks
+	{
+		Vec3Track position;
+		QuatTrack rotation;
+		Vec3Track scale;
+		/// <summary>
+		/// The last key of any of the tracks.
+		/// </summary>
+		float GetEndTime() const;
+	};
+	struct TransformCursors
+	{
+		TrackCursor position;
+		TrackCursor rotation;
+		TrackCursor scale;
+	};
+	struct UniformTransformTracks
+	{
+		UniformVec3Track position;
+		UniformQuatTrack rotation;
+		UniformVec3Track scale;
+	};
+	/// <summary>
+	/// All three tracks at the same rate, up to the end of the longest one.
+	/// </summary>
+	UniformTransformTracks Resample(const TransformTracks& tracks, float sampleRate);
+
+	void SampleTransform(const TransformTracks& tracks, float time, TransformCursors& cursors,
+		DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale);
+	void SampleTransform(const UniformTransformTracks& tracks, float time,
+		DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale);
+
+	/// <summary>
+	/// The tracks a clip has for one node, a bone usually.
+	/// </summary>
+	struct AnimationChannel
+	{
+		std::string nodeName;
+		TransformTracks tracks;
+	};
+	struct AnimationClip
+	{
+		std::string name;
+		/// <summary>
+		/// In seconds.
+		/// </summary>
+		float duration = 0;
+		std::vector<AnimationChannel> channels;
+	};
+}
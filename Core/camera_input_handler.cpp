@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "camera_input_handler.h"
+#include "components.h"
+void transforms::components::CameraInputHandler::Update(float deltaTime, entt::entity self, entt::registry& registry)
+{
+	using namespace DirectX;
+	//TODO INPUT: Create something like the axis system from unity input and use it instead.
+	transforms::components::Transform& t = registry.get<transforms::components::Transform>(self);
+
+	XMVECTOR _pos = XMLoadFloat3(&t.position);
+	XMVECTOR _ct = XMLoadFloat3(&target);
+	// The camera moves along the world axes
+	XMVECTOR _r = XMVectorSet(1, 0, 0, 0);
+	XMVECTOR _f = XMVectorSet(0, 0, 1, 0);
+
+	const transforms::KeyCodes key = lastKey();
+	if (key == transforms::KeyCodes::A) {
+		_r = XMVectorScale(_r, speed * deltaTime);
+		_pos = XMVectorAdd(_r, _pos);
+		_ct = XMVectorAdd(_r, _ct);
+	}
+	if (key == transforms::KeyCodes::D) {
+		_r = XMVectorScale(_r, -speed * deltaTime);
+		_pos = XMVectorAdd(_r, _pos);
+		_ct = XMVectorAdd(_r, _ct);
+
+	}
+	if (key == transforms::KeyCodes::W) {
+		_f = XMVectorScale(_f, speed * deltaTime);
+		_pos = XMVectorAdd(_f, _pos);
+		_ct = XMVectorAdd(_f, _ct);
+	}
+	if (key == transforms::KeyCodes::S) {
+		_f = XMVectorScale(_f, -speed * deltaTime);
+		_pos = XMVectorAdd(_f, _pos);
+		_ct = XMVectorAdd(_f, _ct);
+	}
+
+	XMStoreFloat3(&t.position, _pos);
+	XMStoreFloat3(&target, _ct);
+	t.LookAt(target);
+}
+
+void transforms::components::CreateCameraInputHandler(KeySource lastKey, entt::registry& gRegistry,
+	entt::entity mainCamera)
+{
+	CameraInputHandler handler;
+	handler.lastKey = lastKey;
+	gRegistry.emplace<CameraInputHandler>(mainCamera, handler);
+}
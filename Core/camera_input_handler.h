@@ -0,0 +1,23 @@
+#pragma once
+#include <functional>
+#include <DirectXMath.h>
+#include <entt/entt.hpp>
+#include "key_codes.h"
+namespace transforms::components {
+    /// <summary>
+    /// Where the camera reads the last key pressed: the window, or a replayed capture.
+    /// </summary>
+    using KeySource = std::function<transforms::KeyCodes()>;
+    /// <summary>
+    /// Moves its entity with WASD, looking at a target that moves along with it. A behavior for
+    /// systems::ScriptRunner.
+    /// </summary>
+    struct CameraInputHandler {
+        KeySource lastKey;
+        DirectX::XMFLOAT3 target = DirectX::XMFLOAT3(-6, 0.f, 0);
+        float speed = 10.0f;
+        void Update(float deltaTime, entt::entity self, entt::registry& registry);
+    };
+    void CreateCameraInputHandler(KeySource lastKey, entt::registry& gRegistry,
+        entt::entity mainCamera);
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "components.h"
 #include <entt/entt.hpp>
+#include "cpu_profiler.h"
 
 size_t GetNumberOfRenderables(const entt::registry& gRegistry) {
     auto renderables = gRegistry.view<transforms::components::Renderable>();
@@ -32,6 +33,7 @@ namespace transforms::components
     }
 
     void UpdateAllTransforms(entt::registry& registry) {
+        PROFILE_SCOPE("UpdateAllTransforms");
         using namespace transforms::components;
 
         // Step 1: Iterate over all entities that have a Transform and possibly a Hierarchy
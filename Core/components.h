@@ -1,10 +1,11 @@
 #pragma once
 #include <entt/entt.hpp>
+#include <algorithm>
+#include <string>
 #include <vector>
 #include <DirectXMath.h>
-#include <wrl/client.h>
-#include "d3dx12.h"
 #include <functional>
+#include "gfx_device.h"
 /// <summary>
 /// I need to know how many renderables are there, that's how i establish the unique id for the renderable
 /// component.
@@ -181,6 +182,15 @@ namespace transforms
                 worldMatrix = GetLocalMatrix() * parentMatrix;
                 return worldMatrix;
             }
+            /// <summary>
+            /// The position in worldMatrix as UpdateAllTransforms left it. Unlike GetWorldPosition it doesn't write
+            /// to the transform, so systems that only read transforms can run at the same time.
+            /// </summary>
+            DirectX::XMFLOAT3 GetUpdatedWorldPosition() const {
+                DirectX::XMFLOAT3 worldPosition;
+                DirectX::XMStoreFloat3(&worldPosition, worldMatrix.r[3]);
+                return worldPosition;
+            }
 
             /// <summary>
             /// Look at the target position. The eye is the current position
@@ -228,8 +238,8 @@ namespace transforms
             /// This id is the position in the buffer.
             /// </summary>
             uint32_t uniformBufferId;
-            D3D12_VERTEX_BUFFER_VIEW mVertexBufferView{};
-            D3D12_INDEX_BUFFER_VIEW mIndexBufferView{};
+            common::gfx::VertexBufferView mVertexBufferView{};
+            common::gfx::IndexBufferView mIndexBufferView{};
             int mNumberOfIndices;
         };
 
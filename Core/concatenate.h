@@ -0,0 +1,117 @@
+#pragma once
+#include "pch.h"
+// Helper function to convert a single value to a string
+template<typename T>
+std::wstring ToString(T&& value) {
+    std::wstringstream ss;
+    ss << std::boolalpha << std::forward<T>(value);
+    return ss.str();
+}
+
+// Base case for the variadic function template
+inline std::wstring Concatenate() {
+    return L"";
+}
+
+// Variadic function template to handle multiple arguments
+template<typename T, typename... Args>
+std::wstring Concatenate(T&& first, Args&&... args) {
+    return ToString(std::forward<T>(first)) + Concatenate(std::forward<Args>(args)...);
+}
+
+#pragma once
+
+#include <string>
+
+/// <summary>
+/// utf-8 to wide string, utf-16 where wchar_t is 2 bytes (Windows) and utf-32 where it's 4. Invalid
+/// bytes become U+FFFD. Assimp gives names in utf-8, so this is what the names need.
+/// </summary>
+inline std::wstring multi2wide(const std::string& str)
+{
+	std::wstring result;
+	result.reserve(str.size());
+	size_t i = 0;
+	while (i < str.size())
+	{
+		const unsigned char lead = static_cast<unsigned char>(str[i]);
+		uint32_t codePoint = 0xFFFD;
+		size_t length = 1;
+		if (lead < 0x80) { codePoint = lead; }
+		else if ((lead >> 5) == 0x6) { codePoint = lead & 0x1F; length = 2; }
+		else if ((lead >> 4) == 0xE) { codePoint = lead & 0x0F; length = 3; }
+		else if ((lead >> 3) == 0x1E) { codePoint = lead & 0x07; length = 4; }
+		if (length > 1)
+		{
+			bool valid = i + length <= str.size();
+			for (size_t k = 1; valid && k < length; k++)
+			{
+				const unsigned char continuation = static_cast<unsigned char>(str[i + k]);
+				valid = (continuation >> 6) == 0x2;
+				codePoint = (codePoint << 6) | (continuation & 0x3F);
+			}
+			if (!valid || codePoint > 0x10FFFF)
+			{
+				codePoint = 0xFFFD;
+				length = 1;
+			}
+		}
+		i += length;
+		if (sizeof(wchar_t) == 2 && codePoint > 0xFFFF)
+		{
+			codePoint -= 0x10000;
+			result.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+			result.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+		}
+		else
+		{
+			result.push_back(static_cast<wchar_t>(codePoint));
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Wide string (utf-16 or utf-32, see multi2wide) to utf-8.
+/// </summary>
+inline std::string wide2multi(const std::wstring& str)
+{
+	std::string result;
+	result.reserve(str.size());
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		uint32_t codePoint = static_cast<uint32_t>(str[i]);
+		if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 1 < str.size())
+		{
+			const uint32_t low = static_cast<uint32_t>(str[i + 1]);
+			if (low >= 0xDC00 && low <= 0xDFFF)
+			{
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				i++;
+			}
+		}
+		if (codePoint < 0x80)
+		{
+			result.push_back(static_cast<char>(codePoint));
+		}
+		else if (codePoint < 0x800)
+		{
+			result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+	return result;
+}
@@ -0,0 +1,271 @@
+#include "pch.h"
+#include "cpu_profiler.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+    //the profiler the calling thread registered with, and its buffer there
+    thread_local const common::CpuProfiler* tlsProfiler = nullptr;
+    thread_local void* tlsBuffer = nullptr;
+
+    void WriteJsonString(std::ostream& out, const std::string& s)
+    {
+        out << '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                out << ' ';
+            }
+            else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    double ToMs(uint64_t ns)
+    {
+        return static_cast<double>(ns) / 1.0e6;
+    }
+}
+
+common::CpuProfiler::CpuProfiler(uint32_t frameHistory)
+    :origin(MonotonicClock::Now()), frames(std::max(frameHistory, 1u))
+{
+}
+
+common::CpuProfiler& common::CpuProfiler::Get()
+{
+    static CpuProfiler profiler;
+    return profiler;
+}
+
+uint64_t common::CpuProfiler::Now() const
+{
+    return MonotonicClock::ToNanoseconds(MonotonicClock::Now() - origin);
+}
+
+common::CpuProfiler::ThreadBuffer& common::CpuProfiler::GetThreadBuffer()
+{
+    if (tlsProfiler != this) {
+        //first scope of this thread, the only time it locks
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->index = static_cast<uint32_t>(threads.size());
+        buffer->name = "thread " + std::to_string(buffer->index);
+        tlsProfiler = this;
+        tlsBuffer = buffer.get();
+        threads.push_back(std::move(buffer));
+    }
+    return *static_cast<ThreadBuffer*>(tlsBuffer);
+}
+
+void common::CpuProfiler::SetThreadName(const std::string& name)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    buffer.name = name;
+}
+
+uint32_t common::CpuProfiler::BeginScope()
+{
+    return GetThreadBuffer().depth++;
+}
+
+void common::CpuProfiler::EndScope(const char* name, uint64_t start, uint32_t depth)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    assert(buffer.depth == depth + 1 && "scopes must end in reverse order");
+    buffer.depth = depth;
+    const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    ProfileEvent& event = buffer.events[index % EVENTS_PER_THREAD];
+    event.name = name;
+    event.start = start;
+    event.end = Now();
+    event.depth = depth;
+    event.thread = buffer.index;
+    //publishes the event to EndFrame
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void common::CpuProfiler::EndFrame()
+{
+    const uint64_t now = Now();
+    std::vector<ThreadBuffer*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (const auto& t : threads) {
+            snapshot.push_back(t.get());
+        }
+    }
+    std::lock_guard<std::mutex> lock(framesMutex);
+    ProfiledFrame& frame = frames[frameNumber % frames.size()];
+    frame.frameNumber = frameNumber;
+    frame.start = frameStart;
+    frame.end = now;
+    frame.events.clear();
+    frame.droppedEvents = 0;
+    for (ThreadBuffer* buffer : snapshot) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = buffer->read;
+        if (written - first > EVENTS_PER_THREAD) {
+            frame.droppedEvents += written - first - EVENTS_PER_THREAD;
+            first = written - EVENTS_PER_THREAD;
+        }
+        const size_t copyStart = frame.events.size();
+        for (uint64_t i = first; i < written; i++) {
+            frame.events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+        }
+        //the owner kept going while we copied; anything it may have overwritten is thrown away
+        const uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+        if (writtenAfter - first > EVENTS_PER_THREAD) {
+            const uint64_t overwritten = std::min(writtenAfter - first - EVENTS_PER_THREAD, written - first);
+            frame.events.erase(frame.events.begin() + copyStart, frame.events.begin() + copyStart + overwritten);
+            frame.droppedEvents += overwritten;
+        }
+        buffer->read = written;
+    }
+    std::sort(frame.events.begin(), frame.events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+        });
+    frameThread = GetThreadBuffer().index;
+    frameStart = now;
+    frameNumber++;
+    frameCount = std::min(frameCount + 1, static_cast<uint32_t>(frames.size()));
+}
+
+void common::CpuProfiler::SetFrameHistory(uint32_t frameHistory)
+{
+    std::lock_guard<std::mutex> lock(framesMutex);
+    frames.assign(std::max(frameHistory, 1u), ProfiledFrame{});
+    frameCount = 0;
+}
+
+uint32_t common::CpuProfiler::GetFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(framesMutex);
+    return frameCount;
+}
+
+std::vector<common::ScopeStats> common::CpuProfiler::GetScopeStats() const
+{
+    std::lock_guard<std::mutex> lock(framesMutex);
+    std::vector<ScopeStats> result;
+    if (frameCount == 0) {
+        return result;
+    }
+    struct Accumulator
+    {
+        std::vector<uint64_t> perFrame;
+        uint64_t calls = 0;
+        uint32_t depth = UINT32_MAX;
+        size_t order = SIZE_MAX;
+    };
+    std::unordered_map<std::string, Accumulator> scopes;
+    const ProfiledFrame& newest = frames[(frameNumber - 1) % frames.size()];
+    for (uint32_t f = 0; f < frameCount; f++) {
+        const ProfiledFrame& frame = frames[(frameNumber - 1 - f) % frames.size()];
+        std::unordered_map<std::string, uint64_t> totals;
+        for (size_t e = 0; e < frame.events.size(); e++) {
+            const ProfileEvent& event = frame.events[e];
+            totals[event.name] += event.end - event.start;
+            Accumulator& accumulator = scopes[event.name];
+            accumulator.calls++;
+            accumulator.depth = std::min(accumulator.depth, event.depth);
+            if (&frame == &newest) {
+                accumulator.order = std::min(accumulator.order, e);
+            }
+        }
+        for (const auto& [name, total] : totals) {
+            scopes[name].perFrame.push_back(total);
+        }
+    }
+    std::vector<std::pair<size_t, std::string>> order;
+    for (auto& [name, accumulator] : scopes) {
+        order.emplace_back(accumulator.order, name);
+    }
+    std::sort(order.begin(), order.end());
+    for (const auto& [position, name] : order) {
+        Accumulator& accumulator = scopes[name];
+        std::vector<uint64_t>& values = accumulator.perFrame;
+        std::sort(values.begin(), values.end());
+        uint64_t sum = 0;
+        for (uint64_t v : values) {
+            sum += v;
+        }
+        const size_t p99 = static_cast<size_t>(std::ceil(0.99 * values.size())) - 1;
+        ScopeStats stats;
+        stats.name = name;
+        stats.depth = accumulator.depth;
+        stats.minMs = ToMs(values.front());
+        stats.maxMs = ToMs(values.back());
+        stats.avgMs = ToMs(sum) / values.size();
+        stats.p99Ms = ToMs(values[p99]);
+        stats.callsPerFrame = static_cast<double>(accumulator.calls) / frameCount;
+        result.push_back(stats);
+    }
+    return result;
+}
+
+void common::CpuProfiler::WriteChromeTrace(std::ostream& out) const
+{
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (const auto& t : threads) {
+            names.push_back(t->name);
+        }
+    }
+    std::lock_guard<std::mutex> lock(framesMutex);
+    const std::streamsize oldPrecision = out.precision(3);
+    const std::ios_base::fmtflags oldFlags = out.flags();
+    out << std::fixed;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (uint32_t i = 0; i < names.size(); i++) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+            << ",\"args\":{\"name\":";
+        WriteJsonString(out, names[i]);
+        out << "}}";
+        first = false;
+    }
+    //oldest frame first
+    for (uint32_t f = frameCount; f > 0; f--) {
+        const ProfiledFrame& frame = frames[(frameNumber - f) % frames.size()];
+        out << (first ? "" : ",\n") << "{\"name\":\"Frame " << frame.frameNumber << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+            << frameThread << ",\"ts\":" << frame.start / 1000.0 << ",\"dur\":" << (frame.end - frame.start) / 1000.0 << "}";
+        first = false;
+        for (const ProfileEvent& event : frame.events) {
+            out << ",\n{\"name\":";
+            WriteJsonString(out, event.name);
+            out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread << ",\"ts\":" << event.start / 1000.0
+                << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.flags(oldFlags);
+    out.precision(oldPrecision);
+}
+
+common::ProfileScope::ProfileScope(const char* name, CpuProfiler& profiler)
+    :profiler(profiler), name(name)
+{
+    if (profiler.IsEnabled()) {
+        active = true;
+        depth = profiler.BeginScope();
+        start = profiler.Now();
+    }
+}
+
+common::ProfileScope::~ProfileScope()
+{
+    if (active) {
+        profiler.EndScope(name, start, depth);
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// A finished scope. The name is the literal given to PROFILE_SCOPE, times are nanoseconds since the
+	/// profiler was created, thread is the index of the thread in the profiler.
+	/// </summary>
+	struct ProfileEvent
+	{
+		const char* name = nullptr;
+		uint64_t start = 0;
+		uint64_t end = 0;
+		uint32_t depth = 0;
+		uint32_t thread = 0;
+	};
+
+	/// <summary>
+	/// The scopes that finished between two EndFrame calls, sorted by start time.
+	/// </summary>
+	struct ProfiledFrame
+	{
+		uint64_t frameNumber = 0;
+		uint64_t start = 0;
+		uint64_t end = 0;
+		std::vector<ProfileEvent> events;
+		/// <summary>
+		/// Scopes lost because a thread finished more of them in the frame than its buffer holds.
+		/// </summary>
+		uint64_t droppedEvents = 0;
+	};
+
+	/// <summary>
+	/// The time a scope took per frame over the frame history, adding up all its calls in a frame.
+	/// </summary>
+	struct ScopeStats
+	{
+		std::string name;
+		uint32_t depth = 0;
+		double minMs = 0;
+		double avgMs = 0;
+		double p99Ms = 0;
+		double maxMs = 0;
+		double callsPerFrame = 0;
+	};
+
+	/// <summary>
+	/// Scoped cpu timers. Every thread writes the scopes it finishes into its own buffer, without locks;
+	/// EndFrame, called once per frame by the main loop, moves them into a ring with the last frames.
+	/// From there come the per scope statistics and the chrome trace (chrome://tracing, ui.perfetto.dev).
+	/// Thread buffers live as long as the profiler, it is meant for long lived threads like the main thread and the
+	/// worker pool. Use it through PROFILE_SCOPE.
+	/// </summary>
+	class CpuProfiler
+	{
+	public:
+		static constexpr uint32_t DEFAULT_FRAME_HISTORY = 240;
+		/// <summary>
+		/// Per thread and per frame. The buffer is a ring, a thread that finishes more scopes than this in a
+		/// frame loses the oldest ones.
+		/// </summary>
+		static constexpr uint32_t EVENTS_PER_THREAD = 1 << 14;
+		explicit CpuProfiler(uint32_t frameHistory = DEFAULT_FRAME_HISTORY);
+		CpuProfiler(const CpuProfiler&) = delete;
+		CpuProfiler& operator=(const CpuProfiler&) = delete;
+		/// <summary>
+		/// The profiler PROFILE_SCOPE writes to.
+		/// </summary>
+		static CpuProfiler& Get();
+		void SetEnabled(bool enabled) { this->enabled.store(enabled, std::memory_order_relaxed); }
+		bool IsEnabled() const { return enabled.load(std::memory_order_relaxed); }
+		/// <summary>
+		/// Names the calling thread in the trace. Threads that don't call it are "thread N".
+		/// </summary>
+		void SetThreadName(const std::string& name);
+		/// <summary>
+		/// Nanoseconds since the profiler was created.
+		/// </summary>
+		uint64_t Now() const;
+		/// <summary>
+		/// Opens a scope on the calling thread and returns its depth.
+		/// </summary>
+		uint32_t BeginScope();
+		/// <summary>
+		/// Closes the innermost scope of the calling thread.
+		/// </summary>
+		void EndScope(const char* name, uint64_t start, uint32_t depth);
+		/// <summary>
+		/// Closes the frame: takes the finished scopes of every thread into the frame ring. Scopes still
+		/// open go to the frame in which they end.
+		/// </summary>
+		void EndFrame();
+		/// <summary>
+		/// The statistics of every scope over the frame history, parents before their children, in the order
+		/// they ran in the last frame.
+		/// </summary>
+		std::vector<ScopeStats> GetScopeStats() const;
+		/// <summary>
+		/// The frame history in the chrome trace event format, one complete event per scope and per frame.
+		/// </summary>
+		void WriteChromeTrace(std::ostream& out) const;
+		/// <summary>
+		/// Drops the frame history and keeps the next frameHistory frames from now on. Replays set it to their
+		/// length, so that the statistics cover the whole run.
+		/// </summary>
+		void SetFrameHistory(uint32_t frameHistory);
+		/// <summary>
+		/// How many frames are in the history, at most the history size.
+		/// </summary>
+		uint32_t GetFrameCount() const;
+	private:
+		struct ThreadBuffer
+		{
+			std::array<ProfileEvent, EVENTS_PER_THREAD> events;
+			//written by the owner thread only, read by EndFrame
+			std::atomic<uint64_t> written{ 0 };
+			//only EndFrame touches it
+			uint64_t read = 0;
+			//only the owner thread touches it
+			uint32_t depth = 0;
+			uint32_t index = 0;
+			std::string name;
+		};
+		ThreadBuffer& GetThreadBuffer();
+		uint64_t origin;
+		std::atomic<bool> enabled{ true };
+		mutable std::mutex threadsMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threads;
+		mutable std::mutex framesMutex;
+		std::vector<ProfiledFrame> frames;
+		uint32_t frameCount = 0;
+		uint64_t frameNumber = 0;
+		uint64_t frameStart = 0;
+		uint32_t frameThread = 0;
+	};
+
+	/// <summary>
+	/// Times its own lifetime. name must outlive the profiler, a string literal.
+	/// </summary>
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name, CpuProfiler& profiler = CpuProfiler::Get());
+		~ProfileScope();
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		CpuProfiler& profiler;
+		const char* name;
+		uint64_t start = 0;
+		uint32_t depth = 0;
+		bool active = false;
+	};
+}
+
+#define COMMON_PROFILE_CONCAT_INNER(a, b) a##b
+#define COMMON_PROFILE_CONCAT(a, b) COMMON_PROFILE_CONCAT_INNER(a, b)
+/// <summary>
+/// Times the rest of the enclosing block as a scope called name.
+/// </summary>
+#define PROFILE_SCOPE(name) common::ProfileScope COMMON_PROFILE_CONCAT(profileScope, __LINE__)(name)
@@ -0,0 +1,550 @@
+#include "pch.h"
+#include "cpu_skinning.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPU_SKINNING_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+#define CPU_SKINNING_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+//msvc compiles the avx2 intrinsics without /arch:AVX2, the kernel only runs if the cpu has them
+#define CPU_SKINNING_TARGET_AVX2
+#else
+#define CPU_SKINNING_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace
+{
+    using common::DualQuaternion;
+    using common::SkinInfluences;
+    using common::SkinningSource;
+    using common::SkinningTarget;
+    using DirectX::XMFLOAT3;
+    using DirectX::XMFLOAT4;
+    using DirectX::XMFLOAT4X4;
+
+    //a zero vector stays zero
+    XMFLOAT3 Normalize(float x, float y, float z)
+    {
+        const float invLength = 1.0f / sqrtf(std::max(x * x + y * y + z * z, FLT_MIN));
+        return XMFLOAT3(x * invLength, y * invLength, z * invLength);
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    //v rotated by the unit quaternion (r, rw)
+    XMFLOAT3 Rotate(const XMFLOAT3& r, float rw, const XMFLOAT3& v)
+    {
+        const XMFLOAT3 c = Cross(r, v);
+        const XMFLOAT3 t = Cross(r, XMFLOAT3(c.x + rw * v.x, c.y + rw * v.y, c.z + rw * v.z));
+        return XMFLOAT3(v.x + 2.0f * t.x, v.y + 2.0f * t.y, v.z + 2.0f * t.z);
+    }
+
+    void SkinLinearBlendScalar(const XMFLOAT4X4* skinMatrices, const SkinningSource& source,
+        const SkinningTarget& target, uint32_t first, uint32_t end)
+    {
+        const bool normals = source.normals && target.normals;
+        const bool tangents = source.tangents && target.tangents;
+        for (uint32_t v = first; v < end; v++) {
+            const SkinInfluences& influences = source.influences[v];
+            float m[4][4] = {};
+            for (int i = 0; i < 4; i++) {
+                const float weight = influences.weights[i];
+                const XMFLOAT4X4& joint = skinMatrices[influences.joints[i]];
+                for (int r = 0; r < 4; r++) {
+                    for (int c = 0; c < 4; c++) {
+                        m[r][c] += weight * joint.m[r][c];
+                    }
+                }
+            }
+            const XMFLOAT3& p = source.positions[v];
+            target.positions[v] = XMFLOAT3(p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0],
+                p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1],
+                p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2]);
+            if (normals) {
+                const XMFLOAT3& n = source.normals[v];
+                target.normals[v] = Normalize(n.x * m[0][0] + n.y * m[1][0] + n.z * m[2][0],
+                    n.x * m[0][1] + n.y * m[1][1] + n.z * m[2][1],
+                    n.x * m[0][2] + n.y * m[1][2] + n.z * m[2][2]);
+            }
+            if (tangents) {
+                const XMFLOAT4& t = source.tangents[v];
+                const XMFLOAT3 skinned = Normalize(t.x * m[0][0] + t.y * m[1][0] + t.z * m[2][0],
+                    t.x * m[0][1] + t.y * m[1][1] + t.z * m[2][1],
+                    t.x * m[0][2] + t.y * m[1][2] + t.z * m[2][2]);
+                target.tangents[v] = XMFLOAT4(skinned.x, skinned.y, skinned.z, t.w);
+            }
+        }
+    }
+
+    void SkinDualQuaternionScalar(const DualQuaternion* palette, const SkinningSource& source,
+        const SkinningTarget& target, uint32_t first, uint32_t end)
+    {
+        const bool normals = source.normals && target.normals;
+        const bool tangents = source.tangents && target.tangents;
+        for (uint32_t v = first; v < end; v++) {
+            const SkinInfluences& influences = source.influences[v];
+            const XMFLOAT4& pivot = palette[influences.joints[0]].real;
+            XMFLOAT4 real(0, 0, 0, 0);
+            XMFLOAT4 dual(0, 0, 0, 0);
+            for (int i = 0; i < 4; i++) {
+                const DualQuaternion& joint = palette[influences.joints[i]];
+                float weight = influences.weights[i];
+                //q and -q are the same rotation, the joints in the other hemisphere than the first are flipped
+                if (joint.real.x * pivot.x + joint.real.y * pivot.y + joint.real.z * pivot.z + joint.real.w * pivot.w < 0) {
+                    weight = -weight;
+                }
+                real = XMFLOAT4(real.x + weight * joint.real.x, real.y + weight * joint.real.y,
+                    real.z + weight * joint.real.z, real.w + weight * joint.real.w);
+                dual = XMFLOAT4(dual.x + weight * joint.dual.x, dual.y + weight * joint.dual.y,
+                    dual.z + weight * joint.dual.z, dual.w + weight * joint.dual.w);
+            }
+            const float invLength = 1.0f / sqrtf(std::max(
+                real.x * real.x + real.y * real.y + real.z * real.z + real.w * real.w, FLT_MIN));
+            const XMFLOAT3 r(real.x * invLength, real.y * invLength, real.z * invLength);
+            const float rw = real.w * invLength;
+            const XMFLOAT3 d(dual.x * invLength, dual.y * invLength, dual.z * invLength);
+            const float dw = dual.w * invLength;
+            //translation = 2 * dual * conjugate(real)
+            const XMFLOAT3 rd = Cross(r, d);
+            const XMFLOAT3 translation(2.0f * (rw * d.x - dw * r.x + rd.x), 2.0f * (rw * d.y - dw * r.y + rd.y),
+                2.0f * (rw * d.z - dw * r.z + rd.z));
+            const XMFLOAT3 p = Rotate(r, rw, source.positions[v]);
+            target.positions[v] = XMFLOAT3(p.x + translation.x, p.y + translation.y, p.z + translation.z);
+            if (normals) {
+                target.normals[v] = Rotate(r, rw, source.normals[v]);
+            }
+            if (tangents) {
+                const XMFLOAT4& t = source.tangents[v];
+                const XMFLOAT3 skinned = Rotate(r, rw, XMFLOAT3(t.x, t.y, t.z));
+                target.tangents[v] = XMFLOAT4(skinned.x, skinned.y, skinned.z, t.w);
+            }
+        }
+    }
+
+#if CPU_SKINNING_SSE
+    //the dot of xyz in every lane
+    __m128 Dot3(__m128 a, __m128 b)
+    {
+        const __m128 m = _mm_mul_ps(a, b);
+        return _mm_add_ps(_mm_add_ps(_mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 0, 0, 0)),
+            _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2)));
+    }
+
+    __m128 Dot4(__m128 a, __m128 b)
+    {
+        const __m128 m = _mm_mul_ps(a, b);
+        return _mm_add_ps(Dot3(a, b), _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+
+    __m128 Normalize3(__m128 v)
+    {
+        const __m128 length = _mm_sqrt_ps(_mm_max_ps(Dot3(v, v), _mm_set1_ps(FLT_MIN)));
+        return _mm_mul_ps(v, _mm_div_ps(_mm_set1_ps(1.0f), length));
+    }
+
+    //xyz, w is 0
+    __m128 Cross3(__m128 a, __m128 b)
+    {
+        const __m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    __m128 Rotate3(__m128 real, __m128 realW, __m128 v)
+    {
+        const __m128 t = _mm_add_ps(Cross3(real, v), _mm_mul_ps(realW, v));
+        return _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(2.0f), Cross3(real, t)));
+    }
+
+    __m128 LoadFloat3(const XMFLOAT3& v)
+    {
+        return _mm_set_ps(0.0f, v.z, v.y, v.x);
+    }
+
+    //the 4 floats store would write past the end of the array
+    void StoreFloat3(XMFLOAT3* destination, __m128 v)
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(destination), v);
+        _mm_store_ss(&destination->z, _mm_movehl_ps(v, v));
+    }
+
+    void StoreTangent(XMFLOAT4* destination, __m128 v, float handedness)
+    {
+        _mm_storeu_ps(&destination->x, v);
+        destination->w = handedness;
+    }
+
+    __m128 Transform3(__m128 row0, __m128 row1, __m128 row2, const XMFLOAT3& v)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.x), row0), _mm_mul_ps(_mm_set1_ps(v.y), row1)),
+            _mm_mul_ps(_mm_set1_ps(v.z), row2));
+    }
+
+    //the weight, negated if the joint is in the other hemisphere than the pivot
+    __m128 HemisphereWeight(float weight, __m128 real, __m128 pivot)
+    {
+        const __m128 flip = _mm_and_ps(_mm_cmplt_ps(Dot4(real, pivot), _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+        return _mm_xor_ps(_mm_set1_ps(weight), flip);
+    }
+
+    //translation = 2 * dual * conjugate(real), both normalized
+    __m128 DualQuaternionTranslation(__m128 real, __m128 realW, __m128 dual)
+    {
+        const __m128 dualW = _mm_shuffle_ps(dual, dual, _MM_SHUFFLE(3, 3, 3, 3));
+        return _mm_mul_ps(_mm_set1_ps(2.0f),
+            _mm_add_ps(_mm_sub_ps(_mm_mul_ps(realW, dual), _mm_mul_ps(dualW, real)), Cross3(real, dual)));
+    }
+
+    void SkinLinearBlendSse(const XMFLOAT4X4* skinMatrices, const SkinningSource& source,
+        const SkinningTarget& target, uint32_t first, uint32_t end)
+    {
+        const bool normals = source.normals && target.normals;
+        const bool tangents = source.tangents && target.tangents;
+        for (uint32_t v = first; v < end; v++) {
+            const SkinInfluences& influences = source.influences[v];
+            __m128 row0 = _mm_setzero_ps();
+            __m128 row1 = _mm_setzero_ps();
+            __m128 row2 = _mm_setzero_ps();
+            __m128 row3 = _mm_setzero_ps();
+            for (int i = 0; i < 4; i++) {
+                const float* joint = &skinMatrices[influences.joints[i]].m[0][0];
+                const __m128 weight = _mm_set1_ps(influences.weights[i]);
+                row0 = _mm_add_ps(row0, _mm_mul_ps(weight, _mm_loadu_ps(joint)));
+                row1 = _mm_add_ps(row1, _mm_mul_ps(weight, _mm_loadu_ps(joint + 4)));
+                row2 = _mm_add_ps(row2, _mm_mul_ps(weight, _mm_loadu_ps(joint + 8)));
+                row3 = _mm_add_ps(row3, _mm_mul_ps(weight, _mm_loadu_ps(joint + 12)));
+            }
+            StoreFloat3(&target.positions[v], _mm_add_ps(Transform3(row0, row1, row2, source.positions[v]), row3));
+            if (normals) {
+                StoreFloat3(&target.normals[v], Normalize3(Transform3(row0, row1, row2, source.normals[v])));
+            }
+            if (tangents) {
+                const XMFLOAT4& t = source.tangents[v];
+                StoreTangent(&target.tangents[v], Normalize3(Transform3(row0, row1, row2, XMFLOAT3(t.x, t.y, t.z))), t.w);
+            }
+        }
+    }
+
+    void SkinDualQuaternionSse(const DualQuaternion* palette, const SkinningSource& source,
+        const SkinningTarget& target, uint32_t first, uint32_t end)
+    {
+        const bool normals = source.normals && target.normals;
+        const bool tangents = source.tangents && target.tangents;
+        for (uint32_t v = first; v < end; v++) {
+            const SkinInfluences& influences = source.influences[v];
+            const __m128 pivot = _mm_loadu_ps(&palette[influences.joints[0]].real.x);
+            __m128 real = _mm_setzero_ps();
+            __m128 dual = _mm_setzero_ps();
+            for (int i = 0; i < 4; i++) {
+                const DualQuaternion& joint = palette[influences.joints[i]];
+                const __m128 jointReal = _mm_loadu_ps(&joint.real.x);
+                const __m128 weight = HemisphereWeight(influences.weights[i], jointReal, pivot);
+                real = _mm_add_ps(real, _mm_mul_ps(weight, jointReal));
+                dual = _mm_add_ps(dual, _mm_mul_ps(weight, _mm_loadu_ps(&joint.dual.x)));
+            }
+            const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f),
+                _mm_sqrt_ps(_mm_max_ps(Dot4(real, real), _mm_set1_ps(FLT_MIN))));
+            real = _mm_mul_ps(real, invLength);
+            dual = _mm_mul_ps(dual, invLength);
+            const __m128 realW = _mm_shuffle_ps(real, real, _MM_SHUFFLE(3, 3, 3, 3));
+            StoreFloat3(&target.positions[v], _mm_add_ps(Rotate3(real, realW, LoadFloat3(source.positions[v])),
+                DualQuaternionTranslation(real, realW, dual)));
+            if (normals) {
+                StoreFloat3(&target.normals[v], Rotate3(real, realW, LoadFloat3(source.normals[v])));
+            }
+            if (tangents) {
+                const XMFLOAT4& t = source.tangents[v];
+                StoreTangent(&target.tangents[v], Rotate3(real, realW, LoadFloat3(XMFLOAT3(t.x, t.y, t.z))), t.w);
+            }
+        }
+    }
+#endif
+
+#if CPU_SKINNING_AVX2
+    bool CpuHasAvx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        //and the os must save the ymm registers
+        if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+
+    //xyz of both halves, w is 0
+    CPU_SKINNING_TARGET_AVX2 __m256 Cross3x2(__m256 a, __m256 b)
+    {
+        const __m256 aYzx = _mm256_permute_ps(a, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m256 bYzx = _mm256_permute_ps(b, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m256 c = _mm256_fmsub_ps(a, bYzx, _mm256_mul_ps(aYzx, b));
+        return _mm256_permute_ps(c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    //the position in the low half and the normal in the high one, so that they go through the math together
+    CPU_SKINNING_TARGET_AVX2 __m256 LoadPositionAndNormal(const XMFLOAT3& position, const XMFLOAT3* normal)
+    {
+        const __m128 n = normal ? LoadFloat3(*normal) : _mm_setzero_ps();
+        return _mm256_set_m128(n, LoadFloat3(position));
+    }
+
+    CPU_SKINNING_TARGET_AVX2 void SkinLinearBlendAvx2(const XMFLOAT4X4* skinMatrices, const SkinningSource& source,
+        const SkinningTarget& target, uint32_t first, uint32_t end)
+    {
+        const bool normals = source.normals && target.normals;
+        const bool tangents = source.tangents && target.tangents;
+        for (uint32_t v = first; v < end; v++) {
+            const SkinInfluences& influences = source.influences[v];
+            __m256 rows01 = _mm256_setzero_ps();
+            __m256 rows23 = _mm256_setzero_ps();
+            for (int i = 0; i < 4; i++) {
+                const float* joint = &skinMatrices[influences.joints[i]].m[0][0];
+                const __m256 weight = _mm256_set1_ps(influences.weights[i]);
+                rows01 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(joint), rows01);
+                rows23 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(joint + 8), rows23);
+            }
+            const __m256 row0 = _mm256_permute2f128_ps(rows01, rows01, 0x00);
+            const __m256 row1 = _mm256_permute2f128_ps(rows01, rows01, 0x11);
+            const __m256 row2 = _mm256_permute2f128_ps(rows23, rows23, 0x00);
+            //the translation for the position, nothing for the normal
+            const __m256 row3 = _mm256_permute2f128_ps(rows23, rows23, 0x81);
+            const XMFLOAT3& p = source.positions[v];
+            const XMFLOAT3& n = normals ? source.normals[v] : p;
+            const __m256 x = _mm256_set_m128(_mm_set1_ps(n.x), _mm_set1_ps(p.x));
+            const __m256 y = _mm256_set_m128(_mm_set1_ps(n.y), _mm_set1_ps(p.y));
+            const __m256 z = _mm256_set_m128(_mm_set1_ps(n.z), _mm_set1_ps(p.z));
+            const __m256 skinned = _mm256_fmadd_ps(x, row0, _mm256_fmadd_ps(y, row1, _mm256_fmadd_ps(z, row2, row3)));
+            StoreFloat3(&target.positions[v], _mm256_castps256_ps128(skinned));
+            if (normals) {
+                StoreFloat3(&target.normals[v], Normalize3(_mm256_extractf128_ps(skinned, 1)));
+            }
+            if (tangents) {
+                const XMFLOAT4& t = source.tangents[v];
+                const __m128 skinnedTangent = _mm_fmadd_ps(_mm_set1_ps(t.x), _mm256_castps256_ps128(row0),
+                    _mm_fmadd_ps(_mm_set1_ps(t.y), _mm256_castps256_ps128(row1),
+                        _mm_mul_ps(_mm_set1_ps(t.z), _mm256_castps256_ps128(row2))));
+                StoreTangent(&target.tangents[v], Normalize3(skinnedTangent), t.w);
+            }
+        }
+    }
+
+    CPU_SKINNING_TARGET_AVX2 void SkinDualQuaternionAvx2(const DualQuaternion* palette, const SkinningSource& source,
+        const SkinningTarget& target, uint32_t first, uint32_t end)
+    {
+        const bool normals = source.normals && target.normals;
+        const bool tangents = source.tangents && target.tangents;
+        for (uint32_t v = first; v < end; v++) {
+            const SkinInfluences& influences = source.influences[v];
+            const __m128 pivot = _mm_loadu_ps(&palette[influences.joints[0]].real.x);
+            //real in the low half, dual in the high one
+            __m256 blended = _mm256_setzero_ps();
+            for (int i = 0; i < 4; i++) {
+                const __m256 joint = _mm256_loadu_ps(&palette[influences.joints[i]].real.x);
+                const __m128 weight = HemisphereWeight(influences.weights[i], _mm256_castps256_ps128(joint), pivot);
+                blended = _mm256_fmadd_ps(_mm256_set_m128(weight, weight), joint, blended);
+            }
+            __m128 real = _mm256_castps256_ps128(blended);
+            const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f),
+                _mm_sqrt_ps(_mm_max_ps(Dot4(real, real), _mm_set1_ps(FLT_MIN))));
+            real = _mm_mul_ps(real, invLength);
+            const __m128 dual = _mm_mul_ps(_mm256_extractf128_ps(blended, 1), invLength);
+            const __m128 realW = _mm_shuffle_ps(real, real, _MM_SHUFFLE(3, 3, 3, 3));
+            const __m256 real2 = _mm256_set_m128(real, real);
+            const __m256 realW2 = _mm256_set_m128(realW, realW);
+            const __m256 vectors = LoadPositionAndNormal(source.positions[v], normals ? &source.normals[v] : nullptr);
+            const __m256 t = _mm256_fmadd_ps(realW2, vectors, Cross3x2(real2, vectors));
+            const __m256 rotated = _mm256_fmadd_ps(_mm256_set1_ps(2.0f), Cross3x2(real2, t), vectors);
+            StoreFloat3(&target.positions[v], _mm_add_ps(_mm256_castps256_ps128(rotated),
+                DualQuaternionTranslation(real, realW, dual)));
+            if (normals) {
+                StoreFloat3(&target.normals[v], _mm256_extractf128_ps(rotated, 1));
+            }
+            if (tangents) {
+                const XMFLOAT4& tangent = source.tangents[v];
+                StoreTangent(&target.tangents[v],
+                    Rotate3(real, realW, LoadFloat3(XMFLOAT3(tangent.x, tangent.y, tangent.z))), tangent.w);
+            }
+        }
+    }
+#endif
+}
+
+void common::AddInfluence(SkinInfluences& influences, uint16_t joint, float weight)
+{
+    if (!(weight > 0.0f)) {
+        return;
+    }
+    int weakest = 0;
+    for (int i = 0; i < 4; i++) {
+        if (influences.joints[i] == joint && influences.weights[i] > 0.0f) {
+            influences.weights[i] += weight;
+            return;
+        }
+        if (influences.weights[i] < influences.weights[weakest]) {
+            weakest = i;
+        }
+    }
+    if (weight > influences.weights[weakest]) {
+        influences.joints[weakest] = joint;
+        influences.weights[weakest] = weight;
+    }
+}
+
+void common::NormalizeInfluences(SkinInfluences& influences)
+{
+    const float total = influences.weights[0] + influences.weights[1] + influences.weights[2] + influences.weights[3];
+    if (total > 0.0f) {
+        for (float& weight : influences.weights) {
+            weight /= total;
+        }
+    }
+}
+
+bool common::IsSkinningKernelSupported(SkinningKernel kernel)
+{
+    switch (kernel) {
+    case SkinningKernel::Scalar:
+        return true;
+    case SkinningKernel::SSE:
+#if CPU_SKINNING_SSE
+        return true;
+#else
+        return false;
+#endif
+    case SkinningKernel::AVX2:
+#if CPU_SKINNING_AVX2
+    {
+        static const bool avx2 = CpuHasAvx2();
+        return avx2;
+    }
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+common::SkinningKernel common::GetFastestSkinningKernel()
+{
+    if (IsSkinningKernelSupported(SkinningKernel::AVX2)) {
+        return SkinningKernel::AVX2;
+    }
+    return IsSkinningKernelSupported(SkinningKernel::SSE) ? SkinningKernel::SSE : SkinningKernel::Scalar;
+}
+
+const char* common::GetSkinningKernelName(SkinningKernel kernel)
+{
+    switch (kernel) {
+    case SkinningKernel::SSE:
+        return "sse";
+    case SkinningKernel::AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+void common::SkinLinearBlend(SkinningKernel kernel, const DirectX::XMFLOAT4X4* skinMatrices,
+    const SkinningSource& source, const SkinningTarget& target, uint32_t first, uint32_t count)
+{
+    assert(IsSkinningKernelSupported(kernel));
+    assert(first + count <= source.vertexCount);
+    switch (kernel) {
+#if CPU_SKINNING_AVX2
+    case SkinningKernel::AVX2:
+        SkinLinearBlendAvx2(skinMatrices, source, target, first, first + count);
+        return;
+#endif
+#if CPU_SKINNING_SSE
+    case SkinningKernel::SSE:
+        SkinLinearBlendSse(skinMatrices, source, target, first, first + count);
+        return;
+#endif
+    default:
+        SkinLinearBlendScalar(skinMatrices, source, target, first, first + count);
+        return;
+    }
+}
+
+void common::SkinDualQuaternion(SkinningKernel kernel, const DualQuaternion* palette, const SkinningSource& source,
+    const SkinningTarget& target, uint32_t first, uint32_t count)
+{
+    assert(IsSkinningKernelSupported(kernel));
+    assert(first + count <= source.vertexCount);
+    switch (kernel) {
+#if CPU_SKINNING_AVX2
+    case SkinningKernel::AVX2:
+        SkinDualQuaternionAvx2(palette, source, target, first, first + count);
+        return;
+#endif
+#if CPU_SKINNING_SSE
+    case SkinningKernel::SSE:
+        SkinDualQuaternionSse(palette, source, target, first, first + count);
+        return;
+#endif
+    default:
+        SkinDualQuaternionScalar(palette, source, target, first, first + count);
+        return;
+    }
+}
+
+void common::SkinLinearBlend(WorkerPool& workerPool, SkinningKernel kernel, const DirectX::XMFLOAT4X4* skinMatrices,
+    const SkinningSource& source, const SkinningTarget& target, uint32_t chunkSize)
+{
+    const uint32_t chunkCount = (source.vertexCount + chunkSize - 1) / chunkSize;
+    workerPool.ParallelFor(chunkCount, [kernel, skinMatrices, &source, &target, chunkSize](uint32_t chunk) {
+        const uint32_t first = chunk * chunkSize;
+        SkinLinearBlend(kernel, skinMatrices, source, target, first, std::min(chunkSize, source.vertexCount - first));
+    });
+}
+
+void common::SkinDualQuaternion(WorkerPool& workerPool, SkinningKernel kernel, const DualQuaternion* palette,
+    const SkinningSource& source, const SkinningTarget& target, uint32_t chunkSize)
+{
+    const uint32_t chunkCount = (source.vertexCount + chunkSize - 1) / chunkSize;
+    workerPool.ParallelFor(chunkCount, [kernel, palette, &source, &target, chunkSize](uint32_t chunk) {
+        const uint32_t first = chunk * chunkSize;
+        SkinDualQuaternion(kernel, palette, source, target, first, std::min(chunkSize, source.vertexCount - first));
+    });
+}
+
+void common::ComputeDualQuaternions(const std::vector<DirectX::XMFLOAT4X4>& skinMatrices,
+    std::vector<DualQuaternion>& palette)
+{
+    using namespace DirectX;
+    palette.resize(skinMatrices.size());
+    for (size_t j = 0; j < skinMatrices.size(); j++) {
+        XMVECTOR scale, rotation, translation;
+        XMMatrixDecompose(&scale, &rotation, &translation, XMLoadFloat4x4(&skinMatrices[j]));
+        //dual = translation * rotation / 2; XMQuaternionMultiply(a, b) is b * a
+        const XMVECTOR dual = XMVectorScale(XMQuaternionMultiply(rotation, XMVectorSetW(translation, 0.0f)), 0.5f);
+        XMStoreFloat4(&palette[j].real, rotation);
+        XMStoreFloat4(&palette[j].dual, dual);
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+namespace common
+{
+	class WorkerPool;
+
+	/// <summary>
+	/// The four joints a vertex is bound to and their weights, which add up to one. Unused slots have weight 0
+	/// and any joint.
+	/// </summary>
+	struct SkinInfluences
+	{
+		uint16_t joints[4];
+		float weights[4];
+	};
+	/// <summary>
+	/// Adds a joint to the influences of a vertex. Keeps the four strongest: the weakest slot is replaced if
+	/// weight is larger. A joint already there gets the weight added.
+	/// </summary>
+	void AddInfluence(SkinInfluences& influences, uint16_t joint, float weight);
+	/// <summary>
+	/// Scales the weights so that they add up to one. A vertex without weights keeps them at zero.
+	/// </summary>
+	void NormalizeInfluences(SkinInfluences& influences);
+
+	/// <summary>
+	/// A skin matrix as a rotation and a translation: real is the rotation and dual is half the translation times
+	/// it. Blending these keeps the volume that blending matrices loses at twisting joints. Scale is lost.
+	/// </summary>
+	struct DualQuaternion
+	{
+		DirectX::XMFLOAT4 real;
+		DirectX::XMFLOAT4 dual;
+	};
+
+	/// <summary>
+	/// The vertices of a mesh in bind pose, a stream per attribute. normals and tangents may be null, then they
+	/// aren't skinned. Tangents have the handedness in w.
+	/// </summary>
+	struct SkinningSource
+	{
+		const DirectX::XMFLOAT3* positions = nullptr;
+		const DirectX::XMFLOAT3* normals = nullptr;
+		const DirectX::XMFLOAT4* tangents = nullptr;
+		const SkinInfluences* influences = nullptr;
+		uint32_t vertexCount = 0;
+	};
+	/// <summary>
+	/// Where the skinned vertices go, indexed like the source. The streams the source doesn't have are ignored.
+	/// </summary>
+	struct SkinningTarget
+	{
+		DirectX::XMFLOAT3* positions = nullptr;
+		DirectX::XMFLOAT3* normals = nullptr;
+		DirectX::XMFLOAT4* tangents = nullptr;
+	};
+
+	/// <summary>
+	/// The implementations of the skinning functions. Scalar is the reference the others are checked against,
+	/// SSE does a vertex per iteration with 4-wide math, AVX2 blends two matrix rows per instruction and
+	/// transforms the position and the normal together.
+	/// </summary>
+	enum class SkinningKernel
+	{
+		Scalar,
+		SSE,
+		AVX2
+	};
+	/// <summary>
+	/// Whether the kernel was compiled in and this cpu runs it.
+	/// </summary>
+	bool IsSkinningKernelSupported(SkinningKernel kernel);
+	SkinningKernel GetFastestSkinningKernel();
+	const char* GetSkinningKernelName(SkinningKernel kernel);
+
+	/// <summary>
+	/// How many vertices a task of the parallel skinning gets.
+	/// </summary>
+	constexpr uint32_t SKINNING_CHUNK_SIZE = 2048;
+
+	/// <summary>
+	/// Linear blend skinning of the vertices [first, first + count): the skin matrices of the joints, weighted,
+	/// transform the position, the normal and the tangent. Normals and tangents are normalized after, they go
+	/// through the blended matrix and not its inverse transpose, so non uniform scale skews them.
+	/// </summary>
+	void SkinLinearBlend(SkinningKernel kernel, const DirectX::XMFLOAT4X4* skinMatrices, const SkinningSource& source,
+		const SkinningTarget& target, uint32_t first, uint32_t count);
+	/// <summary>
+	/// Dual quaternion skinning of the vertices [first, first + count), with the palette of ComputeDualQuaternions.
+	/// </summary>
+	void SkinDualQuaternion(SkinningKernel kernel, const DualQuaternion* palette, const SkinningSource& source,
+		const SkinningTarget& target, uint32_t first, uint32_t count);
+	/// <summary>
+	/// All the vertices, in chunks of chunkSize on the pool.
+	/// </summary>
+	void SkinLinearBlend(WorkerPool& workerPool, SkinningKernel kernel, const DirectX::XMFLOAT4X4* skinMatrices,
+		const SkinningSource& source, const SkinningTarget& target, uint32_t chunkSize = SKINNING_CHUNK_SIZE);
+	void SkinDualQuaternion(WorkerPool& workerPool, SkinningKernel kernel, const DualQuaternion* palette,
+		const SkinningSource& source, const SkinningTarget& target, uint32_t chunkSize = SKINNING_CHUNK_SIZE);
+
+	/// <summary>
+	/// The skin matrices as dual quaternions, for SkinDualQuaternion. The matrices must be rotations and
+	/// translations, scale is dropped.
+	/// </summary>
+	void ComputeDualQuaternions(const std::vector<DirectX::XMFLOAT4X4>& skinMatrices,
+		std::vector<DualQuaternion>& palette);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+namespace transforms {
+    /// <summary>
+    /// Stands in for UniformBufferForSRVs: the same SetValue, but over plain memory, so the systems can
+    /// run without a device. One array per frame in flight.
+    /// </summary>
+    template<typename T>
+    class CpuUniformBuffer
+    {
+    public:
+        CpuUniformBuffer(uint32_t frameCount, uint32_t capacity)
+            :data(frameCount, std::vector<T>(capacity)) {
+        }
+        void SetValue(uint32_t frameIndex, uint32_t id, const T& value) {
+            data[frameIndex][id] = value;
+        }
+        const T* GetData(uint32_t frameIndex) const { return data[frameIndex].data(); }
+    private:
+        std::vector<std::vector<T>> data;
+    };
+}
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "crowd_animation.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <functional>
+
+void common::SortByClip(std::vector<CrowdCharacter>& characters)
+{
+    std::sort(characters.begin(), characters.end(), [](const CrowdCharacter& a, const CrowdCharacter& b) {
+        const std::less<const void*> before;
+        if (a.skeleton != b.skeleton) {
+            return before(a.skeleton, b.skeleton);
+        }
+        if (a.clip != b.clip) {
+            return before(a.clip, b.clip);
+        }
+        if (a.channelBones != b.channelBones) {
+            return before(a.channelBones, b.channelBones);
+        }
+        return a.time < b.time;
+    });
+}
+
+void common::AnimateCrowdGroup(const CrowdCharacter* characters, uint32_t count,
+    std::vector<DirectX::XMFLOAT4X4>& modelMatrices)
+{
+    if (count == 0) {
+        return;
+    }
+    const AnimationClip* clip = characters[0].clip;
+    if (clip) {
+        const std::vector<int32_t>& channelBones = *characters[0].channelBones;
+        for (uint32_t i = 0; i < count; i++) {
+            characters[i].cursors->resize(clip->channels.size());
+        }
+        for (size_t c = 0; c < clip->channels.size(); c++) {
+            const int32_t bone = channelBones[c];
+            if (bone < 0) {
+                continue;
+            }
+            const TransformTracks& tracks = clip->channels[c].tracks;
+            for (uint32_t i = 0; i < count; i++) {
+                const CrowdCharacter& character = characters[i];
+                SampleChannel(tracks, static_cast<uint32_t>(bone), character.time, (*character.cursors)[c],
+                    *character.pose);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const CrowdCharacter& character = characters[i];
+        ComputeModelMatrices(*character.skeleton, *character.pose, modelMatrices);
+        ComputeSkinMatrices(*character.skeleton, modelMatrices, *character.skinMatrices);
+    }
+}
+
+void common::AnimateCrowd(WorkerPool& workerPool, std::vector<CrowdCharacter>& characters, uint32_t chunkSize)
+{
+    SortByClip(characters);
+    //the groups: runs of the same clip, cut at chunkSize
+    std::vector<std::pair<uint32_t, uint32_t>> groups;
+    const uint32_t count = static_cast<uint32_t>(characters.size());
+    chunkSize = std::max(chunkSize, 1u);
+    for (uint32_t first = 0; first < count;) {
+        uint32_t end = first + 1;
+        while (end < count && end - first < chunkSize && characters[end].skeleton == characters[first].skeleton &&
+            characters[end].clip == characters[first].clip &&
+            characters[end].channelBones == characters[first].channelBones) {
+            end++;
+        }
+        groups.emplace_back(first, end - first);
+        first = end;
+    }
+    workerPool.ParallelFor(static_cast<uint32_t>(groups.size()), [&characters, &groups](uint32_t g) {
+        //scratch per thread, the model matrices aren't kept
+        thread_local std::vector<DirectX::XMFLOAT4X4> modelMatrices;
+        AnimateCrowdGroup(characters.data() + groups[g].first, groups[g].second, modelMatrices);
+    });
+}
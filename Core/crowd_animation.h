@@ -0,0 +1,51 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include "skeleton.h"
+
+namespace common
+{
+	class WorkerPool;
+
+	/// <summary>
+	/// A character of a crowd: the clip it plays, at which time, and where its pose goes. Only cursors, pose
+	/// and skinMatrices are written. Without a clip the pose is kept as it is and only the matrices are computed.
+	/// </summary>
+	struct CrowdCharacter
+	{
+		const Skeleton* skeleton = nullptr;
+		const AnimationClip* clip = nullptr;
+		/// <summary>
+		/// BindClip of clip and skeleton.
+		/// </summary>
+		const std::vector<int32_t>* channelBones = nullptr;
+		float time = 0;
+		std::vector<TransformCursors>* cursors = nullptr;
+		Pose* pose = nullptr;
+		std::vector<DirectX::XMFLOAT4X4>* skinMatrices = nullptr;
+	};
+
+	/// <summary>
+	/// How many characters a task of AnimateCrowd gets at most. A task never mixes clips, nor channelBones.
+	/// </summary>
+	constexpr uint32_t CROWD_CHUNK_SIZE = 16;
+
+	/// <summary>
+	/// Orders the characters by skeleton, clip, channelBones and time, so that the ones that read the same keys
+	/// are together.
+	/// </summary>
+	void SortByClip(std::vector<CrowdCharacter>& characters);
+	/// <summary>
+	/// Animates characters [first, first + count), which must play the same clip of the same skeleton with the
+	/// same channelBones: channel by channel, each track is sampled for all of them while its keys are in the
+	/// cache, then each pose goes to model space and to the skin matrices. modelMatrices is scratch.
+	/// </summary>
+	void AnimateCrowdGroup(const CrowdCharacter* characters, uint32_t count,
+		std::vector<DirectX::XMFLOAT4X4>& modelMatrices);
+	/// <summary>
+	/// Sorts the characters by clip and animates them in groups of up to chunkSize on the pool.
+	/// </summary>
+	void AnimateCrowd(WorkerPool& workerPool, std::vector<CrowdCharacter>& characters,
+		uint32_t chunkSize = CROWD_CHUNK_SIZE);
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// A monotonically increasing timeline, like a fence that is only signaled with growing values.
+	/// TimelineFence is the d3d one; anything that counts can stand in for it, that's what keeps the
+	/// release and reuse logic free of d3d.
+	/// </summary>
+	class FenceTimeline
+	{
+	public:
+		virtual ~FenceTimeline() = default;
+		/// <summary>
+		/// The last value the gpu has reached.
+		/// </summary>
+		virtual uint64_t GetCompletedValue() const = 0;
+		/// <summary>
+		/// The value that the next signal will use. Work recorded now is done when the timeline reaches it.
+		/// </summary>
+		virtual uint64_t GetNextValue() const = 0;
+	};
+
+	/// <summary>
+	/// Holds objects that the gpu may still be using until the timeline reaches the value they were queued with.
+	/// The values only grow, so it's a fifo and Collect stops at the first entry that isn't done yet.
+	/// </summary>
+	template<typename T>
+	class DeferredReleaseQueue
+	{
+	public:
+		DeferredReleaseQueue(const FenceTimeline& timeline) :timeline(timeline) {}
+		/// <summary>
+		/// Queues item until the work recorded so far is done.
+		/// </summary>
+		void Release(T item)
+		{
+			Release(std::move(item), timeline.GetNextValue());
+		}
+		/// <summary>
+		/// Queues item until the timeline reaches fenceValue. A value older than the last one queued is
+		/// bumped to it to keep the fifo ordered, the item just lives a bit longer.
+		/// </summary>
+		void Release(T item, uint64_t fenceValue)
+		{
+			if (!pending.empty() && pending.back().first > fenceValue) {
+				fenceValue = pending.back().first;
+			}
+			pending.emplace_back(fenceValue, std::move(item));
+		}
+		/// <summary>
+		/// Hands every item whose value was reached to onReleased, oldest first. Returns how many.
+		/// </summary>
+		template<typename F>
+		size_t Collect(F&& onReleased)
+		{
+			const uint64_t completed = timeline.GetCompletedValue();
+			size_t count = 0;
+			while (!pending.empty() && pending.front().first <= completed) {
+				T item = std::move(pending.front().second);
+				pending.pop_front();
+				onReleased(std::move(item));
+				count++;
+			}
+			return count;
+		}
+		/// <summary>
+		/// Destroys every item whose value was reached.
+		/// </summary>
+		size_t Collect()
+		{
+			return Collect([](T&&) {});
+		}
+		size_t GetPendingCount() const { return pending.size(); }
+		/// <summary>
+		/// The value the newest item waits for, 0 if there's none.
+		/// </summary>
+		uint64_t GetLastPendingValue() const { return pending.empty() ? 0 : pending.back().first; }
+	private:
+		const FenceTimeline& timeline;
+		std::deque<std::pair<uint64_t, T>> pending;
+	};
+
+	struct SizeClassPoolStats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		/// <summary>
+		/// Items that came back when their class was already full, the caller dropped them.
+		/// </summary>
+		uint64_t discarded = 0;
+		size_t pooled = 0;
+	};
+
+	/// <summary>
+	/// Keeps released items (upload buffers) by size class for reuse. The classes are the powers of two
+	/// from minClassSize up, so a request reuses anything of its class and wastes at most half of it.
+	/// Each class keeps at most maxPerClass items so that a burst of uploads doesn't pin memory forever.
+	/// </summary>
+	template<typename T>
+	class SizeClassPool
+	{
+	public:
+		SizeClassPool(uint64_t minClassSize = 256, size_t maxPerClass = 8)
+			:minClassSize(minClassSize), maxPerClass(maxPerClass) {}
+		/// <summary>
+		/// The size that items for a request of size must have.
+		/// </summary>
+		uint64_t ClassSize(uint64_t size) const
+		{
+			uint64_t classSize = minClassSize;
+			while (classSize < size) {
+				classSize <<= 1;
+			}
+			return classSize;
+		}
+		/// <summary>
+		/// An item of ClassSize(size), or nothing if the class is empty and the caller must create one.
+		/// </summary>
+		std::optional<T> Take(uint64_t size)
+		{
+			auto it = classes.find(ClassSize(size));
+			if (it == classes.end() || it->second.empty()) {
+				stats.misses++;
+				return std::nullopt;
+			}
+			T item = std::move(it->second.back());
+			it->second.pop_back();
+			stats.hits++;
+			stats.pooled--;
+			return item;
+		}
+		/// <summary>
+		/// Gives an item of classSize back. Returns false, and doesn't take it, if the class is full or
+		/// classSize isn't a class.
+		/// </summary>
+		bool Put(uint64_t classSize, T item)
+		{
+			if (classSize != ClassSize(classSize)) {
+				return false;
+			}
+			std::vector<T>& items = classes[classSize];
+			if (items.size() >= maxPerClass) {
+				stats.discarded++;
+				return false;
+			}
+			items.push_back(std::move(item));
+			stats.pooled++;
+			return true;
+		}
+		void Clear()
+		{
+			classes.clear();
+			stats.pooled = 0;
+		}
+		const SizeClassPoolStats& GetStats() const { return stats; }
+	private:
+		const uint64_t minClassSize;
+		const size_t maxPerClass;
+		std::unordered_map<uint64_t, std::vector<T>> classes;
+		SizeClassPoolStats stats;
+	};
+}
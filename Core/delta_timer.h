@@ -1,5 +1,6 @@
 #pragma once
-#include <chrono>
+#include <cstdint>
+#include "monotonic_clock.h"
 
 namespace common {
     /// <summary>
@@ -8,7 +9,7 @@ namespace common {
     class DeltaTimer {
     public:
         DeltaTimer() {
-            lastTime = std::chrono::high_resolution_clock::now();
+            lastTime = MonotonicClock::Now();
         }
         /// <summary>
         /// Should be called once per frame because every time it's called it'll
@@ -16,13 +17,12 @@ namespace common {
         /// </summary>
         /// <returns></returns>
         float GetDelta() {
-            auto nowTime = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<float> delta = nowTime - lastTime;
-            float deltaTime = delta.count(); // Now it's in seconds
+            uint64_t nowTime = MonotonicClock::Now();
+            float deltaTime = static_cast<float>(MonotonicClock::ToSeconds(nowTime - lastTime));
             lastTime = nowTime;
             return deltaTime;
         }
     private:
-        std::chrono::high_resolution_clock::time_point lastTime;
+        uint64_t lastTime;
     };
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "descriptor_allocator.h"
+#include <stdexcept>
+
+transforms::DescriptorAllocator::DescriptorAllocator(uint32_t reservedCount, uint32_t descriptorsPerPage,
+    uint32_t pageCount, uint32_t transientPerFrame, uint32_t frameCount)
+    :reservedCount(reservedCount), descriptorsPerPage(descriptorsPerPage), maxPages(pageCount),
+    transientPerFrame(transientPerFrame), frameCount(frameCount),
+    transientStart(reservedCount + descriptorsPerPage * pageCount),
+    generations(descriptorsPerPage * pageCount, 0),
+    rangeLength(descriptorsPerPage * pageCount, 0),
+    transientOffset(frameCount, 0)
+{
+    if (descriptorsPerPage == 0 || frameCount == 0) {
+        throw std::invalid_argument("descriptor allocator needs at least one descriptor per page and one frame");
+    }
+    pages.reserve(maxPages);
+}
+
+transforms::DescriptorHandle transforms::DescriptorAllocator::Allocate()
+{
+    //free slots first, lowest page first, so that the live descriptors stay packed
+    for (uint32_t p = 0; p < pages.size(); p++) {
+        Page& page = pages[p];
+        if (!page.freeList.empty()) {
+            uint32_t index = page.freeList.back();
+            page.freeList.pop_back();
+            page.used++;
+            return MakeHandle(index, 1);
+        }
+        if (page.bump < descriptorsPerPage) {
+            uint32_t index = FirstIndexOf(p) + page.bump++;
+            page.used++;
+            return MakeHandle(index, 1);
+        }
+    }
+    if (!OpenPage()) {
+        throw std::runtime_error("Out of persistent descriptors");
+    }
+    Page& page = pages.back();
+    uint32_t index = FirstIndexOf(static_cast<uint32_t>(pages.size() - 1)) + page.bump++;
+    page.used++;
+    return MakeHandle(index, 1);
+}
+
+transforms::DescriptorHandle transforms::DescriptorAllocator::AllocateRange(uint32_t count)
+{
+    if (count == 0) {
+        throw std::invalid_argument("Empty descriptor range");
+    }
+    if (count == 1) {
+        return Allocate();
+    }
+    if (count > descriptorsPerPage) {
+        throw std::length_error("Descriptor range bigger than a page");
+    }
+    //ranges only come from the untouched tail of a page, the free list is made of single slots
+    for (uint32_t p = 0; p < pages.size(); p++) {
+        Page& page = pages[p];
+        if (descriptorsPerPage - page.bump >= count) {
+            uint32_t index = FirstIndexOf(p) + page.bump;
+            page.bump += count;
+            page.used += count;
+            return MakeHandle(index, count);
+        }
+    }
+    if (!OpenPage()) {
+        throw std::runtime_error("Out of persistent descriptors");
+    }
+    Page& page = pages.back();
+    uint32_t index = FirstIndexOf(static_cast<uint32_t>(pages.size() - 1));
+    page.bump = count;
+    page.used = count;
+    return MakeHandle(index, count);
+}
+
+void transforms::DescriptorAllocator::Free(const DescriptorHandle& handle)
+{
+    if (!IsAlive(handle)) {
+        throw std::runtime_error("Freeing a stale descriptor handle");
+    }
+    const uint32_t first = handle.index - reservedCount;
+    Page& page = pages[PageOf(handle.index)];
+    rangeLength[first] = 0;
+    for (uint32_t i = 0; i < handle.count; i++) {
+        generations[first + i]++;
+        page.freeList.push_back(handle.index + i);
+    }
+    page.used -= handle.count;
+    persistentInUse -= handle.count;
+    //an empty page goes back to being untouched space, that's what lets ranges be reused
+    if (page.used == 0) {
+        page.bump = 0;
+        page.freeList.clear();
+    }
+}
+
+bool transforms::DescriptorAllocator::IsAlive(const DescriptorHandle& handle) const
+{
+    if (!handle.IsValid() || handle.index < reservedCount || handle.index >= transientStart) {
+        return false;
+    }
+    const uint32_t slot = handle.index - reservedCount;
+    return rangeLength[slot] != 0 &&
+        rangeLength[slot] == handle.count &&
+        generations[slot] == handle.generation;
+}
+
+transforms::DescriptorHandle transforms::DescriptorAllocator::HandleAt(uint32_t index) const
+{
+    if (index < reservedCount || index >= transientStart) {
+        return {};
+    }
+    const uint32_t slot = index - reservedCount;
+    if (rangeLength[slot] == 0) {
+        return {};
+    }
+    return { index, generations[slot], rangeLength[slot] };
+}
+
+void transforms::DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+    if (frameIndex >= frameCount) {
+        throw std::out_of_range("Frame index out of range");
+    }
+    currentFrame = frameIndex;
+    transientOffset[frameIndex] = 0;
+}
+
+uint32_t transforms::DescriptorAllocator::AllocateTransient(uint32_t count)
+{
+    uint32_t& offset = transientOffset[currentFrame];
+    if (offset + count > transientPerFrame) {
+        throw std::runtime_error("Out of transient descriptors for this frame");
+    }
+    uint32_t index = transientStart + currentFrame * transientPerFrame + offset;
+    offset += count;
+    if (offset > transientHighWater) {
+        transientHighWater = offset;
+    }
+    return index;
+}
+
+transforms::DescriptorHandle transforms::DescriptorAllocator::MakeHandle(uint32_t index, uint32_t count)
+{
+    const uint32_t slot = index - reservedCount;
+    rangeLength[slot] = count;
+    persistentInUse += count;
+    return { index, generations[slot], count };
+}
+
+bool transforms::DescriptorAllocator::OpenPage()
+{
+    if (pages.size() >= maxPages) {
+        return false;
+    }
+    pages.emplace_back();
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace transforms {
+    /// <summary>
+    /// Stable reference to one or more contiguous descriptors. It's an index into the heap, not a
+    /// pointer, so it stays valid for as long as the heap lives. The generation lets the allocator
+    /// detect handles that were already freed (and maybe reused by someone else).
+    /// </summary>
+    struct DescriptorHandle {
+        static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+        uint32_t count = 0;
+        bool IsValid() const { return index != INVALID_INDEX; }
+    };
+
+    /// <summary>
+    /// Bookkeeping for a fixed size descriptor heap. It knows nothing about d3d, it only hands out
+    /// indices, so it can be tested on the CPU. The heap is split in three regions:
+    /// [reserved | persistent pages | transient ring (one linear region per frame in flight)].
+    /// The heap never grows: when the persistent pages are exhausted allocation throws instead of
+    /// rebuilding the heap, because a rebuild invalidates every gpu handle that was already handed out.
+    /// </summary>
+    class DescriptorAllocator
+    {
+    public:
+        DescriptorAllocator(uint32_t reservedCount, uint32_t descriptorsPerPage, uint32_t pageCount,
+            uint32_t transientPerFrame, uint32_t frameCount);
+        /// <summary>
+        /// Total number of descriptors the heap must have to back all the regions.
+        /// </summary>
+        uint32_t GetCapacity() const { return transientStart + transientPerFrame * frameCount; }
+        uint32_t GetReservedCount() const { return reservedCount; }
+        uint32_t GetDescriptorsPerPage() const { return descriptorsPerPage; }
+        /// <summary>
+        /// Allocates one persistent descriptor. Reuses freed slots before touching untouched space.
+        /// </summary>
+        DescriptorHandle Allocate();
+        /// <summary>
+        /// Allocates count contiguous persistent descriptors. A range never crosses a page, so
+        /// count must be <= descriptorsPerPage.
+        /// </summary>
+        DescriptorHandle AllocateRange(uint32_t count);
+        /// <summary>
+        /// Returns the descriptors to the free list and bumps their generation. The caller must make sure
+        /// that the gpu is done with them. Throws if the handle is stale.
+        /// </summary>
+        void Free(const DescriptorHandle& handle);
+        bool IsAlive(const DescriptorHandle& handle) const;
+        /// <summary>
+        /// The live handle whose first descriptor is at index. Invalid handle if there's none.
+        /// </summary>
+        DescriptorHandle HandleAt(uint32_t index) const;
+        /// <summary>
+        /// Starts a new frame: the linear region of that frame is rewound. Only call it after the
+        /// gpu finished the frame that last used frameIndex.
+        /// </summary>
+        void BeginFrame(uint32_t frameIndex);
+        /// <summary>
+        /// Bump allocates count descriptors from the current frame's region. They are only valid
+        /// until the next BeginFrame with the same frameIndex. Returns the absolute heap index.
+        /// </summary>
+        uint32_t AllocateTransient(uint32_t count);
+
+        uint32_t GetPersistentInUse() const { return persistentInUse; }
+        uint32_t GetPagesOpened() const { return static_cast<uint32_t>(pages.size()); }
+        uint32_t GetTransientHighWater() const { return transientHighWater; }
+    private:
+        struct Page {
+            uint32_t bump = 0;
+            uint32_t used = 0;
+            std::vector<uint32_t> freeList;
+        };
+        uint32_t PageOf(uint32_t index) const { return (index - reservedCount) / descriptorsPerPage; }
+        uint32_t FirstIndexOf(uint32_t page) const { return reservedCount + page * descriptorsPerPage; }
+        DescriptorHandle MakeHandle(uint32_t index, uint32_t count);
+        bool OpenPage();
+
+        const uint32_t reservedCount;
+        const uint32_t descriptorsPerPage;
+        const uint32_t maxPages;
+        const uint32_t transientPerFrame;
+        const uint32_t frameCount;
+        const uint32_t transientStart;
+        std::vector<Page> pages;
+        //per persistent slot, indexed by (index - reservedCount)
+        std::vector<uint32_t> generations;
+        std::vector<uint32_t> rangeLength; //0 means it's not the head of a live allocation
+        uint32_t persistentInUse = 0;
+        uint32_t currentFrame = 0;
+        std::vector<uint32_t> transientOffset;
+        uint32_t transientHighWater = 0;
+    };
+}
@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "frame_capture.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace
+{
+    const char* CAPTURE_HEADER = "frame_capture 1";
+
+    bool IsValidEventName(const std::string& name)
+    {
+        return !name.empty() && std::none_of(name.begin(), name.end(), [](char c) {
+            return std::isspace(static_cast<unsigned char>(c)) != 0;
+            });
+    }
+
+    std::runtime_error CaptureError(size_t line, const std::string& what)
+    {
+        return std::runtime_error("frame capture, line " + std::to_string(line) + ": " + what);
+    }
+}
+
+void common::FrameCapture::BeginFrame(float deltaTime, int32_t key)
+{
+    CapturedFrame frame;
+    frame.deltaTime = deltaTime;
+    frame.key = key;
+    frames.push_back(frame);
+}
+
+void common::FrameCapture::AddEvent(const std::string& name, double value)
+{
+    assert(!frames.empty());
+    if (!IsValidEventName(name)) {
+        throw std::invalid_argument("capture event names can't be empty or have whitespace: '" + name + "'");
+    }
+    frames.back().events.push_back({ name, value });
+}
+
+void common::FrameCapture::SetStateHash(uint64_t hash)
+{
+    assert(!frames.empty());
+    frames.back().stateHash = hash;
+}
+
+void common::FrameCapture::Write(std::ostream& out) const
+{
+    //enough digits for the values to read back bit for bit, replays depend on the exact time steps
+    const std::streamsize oldPrecision = out.precision();
+    out << CAPTURE_HEADER << "\n";
+    for (const CapturedFrame& frame : frames) {
+        out << std::setprecision(std::numeric_limits<float>::max_digits10) << frame.deltaTime << ' ' << frame.key << ' '
+            << std::hex << frame.stateHash << std::dec << ' ' << frame.events.size();
+        for (const CapturedEvent& e : frame.events) {
+            out << ' ' << e.name << ' ' << std::setprecision(std::numeric_limits<double>::max_digits10) << e.value;
+        }
+        out << "\n";
+    }
+    out.precision(oldPrecision);
+}
+
+common::FrameCapture common::FrameCapture::Read(std::istream& in)
+{
+    std::string line;
+    if (!std::getline(in, line) || line != CAPTURE_HEADER) {
+        throw CaptureError(1, "expected '" + std::string(CAPTURE_HEADER) + "'");
+    }
+    FrameCapture capture;
+    size_t lineNumber = 1;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream ss(line);
+        CapturedFrame frame;
+        size_t eventCount = 0;
+        if (!(ss >> frame.deltaTime >> frame.key >> std::hex >> frame.stateHash >> std::dec >> eventCount)) {
+            throw CaptureError(lineNumber, "expected delta time, key, state hash and event count");
+        }
+        for (size_t e = 0; e < eventCount; e++) {
+            CapturedEvent event;
+            if (!(ss >> event.name >> event.value)) {
+                throw CaptureError(lineNumber, "expected " + std::to_string(eventCount) + " events");
+            }
+            frame.events.push_back(event);
+        }
+        capture.frames.push_back(frame);
+    }
+    return capture;
+}
+
+common::FrameReplay::FrameReplay(FrameCapture capture, float fixedDeltaTime)
+    :capture(std::move(capture)), fixedDeltaTime(fixedDeltaTime), frame(0),
+    firstDivergentFrame(this->capture.GetFrames().size())
+{
+}
+
+bool common::FrameReplay::Advance()
+{
+    if (started && frame < capture.GetFrames().size()) {
+        frame++;
+    }
+    started = true;
+    return frame < capture.GetFrames().size();
+}
+
+float common::FrameReplay::GetDeltaTime() const
+{
+    return fixedDeltaTime > 0 ? fixedDeltaTime : GetFrame().deltaTime;
+}
+
+bool common::FrameReplay::CheckState(uint64_t stateHash)
+{
+    if (GetDeltaTime() != GetFrame().deltaTime) {
+        //the scripts took another step than in the capture, the state can't be the same
+        uncheckedFrames++;
+        return true;
+    }
+    checkedFrames++;
+    if (stateHash == GetFrame().stateHash) {
+        return true;
+    }
+    firstDivergentFrame = std::min(firstDivergentFrame, frame);
+    return false;
+}
+
+std::optional<common::FrameCapture> common::ReadCaptureFile(const std::string& path, std::ostream& errors)
+{
+    std::ifstream file(path);
+    if (!file) {
+        errors << "Could not open " << path << std::endl;
+        return std::nullopt;
+    }
+    try {
+        FrameCapture capture = FrameCapture::Read(file);
+        if (capture.GetFrames().empty()) {
+            errors << path << " has no frames" << std::endl;
+            return std::nullopt;
+        }
+        return capture;
+    }
+    catch (const std::runtime_error& e) {
+        errors << path << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void common::WriteReplayResult(std::ostream& out, const std::string& name, const FrameReplay& replay)
+{
+    const size_t unchecked = replay.GetUncheckedFrameCount();
+    if (replay.GetFirstDivergentFrame() < replay.GetFrameCount()) {
+        out << "Replay of " << name << " diverged from the capture at frame " << replay.GetFirstDivergentFrame() << std::endl;
+    }
+    else if (replay.GetCheckedFrameCount() == 0) {
+        out << "Replay of " << name << " wasn't checked against the capture, no frame had the captured time step; "
+            "--fixed-dt 0 replays the captured time steps" << std::endl;
+        return;
+    }
+    else {
+        out << "Replay of " << name << " matched the capture" << std::endl;
+    }
+    if (unchecked > 0) {
+        out << unchecked << " frames weren't checked, their time step isn't the captured one" << std::endl;
+    }
+}
+
+uint64_t common::HashState(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// A state change the main loop applied in a frame, like the exposure slider or the frame pacing button.
+	/// The name has no whitespace.
+	/// </summary>
+	struct CapturedEvent
+	{
+		std::string name;
+		double value = 0;
+	};
+
+	/// <summary>
+	/// What drove a frame: the time step the scripts got, the key they saw, the state changes, and a hash of
+	/// the state the scripts left behind, to tell where a replay diverges.
+	/// </summary>
+	struct CapturedFrame
+	{
+		float deltaTime = 0;
+		int32_t key = 0;
+		uint64_t stateHash = 0;
+		std::vector<CapturedEvent> events;
+	};
+
+	/// <summary>
+	/// The frames of a run, in a text format with one line per frame, so that captures can be diffed and
+	/// kept next to the timings they produced.
+	/// </summary>
+	class FrameCapture
+	{
+	public:
+		/// <summary>
+		/// Starts a frame. Events and the state hash go to the last frame begun.
+		/// </summary>
+		void BeginFrame(float deltaTime, int32_t key);
+		/// <summary>
+		/// Throws std::invalid_argument if the name is empty or has whitespace.
+		/// </summary>
+		void AddEvent(const std::string& name, double value);
+		void SetStateHash(uint64_t hash);
+		const std::vector<CapturedFrame>& GetFrames() const { return frames; }
+		void Write(std::ostream& out) const;
+		/// <summary>
+		/// Throws std::runtime_error, with the line, if the stream isn't a capture.
+		/// </summary>
+		static FrameCapture Read(std::istream& in);
+	private:
+		std::vector<CapturedFrame> frames;
+	};
+
+	/// <summary>
+	/// Reads the capture in the file at path, or writes to errors why it can't, an empty capture included,
+	/// and returns nothing.
+	/// </summary>
+	std::optional<FrameCapture> ReadCaptureFile(const std::string& path, std::ostream& errors);
+
+	/// <summary>
+	/// Feeds a capture back, frame by frame. With a fixedDeltaTime greater than zero every frame gets that
+	/// time step instead of the captured one, which takes the frame rate of the capturing machine out of the
+	/// simulation. The state hashes are only comparable when the time steps are the same as in the capture.
+	/// </summary>
+	class FrameReplay
+	{
+	public:
+		FrameReplay(FrameCapture capture, float fixedDeltaTime);
+		/// <summary>
+		/// Moves to the next frame, returns false when the capture is over.
+		/// </summary>
+		bool Advance();
+		/// <summary>
+		/// The current frame, valid after Advance returned true.
+		/// </summary>
+		const CapturedFrame& GetFrame() const { return capture.GetFrames()[frame]; }
+		float GetDeltaTime() const;
+		size_t GetFrameNumber() const { return frame; }
+		size_t GetFrameCount() const { return capture.GetFrames().size(); }
+		/// <summary>
+		/// Compares the state of the current frame with the captured one, returns false if it differs.
+		/// Frames with a different time step from the capture aren't checked, they count as unchecked.
+		/// </summary>
+		bool CheckState(uint64_t stateHash);
+		/// <summary>
+		/// The first frame whose state differed from the capture, or GetFrameCount() if none did.
+		/// </summary>
+		size_t GetFirstDivergentFrame() const { return firstDivergentFrame; }
+		size_t GetCheckedFrameCount() const { return checkedFrames; }
+		/// <summary>
+		/// The frames CheckState skipped because their time step wasn't the captured one. A fixedDeltaTime of 0
+		/// replays the captured steps and checks every frame.
+		/// </summary>
+		size_t GetUncheckedFrameCount() const { return uncheckedFrames; }
+	private:
+		const FrameCapture capture;
+		const float fixedDeltaTime;
+		size_t frame;
+		size_t firstDivergentFrame;
+		size_t checkedFrames = 0;
+		size_t uncheckedFrames = 0;
+		bool started = false;
+	};
+
+	/// <summary>
+	/// Writes whether the replay of the capture called name matched it, diverged, or couldn't be checked.
+	/// </summary>
+	void WriteReplayResult(std::ostream& out, const std::string& name, const FrameReplay& replay);
+
+	/// <summary>
+	/// FNV-1a over size bytes, chained from hash. Start a chain with STATE_HASH_SEED.
+	/// </summary>
+	constexpr uint64_t STATE_HASH_SEED = 0xcbf29ce484222325ull;
+	uint64_t HashState(uint64_t hash, const void* data, size_t size);
+}
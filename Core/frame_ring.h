@@ -0,0 +1,69 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace common
+{
+	/// <summary>
+	/// One T per frame in flight, indexed by the frame index. The number of frames is chosen at runtime,
+	/// when the ring is created, and doesn't change after that.
+	/// It's what the per frame resources (allocators, uniform buffers, depth buffers, ...) are stored in,
+	/// instead of vectors resized to a compile time frame count.
+	/// </summary>
+	template<typename T>
+	class FrameRing
+	{
+	public:
+		FrameRing() = default;
+		explicit FrameRing(uint32_t frameCount)
+		{
+			Reset(frameCount);
+		}
+		/// <summary>
+		/// Every element is factory(frameIndex).
+		/// </summary>
+		template<typename F>
+		FrameRing(uint32_t frameCount, F&& factory)
+		{
+			Reset(frameCount);
+			for (uint32_t i = 0; i < frameCount; i++) {
+				items[i] = factory(i);
+			}
+		}
+		/// <summary>
+		/// Drops the elements and creates frameCount default constructed ones.
+		/// </summary>
+		void Reset(uint32_t frameCount)
+		{
+			if (frameCount == 0) {
+				throw std::invalid_argument("A frame ring needs at least one frame");
+			}
+			items = std::make_unique<T[]>(frameCount);
+			count = frameCount;
+		}
+		T& operator[](uint32_t frameIndex)
+		{
+			assert(frameIndex < count);
+			return items[frameIndex];
+		}
+		const T& operator[](uint32_t frameIndex) const
+		{
+			assert(frameIndex < count);
+			return items[frameIndex];
+		}
+		/// <summary>
+		/// The frame that comes after frameIndex, wrapping around.
+		/// </summary>
+		uint32_t Next(uint32_t frameIndex) const { return (frameIndex + 1) % count; }
+		uint32_t GetFrameCount() const { return count; }
+		T* begin() { return items.get(); }
+		T* end() { return items.get() + count; }
+		const T* begin() const { return items.get(); }
+		const T* end() const { return items.get() + count; }
+	private:
+		std::unique_ptr<T[]> items;
+		uint32_t count = 0;
+	};
+}
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "frame_stats.h"
+#include <algorithm>
+#include <cmath>
+
+common::FrameStats::FrameStats(uint32_t history, double bucketMs, double maxMs, StutterSettings stutterSettings)
+    :bucketMs(bucketMs), maxMs(maxMs), stutterSettings(stutterSettings),
+    histogram(static_cast<size_t>(std::ceil(maxMs / bucketMs)) + 1),
+    history(std::max(history, 1u))
+{
+    assert(bucketMs > 0 && maxMs > bucketMs);
+}
+
+void common::FrameStats::Reset()
+{
+    std::fill(histogram.begin(), histogram.end(), 0);
+    std::fill(history.begin(), history.end(), FrameRecord{});
+    frameCount = 0;
+    minMs = 0;
+    maxSeenMs = 0;
+    mean = 0;
+    m2 = 0;
+    jitterSum = 0;
+    previousMs = 0;
+    movingAverageMs = 0;
+    stutterCount = 0;
+}
+
+bool common::FrameStats::AddFrame(double frameMs)
+{
+    frameMs = std::max(frameMs, 0.0);
+    const size_t bucket = std::min(static_cast<size_t>(frameMs / bucketMs), histogram.size() - 1);
+    histogram[bucket]++;
+    bool stutter = false;
+    if (frameCount == 0) {
+        minMs = frameMs;
+        maxSeenMs = frameMs;
+        movingAverageMs = frameMs;
+    }
+    else {
+        minMs = std::min(minMs, frameMs);
+        maxSeenMs = std::max(maxSeenMs, frameMs);
+        jitterSum += std::abs(frameMs - previousMs);
+        stutter = frameMs > movingAverageMs * stutterSettings.ratio &&
+            frameMs - movingAverageMs > stutterSettings.minimumMs;
+        //a stutter would drag the average up and hide the next one, so it stays out
+        if (!stutter) {
+            const double alpha = 2.0 / (std::max(stutterSettings.averageFrames, 1u) + 1.0);
+            movingAverageMs += alpha * (frameMs - movingAverageMs);
+        }
+    }
+    if (stutter) {
+        stutterCount++;
+    }
+    frameCount++;
+    const double delta = frameMs - mean;
+    mean += delta / frameCount;
+    m2 += delta * (frameMs - mean);
+    previousMs = frameMs;
+    history[(frameCount - 1) % history.size()] = { frameCount - 1, frameMs, stutter };
+    return stutter;
+}
+
+double common::FrameStats::GetPercentile(double fraction) const
+{
+    if (frameCount == 0) {
+        return 0;
+    }
+    fraction = std::clamp(fraction, 0.0, 1.0);
+    //the rank of the frame we want, 1 based
+    const double rank = std::max(1.0, std::ceil(fraction * frameCount));
+    uint64_t below = 0;
+    for (size_t b = 0; b < histogram.size(); b++) {
+        if (below + histogram[b] >= rank) {
+            if (b == histogram.size() - 1) {
+                return maxMs;
+            }
+            //spread the frames of the bucket evenly over it
+            const double inside = (rank - below) / histogram[b];
+            return std::clamp((b + inside) * bucketMs, minMs, maxSeenMs);
+        }
+        below += histogram[b];
+    }
+    return maxSeenMs;
+}
+
+common::FrameStatsSummary common::FrameStats::GetSummary() const
+{
+    FrameStatsSummary summary;
+    summary.frameCount = frameCount;
+    if (frameCount == 0) {
+        return summary;
+    }
+    summary.minMs = minMs;
+    summary.maxMs = maxSeenMs;
+    summary.meanMs = mean;
+    summary.stdDevMs = frameCount > 1 ? std::sqrt(m2 / (frameCount - 1)) : 0.0;
+    summary.p50Ms = GetPercentile(0.50);
+    summary.p95Ms = GetPercentile(0.95);
+    summary.p99Ms = GetPercentile(0.99);
+    summary.jitterMs = frameCount > 1 ? jitterSum / (frameCount - 1) : 0.0;
+    summary.stutterCount = stutterCount;
+    return summary;
+}
+
+void common::FrameStats::WriteFramesCsv(std::ostream& out) const
+{
+    out << "frame,ms,stutter\n";
+    const uint64_t count = std::min<uint64_t>(frameCount, history.size());
+    for (uint64_t i = frameCount - count; i < frameCount; i++) {
+        const FrameRecord& record = history[i % history.size()];
+        out << record.frame << ',' << record.ms << ',' << (record.stutter ? 1 : 0) << '\n';
+    }
+}
+
+void common::FrameStats::WriteHistogramCsv(std::ostream& out) const
+{
+    out << "from_ms,to_ms,count\n";
+    for (size_t b = 0; b < histogram.size(); b++) {
+        out << b * bucketMs << ',';
+        if (b == histogram.size() - 1) {
+            out << "inf";
+        }
+        else {
+            out << (b + 1) * bucketMs;
+        }
+        out << ',' << histogram[b] << '\n';
+    }
+}
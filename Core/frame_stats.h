@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// When a frame counts as a stutter: it took more than ratio times the recent average and more than
+	/// minimumMs over it. The recent average is an exponential moving average over about averageFrames frames.
+	/// </summary>
+	struct StutterSettings
+	{
+		double ratio = 2.0;
+		double minimumMs = 4.0;
+		uint32_t averageFrames = 30;
+	};
+
+	struct FrameStatsSummary
+	{
+		uint64_t frameCount = 0;
+		double minMs = 0;
+		double maxMs = 0;
+		double meanMs = 0;
+		double stdDevMs = 0;
+		double p50Ms = 0;
+		double p95Ms = 0;
+		double p99Ms = 0;
+		/// <summary>
+		/// Mean absolute difference between consecutive frame times.
+		/// </summary>
+		double jitterMs = 0;
+		uint64_t stutterCount = 0;
+	};
+
+	/// <summary>
+	/// Frame time statistics. Every frame goes into a histogram with fixed buckets, which gives the
+	/// percentiles of the whole run in constant memory, and into a ring with the last frames, which is what
+	/// the CSV export writes. Feed it once per frame with AddFrame.
+	/// </summary>
+	class FrameStats
+	{
+	public:
+		static constexpr uint32_t DEFAULT_HISTORY = 4096;
+		/// <summary>
+		/// bucketMs wide buckets from 0 to maxMs; slower frames go to an overflow bucket and count as maxMs
+		/// in the percentiles.
+		/// </summary>
+		explicit FrameStats(uint32_t history = DEFAULT_HISTORY, double bucketMs = 0.1, double maxMs = 250.0,
+			StutterSettings stutterSettings = {});
+		/// <summary>
+		/// Adds a frame, returns whether it was a stutter.
+		/// </summary>
+		bool AddFrame(double frameMs);
+		void Reset();
+		FrameStatsSummary GetSummary() const;
+		/// <summary>
+		/// The frame time below which fraction (0 to 1) of the frames are, from the histogram: exact to a bucket.
+		/// </summary>
+		double GetPercentile(double fraction) const;
+		/// <summary>
+		/// The last frames, oldest first: frame,ms,stutter.
+		/// </summary>
+		void WriteFramesCsv(std::ostream& out) const;
+		/// <summary>
+		/// The histogram buckets: from_ms,to_ms,count. The overflow bucket ends at inf.
+		/// </summary>
+		void WriteHistogramCsv(std::ostream& out) const;
+	private:
+		struct FrameRecord
+		{
+			uint64_t frame = 0;
+			double ms = 0;
+			bool stutter = false;
+		};
+		const double bucketMs;
+		const double maxMs;
+		const StutterSettings stutterSettings;
+		//the last bucket is the overflow
+		std::vector<uint64_t> histogram;
+		std::vector<FrameRecord> history;
+		uint64_t frameCount = 0;
+		double minMs = 0;
+		double maxSeenMs = 0;
+		//Welford's running mean and variance
+		double mean = 0;
+		double m2 = 0;
+		double jitterSum = 0;
+		double previousMs = 0;
+		double movingAverageMs = 0;
+		uint64_t stutterCount = 0;
+	};
+}
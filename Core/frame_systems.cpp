@@ -0,0 +1,42 @@
+#include "pch.h"
+#include "frame_systems.h"
+#include "frame_capture.h"
+
+void transforms::AddSimulationSystems(common::SystemScheduler& scheduler, entt::registry& registry,
+    FrameState& frame, std::shared_ptr<systems::ScriptRunner> scriptRunner)
+{
+    using namespace components;
+    common::SystemDesc scripts;
+    scripts.name = "RunScripts";
+    //behaviors keep their own state, they write themselves
+    scripts.writes = ComponentAccess<Transform, Script>(registry);
+    for (const std::type_index& behavior : scriptRunner->GetBehaviorTypes()) {
+        scripts.writes.push_back(behavior);
+    }
+    //scripts can do anything, like closing the window, which works only from the thread that made it
+    scripts.exclusive = true;
+    scripts.run = [scriptRunner, &registry, &frame]() {
+        scriptRunner->Run(registry, frame.deltaTime);
+    };
+    scheduler.Add(scripts);
+    common::SystemDesc transformsSystem;
+    transformsSystem.name = "UpdateAllTransforms";
+    transformsSystem.reads = ComponentAccess<Hierarchy>(registry);
+    transformsSystem.writes = ComponentAccess<Transform>(registry);
+    transformsSystem.run = [&registry]() {
+        UpdateAllTransforms(registry);
+    };
+    scheduler.Add(transformsSystem);
+}
+
+uint64_t transforms::HashScriptedState(entt::registry& registry)
+{
+    using namespace components;
+    uint64_t hash = common::STATE_HASH_SEED;
+    registry.view<Transform>().each([&hash](entt::entity, const Transform& t) {
+        hash = common::HashState(hash, &t.position, sizeof(t.position));
+        hash = common::HashState(hash, &t.rotation, sizeof(t.rotation));
+        hash = common::HashState(hash, &t.scale, sizeof(t.scale));
+    });
+    return hash;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <typeindex>
+#include <vector>
+#include <entt/entt.hpp>
+#include "system_scheduler.h"
+#include "components.h"
+#include "script_runner_system.h"
+#include "per_object_data_upload_system.h"
+#include "ShadowDataUpdateSystem.h"
+#include "lighting_data.h"
+#include "per_frame_data_for_simple_lighting.h"
+#include "per_frame_data_for_unlit_debug.h"
+#include "cpu_profiler.h"
+namespace transforms {
+    /// <summary>
+    /// The component list of a SystemDesc. It also creates the storage of the components, views only read
+    /// the registry once every storage they ask for exists, and the systems' views run at the same time.
+    /// </summary>
+    template<typename... Components>
+    std::vector<std::type_index> ComponentAccess(entt::registry& registry) {
+        (registry.storage<Components>(), ...);
+        return common::Resources<Components...>();
+    }
+    /// <summary>
+    /// What the frame systems get from the main loop, set before every SystemScheduler::Run, and what they
+    /// hand to each other.
+    /// </summary>
+    struct FrameState {
+        uint32_t frameIndex = 0;
+        float deltaTime = 0;
+        float exposure = 0;
+        /// <summary>
+        /// Written by the lighting upload, read by the per-frame data upload.
+        /// </summary>
+        struct LightCount {
+            uint32_t value = 0;
+        } lightCount;
+    };
+    /// <summary>
+    /// The systems both the window and the headless replay run: the scripts, with the behaviors registered in
+    /// scriptRunner, and the transforms.
+    /// </summary>
+    void AddSimulationSystems(common::SystemScheduler& scheduler, entt::registry& registry, FrameState& frame,
+        std::shared_ptr<systems::ScriptRunner> scriptRunner);
+    /// <summary>
+    /// The per-object and shadow map uploads, into any buffers with SetValue: the gpu ones or cpu stand-ins.
+    /// ShadowMap is the shadow map component, a shared_ptr to a PointLightShadowCamera or to something derived.
+    /// </summary>
+    template<typename ShadowMap, typename PerObjectBuffer, typename PointShadowBuffer>
+    void AddObjectAndShadowUploadSystems(common::SystemScheduler& scheduler, entt::registry& registry,
+        FrameState& frame, PerObjectBuffer* perObjectBuffer, PointShadowBuffer* pointShadowBuffer)
+    {
+        using namespace components;
+        typedef std::shared_ptr<BSDFMaterial> BSDFMaterial_t;
+        common::SystemDesc perObject;
+        perObject.name = "PerObjectDataUpload";
+        perObject.reads = ComponentAccess<Renderable, Transform, BSDFMaterial_t>(registry);
+        perObject.writes = common::Resources<PerObjectBuffer>();
+        perObject.run = [&registry, &frame, perObjectBuffer]() {
+            PerObjectDataUploadSystem(registry.view<Renderable, Transform, BSDFMaterial_t>(), perObjectBuffer,
+                frame.frameIndex);
+        };
+        scheduler.Add(perObject);
+        common::SystemDesc shadowData;
+        shadowData.name = "ShadowDataDataUpload";
+        shadowData.reads = ComponentAccess<Transform, PointLight>(registry);
+        //it moves the shadow maps to their light
+        shadowData.writes = ComponentAccess<ShadowMap>(registry);
+        shadowData.writes.push_back(typeid(PointShadowBuffer));
+        shadowData.run = [&registry, &frame, pointShadowBuffer]() {
+            ShadowDataDataUploadSystem(registry.view<Transform, PointLight, ShadowMap>(), pointShadowBuffer,
+                frame.frameIndex);
+        };
+        scheduler.Add(shadowData);
+    }
+    /// <summary>
+    /// The lights and the per-frame camera data uploads, into any buffers with SetValue like
+    /// AddObjectAndShadowUploadSystems. The lighting one counts the lights in FrameState::lightCount, the
+    /// per-frame one, after it, hands the count to the shaders.
+    /// </summary>
+    template<typename ShadowMap, typename LightingBuffer, typename UnlitDebugBuffer, typename SimpleLightingBuffer>
+    void AddLightingAndPerFrameUploadSystems(common::SystemScheduler& scheduler, entt::registry& registry,
+        FrameState& frame, LightingBuffer* lightingBuffer, UnlitDebugBuffer* unlitDebugBuffer,
+        SimpleLightingBuffer* simpleLightingBuffer)
+    {
+        using namespace components;
+        common::SystemDesc lighting;
+        lighting.name = "LightingDataUpload";
+        lighting.reads = ComponentAccess<Transform, PointLight, ShadowMap>(registry);
+        lighting.writes = common::Resources<LightingBuffer, FrameState::LightCount>();
+        lighting.run = [&registry, &frame, lightingBuffer]() {
+            PROFILE_SCOPE("LightingDataUpload");
+            uint32_t numLights = 0;
+            registry.view<Transform, PointLight, ShadowMap>().each([&numLights, &frame, lightingBuffer](
+                entt::entity e,
+                const Transform& t,
+                const PointLight& l,
+                const ShadowMap& shadowMap) {
+                LightingData ld{};
+                ld.attenuationConstant = l.attenuationConstant;
+                ld.attenuationLinear = l.attenuationLinear;
+                ld.attenuationQuadratic = l.attenuationQuadratic;
+                ld.ColorAmbient = l.ColorAmbient;
+                ld.ColorDiffuse = l.ColorDiffuse;
+                ld.ColorSpecular = l.ColorSpecular;
+                auto _p = t.GetUpdatedWorldPosition();
+                ld.position.x = _p.x;
+                ld.position.y = _p.y;
+                ld.position.z = _p.z;
+                ld.position.w = 0;
+                //copy shadow map data.
+                DirectX::XMStoreFloat4x4(&ld.projectionMatrix, DirectX::XMMatrixTranspose(shadowMap->GetProjectionMatrix()));
+                ld.shadowFarPlane = shadowMap->GetFarPlane();
+                ld.shadowMapIndex = numLights;
+                lightingBuffer->SetValue(frame.frameIndex, numLights, ld);
+                numLights++;
+            });
+            frame.lightCount.value = numLights;
+        };
+        scheduler.Add(lighting);
+        common::SystemDesc perFrame;
+        perFrame.name = "PerFrameDataUpload";
+        perFrame.reads = ComponentAccess<Transform, Perspective, tags::MainCamera>(registry);
+        perFrame.reads.push_back(typeid(FrameState::LightCount));
+        perFrame.writes = common::Resources<UnlitDebugBuffer, SimpleLightingBuffer>();
+        perFrame.run = [&registry, &frame, unlitDebugBuffer, simpleLightingBuffer]() {
+            PROFILE_SCOPE("PerFrameDataUpload");
+            registry.view<Transform, Perspective, tags::MainCamera>().each([&frame, unlitDebugBuffer, simpleLightingBuffer](
+                auto entity, const Transform& transform, const Perspective& perspective) {
+                //For now i assume that there's only one camera that matters, the one with the MainCamera tag.
+                using namespace DirectX;
+                XMMATRIX viewMatrix = XMMatrixInverse(nullptr, transform.worldMatrix);
+                XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(perspective.fovDegrees), perspective.ratio, perspective.zNear, perspective.zFar);
+                XMMATRIX viewProjectionMatrix = XMMatrixTranspose(XMMatrixMultiply(viewMatrix, projectionMatrix));
+
+                PerFrameDataForUnlitDebug pfd{ viewProjectionMatrix };
+                unlitDebugBuffer->SetValue(frame.frameIndex, 0, pfd);
+
+                PerFrameDataForSimpleLighting _sl{};
+                _sl.cameraPosition = transform.GetUpdatedWorldPosition();
+                _sl.projMatrix = XMMatrixTranspose(projectionMatrix);
+                _sl.viewMatrix = XMMatrixTranspose(viewMatrix);
+                _sl.viewProjMatrix = viewProjectionMatrix;
+                _sl.numberOfPointLights = frame.lightCount.value;
+                _sl.exposure.x = frame.exposure;
+                simpleLightingBuffer->SetValue(frame.frameIndex, 0, _sl);
+            });
+        };
+        scheduler.Add(perFrame);
+    }
+    /// <summary>
+    /// Hash of the local transforms, which only the scripts move: what a replay has to reproduce.
+    /// </summary>
+    uint64_t HashScriptedState(entt::registry& registry);
+}
@@ -1,13 +1,12 @@
 #include "pch.h"
 #include "game_timer.h"
+#include "monotonic_clock.h"
 
 common::GameTimer::GameTimer()
 	:mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0),
 	mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / (double)countsPerSec;
+	mSecondsPerCount = MonotonicClock::SecondsPerTick();
 }
 
 float common::GameTimer::TotalTime() const
@@ -29,8 +28,7 @@ float common::GameTimer::DeltaTime() const
 
 void common::GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	int64_t currTime = static_cast<int64_t>(MonotonicClock::Now());
 	mBaseTime = currTime;
 	mPrevTime = currTime;
 	mStopTime = 0;
@@ -39,8 +37,7 @@ void common::GameTimer::Reset()
 
 void common::GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	int64_t startTime = static_cast<int64_t>(MonotonicClock::Now());
 	if (mStopped)
 	{
 		mPausedTime += (startTime - mStopTime);
@@ -54,8 +51,7 @@ void common::GameTimer::Stop()
 {
 	if (!mStopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		int64_t currTime = static_cast<int64_t>(MonotonicClock::Now());
 		mStopTime = currTime;
 		mStopped = true;
 	}
@@ -68,8 +64,7 @@ void common::GameTimer::Tick()
 		mDeltaTime = 0.0;
 		return;
 	}
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	int64_t currTime = static_cast<int64_t>(MonotonicClock::Now());
 	mCurrTime = currTime;
 	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
 	mPrevTime = currTime;
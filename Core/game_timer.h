@@ -1,6 +1,10 @@
 #pragma once
+#include <cstdint>
 namespace common
 {
+	/// <summary>
+	/// Total and delta time with pause support, on top of MonotonicClock.
+	/// </summary>
 	class GameTimer
 	{
 	public:
@@ -20,11 +24,11 @@ namespace common
 	private:
 		double mSecondsPerCount;
 		double mDeltaTime;
-		__int64 mBaseTime;
-		__int64 mPausedTime;
-		__int64 mStopTime;
-		__int64 mPrevTime;
-		__int64 mCurrTime;
+		int64_t mBaseTime;
+		int64_t mPausedTime;
+		int64_t mStopTime;
+		int64_t mPrevTime;
+		int64_t mCurrTime;
 		bool mStopped;
 	};
 }
\ No newline at end of file
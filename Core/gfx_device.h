@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace common::gfx
+{
+	//Opaque handles. The backend decides what's inside, for d3d12 they are the interface pointers and the
+	//descriptor handle values, for the recording backend just numbers that end up in the command stream.
+	struct ResourceHandle { uint64_t value = 0; };
+	struct PipelineHandle { uint64_t value = 0; };
+	struct RootSignatureHandle { uint64_t value = 0; };
+	struct DescriptorHeapHandle { uint64_t value = 0; };
+	struct CpuDescriptor { uint64_t ptr = 0; };
+	struct GpuDescriptor { uint64_t ptr = 0; };
+
+	/// <summary>
+	/// The resource states the renderer uses, a subset of D3D12_RESOURCE_STATES.
+	/// </summary>
+	enum class ResourceState : uint32_t
+	{
+		Common,
+		RenderTarget,
+		DepthWrite,
+		PixelShaderResource,
+		NonPixelShaderResource,
+		CopySource,
+		CopyDest,
+		GenericRead,
+		Present
+	};
+
+	enum class PrimitiveTopology : uint32_t
+	{
+		TriangleList,
+		TriangleStrip,
+		LineList
+	};
+
+	struct VertexBufferView
+	{
+		uint64_t location = 0;
+		uint32_t sizeInBytes = 0;
+		uint32_t strideInBytes = 0;
+	};
+
+	struct IndexBufferView
+	{
+		uint64_t location = 0;
+		uint32_t sizeInBytes = 0;
+		bool index32 = true;
+	};
+
+	struct Viewport
+	{
+		float x = 0;
+		float y = 0;
+		float width = 0;
+		float height = 0;
+		float minDepth = 0;
+		float maxDepth = 1;
+	};
+
+	struct Rect
+	{
+		int32_t left = 0;
+		int32_t top = 0;
+		int32_t right = 0;
+		int32_t bottom = 0;
+	};
+
+	/// <summary>
+	/// The part of a graphics command list the frame uses. Same names and meaning as ID3D12GraphicsCommandList,
+	/// so the d3d12 implementation is one call per method. A list is created closed, Reset opens it for recording.
+	/// A list is recorded by one thread at a time.
+	/// </summary>
+	class CommandList
+	{
+	public:
+		virtual ~CommandList() = default;
+		/// <summary>
+		/// Drops what was recorded and opens the list. The gpu must be done with the previous recording.
+		/// </summary>
+		virtual void Reset() = 0;
+		virtual void Close() = 0;
+		virtual void ResourceBarrier(ResourceHandle resource, ResourceState before, ResourceState after) = 0;
+		virtual void CopyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset,
+			uint64_t numBytes) = 0;
+		virtual void SetGraphicsRootSignature(RootSignatureHandle rootSignature) = 0;
+		virtual void SetPipelineState(PipelineHandle pipeline) = 0;
+		/// <summary>
+		/// The shader visible heap, the renderer only ever binds one.
+		/// </summary>
+		virtual void SetDescriptorHeap(DescriptorHeapHandle heap) = 0;
+		virtual void SetGraphicsRootDescriptorTable(uint32_t rootParameter, GpuDescriptor baseDescriptor) = 0;
+		virtual void SetGraphicsRoot32BitConstant(uint32_t rootParameter, uint32_t value, uint32_t offset) = 0;
+		virtual void SetPrimitiveTopology(PrimitiveTopology topology) = 0;
+		virtual void SetViewport(const Viewport& viewport) = 0;
+		virtual void SetScissorRect(const Rect& rect) = 0;
+		/// <summary>
+		/// One render target and an optional depth target, a zero dsv means none.
+		/// </summary>
+		virtual void SetRenderTarget(CpuDescriptor rtv, CpuDescriptor dsv) = 0;
+		virtual void ClearRenderTarget(CpuDescriptor rtv, const std::array<float, 4>& color) = 0;
+		virtual void ClearDepth(CpuDescriptor dsv, float depth) = 0;
+		virtual void SetVertexBuffer(const VertexBufferView& view) = 0;
+		virtual void SetIndexBuffer(const IndexBufferView& view) = 0;
+		virtual void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+			uint32_t startInstance) = 0;
+		virtual void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+			int32_t baseVertex, uint32_t startInstance) = 0;
+		virtual void BeginEvent(const wchar_t* name) = 0;
+		virtual void EndEvent() = 0;
+	};
+
+	/// <summary>
+	/// Creates command lists and writes descriptors. There's a d3d12 implementation and a recording one that
+	/// only counts and logs, so the cpu side of a frame can run and be measured without a gpu.
+	/// </summary>
+	class Device
+	{
+	public:
+		virtual ~Device() = default;
+		/// <summary>
+		/// A direct command list with its own allocator, created closed.
+		/// </summary>
+		virtual std::unique_ptr<CommandList> CreateCommandList(const std::wstring& name) = 0;
+		/// <summary>
+		/// Writes the srv of a structured buffer into dst.
+		/// </summary>
+		virtual void CreateStructuredBufferView(CpuDescriptor dst, ResourceHandle buffer, uint32_t numElements,
+			uint32_t stride) = 0;
+	};
+}
@@ -0,0 +1,10 @@
+#pragma once
+namespace transforms
+{
+	/// <summary>
+	/// The keys the samples react to. Captures store them as ints, new keys go at the end.
+	/// </summary>
+	enum KeyCodes {
+		W, A, S, D, Q, E, Esc, None
+	};
+}
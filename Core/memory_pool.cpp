@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "memory_pool.h"
+#include <algorithm>
+#include <stdexcept>
+
+common::MemoryPoolCore::MemoryPoolCore(uint64_t blockSize, uint64_t granularity)
+    :blockSize(blockSize), granularity(granularity)
+{
+    if (granularity == 0 || blockSize < granularity) {
+        throw std::invalid_argument("Memory pool block must hold at least one granule");
+    }
+}
+
+common::PoolAllocation common::MemoryPoolCore::Allocate(uint64_t size)
+{
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b] == nullptr) {
+            continue;
+        }
+        PoolAllocation allocation = AllocateInBlock(b, size);
+        if (allocation.IsValid()) {
+            return allocation;
+        }
+    }
+    return {};
+}
+
+common::PoolAllocation common::MemoryPoolCore::AllocateInBlock(uint32_t block, uint64_t size)
+{
+    if (!HasBlock(block)) {
+        return {};
+    }
+    const uint64_t offset = blocks[block]->Allocate(size);
+    if (offset == TlsfAllocator::INVALID_OFFSET) {
+        return {};
+    }
+    return { block, offset, blocks[block]->AlignedSize(size) };
+}
+
+uint32_t common::MemoryPoolCore::AddBlock(uint64_t minSize)
+{
+    uint64_t size = std::max(blockSize, minSize);
+    size = ((size + granularity - 1) / granularity) * granularity;
+    auto allocator = std::make_unique<TlsfAllocator>(size, granularity);
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b] == nullptr) {
+            blocks[b] = std::move(allocator);
+            return b;
+        }
+    }
+    blocks.push_back(std::move(allocator));
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void common::MemoryPoolCore::Free(const PoolAllocation& allocation)
+{
+    if (!HasBlock(allocation.block)) {
+        throw std::runtime_error("Freeing an allocation from a block that doesn't exist");
+    }
+    blocks[allocation.block]->Free(allocation.offset);
+}
+
+void common::MemoryPoolCore::RemoveBlock(uint32_t block)
+{
+    if (!HasBlock(block) || !blocks[block]->IsEmpty()) {
+        throw std::runtime_error("Only existing empty blocks can be removed");
+    }
+    blocks[block] = nullptr;
+}
+
+std::vector<uint32_t> common::MemoryPoolCore::ReleaseEmptyBlocks(uint32_t keep)
+{
+    std::vector<uint32_t> released;
+    uint32_t kept = 0;
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b] == nullptr || !blocks[b]->IsEmpty()) {
+            continue;
+        }
+        //only blocks with the default size are worth keeping, the big dedicated ones go away
+        if (kept < keep && blocks[b]->GetSize() == blockSize) {
+            kept++;
+            continue;
+        }
+        blocks[b] = nullptr;
+        released.push_back(b);
+    }
+    return released;
+}
+
+common::PoolStats common::MemoryPoolCore::GetStats() const
+{
+    PoolStats stats;
+    float weightedFragmentation = 0.0f;
+    uint64_t freeBytes = 0;
+    for (const auto& block : blocks) {
+        if (block == nullptr) {
+            continue;
+        }
+        stats.blockCount++;
+        stats.reservedBytes += block->GetSize();
+        stats.usedBytes += block->GetUsed();
+        stats.allocationCount += block->GetAllocationCount();
+        const uint64_t blockFree = block->GetSize() - block->GetUsed();
+        weightedFragmentation += block->GetFragmentation() * static_cast<float>(blockFree);
+        freeBytes += blockFree;
+    }
+    if (freeBytes > 0) {
+        stats.fragmentation = weightedFragmentation / static_cast<float>(freeBytes);
+    }
+    return stats;
+}
+
+std::vector<common::DefragmentationMove> common::MemoryPoolCore::PlanDefragmentation(
+    const std::vector<PoolAllocation>& live, uint64_t maxBytes)
+{
+    std::vector<DefragmentationMove> moves;
+    //blocks from the least used to the most used. The least used ones are emptied into the others.
+    std::vector<uint32_t> order;
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b] != nullptr && !blocks[b]->IsEmpty()) {
+            order.push_back(b);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return blocks[a]->GetUsed() < blocks[b]->GetUsed();
+        });
+    //biggest allocations first, they are the hardest to place
+    std::vector<PoolAllocation> candidates = live;
+    std::sort(candidates.begin(), candidates.end(), [](const PoolAllocation& a, const PoolAllocation& b) {
+        return a.size > b.size;
+        });
+    uint64_t movedBytes = 0;
+    for (size_t s = 0; s < order.size() && movedBytes < maxBytes; s++) {
+        const uint32_t source = order[s];
+        for (const PoolAllocation& allocation : candidates) {
+            if (allocation.block != source || movedBytes + allocation.size > maxBytes) {
+                continue;
+            }
+            //only into blocks that are more used than the source, and never back into a drained one
+            for (size_t d = order.size(); d-- > s + 1;) {
+                PoolAllocation to = AllocateInBlock(order[d], allocation.size);
+                if (to.IsValid()) {
+                    moves.push_back({ allocation, to });
+                    movedBytes += allocation.size;
+                    break;
+                }
+            }
+        }
+    }
+    return moves;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tlsf_allocator.h"
+
+namespace common
+{
+	/// <summary>
+	/// Where an allocation lives: the block (one ID3D12Heap on the d3d side) and the offset inside it.
+	/// </summary>
+	struct PoolAllocation
+	{
+		static constexpr uint32_t INVALID_BLOCK = ~0u;
+		uint32_t block = INVALID_BLOCK;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		bool IsValid() const { return block != INVALID_BLOCK; }
+	};
+
+	/// <summary>
+	/// The destination is already reserved when the move is planned. The owner copies the data, starts
+	/// using the destination and then frees the source.
+	/// </summary>
+	struct DefragmentationMove
+	{
+		PoolAllocation from;
+		PoolAllocation to;
+	};
+
+	struct PoolStats
+	{
+		uint64_t reservedBytes = 0;
+		uint64_t usedBytes = 0;
+		uint32_t blockCount = 0;
+		uint64_t allocationCount = 0;
+		/// <summary>
+		/// Average of the blocks' fragmentation weighted by their free space. See TlsfAllocator::GetFragmentation
+		/// </summary>
+		float fragmentation = 0.0f;
+	};
+
+	/// <summary>
+	/// A growable set of TLSF blocks that share the same granularity (the alignment class). It's the
+	/// device independent part of the gpu memory allocator: it decides where things go, the d3d side
+	/// creates the heaps and the placed resources.
+	/// </summary>
+	class MemoryPoolCore
+	{
+	public:
+		MemoryPoolCore(uint64_t blockSize, uint64_t granularity);
+		/// <summary>
+		/// Tries the existing blocks, oldest first. Returns an invalid allocation if none has room,
+		/// then the caller must AddBlock and try again.
+		/// </summary>
+		PoolAllocation Allocate(uint64_t size);
+		/// <summary>
+		/// Allocates in a specific block.
+		/// </summary>
+		PoolAllocation AllocateInBlock(uint32_t block, uint64_t size);
+		/// <summary>
+		/// Adds a block with the default size, or bigger if minSize doesn't fit in it. Returns its id. Ids of
+		/// released blocks are reused.
+		/// </summary>
+		uint32_t AddBlock(uint64_t minSize = 0);
+		void Free(const PoolAllocation& allocation);
+		/// <summary>
+		/// Removes one block, it must be empty. For when the caller couldn't create its heap.
+		/// </summary>
+		void RemoveBlock(uint32_t block);
+		/// <summary>
+		/// Removes the empty blocks, keeping at most keep of them around. Returns the removed ids so the
+		/// caller can release the heaps.
+		/// </summary>
+		std::vector<uint32_t> ReleaseEmptyBlocks(uint32_t keep = 1);
+		bool HasBlock(uint32_t block) const { return block < blocks.size() && blocks[block] != nullptr; }
+		uint64_t GetBlockSize(uint32_t block) const { return blocks[block]->GetSize(); }
+		uint64_t GetGranularity() const { return granularity; }
+		uint64_t GetDefaultBlockSize() const { return blockSize; }
+		PoolStats GetStats() const;
+		/// <summary>
+		/// Plans moves that empty the least used blocks into the most used ones, up to maxBytes. live are the
+		/// allocations that may be moved. The destinations are allocated by this call; the sources are not freed.
+		/// </summary>
+		std::vector<DefragmentationMove> PlanDefragmentation(const std::vector<PoolAllocation>& live, uint64_t maxBytes);
+	private:
+		const uint64_t blockSize;
+		const uint64_t granularity;
+		std::vector<std::unique_ptr<TlsfAllocator>> blocks;
+	};
+}
@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "monotonic_clock.h"
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h> //QueryPerformanceCounter, the fallback when there is no invariant tsc
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COMMON_CLOCK_HAS_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace
+{
+    using common::MonotonicClock;
+
+    uint64_t SteadyClockNow()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+#ifdef COMMON_CLOCK_HAS_TSC
+    /// <summary>
+    /// An invariant TSC runs at a constant rate in every power state and is synchronized between cores,
+    /// cpuid 0x80000007, edx bit 8.
+    /// </summary>
+    bool HasInvariantTsc()
+    {
+#if defined(_MSC_VER)
+        int regs[4] = {};
+        __cpuid(regs, 0x80000000);
+        if (static_cast<unsigned>(regs[0]) < 0x80000007u) {
+            return false;
+        }
+        __cpuid(regs, 0x80000007);
+        return (regs[3] & (1 << 8)) != 0;
+#else
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u) {
+            return false;
+        }
+        __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+#endif
+    }
+#endif
+
+    struct Calibration
+    {
+        MonotonicClock::Source source = MonotonicClock::Source::SteadyClock;
+        double secondsPerTick = 1.0e-9;
+    };
+
+    Calibration Calibrate()
+    {
+        Calibration calibration;
+#ifdef COMMON_CLOCK_HAS_TSC
+        if (HasInvariantTsc()) {
+            //count the ticks over a few milliseconds of the os clock; the error is around ten parts in a million
+            const auto osStart = std::chrono::steady_clock::now();
+            const uint64_t tscStart = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const auto osEnd = std::chrono::steady_clock::now();
+            const uint64_t tscEnd = __rdtsc();
+            const double seconds = std::chrono::duration<double>(osEnd - osStart).count();
+            if (tscEnd > tscStart && seconds > 0) {
+                calibration.source = MonotonicClock::Source::Tsc;
+                calibration.secondsPerTick = seconds / static_cast<double>(tscEnd - tscStart);
+                return calibration;
+            }
+        }
+#endif
+#ifdef _WIN32
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        calibration.source = MonotonicClock::Source::QueryPerformanceCounter;
+        calibration.secondsPerTick = 1.0 / static_cast<double>(frequency.QuadPart);
+#endif
+        return calibration;
+    }
+
+    const Calibration& GetCalibration()
+    {
+        static const Calibration calibration = Calibrate();
+        return calibration;
+    }
+}
+
+uint64_t common::MonotonicClock::Now()
+{
+    switch (GetCalibration().source) {
+#ifdef COMMON_CLOCK_HAS_TSC
+    case Source::Tsc:
+        return __rdtsc();
+#endif
+#ifdef _WIN32
+    case Source::QueryPerformanceCounter:
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return static_cast<uint64_t>(counter.QuadPart);
+    }
+#endif
+    default:
+        return SteadyClockNow();
+    }
+}
+
+double common::MonotonicClock::SecondsPerTick()
+{
+    return GetCalibration().secondsPerTick;
+}
+
+double common::MonotonicClock::TicksPerSecond()
+{
+    return 1.0 / GetCalibration().secondsPerTick;
+}
+
+common::MonotonicClock::Source common::MonotonicClock::GetSource()
+{
+    return GetCalibration().source;
+}
+
+const char* common::MonotonicClock::GetSourceName()
+{
+    switch (GetSource()) {
+    case Source::Tsc:
+        return "tsc";
+    case Source::QueryPerformanceCounter:
+        return "QueryPerformanceCounter";
+    default:
+        return "steady_clock";
+    }
+}
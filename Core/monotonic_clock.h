@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+namespace common
+{
+	/// <summary>
+	/// The clock under the timers and the profiler. Ticks only go forward and are comparable between threads.
+	/// On x86 cpus with an invariant TSC it reads the TSC, calibrated against the os clock the first time
+	/// the clock is used. Otherwise it falls back to QueryPerformanceCounter on Windows and to
+	/// std::chrono::steady_clock everywhere else.
+	/// </summary>
+	class MonotonicClock
+	{
+	public:
+		enum class Source { Tsc, QueryPerformanceCounter, SteadyClock };
+		/// <summary>
+		/// The current time in ticks, from an arbitrary origin.
+		/// </summary>
+		static uint64_t Now();
+		static double SecondsPerTick();
+		static double TicksPerSecond();
+		static double ToSeconds(uint64_t ticks) { return ticks * SecondsPerTick(); }
+		static double ToMilliseconds(uint64_t ticks) { return ticks * SecondsPerTick() * 1.0e3; }
+		static uint64_t ToNanoseconds(uint64_t ticks) { return static_cast<uint64_t>(ticks * SecondsPerTick() * 1.0e9); }
+		static Source GetSource();
+		static const char* GetSourceName();
+	};
+}
@@ -0,0 +1,31 @@
+#include "pch.h"
+#include "parallel_command_recorder.h"
+
+common::ParallelCommandRecorder::ParallelCommandRecorder(gfx::Device& device, WorkerPool& workers,
+    uint32_t frameCount)
+    :device(device), workers(workers), lists(frameCount)
+{
+}
+
+std::vector<common::gfx::CommandList*> common::ParallelCommandRecorder::Record(uint32_t frameIndex,
+    const RecordingPlan& plan, const RecordFn& record)
+{
+    const std::vector<RecordingSegment>& segments = plan.GetSegments();
+    std::vector<std::unique_ptr<gfx::CommandList>>& frameLists = lists[frameIndex];
+    //grow the pool before going wide, creating lists isn't something to do from the workers
+    while (frameLists.size() < segments.size()) {
+        std::wstring name = L"RecordingList_frame" + std::to_wstring(frameIndex) + L"_" + std::to_wstring(frameLists.size());
+        frameLists.push_back(device.CreateCommandList(name));
+    }
+    workers.ParallelFor(static_cast<uint32_t>(segments.size()), [&segments, &frameLists, &record](uint32_t i) {
+        gfx::CommandList& list = *frameLists[i];
+        list.Reset();
+        record(segments[i], list);
+        list.Close();
+        });
+    std::vector<gfx::CommandList*> ordered(segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        ordered[i] = frameLists[i].get();
+    }
+    return ordered;
+}
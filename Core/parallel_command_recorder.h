@@ -0,0 +1,38 @@
+#pragma once
+#include <functional>
+#include <string>
+#include "frame_ring.h"
+#include "gfx_device.h"
+#include "recording_plan.h"
+#include "worker_pool.h"
+
+namespace common
+{
+	/// <summary>
+	/// Records the segments of a RecordingPlan on the worker pool, each segment in its own command list.
+	/// The lists come from a per frame pool that grows to the largest plan seen, so after the first frames
+	/// nothing is created anymore. It only sees the gfx interface, with the recording device it runs without a gpu.
+	/// </summary>
+	class ParallelCommandRecorder
+	{
+	public:
+		/// <summary>
+		/// Records the commands of a segment into list. Called from the workers, concurrently with other
+		/// segments, so it must only read shared state. The list is open and empty: every segment has to
+		/// set its own root signature, heaps, pipeline and targets.
+		/// </summary>
+		using RecordFn = std::function<void(const RecordingSegment&, gfx::CommandList&)>;
+		ParallelCommandRecorder(gfx::Device& device, WorkerPool& workers, uint32_t frameCount);
+		/// <summary>
+		/// Records every segment of the plan and returns the closed lists in submission order. The gpu must be
+		/// done with the previous use of frameIndex.
+		/// </summary>
+		std::vector<gfx::CommandList*> Record(uint32_t frameIndex, const RecordingPlan& plan, const RecordFn& record);
+		size_t GetListCount(uint32_t frameIndex) const { return lists[frameIndex].size(); }
+		WorkerPool& GetWorkers() { return workers; }
+	private:
+		gfx::Device& device;
+		WorkerPool& workers;
+		FrameRing<std::vector<std::unique_ptr<gfx::CommandList>>> lists;
+	};
+}
@@ -0,0 +1,26 @@
+// pch.h: This is a precompiled header file.
+// Core is the part of the code that doesn't know about Windows nor D3D12: math, components, systems,
+// loaders, allocators and timers. Nothing in here may include windows.h, d3d12.h or d3dx12.h, so that
+// it builds with gcc and clang too (DirectXMath is header only and portable, outside Windows it needs
+// a sal.h, the vcpkg port installs one; see CMakeLists.txt). The Win32/D3D12 code lives in Common, on top of it.
+
+#ifndef CORE_PCH_H
+#define CORE_PCH_H
+
+#include <DirectXMath.h>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <optional>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <random>
+
+#endif //CORE_PCH_H
@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <DirectXMath.h>
+#include <entt/entt.hpp>
+#include "per_object_data.h"
+#include "components.h"
+#include "cpu_profiler.h"
+namespace transforms {
+    /// <summary>
+    /// What the bsdf shaders read about an object, from its transform and material.
+    /// </summary>
+    inline PerObjectData PackPerObjectData(const components::Transform& transform, const components::BSDFMaterial& mat) {
+        //TODO PBR: transfer PBR data
+        PerObjectData pod{};
+        pod.modelMatrix = DirectX::XMMatrixTranspose(transform.worldMatrix);
+        pod.inverseTransposeModelMat = DirectX::XMMatrixInverse(nullptr, transform.worldMatrix);
+
+        pod.baseColor = DirectX::XMLoadFloat4(&mat.baseColor);
+        pod.metallicFactor = mat.metallicFactor;
+        pod.roughnessFactor = mat.roughnessFactor;
+        pod.opacity = mat.opacity;
+        pod.refracti = mat.refracti;
+        pod.emissiveColor = DirectX::XMVectorSet(mat.emissiveColor.x, mat.emissiveColor.y, mat.emissiveColor.z, 1);
+        return pod;
+    }
+    /// <summary>
+    /// Writes the per-object data of every renderable at its uniformBufferId. The buffer is anything with
+    /// SetValue(frameIndex, id, PerObjectData), the benchmarks use one in plain memory.
+    /// </summary>
+    template<typename View, typename UniformBuffer>
+    void PerObjectDataUploadSystem(View&& view, UniformBuffer* perObjectUniformBuffer, uint32_t frameIndex) {
+        PROFILE_SCOPE("PerObjectDataUpload");
+        view.each([perObjectUniformBuffer, frameIndex](entt::entity entity,
+            const components::Renderable& renderable,
+            const components::Transform& transform,
+            const std::shared_ptr<components::BSDFMaterial> mat) {
+                perObjectUniformBuffer->SetValue(frameIndex, renderable.uniformBufferId, PackPerObjectData(transform, *mat));
+            });
+    }
+}
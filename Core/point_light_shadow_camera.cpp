@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "point_light_shadow_camera.h"
+
+transforms::PointLightShadowCamera::PointLightShadowCamera(float farPlane)
+    :m_farPlane(farPlane)
+{
+    UpdateLightPosition(DirectX::XMFLOAT3(0, 0, 0));
+    m_projectionMatrix = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, 1.0f, 0.1f, m_farPlane);
+}
+
+void transforms::PointLightShadowCamera::UpdateLightPosition(const DirectX::XMFLOAT3& lightPos)
+{
+    using namespace DirectX;
+
+    XMVECTOR eyePos = XMLoadFloat3(&lightPos);
+
+    // Cube face directions and up vectors
+    struct CubeFace
+    {
+        XMVECTOR target;
+        XMVECTOR up;
+    };
+
+    std::array<CubeFace, FACE_COUNT> faces = { {
+        { XMVectorSet(1, 0, 0, 0),  XMVectorSet(0, 1, 0, 0) },  // +X
+        { XMVectorSet(-1, 0, 0, 0), XMVectorSet(0, 1, 0, 0) },  // -X
+        { XMVectorSet(0, 1, 0, 0),  XMVectorSet(0, 0, -1, 0) }, // +Y
+        { XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0) },  // -Y
+        { XMVectorSet(0, 0, 1, 0),  XMVectorSet(0, 1, 0, 0) },  // +Z
+        { XMVectorSet(0, 0, -1, 0), XMVectorSet(0, 1, 0, 0) }   // -Z
+    } };
+
+    for (uint32_t i = 0; i < FACE_COUNT; ++i)
+    {
+        XMVECTOR target = XMVectorAdd(eyePos, faces[i].target);
+        m_viewMatrices[i] = XMMatrixLookAtLH(eyePos, target, faces[i].up);
+    }
+}
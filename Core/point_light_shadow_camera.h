@@ -0,0 +1,51 @@
+#pragma once
+#include <DirectXMath.h>
+#include <array>
+#include <cstdint>
+
+//point lights, and so cube shadow maps, that the bsdf shaders take; bsdf_ps.hlsl has the same number
+constexpr int MAX_LIGHTS = 16;
+//side of the cube shadow map faces, in texels
+constexpr int SHADOW_MAP_SIZE = 2048;
+
+namespace transforms
+{
+	/// <summary>
+	/// Structure that matches the HLSL cbuffer ShadowMapConstants
+	/// </summary>
+	struct alignas(16) ShadowMapConstants
+	{
+		DirectX::XMFLOAT4X4 viewMatrix;
+		DirectX::XMFLOAT4X4 projMatrix;
+		DirectX::XMFLOAT3 lightPosition;
+		float farPlane;
+	};
+
+	/// <summary>
+	/// The cameras of the 6 faces of a point light's cube shadow map: 90 degree fov, square, looking down
+	/// the axes from the light. Only the math, CubeMapShadowMap adds the textures to it.
+	/// </summary>
+	class PointLightShadowCamera
+	{
+	public:
+		static constexpr uint32_t FACE_COUNT = 6;
+		PointLightShadowCamera(float farPlane = 500.0f);
+		float GetFarPlane()const { return m_farPlane; }
+		/// <summary>
+		/// The view matrix of a face in +X, -X, +Y, -Y, +Z, -Z order, identity past the last one.
+		/// </summary>
+		DirectX::XMMATRIX GetViewMatrix(uint32_t faceIndex) const
+		{
+			return (faceIndex < FACE_COUNT) ? m_viewMatrices[faceIndex] : DirectX::XMMatrixIdentity();
+		}
+		DirectX::XMMATRIX GetProjectionMatrix() const { return m_projectionMatrix; }
+		/// <summary>
+		/// Moves the cameras to the light, recalculating the view matrices.
+		/// </summary>
+		void UpdateLightPosition(const DirectX::XMFLOAT3& lightPos);
+	private:
+		float m_farPlane;
+		std::array<DirectX::XMMATRIX, FACE_COUNT> m_viewMatrices;
+		DirectX::XMMATRIX m_projectionMatrix;
+	};
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include "gfx_device.h"
+#include "components.h"
+#include "point_light_shadow_camera.h"
+namespace transforms {
+    /// <summary>
+    /// The commands of the point shadow faces that only need the gfx interface, shared by the gpu passes and
+    /// the headless replay, which records them on the recording device.
+    /// </summary>
+    namespace _PointShadowCalculationSystem {
+        inline void BeginCubeMapEvent(uint32_t i,
+            common::gfx::CommandList& commandList)
+        {
+            static const wchar_t* faceNames[] = { L"+X", L"-X", L"+Y", L"-Y", L"+Z", L"-Z" };
+            assert(i < 6);
+            commandList.BeginEvent(faceNames[i]);
+        }
+
+        inline void SetViewport(common::gfx::CommandList& commandList) {
+            common::gfx::Viewport viewport;
+            viewport.width = static_cast<float>(SHADOW_MAP_SIZE);
+            viewport.height = static_cast<float>(SHADOW_MAP_SIZE);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            commandList.SetViewport(viewport);
+            common::gfx::Rect scissorRect;
+            scissorRect.right = SHADOW_MAP_SIZE;
+            scissorRect.bottom = SHADOW_MAP_SIZE;
+            commandList.SetScissorRect(scissorRect);
+        }
+
+        inline void DrawForShadow(const transforms::components::Renderable& renderable,
+            common::gfx::CommandList& commandList, uint32_t shadowDataId) {
+            commandList.SetVertexBuffer(renderable.mVertexBufferView);
+            commandList.SetIndexBuffer(renderable.mIndexBufferView);
+            commandList.SetGraphicsRoot32BitConstant(0, renderable.uniformBufferId, 0);
+            commandList.SetGraphicsRoot32BitConstant(1, shadowDataId, 0);
+            commandList.DrawIndexedInstanced(renderable.mNumberOfIndices, 1, 0, 0, 0);
+        }
+    }
+}
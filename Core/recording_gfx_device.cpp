@@ -0,0 +1,315 @@
+#include "pch.h"
+#include "recording_gfx_device.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    /// <summary>
+    /// How to print the arguments of an op: how many there are and which ones are floats or signed.
+    /// </summary>
+    struct OpFormat
+    {
+        const char* name;
+        uint32_t argCount;
+        uint32_t floatMask;
+        uint32_t signedMask;
+    };
+    //in the order of CommandOp
+    const OpFormat opFormats[] = {
+        { "ResourceBarrier", 3, 0, 0 },
+        { "CopyBufferRegion", 5, 0, 0 },
+        { "SetGraphicsRootSignature", 1, 0, 0 },
+        { "SetPipelineState", 1, 0, 0 },
+        { "SetDescriptorHeap", 1, 0, 0 },
+        { "SetGraphicsRootDescriptorTable", 2, 0, 0 },
+        { "SetGraphicsRoot32BitConstant", 3, 0, 0 },
+        { "SetPrimitiveTopology", 1, 0, 0 },
+        { "SetViewport", 6, 0b111111, 0 },
+        { "SetScissorRect", 4, 0, 0b1111 },
+        { "SetRenderTarget", 2, 0, 0 },
+        { "ClearRenderTarget", 5, 0b11110, 0 },
+        { "ClearDepth", 2, 0b10, 0 },
+        { "SetVertexBuffer", 3, 0, 0 },
+        { "SetIndexBuffer", 3, 0, 0 },
+        { "DrawInstanced", 4, 0, 0 },
+        { "DrawIndexedInstanced", 5, 0, 0b1000 },
+        { "BeginEvent", 1, 0, 0 },
+        { "EndEvent", 0, 0, 0 },
+    };
+    static_assert(sizeof(opFormats) / sizeof(opFormats[0]) == static_cast<size_t>(common::gfx::CommandOp::EndEvent) + 1,
+        "one format per op");
+
+    uint64_t FloatBits(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+    float BitsToFloat(uint64_t v)
+    {
+        uint32_t bits = static_cast<uint32_t>(v);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+    uint64_t Signed(int64_t v)
+    {
+        return static_cast<uint64_t>(v);
+    }
+    //event names are ascii, anything else is printed as ?
+    std::string Narrow(const std::wstring& s)
+    {
+        std::string result;
+        result.reserve(s.size());
+        for (wchar_t c : s) {
+            result.push_back(c > 0 && c < 128 ? static_cast<char>(c) : '?');
+        }
+        return result;
+    }
+}
+
+const char* common::gfx::GetCommandOpName(CommandOp op)
+{
+    return opFormats[static_cast<size_t>(op)].name;
+}
+
+common::gfx::RecordingStats& common::gfx::RecordingStats::operator+=(const RecordingStats& other)
+{
+    commands += other.commands;
+    draws += other.draws;
+    vertices += other.vertices;
+    barriers += other.barriers;
+    copies += other.copies;
+    bytesCopied += other.bytesCopied;
+    stateChanges += other.stateChanges;
+    renderTargetChanges += other.renderTargetChanges;
+    clears += other.clears;
+    return *this;
+}
+
+common::gfx::RecordingCommandList::RecordingCommandList(const std::wstring& name)
+    :name(name)
+{
+}
+
+void common::gfx::RecordingCommandList::Serialize(std::ostream& out) const
+{
+    const std::streamsize oldPrecision = out.precision(std::numeric_limits<float>::max_digits10);
+    for (const RecordedCommand& command : commands) {
+        const OpFormat& format = opFormats[static_cast<size_t>(command.op)];
+        out << format.name;
+        if (command.op == CommandOp::BeginEvent) {
+            out << " \"" << Narrow(eventNames[command.args[0]]) << "\"";
+        }
+        else {
+            for (uint32_t i = 0; i < format.argCount; i++) {
+                out << ' ';
+                if (format.floatMask & (1u << i)) {
+                    out << BitsToFloat(command.args[i]);
+                }
+                else if (format.signedMask & (1u << i)) {
+                    out << static_cast<int64_t>(command.args[i]);
+                }
+                else {
+                    out << command.args[i];
+                }
+            }
+        }
+        out << '\n';
+    }
+    out.precision(oldPrecision);
+}
+
+void common::gfx::RecordingCommandList::Push(CommandOp op, std::initializer_list<uint64_t> args)
+{
+    assert(!closed && "recording into a closed list");
+    assert(args.size() == opFormats[static_cast<size_t>(op)].argCount);
+    RecordedCommand command;
+    command.op = op;
+    std::copy(args.begin(), args.end(), command.args.begin());
+    commands.push_back(command);
+    stats.commands++;
+}
+
+void common::gfx::RecordingCommandList::Reset()
+{
+    //like an allocator reset, the memory stays for the next recording
+    commands.clear();
+    eventNames.clear();
+    stats = RecordingStats();
+    closed = false;
+}
+
+void common::gfx::RecordingCommandList::Close()
+{
+    assert(!closed);
+    closed = true;
+}
+
+void common::gfx::RecordingCommandList::ResourceBarrier(ResourceHandle resource, ResourceState before, ResourceState after)
+{
+    Push(CommandOp::ResourceBarrier, { resource.value, static_cast<uint64_t>(before), static_cast<uint64_t>(after) });
+    stats.barriers++;
+}
+
+void common::gfx::RecordingCommandList::CopyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src,
+    uint64_t srcOffset, uint64_t numBytes)
+{
+    Push(CommandOp::CopyBufferRegion, { dst.value, dstOffset, src.value, srcOffset, numBytes });
+    stats.copies++;
+    stats.bytesCopied += numBytes;
+}
+
+void common::gfx::RecordingCommandList::SetGraphicsRootSignature(RootSignatureHandle rootSignature)
+{
+    Push(CommandOp::SetGraphicsRootSignature, { rootSignature.value });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetPipelineState(PipelineHandle pipeline)
+{
+    Push(CommandOp::SetPipelineState, { pipeline.value });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetDescriptorHeap(DescriptorHeapHandle heap)
+{
+    Push(CommandOp::SetDescriptorHeap, { heap.value });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetGraphicsRootDescriptorTable(uint32_t rootParameter, GpuDescriptor baseDescriptor)
+{
+    Push(CommandOp::SetGraphicsRootDescriptorTable, { rootParameter, baseDescriptor.ptr });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetGraphicsRoot32BitConstant(uint32_t rootParameter, uint32_t value, uint32_t offset)
+{
+    Push(CommandOp::SetGraphicsRoot32BitConstant, { rootParameter, value, offset });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+    Push(CommandOp::SetPrimitiveTopology, { static_cast<uint64_t>(topology) });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetViewport(const Viewport& viewport)
+{
+    Push(CommandOp::SetViewport, { FloatBits(viewport.x), FloatBits(viewport.y), FloatBits(viewport.width),
+        FloatBits(viewport.height), FloatBits(viewport.minDepth), FloatBits(viewport.maxDepth) });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetScissorRect(const Rect& rect)
+{
+    Push(CommandOp::SetScissorRect, { Signed(rect.left), Signed(rect.top), Signed(rect.right), Signed(rect.bottom) });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetRenderTarget(CpuDescriptor rtv, CpuDescriptor dsv)
+{
+    Push(CommandOp::SetRenderTarget, { rtv.ptr, dsv.ptr });
+    stats.renderTargetChanges++;
+}
+
+void common::gfx::RecordingCommandList::ClearRenderTarget(CpuDescriptor rtv, const std::array<float, 4>& color)
+{
+    Push(CommandOp::ClearRenderTarget, { rtv.ptr, FloatBits(color[0]), FloatBits(color[1]), FloatBits(color[2]),
+        FloatBits(color[3]) });
+    stats.clears++;
+}
+
+void common::gfx::RecordingCommandList::ClearDepth(CpuDescriptor dsv, float depth)
+{
+    Push(CommandOp::ClearDepth, { dsv.ptr, FloatBits(depth) });
+    stats.clears++;
+}
+
+void common::gfx::RecordingCommandList::SetVertexBuffer(const VertexBufferView& view)
+{
+    Push(CommandOp::SetVertexBuffer, { view.location, view.sizeInBytes, view.strideInBytes });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::SetIndexBuffer(const IndexBufferView& view)
+{
+    Push(CommandOp::SetIndexBuffer, { view.location, view.sizeInBytes, view.index32 ? 1u : 0u });
+    stats.stateChanges++;
+}
+
+void common::gfx::RecordingCommandList::DrawInstanced(uint32_t vertexCount, uint32_t instanceCount,
+    uint32_t startVertex, uint32_t startInstance)
+{
+    Push(CommandOp::DrawInstanced, { vertexCount, instanceCount, startVertex, startInstance });
+    stats.draws++;
+    stats.vertices += static_cast<uint64_t>(vertexCount) * instanceCount;
+}
+
+void common::gfx::RecordingCommandList::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount,
+    uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    Push(CommandOp::DrawIndexedInstanced, { indexCount, instanceCount, startIndex, Signed(baseVertex), startInstance });
+    stats.draws++;
+    stats.vertices += static_cast<uint64_t>(indexCount) * instanceCount;
+}
+
+void common::gfx::RecordingCommandList::BeginEvent(const wchar_t* name)
+{
+    Push(CommandOp::BeginEvent, { eventNames.size() });
+    eventNames.emplace_back(name);
+}
+
+void common::gfx::RecordingCommandList::EndEvent()
+{
+    Push(CommandOp::EndEvent, {});
+}
+
+std::unique_ptr<common::gfx::CommandList> common::gfx::RecordingDevice::CreateCommandList(const std::wstring& name)
+{
+    createdLists++;
+    return std::make_unique<RecordingCommandList>(name);
+}
+
+void common::gfx::RecordingDevice::CreateStructuredBufferView(CpuDescriptor dst, ResourceHandle buffer,
+    uint32_t numElements, uint32_t stride)
+{
+    //the d3d12 device would write through dst, a null one is a bug even without a gpu
+    assert(dst.ptr != 0);
+    std::lock_guard<std::mutex> lock(descriptorWritesMutex);
+    descriptorWrites.push_back({ dst, buffer, numElements, stride });
+}
+
+uint64_t common::gfx::RecordingDevice::GetDescriptorWrites() const
+{
+    std::lock_guard<std::mutex> lock(descriptorWritesMutex);
+    return descriptorWrites.size();
+}
+
+std::vector<common::gfx::RecordedDescriptorWrite> common::gfx::RecordingDevice::GetDescriptorWriteLog() const
+{
+    std::lock_guard<std::mutex> lock(descriptorWritesMutex);
+    return descriptorWrites;
+}
+
+common::gfx::RecordingStats common::gfx::SumRecordingStats(const std::vector<CommandList*>& lists)
+{
+    RecordingStats total;
+    for (CommandList* list : lists) {
+        total += static_cast<RecordingCommandList*>(list)->GetStats();
+    }
+    return total;
+}
+
+void common::gfx::SerializeCommandStream(std::ostream& out, const std::vector<CommandList*>& lists)
+{
+    for (CommandList* list : lists) {
+        const RecordingCommandList* recording = static_cast<RecordingCommandList*>(list);
+        out << "list \"" << Narrow(recording->GetName()) << "\"\n";
+        recording->Serialize(out);
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "gfx_device.h"
+
+namespace common::gfx
+{
+	enum class CommandOp : uint32_t
+	{
+		ResourceBarrier,
+		CopyBufferRegion,
+		SetGraphicsRootSignature,
+		SetPipelineState,
+		SetDescriptorHeap,
+		SetGraphicsRootDescriptorTable,
+		SetGraphicsRoot32BitConstant,
+		SetPrimitiveTopology,
+		SetViewport,
+		SetScissorRect,
+		SetRenderTarget,
+		ClearRenderTarget,
+		ClearDepth,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		DrawInstanced,
+		DrawIndexedInstanced,
+		BeginEvent,
+		EndEvent
+	};
+	const char* GetCommandOpName(CommandOp op);
+
+	/// <summary>
+	/// A command as the recording backend keeps it: the op and its arguments in call order. Floats are stored
+	/// by their bits, event names as an index in the list's name table.
+	/// </summary>
+	struct RecordedCommand
+	{
+		CommandOp op = CommandOp::EndEvent;
+		std::array<uint64_t, 6> args{};
+	};
+
+	/// <summary>
+	/// What a recording did. stateChanges are the bindings (root signature, pipeline, heap, tables, constants,
+	/// buffers, viewport), vertices are the vertices or indices processed counting every instance.
+	/// </summary>
+	struct RecordingStats
+	{
+		uint64_t commands = 0;
+		uint64_t draws = 0;
+		uint64_t vertices = 0;
+		uint64_t barriers = 0;
+		uint64_t copies = 0;
+		uint64_t bytesCopied = 0;
+		uint64_t stateChanges = 0;
+		uint64_t renderTargetChanges = 0;
+		uint64_t clears = 0;
+		RecordingStats& operator+=(const RecordingStats& other);
+	};
+
+	/// <summary>
+	/// A command list that doesn't talk to a gpu, it keeps the commands and counts them. Recording into it costs
+	/// about as much as the bookkeeping of a real list, without the driver.
+	/// </summary>
+	class RecordingCommandList : public CommandList
+	{
+	public:
+		explicit RecordingCommandList(const std::wstring& name);
+		const std::wstring& GetName() const { return name; }
+		const std::vector<RecordedCommand>& GetCommands() const { return commands; }
+		const RecordingStats& GetStats() const { return stats; }
+		bool IsClosed() const { return closed; }
+		/// <summary>
+		/// Writes the commands as text, one per line with its arguments. The output only depends on the calls,
+		/// so two recordings of the same frame can be compared line by line.
+		/// </summary>
+		void Serialize(std::ostream& out) const;
+
+		void Reset() override;
+		void Close() override;
+		void ResourceBarrier(ResourceHandle resource, ResourceState before, ResourceState after) override;
+		void CopyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset,
+			uint64_t numBytes) override;
+		void SetGraphicsRootSignature(RootSignatureHandle rootSignature) override;
+		void SetPipelineState(PipelineHandle pipeline) override;
+		void SetDescriptorHeap(DescriptorHeapHandle heap) override;
+		void SetGraphicsRootDescriptorTable(uint32_t rootParameter, GpuDescriptor baseDescriptor) override;
+		void SetGraphicsRoot32BitConstant(uint32_t rootParameter, uint32_t value, uint32_t offset) override;
+		void SetPrimitiveTopology(PrimitiveTopology topology) override;
+		void SetViewport(const Viewport& viewport) override;
+		void SetScissorRect(const Rect& rect) override;
+		void SetRenderTarget(CpuDescriptor rtv, CpuDescriptor dsv) override;
+		void ClearRenderTarget(CpuDescriptor rtv, const std::array<float, 4>& color) override;
+		void ClearDepth(CpuDescriptor dsv, float depth) override;
+		void SetVertexBuffer(const VertexBufferView& view) override;
+		void SetIndexBuffer(const IndexBufferView& view) override;
+		void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+			uint32_t startInstance) override;
+		void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+			int32_t baseVertex, uint32_t startInstance) override;
+		void BeginEvent(const wchar_t* name) override;
+		void EndEvent() override;
+	private:
+		void Push(CommandOp op, std::initializer_list<uint64_t> args);
+		std::wstring name;
+		std::vector<RecordedCommand> commands;
+		std::vector<std::wstring> eventNames;
+		RecordingStats stats;
+		bool closed = true;
+	};
+
+	/// <summary>
+	/// A descriptor the recording device wrote, with the arguments of the call.
+	/// </summary>
+	struct RecordedDescriptorWrite
+	{
+		CpuDescriptor dst;
+		ResourceHandle buffer;
+		uint32_t numElements = 0;
+		uint32_t stride = 0;
+	};
+
+	/// <summary>
+	/// The device of the recording backend. Lists may be created and recorded from any thread.
+	/// </summary>
+	class RecordingDevice : public Device
+	{
+	public:
+		std::unique_ptr<CommandList> CreateCommandList(const std::wstring& name) override;
+		void CreateStructuredBufferView(CpuDescriptor dst, ResourceHandle buffer, uint32_t numElements,
+			uint32_t stride) override;
+		uint64_t GetDescriptorWrites() const;
+		/// <summary>
+		/// The views written so far, in call order.
+		/// </summary>
+		std::vector<RecordedDescriptorWrite> GetDescriptorWriteLog() const;
+		uint64_t GetCreatedListCount() const { return createdLists.load(); }
+	private:
+		mutable std::mutex descriptorWritesMutex;
+		std::vector<RecordedDescriptorWrite> descriptorWrites;
+		std::atomic<uint64_t> createdLists{ 0 };
+	};
+
+	/// <summary>
+	/// Sums the stats of lists created by a RecordingDevice.
+	/// </summary>
+	RecordingStats SumRecordingStats(const std::vector<CommandList*>& lists);
+	/// <summary>
+	/// Serializes lists created by a RecordingDevice in submission order, each one headed by its name.
+	/// </summary>
+	void SerializeCommandStream(std::ostream& out, const std::vector<CommandList*>& lists);
+}
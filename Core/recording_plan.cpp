@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "recording_plan.h"
+#include <algorithm>
+
+uint32_t common::RecordingPlan::AddSerialPass()
+{
+    segments.push_back({ passCount, 0, 1 });
+    return passCount++;
+}
+
+uint32_t common::RecordingPlan::AddParallelPass(const std::vector<uint64_t>& itemCosts, uint32_t maxSegments,
+    uint64_t minSegmentCost)
+{
+    for (const RecordingSegment& segment : Partition(passCount, itemCosts, maxSegments, minSegmentCost)) {
+        segments.push_back(segment);
+    }
+    return passCount++;
+}
+
+void common::RecordingPlan::Clear()
+{
+    segments.clear();
+    passCount = 0;
+}
+
+std::vector<common::RecordingSegment> common::RecordingPlan::Partition(uint32_t pass,
+    const std::vector<uint64_t>& itemCosts, uint32_t maxSegments, uint64_t minSegmentCost)
+{
+    std::vector<RecordingSegment> result;
+    const uint32_t itemCount = static_cast<uint32_t>(itemCosts.size());
+    if (itemCount == 0) {
+        return result;
+    }
+    //items without cost still cost something to record
+    std::vector<uint64_t> prefix(itemCount + 1, 0);
+    for (uint32_t i = 0; i < itemCount; i++) {
+        prefix[i + 1] = prefix[i] + std::max<uint64_t>(itemCosts[i], 1);
+    }
+    const uint64_t total = prefix[itemCount];
+    uint64_t segmentCount = std::min<uint64_t>(std::max(maxSegments, 1u), itemCount);
+    if (minSegmentCost > 0) {
+        segmentCount = std::max<uint64_t>(1, std::min<uint64_t>(segmentCount, total / minSegmentCost));
+    }
+    //segment k ends at the first item whose prefix reaches (k + 1) / segmentCount of the total. An
+    //item that's bigger than a share takes several boundaries, then there are fewer segments.
+    uint32_t first = 0;
+    for (uint64_t k = 0; k < segmentCount && first < itemCount; k++) {
+        const uint64_t boundary = (total * (k + 1) + segmentCount - 1) / segmentCount;
+        uint32_t end = first + 1;
+        while (end < itemCount && prefix[end] < boundary) {
+            end++;
+        }
+        if (k + 1 == segmentCount) {
+            end = itemCount;
+        }
+        result.push_back({ pass, first, end - first });
+        first = end;
+    }
+    if (minSegmentCost == 0) {
+        return result;
+    }
+    //the segments after an item bigger than its share can fall under the minimum: each one that's short takes
+    //the next ones until it's worth a list, and a short one at the end goes to the previous segment
+    auto cost = [&prefix](const RecordingSegment& segment) {
+        return prefix[segment.firstItem + segment.itemCount] - prefix[segment.firstItem];
+    };
+    std::vector<RecordingSegment> merged;
+    for (const RecordingSegment& segment : result) {
+        if (!merged.empty() && cost(merged.back()) < minSegmentCost) {
+            merged.back().itemCount += segment.itemCount;
+        }
+        else {
+            merged.push_back(segment);
+        }
+    }
+    if (merged.size() > 1 && cost(merged.back()) < minSegmentCost) {
+        merged[merged.size() - 2].itemCount += merged.back().itemCount;
+        merged.pop_back();
+    }
+    return merged;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// A contiguous range of the items of a pass, recorded into one command list.
+	/// </summary>
+	struct RecordingSegment
+	{
+		uint32_t pass = 0;
+		uint32_t firstItem = 0;
+		uint32_t itemCount = 0;
+	};
+
+	/// <summary>
+	/// Splits the work of a frame in segments that can be recorded at the same time, each in its own command
+	/// list. Passes are added in the order the gpu has to run them and the segments come out in that order,
+	/// so submitting the lists in segment order respects every dependency between passes. Inside a parallel
+	/// pass the items are independent (cube faces, slices of a draw list) and the segments keep their order too.
+	/// It knows nothing about d3d, the recorder turns the segments into command lists.
+	/// </summary>
+	class RecordingPlan
+	{
+	public:
+		/// <summary>
+		/// A pass that goes in a single segment with one item, like barriers and clears. Returns the pass id.
+		/// </summary>
+		uint32_t AddSerialPass();
+		/// <summary>
+		/// A pass whose items may be recorded in parallel. itemCosts is the recording cost of each item (draw
+		/// calls, for example). It's split in at most maxSegments contiguous segments of about the same cost,
+		/// and none cheaper than minSegmentCost unless the whole pass is. Returns the pass id.
+		/// </summary>
+		uint32_t AddParallelPass(const std::vector<uint64_t>& itemCosts, uint32_t maxSegments, uint64_t minSegmentCost = 0);
+		/// <summary>
+		/// Every segment, in submission order.
+		/// </summary>
+		const std::vector<RecordingSegment>& GetSegments() const { return segments; }
+		uint32_t GetPassCount() const { return passCount; }
+		void Clear();
+		/// <summary>
+		/// The split used by AddParallelPass. The segments cover all items, in order, without gaps.
+		/// </summary>
+		static std::vector<RecordingSegment> Partition(uint32_t pass, const std::vector<uint64_t>& itemCosts,
+			uint32_t maxSegments, uint64_t minSegmentCost);
+	private:
+		std::vector<RecordingSegment> segments;
+		uint32_t passCount = 0;
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include "deferred_release.h"
+
+namespace common
+{
+	/// <summary>
+	/// The device independent part of ResourceRecycler: which objects wait for which fence value, and which
+	/// upload buffers are back in the pool. Object and Buffer are whatever owns them, ComPtrs on the d3d side;
+	/// dropping one is releasing it. Not thread safe.
+	/// </summary>
+	template<typename Object, typename Buffer>
+	class RecyclerCore
+	{
+	public:
+		RecyclerCore(const FenceTimeline& timeline, uint64_t minClassSize = 256, size_t maxPerClass = 8)
+			:releases(timeline), uploads(timeline), uploadPool(minClassSize, maxPerClass) {}
+		/// <summary>
+		/// Drops object once the work recorded so far is done.
+		/// </summary>
+		void DeferRelease(Object object)
+		{
+			releases.Release(std::move(object));
+		}
+		/// <summary>
+		/// Drops object once the timeline reaches fenceValue.
+		/// </summary>
+		void DeferRelease(Object object, uint64_t fenceValue)
+		{
+			releases.Release(std::move(object), fenceValue);
+		}
+		/// <summary>
+		/// The size a new upload buffer for a request of size must have to go back to the pool.
+		/// </summary>
+		uint64_t GetUploadClassSize(uint64_t size) const { return uploadPool.ClassSize(size); }
+		/// <summary>
+		/// A pooled upload buffer with at least size bytes, or nothing and the caller creates one of
+		/// GetUploadClassSize(size).
+		/// </summary>
+		std::optional<Buffer> TakeUploadBuffer(uint64_t size)
+		{
+			return uploadPool.Take(size);
+		}
+		/// <summary>
+		/// Gives back a buffer of classSize bytes. It goes back to the pool when the timeline reaches
+		/// fenceValue, or is dropped then if its class is full.
+		/// </summary>
+		void RecycleUploadBuffer(Buffer buffer, uint64_t classSize, uint64_t fenceValue)
+		{
+			uploads.Release({ classSize, std::move(buffer) }, fenceValue);
+		}
+		/// <summary>
+		/// Drops and pools whatever the timeline has passed, oldest first. Never waits.
+		/// </summary>
+		void Collect()
+		{
+			releases.Collect();
+			uploads.Collect([this](std::pair<uint64_t, Buffer>&& upload) {
+				uploadPool.Put(upload.first, std::move(upload.second));
+			});
+		}
+		/// <summary>
+		/// Drops the pooled buffers and whatever the timeline has passed. Pending items whose value wasn't
+		/// reached stay, callers clear when the gpu is idle.
+		/// </summary>
+		void Clear()
+		{
+			releases.Collect();
+			uploads.Collect();
+			uploadPool.Clear();
+		}
+		size_t GetPendingCount() const { return releases.GetPendingCount() + uploads.GetPendingCount(); }
+		const SizeClassPoolStats& GetUploadPoolStats() const { return uploadPool.GetStats(); }
+	private:
+		DeferredReleaseQueue<Object> releases;
+		DeferredReleaseQueue<std::pair<uint64_t, Buffer>> uploads;
+		SizeClassPool<Buffer> uploadPool;
+	};
+}
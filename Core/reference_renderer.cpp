@@ -0,0 +1,354 @@
+#include "pch.h"
+#include "reference_renderer.h"
+#include "point_light_shadow_camera.h"
+#include "worker_pool.h"
+#include <cmath>
+using namespace common::sw;
+namespace {
+    //bsdf_ps.hlsl and shadow_map_ps.hlsl constants
+    constexpr float PI = 3.14159265359f;
+    constexpr float MIN_ROUGHNESS = 0.004f;
+    constexpr float EPSILON = 0.0001f;
+    constexpr float C_EVSM = 50.0f;
+    //the varyings of the main pass, VS_OUTPUT of bsdf_vs.hlsl without the ones the pixel shader doesn't read
+    constexpr uint32_t WORLD_POS = 0;
+    constexpr uint32_t NORMAL = 3;
+    constexpr uint32_t VIEW_DIR = 6;
+    constexpr uint32_t BSDF_VARYINGS = 9;
+
+    Vec3 ReadVec3(const float* v) { return { v[0], v[1], v[2] }; }
+    void WriteVec3(float* dst, const Vec3& v) { dst[0] = v.x; dst[1] = v.y; dst[2] = v.z; }
+    Vec3 Pow(const Vec3& v, float e) { return { std::pow(v.x, e), std::pow(v.y, e), std::pow(v.z, e) }; }
+
+    /// <summary>
+    /// Same faces as CubeMapShadowMap::SetupViewMatrices.
+    /// </summary>
+    Mat4 ShadowFaceViewMatrix(const Vec3& lightPosition, int face)
+    {
+        static const Vec3 targets[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+        static const Vec3 ups[6] = { {0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0} };
+        return LookAtLH(lightPosition, lightPosition + targets[face], ups[face]);
+    }
+
+    /// <summary>
+    /// TextureCube.Sample: picks the face of the major axis and the coordinates in it like d3d does, then
+    /// samples that face. It doesn't filter across the face edges.
+    /// </summary>
+    Vec2 SampleShadowCube(const transforms::ReferenceRenderer::ShadowCube& cube, const Vec3& d)
+    {
+        const float ax = std::fabs(d.x);
+        const float ay = std::fabs(d.y);
+        const float az = std::fabs(d.z);
+        int face;
+        float sc, tc, ma;
+        if (ax >= ay && ax >= az) {
+            face = d.x >= 0 ? 0 : 1;
+            sc = d.x >= 0 ? -d.z : d.z;
+            tc = -d.y;
+            ma = ax;
+        }
+        else if (ay >= az) {
+            face = d.y >= 0 ? 2 : 3;
+            sc = d.x;
+            tc = d.y >= 0 ? d.z : -d.z;
+            ma = ay;
+        }
+        else {
+            face = d.z >= 0 ? 4 : 5;
+            sc = d.z >= 0 ? d.x : -d.x;
+            tc = -d.y;
+            ma = az;
+        }
+        if (ma == 0) {
+            return SampleBilinear(cube[0], 0.5f, 0.5f);
+        }
+        return SampleBilinear(cube[face], (sc / ma + 1.0f) * 0.5f, (tc / ma + 1.0f) * 0.5f);
+    }
+
+    float CalculateVarianceShadow(const Vec3& worldPos, const transforms::ReferenceLight& light,
+        const transforms::ReferenceRenderer::ShadowCube& shadowMap)
+    {
+        const Vec3 fragToLight = worldPos - light.position;
+        float currentDepth = Length(fragToLight) / light.shadowFarPlane;
+        const float depthBias = 0.00005f;
+        currentDepth += depthBias;
+        const float warpedCurrentDepth = std::exp(std::min(C_EVSM * currentDepth, 100.0f));
+        const Vec2 shadowData = SampleShadowCube(shadowMap, fragToLight);
+        const float storedDepth = shadowData.x;
+        const float storedDepthSquared = shadowData.y;
+        if (warpedCurrentDepth <= storedDepth) {
+            return 1.0f;
+        }
+        float variance = storedDepthSquared - (storedDepth * storedDepth);
+        variance = std::max(variance, 0.00002f);
+        const float d = warpedCurrentDepth - storedDepth;
+        float pMax = variance / (variance + d * d);
+        const float lightBleedingReduction = 0.05f;
+        pMax = Saturate((pMax - lightBleedingReduction) / (1.0f - lightBleedingReduction));
+        return Saturate(pMax);
+    }
+
+    Vec3 CalculateFresnelReflectance(float cosTheta, const Vec3& F0)
+    {
+        const float f = std::pow(std::clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
+        return F0 + (Vec3{ 1, 1, 1 } - F0) * f;
+    }
+
+    float CalculateGGXDistribution(const Vec3& N, const Vec3& H, float alpha)
+    {
+        const float alpha2 = alpha * alpha;
+        const float NdotH = std::max(Dot(N, H), 0.0f);
+        const float NdotH2 = NdotH * NdotH;
+        float denominator = (NdotH2 * (alpha2 - 1.0f) + 1.0f);
+        denominator = PI * denominator * denominator;
+        return alpha2 / std::max(denominator, EPSILON);
+    }
+
+    float CalculateGeometryMasking(float NdotV, float alpha)
+    {
+        const float k = alpha / 2.0f;
+        return NdotV / std::max(NdotV * (1.0f - k) + k, EPSILON);
+    }
+
+    float CalculateSmithGeometry(const Vec3& N, const Vec3& V, const Vec3& L, float alpha)
+    {
+        const float NdotV = std::max(Dot(N, V), 0.0f);
+        const float NdotL = std::max(Dot(N, L), 0.0f);
+        return CalculateGeometryMasking(NdotV, alpha) * CalculateGeometryMasking(NdotL, alpha);
+    }
+
+    float CalculatePointLightAttenuation(const transforms::ReferenceLight& light, float distance)
+    {
+        return 1.0f / (light.attenuationConstant + light.attenuationLinear * distance +
+            light.attenuationQuadratic * distance * distance);
+    }
+
+    Vec3 EvaluateCookTorranceBRDF(const Vec3& N, const Vec3& V, const Vec3& L, const Vec3& albedo, float metallic,
+        float roughness)
+    {
+        const Vec3 H = Normalize(V + L);
+        const float NdotV = std::max(Dot(N, V), 0.0f);
+        const float NdotL = std::max(Dot(N, L), 0.0f);
+        const float HdotV = std::max(Dot(H, V), 0.0f);
+        const float alpha = roughness * roughness;
+        const Vec3 F0 = Lerp(Vec3{ 0.04f, 0.04f, 0.04f }, albedo, metallic);
+        const float D = CalculateGGXDistribution(N, H, alpha);
+        const float G = CalculateSmithGeometry(N, V, L, alpha);
+        const Vec3 F = CalculateFresnelReflectance(HdotV, F0);
+        const Vec3 kS = F;
+        const Vec3 kD = (Vec3{ 1, 1, 1 } - kS) * (1.0f - metallic);
+        const Vec3 specular = F * (D * G) / (4.0f * NdotV * NdotL + EPSILON);
+        const Vec3 diffuse = kD * albedo / PI;
+        return diffuse + specular;
+    }
+
+    Vec3 ApplyExposureToneMapping(const Vec3& hdrColor, float exposure)
+    {
+        const Vec3 c = hdrColor * exposure;
+        const float a = 2.51f;
+        const float b = 0.03f;
+        const float cc = 2.43f;
+        const float d = 0.59f;
+        const float e = 0.14f;
+        auto aces = [=](float x) { return Saturate((x * (a * x + b)) / (x * (cc * x + d) + e)); };
+        return { aces(c.x), aces(c.y), aces(c.z) };
+    }
+
+    /// <summary>
+    /// shadow_map_ps.hlsl, varying 0 is the distance to the light over the far plane.
+    /// </summary>
+    class ShadowMapShader : public PixelShader {
+    public:
+        Vec4 Shade(const float* varyings) const override
+        {
+            const float warpedDepth = std::exp(C_EVSM * varyings[0] + 0.001f);
+            return { warpedDepth, warpedDepth * warpedDepth, 0.0f, 1.0f };
+        }
+    };
+
+    /// <summary>
+    /// bsdf_ps.hlsl for one object.
+    /// </summary>
+    class BsdfShader : public PixelShader {
+    public:
+        BsdfShader(const transforms::ReferenceObject& object, const transforms::ReferenceScene& scene,
+            const std::vector<transforms::ReferenceRenderer::ShadowCube>& shadowMaps)
+            :object(object), scene(scene), shadowMaps(shadowMaps)
+        {
+        }
+        Vec4 Shade(const float* varyings) const override
+        {
+            const Vec3 worldPos = ReadVec3(varyings + WORLD_POS);
+            const Vec3 N = Normalize(ReadVec3(varyings + NORMAL));
+            const Vec3 V = Normalize(ReadVec3(varyings + VIEW_DIR));
+            const Vec3 albedo = object.baseColor.xyz();
+            const float metallic = object.metallicFactor;
+            const float roughness = std::max(object.roughnessFactor, MIN_ROUGHNESS);
+            Vec3 finalColor = albedo * 0.03f;
+            const size_t lightCount = std::min(scene.lights.size(), static_cast<size_t>(MAX_LIGHTS));
+            for (size_t lightIndex = 0; lightIndex < lightCount; lightIndex++) {
+                const transforms::ReferenceLight& light = scene.lights[lightIndex];
+                const Vec3 lightVector = light.position - worldPos;
+                const float lightDistance = Length(lightVector);
+                const Vec3 L = lightVector / lightDistance;
+                const float NdotL = std::max(Dot(N, L), 0.0f);
+                if (NdotL <= 0.0f) {
+                    continue;
+                }
+                const float attenuation = CalculatePointLightAttenuation(light, lightDistance);
+                const float shadowFactor = CalculateVarianceShadow(worldPos, light, shadowMaps[lightIndex]);
+                if (attenuation < 0.001f || shadowFactor < 0.001f) {
+                    continue;
+                }
+                const Vec3 brdfValue = EvaluateCookTorranceBRDF(N, V, L, albedo, metallic, roughness);
+                finalColor += brdfValue * light.colorDiffuse.xyz() * (light.colorDiffuse.w * NdotL * attenuation * shadowFactor);
+            }
+            finalColor += object.emissiveColor;
+            finalColor = ApplyExposureToneMapping(finalColor, scene.exposure);
+            finalColor = Pow(finalColor, 1.0f / 2.2f);
+            return { finalColor.x, finalColor.y, finalColor.z, object.opacity * object.baseColor.w };
+        }
+    private:
+        const transforms::ReferenceObject& object;
+        const transforms::ReferenceScene& scene;
+        const std::vector<transforms::ReferenceRenderer::ShadowCube>& shadowMaps;
+    };
+
+    /// <summary>
+    /// scene_offscreen_presentation_ps.hlsl, varyings 0 and 1 are the texture coordinates.
+    /// </summary>
+    class PresentationShader : public PixelShader {
+    public:
+        explicit PresentationShader(const ColorBuffer& sceneTexture) :sceneTexture(sceneTexture) {}
+        Vec4 Shade(const float* varyings) const override
+        {
+            return SampleBilinear(sceneTexture, varyings[0], varyings[1]);
+        }
+    private:
+        const ColorBuffer& sceneTexture;
+    };
+}
+
+transforms::ReferenceRenderer::ReferenceRenderer(common::WorkerPool& workerPool, uint32_t shadowMapSize)
+    :workerPool(workerPool), rasterizer(workerPool), shadowMapSize(shadowMapSize)
+{
+}
+
+void transforms::ReferenceRenderer::Render(const ReferenceScene& scene, ColorBuffer& output)
+{
+    stats = RasterizerStats();
+    if (offscreenTarget.width != output.width || offscreenTarget.height != output.height) {
+        offscreenTarget = ColorBuffer(output.width, output.height);
+        depthBuffer = DepthBuffer(output.width, output.height);
+    }
+    shadedVertices.resize(scene.objects.size());
+    RenderShadowMaps(scene);
+    RenderMainPass(scene);
+    RenderPresentation(output);
+}
+
+void transforms::ReferenceRenderer::RenderShadowMaps(const ReferenceScene& scene)
+{
+    const size_t lightCount = std::min(scene.lights.size(), static_cast<size_t>(MAX_LIGHTS));
+    shadowMaps.resize(lightCount);
+    ColorBuffer faceTarget(shadowMapSize, shadowMapSize);
+    DepthBuffer faceDepth(shadowMapSize, shadowMapSize);
+    const ShadowMapShader shader;
+    for (size_t lightIndex = 0; lightIndex < lightCount; lightIndex++) {
+        const ReferenceLight& light = scene.lights[lightIndex];
+        const Mat4 projection = PerspectiveFovLH(PI / 2.0f, 1.0f, 0.1f, light.shadowFarPlane);
+        for (int face = 0; face < 6; face++) {
+            const Mat4 viewProjection = ShadowFaceViewMatrix(light.position, face) * projection;
+            //shadow_map_vs.hlsl
+            workerPool.ParallelFor(static_cast<uint32_t>(scene.objects.size()), [&](uint32_t i) {
+                const ReferenceObject& object = scene.objects[i];
+                std::vector<ShadedVertex>& out = shadedVertices[i];
+                out.resize(object.mesh->positions.size());
+                for (size_t v = 0; v < out.size(); v++) {
+                    const Vec4 worldPos = TransformPoint(object.mesh->positions[v], object.world);
+                    out[v].position = Transform(worldPos, viewProjection);
+                    out[v].varyings[0] = Length(worldPos.xyz() - light.position) / light.shadowFarPlane;
+                }
+                });
+            faceTarget.Clear({ 1.0f, 1.0f, 1.0f, 1.0f });
+            faceDepth.Clear(1.0f);
+            rasterizer.Begin(&faceTarget, &faceDepth);
+            for (size_t i = 0; i < scene.objects.size(); i++) {
+                const ReferenceMesh& mesh = *scene.objects[i].mesh;
+                rasterizer.Draw({ shadedVertices[i].data(), mesh.indices.data(),
+                    static_cast<uint32_t>(mesh.indices.size()), 1, &shader, CullMode::Back });
+            }
+            rasterizer.End();
+            AddStats();
+            //the moments are all the bsdf shader reads, keep the two channels
+            Surface<Vec2>& moments = shadowMaps[lightIndex][face];
+            moments = Surface<Vec2>(shadowMapSize, shadowMapSize);
+            for (size_t t = 0; t < faceTarget.texels.size(); t++) {
+                moments.texels[t] = { faceTarget.texels[t].x, faceTarget.texels[t].y };
+            }
+        }
+    }
+}
+
+void transforms::ReferenceRenderer::RenderMainPass(const ReferenceScene& scene)
+{
+    const Mat4 viewProjection = scene.view * scene.projection;
+    //bsdf_vs.hlsl
+    workerPool.ParallelFor(static_cast<uint32_t>(scene.objects.size()), [&](uint32_t i) {
+        const ReferenceObject& object = scene.objects[i];
+        const Mat4 inverseTransposeWorld = Transpose(Inverse(object.world));
+        std::vector<ShadedVertex>& out = shadedVertices[i];
+        out.resize(object.mesh->positions.size());
+        for (size_t v = 0; v < out.size(); v++) {
+            const Vec4 worldPos = TransformPoint(object.mesh->positions[v], object.world);
+            out[v].position = Transform(worldPos, viewProjection);
+            WriteVec3(out[v].varyings + WORLD_POS, worldPos.xyz());
+            WriteVec3(out[v].varyings + NORMAL, Normalize(TransformNormal(object.mesh->normals[v], inverseTransposeWorld)));
+            WriteVec3(out[v].varyings + VIEW_DIR, Normalize(scene.cameraPosition - worldPos.xyz()));
+        }
+        });
+    std::vector<BsdfShader> shaders;
+    shaders.reserve(scene.objects.size());
+    for (const ReferenceObject& object : scene.objects) {
+        shaders.emplace_back(object, scene, shadowMaps);
+    }
+    offscreenTarget.Clear({ 0.0f, 0.0f, 0.0f, 1.0f });
+    depthBuffer.Clear(1.0f);
+    rasterizer.Begin(&offscreenTarget, &depthBuffer);
+    for (size_t i = 0; i < scene.objects.size(); i++) {
+        const ReferenceMesh& mesh = *scene.objects[i].mesh;
+        rasterizer.Draw({ shadedVertices[i].data(), mesh.indices.data(),
+            static_cast<uint32_t>(mesh.indices.size()), BSDF_VARYINGS, &shaders[i], CullMode::Back });
+    }
+    rasterizer.End();
+    AddStats();
+}
+
+void transforms::ReferenceRenderer::RenderPresentation(ColorBuffer& output)
+{
+    //scene_offscreen_presentation_vs.hlsl, the fullscreen triangle from the vertex ids
+    ShadedVertex triangle[3];
+    for (uint32_t id = 0; id < 3; id++) {
+        const float u = static_cast<float>((id << 1) & 2);
+        const float v = static_cast<float>(id & 2);
+        triangle[id].position = { u * 2.0f - 1.0f, -(v * 2.0f - 1.0f), 0.0f, 1.0f };
+        triangle[id].varyings[0] = u;
+        triangle[id].varyings[1] = v;
+    }
+    const uint32_t indices[3] = { 0, 1, 2 };
+    const PresentationShader shader(offscreenTarget);
+    output.Clear({ 0.4f, 0.2f, 0.4f, 1.0f });
+    rasterizer.Begin(&output, nullptr);
+    rasterizer.Draw({ triangle, indices, 3, 2, &shader, CullMode::None });
+    rasterizer.End();
+    AddStats();
+}
+
+void transforms::ReferenceRenderer::AddStats()
+{
+    const RasterizerStats& pass = rasterizer.GetStats();
+    stats.trianglesIn += pass.trianglesIn;
+    stats.trianglesCulled += pass.trianglesCulled;
+    stats.trianglesBinned += pass.trianglesBinned;
+    stats.pixelsShaded += pass.pixelsShaded;
+}
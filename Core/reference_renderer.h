@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+#include "software_rasterizer.h"
+namespace transforms {
+    /// <summary>
+    /// The cpu copy of a mesh, what the reference renderer draws. Same space and winding as the uploaded one.
+    /// </summary>
+    struct ReferenceMesh {
+        std::vector<common::sw::Vec3> positions;
+        std::vector<common::sw::Vec3> normals;
+        std::vector<uint32_t> indices;
+    };
+    /// <summary>
+    /// A renderable with what the bsdf shaders read from PerObjectData.
+    /// </summary>
+    struct ReferenceObject {
+        std::shared_ptr<const ReferenceMesh> mesh;
+        common::sw::Mat4 world = common::sw::Mat4::Identity();
+        common::sw::Vec4 baseColor;
+        float metallicFactor = 0;
+        float roughnessFactor = 0;
+        float opacity = 1;
+        common::sw::Vec3 emissiveColor;
+    };
+    /// <summary>
+    /// A point light with its cube shadow map, as in LightingData.
+    /// </summary>
+    struct ReferenceLight {
+        common::sw::Vec3 position;
+        float attenuationConstant = 1;
+        float attenuationLinear = 0;
+        float attenuationQuadratic = 0;
+        common::sw::Vec4 colorDiffuse;
+        float shadowFarPlane = 500.0f;
+    };
+    struct ReferenceScene {
+        std::vector<ReferenceObject> objects;
+        std::vector<ReferenceLight> lights;
+        common::sw::Mat4 view = common::sw::Mat4::Identity();
+        common::sw::Mat4 projection = common::sw::Mat4::Identity();
+        common::sw::Vec3 cameraPosition;
+        float exposure = 0.002f;
+    };
+
+    /// <summary>
+    /// Renders a frame of the sample on the cpu with the software rasterizer: the point shadow pass, the bsdf
+    /// main pass into an offscreen target and the fullscreen presentation pass. The shaders are ports of
+    /// shadow_map_*.hlsl, bsdf_*.hlsl and scene_offscreen_presentation_*.hlsl, so the result can be compared
+    /// with the gpu frame and with itself: the same scene gives the same image on any machine and thread count.
+    /// </summary>
+    class ReferenceRenderer {
+    public:
+        ReferenceRenderer(common::WorkerPool& workerPool, uint32_t shadowMapSize);
+        /// <summary>
+        /// Renders scene into output, which has the size of the frame.
+        /// </summary>
+        void Render(const ReferenceScene& scene, common::sw::ColorBuffer& output);
+        /// <summary>
+        /// The main pass result of the last Render, before the presentation pass.
+        /// </summary>
+        const common::sw::ColorBuffer& GetOffscreenTarget() const { return offscreenTarget; }
+        /// <summary>
+        /// The rasterizer counters of the last Render, all passes together.
+        /// </summary>
+        const common::sw::RasterizerStats& GetStats() const { return stats; }
+        /// <summary>
+        /// A cube shadow map: the two EVSM moments of every face, in the d3d face order (+x, -x, +y, -y, +z, -z).
+        /// </summary>
+        using ShadowCube = std::array<common::sw::Surface<common::sw::Vec2>, 6>;
+    private:
+        void RenderShadowMaps(const ReferenceScene& scene);
+        void RenderMainPass(const ReferenceScene& scene);
+        void RenderPresentation(common::sw::ColorBuffer& output);
+        void AddStats();
+        common::WorkerPool& workerPool;
+        common::sw::Rasterizer rasterizer;
+        const uint32_t shadowMapSize;
+        std::vector<ShadowCube> shadowMaps;
+        common::sw::ColorBuffer offscreenTarget;
+        common::sw::DepthBuffer depthBuffer;
+        //vertex shader output, one array per object
+        std::vector<std::vector<common::sw::ShadedVertex>> shadedVertices;
+        common::sw::RasterizerStats stats;
+    };
+}
@@ -0,0 +1,224 @@
+#include "pch.h"
+#include "scene_import.h"
+#include "components.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <cstring>
+#include <tuple>
+
+namespace
+{
+    typedef std::shared_ptr<transforms::components::BSDFMaterial> BSDFMaterial_t;
+
+    DirectX::XMFLOAT3 _aiVec3ToDirectXVector(const aiVector3D& vec)
+    {
+        DirectX::XMFLOAT3 v(vec.x, vec.y, vec.z);
+        return v;
+    }
+
+    DirectX::XMFLOAT4 _aiColor3DToDirectXVector4(const aiColor3D& vec)
+    {
+        DirectX::XMFLOAT4 v(vec.r, vec.g, vec.b, 1.0f);
+        return v;
+    }
+
+    DirectX::XMFLOAT2 _removeZ(DirectX::XMFLOAT3 vec)
+    {
+        DirectX::XMFLOAT2 v(vec.x, vec.y);
+        return v;
+    }
+
+    std::tuple<DirectX::XMFLOAT3, DirectX::XMFLOAT4, DirectX::XMFLOAT3> GetLocalTransform(aiMatrix4x4 transform) {
+        aiVector3D position;
+        aiQuaternion rotation;
+        aiVector3D scale;
+        transform.Decompose(scale, rotation, position);
+        DirectX::XMFLOAT3 p(position.x, position.y, position.z);
+        DirectX::XMFLOAT4 r(rotation.x, rotation.y, rotation.z, rotation.w);
+        DirectX::XMFLOAT3 s(scale.x, scale.y, scale.z);
+        return std::make_tuple(p, r, s);
+    }
+
+    std::string GetMaterialName(aiMaterial* material) {
+        aiString ai_name;
+        material->Get(AI_MATKEY_NAME, ai_name);
+        std::string str_name = ai_name.C_Str();
+        return str_name;
+    }
+
+    DirectX::XMFLOAT4 GetBaseColor(aiMaterial* material) {
+        aiColor4D c;
+        material->Get(AI_MATKEY_BASE_COLOR, c);
+        DirectX::XMFLOAT4 dx_color(c.r, c.g, c.b, c.a);
+        return dx_color;
+    }
+
+    float GetMetallicFactor(aiMaterial* material) {
+        float f;
+        material->Get(AI_MATKEY_METALLIC_FACTOR, f);
+        return f;
+    }
+
+    float GetRoughnessFactor(aiMaterial* material) {
+        float f;
+        material->Get(AI_MATKEY_ROUGHNESS_FACTOR, f);
+        return f;
+    }
+
+    DirectX::XMFLOAT3 GetColorEmissive(aiMaterial* m) {
+        aiColor3D c;
+        m->Get(AI_MATKEY_COLOR_EMISSIVE, c);
+        DirectX::XMFLOAT3 dx_color(c.r, c.g, c.b);
+        return dx_color;
+    }
+
+    float GetOpacity(aiMaterial* m) {
+        float f;
+        m->Get(AI_MATKEY_OPACITY, f);
+        return f;
+    }
+
+    float GetRefracti(aiMaterial* m) {
+        //TODO PBR FIXME: Blender aint exporting the index of refraction
+        float f = 2.5f; // Default IOR for most materials (air-glass boundary)
+        if (AI_SUCCESS != m->Get(AI_MATKEY_REFRACTI, f)) {
+            f = 2.5f; // fallback
+        }
+        return f;
+    }
+
+    common::MeshData ToMeshData(const aiMesh* currMesh) {
+        common::MeshData md;
+        md.normals.resize(currMesh->mNumVertices);
+        md.vertices.resize(currMesh->mNumVertices);
+        md.uv.resize(currMesh->mNumVertices);
+        md.tg.resize(currMesh->mNumVertices);
+        md.cotg.resize(currMesh->mNumVertices);
+        for (uint32_t i = 0; i < currMesh->mNumVertices; i++) {
+            md.vertices[i] = _aiVec3ToDirectXVector(currMesh->mVertices[i]);
+            md.normals[i] = _aiVec3ToDirectXVector(currMesh->mNormals[i]);
+            md.uv[i] = _removeZ(_aiVec3ToDirectXVector(currMesh->mTextureCoords[0][i]));
+            //PBR: get tangent and bitangent
+            md.tg[i] = _aiVec3ToDirectXVector(currMesh->mTangents[i]);
+            md.cotg[i] = _aiVec3ToDirectXVector(currMesh->mBitangents[i]);
+        }
+        for (unsigned int j = 0; j < currMesh->mNumFaces; j++) {
+            const aiFace& face = currMesh->mFaces[j];
+            for (unsigned int k = 0; k < face.mNumIndices; k++) {
+                md.indices.push_back(static_cast<uint16_t>(face.mIndices[k]));
+            }
+        }
+        md.name = std::string(currMesh->mName.C_Str());
+        return md;
+    }
+
+    entt::entity ProcessNode(entt::registry& registry, aiNode* node, const aiScene* scene,
+        const std::vector<BSDFMaterial_t>& materials, const transforms::SceneMeshFn& onMesh,
+        entt::entity parent = entt::null) {
+        using namespace transforms::components;
+        entt::entity e = registry.create();
+        // Decompose the matrix into components and create the transform component.
+        auto prs = GetLocalTransform(node->mTransformation);
+        Transform transform;
+        transform.position = std::get<0>(prs);
+        transform.rotation = std::get<1>(prs);
+        transform.scale = std::get<2>(prs);
+        transform.updateEulers();
+        registry.emplace<Transform>(e, transform);
+        // Create the hierarchy component and set the parent received as param as the parent of the hierarchy
+        Hierarchy hierarchy;
+        hierarchy.parent = parent;
+        //Get the meshes
+        for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+            const aiMesh* currMesh = scene->mMeshes[node->mMeshes[i]];
+            //PBR: Add the material component to the meshes based on the material id
+            registry.emplace<BSDFMaterial_t>(e, materials[currMesh->mMaterialIndex]);
+            onMesh(e, ToMeshData(currMesh));
+        }
+        //lighting: Get the lights
+        for (unsigned int i = 0; i < scene->mNumLights; ++i) {
+            aiLight* light = scene->mLights[i];
+            if (strcmp(light->mName.C_Str(), node->mName.C_Str()) == 0) {
+                //I assume one light per node.
+                PointLight pl{};
+                std::string str(light->mName.C_Str());
+                pl.name = std::wstring(str.begin(), str.end());
+                pl.attenuationConstant = light->mAttenuationConstant;
+                pl.attenuationLinear = light->mAttenuationLinear;
+                pl.attenuationQuadratic = light->mAttenuationQuadratic;
+                pl.ColorAmbient = _aiColor3DToDirectXVector4(light->mColorAmbient);
+                pl.ColorDiffuse = _aiColor3DToDirectXVector4(light->mColorDiffuse);
+                pl.ColorSpecular = _aiColor3DToDirectXVector4(light->mColorSpecular);
+                registry.emplace<PointLight>(e, pl);
+            }
+        }
+        for (unsigned int i = 0; i < node->mNumChildren; i++) {
+            entt::entity child = ProcessNode(registry, node->mChildren[i], scene, materials, onMesh, e);
+            hierarchy.AddChild(child);
+        }
+        registry.emplace<Hierarchy>(e, hierarchy);
+        return e;
+    }
+}
+
+void transforms::ImportScene(entt::registry& registry, const std::string& path, const SceneMeshFn& onMesh)
+{
+    Assimp::Importer importer;
+    ///////read the file and throws if something bad happens
+    const aiScene* scene = importer.ReadFile(path.c_str(),
+        aiProcess_Triangulate
+        | aiProcess_JoinIdenticalVertices
+        | aiProcess_CalcTangentSpace //PBR: need this to generate tangents and bitangents
+        | aiProcess_MakeLeftHanded
+        | aiProcess_FlipWindingOrder
+    );
+    if (!scene) {
+        throw std::runtime_error(importer.GetErrorString());
+    }
+    //Material: read all materials
+    //TODO PBR: Use the textures if they are present
+    std::vector<BSDFMaterial_t> bsdfMaterials;
+    for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+        aiMaterial* material = scene->mMaterials[i];
+        auto m = std::make_shared<components::BSDFMaterial>();
+        m->baseColor = GetBaseColor(material);
+        m->emissiveColor = GetColorEmissive(material);
+        m->idInFile = i;
+        m->metallicFactor = GetMetallicFactor(material);
+        m->name = GetMaterialName(material);
+        m->opacity = GetOpacity(material);
+        m->refracti = GetRefracti(material);
+        m->roughnessFactor = GetRoughnessFactor(material);
+        bsdfMaterials.push_back(m);
+    }
+    ProcessNode(registry, scene->mRootNode, scene, bsdfMaterials, onMesh);
+}
+
+std::shared_ptr<transforms::ReferenceMesh> transforms::MakeReferenceMesh(const common::MeshData& mesh)
+{
+    auto referenceMesh = std::make_shared<ReferenceMesh>();
+    for (size_t v = 0; v < mesh.vertices.size(); v++) {
+        referenceMesh->positions.push_back({ mesh.vertices[v].x, mesh.vertices[v].y, mesh.vertices[v].z });
+        referenceMesh->normals.push_back({ mesh.normals[v].x, mesh.normals[v].y, mesh.normals[v].z });
+    }
+    referenceMesh->indices.assign(mesh.indices.begin(), mesh.indices.end());
+    return referenceMesh;
+}
+
+entt::entity transforms::CreateMainCamera(entt::registry& registry, float aspectRatio)
+{
+    entt::entity mainCamera = registry.create();
+    components::Transform cameraTransform;
+    cameraTransform.position = DirectX::XMFLOAT3(-6, 21.f, -12);
+    cameraTransform.LookAt(DirectX::XMFLOAT3(-6, 0.f, 0));
+    components::Perspective cameraPerspective;
+    cameraPerspective.fovDegrees = 45.0f;
+    cameraPerspective.ratio = aspectRatio;
+    cameraPerspective.zNear = 0.1f;
+    cameraPerspective.zFar = 500.f;
+    registry.emplace<components::Transform>(mainCamera, cameraTransform);
+    registry.emplace<components::Perspective>(mainCamera, cameraPerspective);
+    registry.emplace<components::tags::MainCamera>(mainCamera, components::tags::MainCamera{});
+    return mainCamera;
+}
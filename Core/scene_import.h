@@ -0,0 +1,28 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <entt/entt.hpp>
+#include "mesh_load.h"
+#include "reference_renderer.h"
+namespace transforms {
+    /// <summary>
+    /// Gets every mesh of an imported scene with its entity, which already has its transform and material.
+    /// It adds what draws the mesh: gpu buffers and a Renderable, or the cpu copy of the reference renderer.
+    /// </summary>
+    using SceneMeshFn = std::function<void(entt::entity, const common::MeshData&)>;
+    /// <summary>
+    /// Reads a scene with assimp into the registry: an entity per node, with its local transform, its
+    /// hierarchy, the bsdf material of its meshes and the point light of the same name, if there's one.
+    /// Throws std::runtime_error if assimp can't read the file.
+    /// </summary>
+    void ImportScene(entt::registry& registry, const std::string& path, const SceneMeshFn& onMesh);
+    /// <summary>
+    /// The cpu copy of a mesh, for the reference renderer.
+    /// </summary>
+    std::shared_ptr<ReferenceMesh> MakeReferenceMesh(const common::MeshData& mesh);
+    /// <summary>
+    /// Creates the main camera, looking at the map from above.
+    /// </summary>
+    entt::entity CreateMainCamera(entt::registry& registry, float aspectRatio);
+}
@@ -0,0 +1,36 @@
+#include "pch.h"
+#include "script_runner_system.h"
+#include <entt/entt.hpp>
+#include "components.h"
+#include "delta_timer.h"
+#include "cpu_profiler.h"
+
+namespace transforms::systems {
+    void RunScripts(entt::registry& gRegistry,
+        const float deltaTime) {
+        PROFILE_SCOPE("RunScripts");
+        auto scriptViews = gRegistry.view<transforms::components::Script>();
+        scriptViews.each([deltaTime, &gRegistry]
+        (entt::entity entity, transforms::components::Script& script) {
+            script.execute(deltaTime, entity, gRegistry);
+        });
+    }
+
+    void ScriptRunner::Run(entt::registry& registry, float deltaTime) const {
+        {
+            PROFILE_SCOPE("RunBehaviors");
+            for (const BehaviorType& type : behaviors) {
+                type.run(registry, deltaTime);
+            }
+        }
+        RunScripts(registry, deltaTime);
+    }
+
+    std::vector<std::type_index> ScriptRunner::GetBehaviorTypes() const {
+        std::vector<std::type_index> types;
+        for (const BehaviorType& type : behaviors) {
+            types.push_back(type.type);
+        }
+        return types;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <typeindex>
+#include <vector>
+#include <entt/entt.hpp>
+namespace transforms::systems {
+    /// <summary>
+    /// Runs the Script components, through their std::function. For one-off behaviors, the typed ones in
+    /// ScriptRunner cost less per entity.
+    /// </summary>
+    void RunScripts(entt::registry& gRegistry,const float deltaTime);
+
+    /// <summary>
+    /// Runs typed behaviors: components with a
+    /// void Update(float deltaTime, entt::entity self, entt::registry& registry) member. Each registered
+    /// type is one loop over its packed storage with a direct call per entity, instead of an indirect
+    /// call through a std::function. The Script components run after them.
+    /// </summary>
+    class ScriptRunner {
+    public:
+        template<typename Behavior>
+        void Register() {
+            for (const BehaviorType& type : behaviors) {
+                if (type.type == typeid(Behavior)) {
+                    return;
+                }
+            }
+            behaviors.push_back({ typeid(Behavior), &RunBehaviors<Behavior> });
+        }
+        void Run(entt::registry& registry, float deltaTime) const;
+        /// <summary>
+        /// The registered behavior types, what the scripts system reads.
+        /// </summary>
+        std::vector<std::type_index> GetBehaviorTypes() const;
+    private:
+        template<typename Behavior>
+        static void RunBehaviors(entt::registry& registry, float deltaTime) {
+            //updates may add or remove other components, not Behavior, which would move the storage under the loop
+            for (auto [entity, behavior] : registry.storage<Behavior>().each()) {
+                behavior.Update(deltaTime, entity, registry);
+            }
+        }
+        struct BehaviorType {
+            std::type_index type;
+            void (*run)(entt::registry& registry, float deltaTime);
+        };
+        std::vector<BehaviorType> behaviors;
+    };
+}
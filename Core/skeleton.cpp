@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "skeleton.h"
+#include <algorithm>
+
+size_t common::Pose::GetMemorySize() const
+{
+    return positions.size() * sizeof(DirectX::XMFLOAT3) + rotations.size() * sizeof(DirectX::XMFLOAT4) +
+        scales.size() * sizeof(DirectX::XMFLOAT3);
+}
+
+int32_t common::Skeleton::FindBone(const std::string& name) const
+{
+    const auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : static_cast<int32_t>(it - names.begin());
+}
+
+common::Skeleton common::BuildSkeleton(const std::vector<SkeletonBone>& bones, const std::vector<uint32_t>& jointBones,
+    const std::vector<DirectX::XMFLOAT4X4>& inverseBindMatrices)
+{
+    const uint32_t count = static_cast<uint32_t>(bones.size());
+    std::vector<std::vector<uint32_t>> children(count);
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (uint32_t b = 0; b < count; b++) {
+        const int32_t parent = bones[b].parent;
+        if (parent >= 0 && static_cast<uint32_t>(parent) < count && static_cast<uint32_t>(parent) != b) {
+            children[parent].push_back(b);
+        }
+        else {
+            order.push_back(b);
+        }
+    }
+    //breadth first from the roots, each bone is after its parent
+    std::vector<int32_t> newIndex(count, -1);
+    for (size_t i = 0; i < order.size(); i++) {
+        newIndex[order[i]] = static_cast<int32_t>(i);
+        for (uint32_t child : children[order[i]]) {
+            order.push_back(child);
+        }
+    }
+    //bones in a parent cycle are never reached, they become roots
+    for (uint32_t b = 0; b < count; b++) {
+        if (newIndex[b] < 0) {
+            newIndex[b] = static_cast<int32_t>(order.size());
+            order.push_back(b);
+        }
+    }
+
+    Skeleton skeleton;
+    skeleton.names.reserve(count);
+    skeleton.parents.reserve(count);
+    skeleton.restPose.positions.reserve(count);
+    skeleton.restPose.rotations.reserve(count);
+    skeleton.restPose.scales.reserve(count);
+    for (uint32_t b : order) {
+        const SkeletonBone& bone = bones[b];
+        const int32_t parent = bone.parent >= 0 && static_cast<uint32_t>(bone.parent) < count ? newIndex[bone.parent] : -1;
+        skeleton.names.push_back(bone.name);
+        skeleton.parents.push_back(parent < static_cast<int32_t>(skeleton.parents.size()) ? parent : -1);
+        skeleton.restPose.positions.push_back(bone.position);
+        skeleton.restPose.rotations.push_back(bone.rotation);
+        skeleton.restPose.scales.push_back(bone.scale);
+    }
+    for (size_t j = 0; j < jointBones.size(); j++) {
+        skeleton.jointBones.push_back(static_cast<uint32_t>(newIndex[jointBones[j]]));
+        DirectX::XMFLOAT4X4 identity;
+        DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+        skeleton.inverseBindMatrices.push_back(j < inverseBindMatrices.size() ? inverseBindMatrices[j] : identity);
+    }
+    return skeleton;
+}
+
+void common::ComputeModelMatrices(const Skeleton& skeleton, const Pose& pose,
+    std::vector<DirectX::XMFLOAT4X4>& modelMatrices)
+{
+    using namespace DirectX;
+    const uint32_t count = skeleton.GetBoneCount();
+    modelMatrices.resize(count);
+    for (uint32_t b = 0; b < count; b++) {
+        XMMATRIX model = XMMatrixScalingFromVector(XMLoadFloat3(&pose.scales[b])) *
+            XMMatrixRotationQuaternion(XMLoadFloat4(&pose.rotations[b])) *
+            XMMatrixTranslationFromVector(XMLoadFloat3(&pose.positions[b]));
+        const int32_t parent = skeleton.parents[b];
+        if (parent >= 0) {
+            //the parent is earlier in the array, already in model space
+            model = model * XMLoadFloat4x4(&modelMatrices[parent]);
+        }
+        XMStoreFloat4x4(&modelMatrices[b], model);
+    }
+}
+
+void common::ComputeSkinMatrices(const Skeleton& skeleton, const std::vector<DirectX::XMFLOAT4X4>& modelMatrices,
+    std::vector<DirectX::XMFLOAT4X4>& skinMatrices)
+{
+    using namespace DirectX;
+    const uint32_t count = skeleton.GetJointCount();
+    skinMatrices.resize(count);
+    for (uint32_t j = 0; j < count; j++) {
+        XMStoreFloat4x4(&skinMatrices[j], XMLoadFloat4x4(&skeleton.inverseBindMatrices[j]) *
+            XMLoadFloat4x4(&modelMatrices[skeleton.jointBones[j]]));
+    }
+}
+
+std::vector<int32_t> common::BindClip(const Skeleton& skeleton, const AnimationClip& clip)
+{
+    std::vector<int32_t> channelBones;
+    channelBones.reserve(clip.channels.size());
+    for (const AnimationChannel& channel : clip.channels) {
+        channelBones.push_back(skeleton.FindBone(channel.nodeName));
+    }
+    return channelBones;
+}
+
+void common::SampleClip(const AnimationClip& clip, const std::vector<int32_t>& channelBones, float time,
+    std::vector<TransformCursors>& cursors, Pose& pose)
+{
+    cursors.resize(clip.channels.size());
+    for (size_t c = 0; c < clip.channels.size(); c++) {
+        const int32_t bone = channelBones[c];
+        if (bone >= 0) {
+            SampleChannel(clip.channels[c].tracks, static_cast<uint32_t>(bone), time, cursors[c], pose);
+        }
+    }
+}
+
+void common::SampleChannel(const TransformTracks& tracks, uint32_t bone, float time, TransformCursors& cursors,
+    Pose& pose)
+{
+    using namespace DirectX;
+    if (!tracks.position.IsEmpty()) {
+        XMStoreFloat3(&pose.positions[bone], SampleTrack(tracks.position, time, cursors.position, XMVectorZero()));
+    }
+    if (!tracks.rotation.IsEmpty()) {
+        XMStoreFloat4(&pose.rotations[bone], SampleTrack(tracks.rotation, time, cursors.rotation, XMQuaternionIdentity()));
+    }
+    if (!tracks.scale.IsEmpty()) {
+        XMStoreFloat3(&pose.scales[bone], SampleTrack(tracks.scale, time, cursors.scale, XMVectorSplatOne()));
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "animation_track.h"
+
+namespace common
+{
+	/// <summary>
+	/// The local transforms of the bones of a skeleton, an array per component so that the passes over them
+	/// are linear. It's what an instance of a character owns, the skeleton is shared.
+	/// </summary>
+	struct Pose
+	{
+		std::vector<DirectX::XMFLOAT3> positions;
+		std::vector<DirectX::XMFLOAT4> rotations;
+		std::vector<DirectX::XMFLOAT3> scales;
+		size_t GetMemorySize() const;
+	};
+
+	/// <summary>
+	/// The bones of a character, shared by its instances. Parents come before their children, parents[b] < b
+	/// and -1 for roots, so a single pass in order composes the model matrices.
+	/// </summary>
+	struct Skeleton
+	{
+		std::vector<std::string> names;
+		std::vector<int32_t> parents;
+		/// <summary>
+		/// The local transforms in the file, what instances start with.
+		/// </summary>
+		Pose restPose;
+		/// <summary>
+		/// Vertices reference joints, the bones the mesh is bound to, in the order of the skin. jointBones[j]
+		/// is the bone of joint j and inverseBindMatrices[j] takes a vertex from the mesh to that bone.
+		/// </summary>
+		std::vector<uint32_t> jointBones;
+		std::vector<DirectX::XMFLOAT4X4> inverseBindMatrices;
+		uint32_t GetBoneCount() const { return static_cast<uint32_t>(parents.size()); }
+		uint32_t GetJointCount() const { return static_cast<uint32_t>(jointBones.size()); }
+		/// <summary>
+		/// The bone with that name, -1 if there's none. A search, for loading.
+		/// </summary>
+		int32_t FindBone(const std::string& name) const;
+	};
+
+	/// <summary>
+	/// A bone as the files have it: any order, the parent by its index in the same list.
+	/// </summary>
+	struct SkeletonBone
+	{
+		std::string name;
+		int32_t parent = -1;
+		DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0, 0, 0);
+		DirectX::XMFLOAT4 rotation = DirectX::XMFLOAT4(0, 0, 0, 1);
+		DirectX::XMFLOAT3 scale = DirectX::XMFLOAT3(1, 1, 1);
+	};
+	/// <summary>
+	/// Sorts the bones parents first. jointBones are indices in bones, inverseBindMatrices one per joint.
+	/// </summary>
+	Skeleton BuildSkeleton(const std::vector<SkeletonBone>& bones, const std::vector<uint32_t>& jointBones,
+		const std::vector<DirectX::XMFLOAT4X4>& inverseBindMatrices);
+
+	/// <summary>
+	/// Local to model space, one pass over the bones in order. modelMatrices gets one per bone.
+	/// </summary>
+	void ComputeModelMatrices(const Skeleton& skeleton, const Pose& pose, std::vector<DirectX::XMFLOAT4X4>& modelMatrices);
+	/// <summary>
+	/// The matrices the vertices are skinned with, inverse bind times model, one per joint in the order of
+	/// the vertex joint indices.
+	/// </summary>
+	void ComputeSkinMatrices(const Skeleton& skeleton, const std::vector<DirectX::XMFLOAT4X4>& modelMatrices,
+		std::vector<DirectX::XMFLOAT4X4>& skinMatrices);
+
+	/// <summary>
+	/// The bone each channel of the clip drives, -1 for channels of nodes the skeleton doesn't have. Once
+	/// per clip and skeleton, the names aren't looked at when sampling.
+	/// </summary>
+	std::vector<int32_t> BindClip(const Skeleton& skeleton, const AnimationClip& clip);
+	/// <summary>
+	/// Writes the clip at time into the pose. Bones without a channel, and tracks without keys, keep what the
+	/// pose had. cursors has one set per channel.
+	/// </summary>
+	void SampleClip(const AnimationClip& clip, const std::vector<int32_t>& channelBones, float time,
+		std::vector<TransformCursors>& cursors, Pose& pose);
+	/// <summary>
+	/// One channel of SampleClip: the tracks at time into the local transform of bone.
+	/// </summary>
+	void SampleChannel(const TransformTracks& tracks, uint32_t bone, float time, TransformCursors& cursors, Pose& pose);
+}
@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "skin_import.h"
+#include <assimp/scene.h>
+#include <algorithm>
+
+void common::ImportInfluences(const aiMesh& mesh, const std::vector<uint16_t>& joints,
+    std::vector<SkinInfluences>& influences)
+{
+    influences.assign(mesh.mNumVertices, SkinInfluences{});
+    const unsigned int boneCount = std::min(mesh.mNumBones, static_cast<unsigned int>(joints.size()));
+    for (unsigned int b = 0; b < boneCount; b++) {
+        const aiBone& bone = *mesh.mBones[b];
+        for (unsigned int w = 0; w < bone.mNumWeights; w++) {
+            const aiVertexWeight& weight = bone.mWeights[w];
+            if (weight.mVertexId < mesh.mNumVertices) {
+                AddInfluence(influences[weight.mVertexId], joints[b], weight.mWeight);
+            }
+        }
+    }
+    for (SkinInfluences& vertex : influences) {
+        NormalizeInfluences(vertex);
+    }
+}
+
+common::SceneBoneIndex::SceneBoneIndex(const aiScene& scene)
+{
+    for (unsigned int m = 0; m < scene.mNumMeshes; m++) {
+        const aiMesh& mesh = *scene.mMeshes[m];
+        for (unsigned int b = 0; b < mesh.mNumBones; b++) {
+            aiBone* bone = mesh.mBones[b];
+            bones.emplace(std::string_view(bone->mName.data, bone->mName.length), bone);
+        }
+    }
+    if (scene.mRootNode) {
+        IndexNode(scene.mRootNode, true);
+    }
+}
+
+aiBone* common::SceneBoneIndex::FindBone(std::string_view name) const
+{
+    const auto it = bones.find(name);
+    return it == bones.end() ? nullptr : it->second;
+}
+
+void common::SceneBoneIndex::IndexNode(aiNode* node, bool isRoot)
+{
+    if (FindBone(std::string_view(node->mName.data, node->mName.length))) {
+        boneNodes.insert(node);
+        //the search for the armature started at the children of the root
+        if (!isRoot && !armatureRoot) {
+            armatureRoot = node;
+        }
+    }
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        IndexNode(node->mChildren[i], false);
+    }
+}
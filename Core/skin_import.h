@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "cpu_skinning.h"
+
+struct aiBone;
+struct aiMesh;
+struct aiNode;
+struct aiScene;
+
+namespace common
+{
+	/// <summary>
+	/// The influences of the vertices of an assimp mesh, in one pass over the weights of its bones: each weight goes
+	/// to the slots of its vertex, which keep the 4 strongest, and then they are normalized. joints[b] is the joint
+	/// index that mesh->mBones[b] gets in the vertices. Linear in the number of weights.
+	/// </summary>
+	void ImportInfluences(const aiMesh& mesh, const std::vector<uint16_t>& joints,
+		std::vector<SkinInfluences>& influences);
+
+	/// <summary>
+	/// The bones of an assimp scene, indexed once so that the loaders don't compare every node with every bone of
+	/// every mesh. The names are views of the names of the bones, the scene must outlive the index.
+	/// </summary>
+	class SceneBoneIndex
+	{
+	public:
+		explicit SceneBoneIndex(const aiScene& scene);
+		/// <summary>
+		/// The bone with that name, the first one if more than one mesh has it. Null if no mesh has it.
+		/// </summary>
+		aiBone* FindBone(std::string_view name) const;
+		/// <summary>
+		/// Whether the node is a bone of a mesh, it isn't enough to be in the armature.
+		/// </summary>
+		bool IsBone(const aiNode* node) const { return boneNodes.count(node) != 0; }
+		/// <summary>
+		/// The first bone node, depth first from the children of the root node. Null if the scene has no bones.
+		/// </summary>
+		aiNode* GetArmatureRoot() const { return armatureRoot; }
+		size_t GetBoneCount() const { return bones.size(); }
+	private:
+		void IndexNode(aiNode* node, bool isRoot);
+		std::unordered_map<std::string_view, aiBone*> bones;
+		std::unordered_set<const aiNode*> boneNodes;
+		aiNode* armatureRoot = nullptr;
+	};
+}
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "slot_allocator.h"
+#include <stdexcept>
+
+transforms::SlotAllocator::SlotAllocator(uint32_t slotsPerBlock, uint32_t maxBlocks)
+    :slotsPerBlock(slotsPerBlock), maxBlocks(maxBlocks),
+    generations(slotsPerBlock, 0), alive(slotsPerBlock, false)
+{
+    if (slotsPerBlock == 0 || maxBlocks == 0) {
+        throw std::invalid_argument("slot allocator needs at least one block with one slot");
+    }
+}
+
+transforms::SlotHandle transforms::SlotAllocator::Allocate()
+{
+    uint32_t index;
+    if (!freeList.empty()) {
+        index = freeList.back();
+        freeList.pop_back();
+    }
+    else {
+        if (bump == GetCapacity()) {
+            if (blockCount == maxBlocks) {
+                return {};
+            }
+            blockCount++;
+            generations.resize(GetCapacity(), 0);
+            alive.resize(GetCapacity(), false);
+        }
+        index = bump++;
+    }
+    alive[index] = true;
+    used++;
+    if (used > highWaterMark) {
+        highWaterMark = used;
+    }
+    return { index, generations[index] };
+}
+
+bool transforms::SlotAllocator::Free(const SlotHandle& handle)
+{
+    if (!IsAlive(handle)) {
+        return false;
+    }
+    alive[handle.index] = false;
+    generations[handle.index]++;
+    freeList.push_back(handle.index);
+    used--;
+    return true;
+}
+
+bool transforms::SlotAllocator::IsAlive(const SlotHandle& handle) const
+{
+    return handle.IsValid() && handle.index < bump &&
+        alive[handle.index] && generations[handle.index] == handle.generation;
+}
+
+void transforms::SlotAllocator::Reset()
+{
+    for (uint32_t i = 0; i < bump; i++) {
+        if (alive[i]) {
+            alive[i] = false;
+            generations[i]++;
+        }
+    }
+    freeList.clear();
+    bump = 0;
+    used = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace transforms {
+    /// <summary>
+    /// Handle to a single slot. index is global across all the blocks, block = index / slotsPerBlock.
+    /// </summary>
+    struct SlotHandle {
+        static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+        bool IsValid() const { return index != INVALID_INDEX; }
+    };
+
+    /// <summary>
+    /// Free list allocator of single slots, split in blocks of fixed size. No d3d in here, the owner maps
+    /// blocks to descriptor heaps. When all the blocks are full and maxBlocks allows it, a new block
+    /// is opened; the owner has to check GetBlockCount() after Allocate() and create the backing heap.
+    /// </summary>
+    class SlotAllocator
+    {
+    public:
+        SlotAllocator(uint32_t slotsPerBlock, uint32_t maxBlocks);
+        /// <summary>
+        /// Returns an invalid handle when every block is full and no more can be opened.
+        /// </summary>
+        SlotHandle Allocate();
+        /// <summary>
+        /// Returns false, and does nothing, if the handle is stale or was already freed.
+        /// </summary>
+        bool Free(const SlotHandle& handle);
+        bool IsAlive(const SlotHandle& handle) const;
+        /// <summary>
+        /// Frees everything. All the handles given so far become stale.
+        /// </summary>
+        void Reset();
+        uint32_t GetSlotsPerBlock() const { return slotsPerBlock; }
+        uint32_t GetBlockCount() const { return blockCount; }
+        uint32_t GetCapacity() const { return blockCount * slotsPerBlock; }
+        uint32_t GetUsed() const { return used; }
+        /// <summary>
+        /// The most slots that were alive at the same time, use it to size the first block.
+        /// </summary>
+        uint32_t GetHighWaterMark() const { return highWaterMark; }
+    private:
+        const uint32_t slotsPerBlock;
+        const uint32_t maxBlocks;
+        uint32_t blockCount = 1;
+        uint32_t bump = 0;
+        uint32_t used = 0;
+        uint32_t highWaterMark = 0;
+        std::vector<uint32_t> freeList;
+        std::vector<uint32_t> generations;
+        std::vector<bool> alive;
+    };
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace common::sw
+{
+	//The small amount of vector math the software rasterizer and its shaders need. Same conventions as
+	//DirectXMath: row vectors, v * M, matrices stored row by row, left handed.
+	struct Vec2
+	{
+		float x = 0, y = 0;
+	};
+
+	struct Vec3
+	{
+		float x = 0, y = 0, z = 0;
+	};
+
+	struct Vec4
+	{
+		float x = 0, y = 0, z = 0, w = 0;
+		Vec3 xyz() const { return { x, y, z }; }
+	};
+
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3 operator*(const Vec3& a, const Vec3& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+	inline Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	inline Vec3 operator/(const Vec3& a, float s) { return { a.x / s, a.y / s, a.z / s }; }
+	inline Vec3& operator+=(Vec3& a, const Vec3& b) { a = a + b; return a; }
+	inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+	inline float Length(const Vec3& v) { return std::sqrt(Dot(v, v)); }
+	inline Vec3 Normalize(const Vec3& v)
+	{
+		const float length = Length(v);
+		return length > 0 ? v / length : v;
+	}
+	inline float Saturate(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+	inline Vec3 Saturate(const Vec3& v) { return { Saturate(v.x), Saturate(v.y), Saturate(v.z) }; }
+	inline Vec3 Lerp(const Vec3& a, const Vec3& b, float t) { return a + (b - a) * t; }
+
+	struct Mat4
+	{
+		float m[4][4] = {};
+		static Mat4 Identity()
+		{
+			Mat4 r;
+			for (int i = 0; i < 4; i++) {
+				r.m[i][i] = 1;
+			}
+			return r;
+		}
+	};
+
+	inline Vec4 Transform(const Vec4& v, const Mat4& m)
+	{
+		Vec4 r;
+		r.x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + v.w * m.m[3][0];
+		r.y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + v.w * m.m[3][1];
+		r.z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + v.w * m.m[3][2];
+		r.w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + v.w * m.m[3][3];
+		return r;
+	}
+	inline Vec4 TransformPoint(const Vec3& p, const Mat4& m) { return Transform({ p.x, p.y, p.z, 1 }, m); }
+	/// <summary>
+	/// v * the upper 3x3 of m, like mul(v, (float3x3)m).
+	/// </summary>
+	inline Vec3 TransformNormal(const Vec3& v, const Mat4& m)
+	{
+		return Transform({ v.x, v.y, v.z, 0 }, m).xyz();
+	}
+	inline Mat4 operator*(const Mat4& a, const Mat4& b)
+	{
+		Mat4 r;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+			}
+		}
+		return r;
+	}
+	inline Mat4 Transpose(const Mat4& a)
+	{
+		Mat4 r;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				r.m[i][j] = a.m[j][i];
+			}
+		}
+		return r;
+	}
+	/// <summary>
+	/// The inverse by cofactors. A singular matrix gives the zero matrix.
+	/// </summary>
+	inline Mat4 Inverse(const Mat4& a)
+	{
+		const float* s = &a.m[0][0];
+		float inv[16];
+		inv[0] = s[5] * s[10] * s[15] - s[5] * s[11] * s[14] - s[9] * s[6] * s[15] + s[9] * s[7] * s[14] + s[13] * s[6] * s[11] - s[13] * s[7] * s[10];
+		inv[4] = -s[4] * s[10] * s[15] + s[4] * s[11] * s[14] + s[8] * s[6] * s[15] - s[8] * s[7] * s[14] - s[12] * s[6] * s[11] + s[12] * s[7] * s[10];
+		inv[8] = s[4] * s[9] * s[15] - s[4] * s[11] * s[13] - s[8] * s[5] * s[15] + s[8] * s[7] * s[13] + s[12] * s[5] * s[11] - s[12] * s[7] * s[9];
+		inv[12] = -s[4] * s[9] * s[14] + s[4] * s[10] * s[13] + s[8] * s[5] * s[14] - s[8] * s[6] * s[13] - s[12] * s[5] * s[10] + s[12] * s[6] * s[9];
+		inv[1] = -s[1] * s[10] * s[15] + s[1] * s[11] * s[14] + s[9] * s[2] * s[15] - s[9] * s[3] * s[14] - s[13] * s[2] * s[11] + s[13] * s[3] * s[10];
+		inv[5] = s[0] * s[10] * s[15] - s[0] * s[11] * s[14] - s[8] * s[2] * s[15] + s[8] * s[3] * s[14] + s[12] * s[2] * s[11] - s[12] * s[3] * s[10];
+		inv[9] = -s[0] * s[9] * s[15] + s[0] * s[11] * s[13] + s[8] * s[1] * s[15] - s[8] * s[3] * s[13] - s[12] * s[1] * s[11] + s[12] * s[3] * s[9];
+		inv[13] = s[0] * s[9] * s[14] - s[0] * s[10] * s[13] - s[8] * s[1] * s[14] + s[8] * s[2] * s[13] + s[12] * s[1] * s[10] - s[12] * s[2] * s[9];
+		inv[2] = s[1] * s[6] * s[15] - s[1] * s[7] * s[14] - s[5] * s[2] * s[15] + s[5] * s[3] * s[14] + s[13] * s[2] * s[7] - s[13] * s[3] * s[6];
+		inv[6] = -s[0] * s[6] * s[15] + s[0] * s[7] * s[14] + s[4] * s[2] * s[15] - s[4] * s[3] * s[14] - s[12] * s[2] * s[7] + s[12] * s[3] * s[6];
+		inv[10] = s[0] * s[5] * s[15] - s[0] * s[7] * s[13] - s[4] * s[1] * s[15] + s[4] * s[3] * s[13] + s[12] * s[1] * s[7] - s[12] * s[3] * s[5];
+		inv[14] = -s[0] * s[5] * s[14] + s[0] * s[6] * s[13] + s[4] * s[1] * s[14] - s[4] * s[2] * s[13] - s[12] * s[1] * s[6] + s[12] * s[2] * s[5];
+		inv[3] = -s[1] * s[6] * s[11] + s[1] * s[7] * s[10] + s[5] * s[2] * s[11] - s[5] * s[3] * s[10] - s[9] * s[2] * s[7] + s[9] * s[3] * s[6];
+		inv[7] = s[0] * s[6] * s[11] - s[0] * s[7] * s[10] - s[4] * s[2] * s[11] + s[4] * s[3] * s[10] + s[8] * s[2] * s[7] - s[8] * s[3] * s[6];
+		inv[11] = -s[0] * s[5] * s[11] + s[0] * s[7] * s[9] + s[4] * s[1] * s[11] - s[4] * s[3] * s[9] - s[8] * s[1] * s[7] + s[8] * s[3] * s[5];
+		inv[15] = s[0] * s[5] * s[10] - s[0] * s[6] * s[9] - s[4] * s[1] * s[10] + s[4] * s[2] * s[9] + s[8] * s[1] * s[6] - s[8] * s[2] * s[5];
+		const float det = s[0] * inv[0] + s[1] * inv[4] + s[2] * inv[8] + s[3] * inv[12];
+		Mat4 r;
+		if (det == 0) {
+			return r;
+		}
+		const float invDet = 1.0f / det;
+		float* d = &r.m[0][0];
+		for (int i = 0; i < 16; i++) {
+			d[i] = inv[i] * invDet;
+		}
+		return r;
+	}
+	/// <summary>
+	/// Same as XMMatrixLookAtLH.
+	/// </summary>
+	inline Mat4 LookAtLH(const Vec3& eye, const Vec3& target, const Vec3& up)
+	{
+		const Vec3 z = Normalize(target - eye);
+		const Vec3 x = Normalize(Cross(up, z));
+		const Vec3 y = Cross(z, x);
+		Mat4 r;
+		r.m[0][0] = x.x; r.m[0][1] = y.x; r.m[0][2] = z.x;
+		r.m[1][0] = x.y; r.m[1][1] = y.y; r.m[1][2] = z.y;
+		r.m[2][0] = x.z; r.m[2][1] = y.z; r.m[2][2] = z.z;
+		r.m[3][0] = -Dot(x, eye); r.m[3][1] = -Dot(y, eye); r.m[3][2] = -Dot(z, eye);
+		r.m[3][3] = 1;
+		return r;
+	}
+	/// <summary>
+	/// Same as XMMatrixPerspectiveFovLH, depth goes from 0 at the near plane to 1 at the far plane.
+	/// </summary>
+	inline Mat4 PerspectiveFovLH(float fovY, float aspect, float zNear, float zFar)
+	{
+		const float h = std::cos(fovY * 0.5f) / std::sin(fovY * 0.5f);
+		const float range = zFar / (zFar - zNear);
+		Mat4 r;
+		r.m[0][0] = h / aspect;
+		r.m[1][1] = h;
+		r.m[2][2] = range;
+		r.m[2][3] = 1;
+		r.m[3][2] = -range * zNear;
+		return r;
+	}
+}
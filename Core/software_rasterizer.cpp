@@ -0,0 +1,310 @@
+#include "pch.h"
+#include "software_rasterizer.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <cmath>
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../tinygltf/stb_image_write.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SW_RASTERIZER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    using common::sw::ShadedVertex;
+
+    //the clipped vertex between a (inside) and b (outside) where the near plane distance is 0
+    ShadedVertex ClipEdge(const ShadedVertex& a, const ShadedVertex& b, uint32_t varyingCount)
+    {
+        const float t = a.position.z / (a.position.z - b.position.z);
+        ShadedVertex r;
+        r.position.x = a.position.x + (b.position.x - a.position.x) * t;
+        r.position.y = a.position.y + (b.position.y - a.position.y) * t;
+        r.position.z = a.position.z + (b.position.z - a.position.z) * t;
+        r.position.w = a.position.w + (b.position.w - a.position.w) * t;
+        for (uint32_t i = 0; i < varyingCount; i++) {
+            r.varyings[i] = a.varyings[i] + (b.varyings[i] - a.varyings[i]) * t;
+        }
+        return r;
+    }
+
+    bool IsTopLeft(float a, float b)
+    {
+        //the edge function grows towards the inside: a > 0 means the inside is to the right (a left edge),
+        //a horizontal edge with b > 0 has the inside below it (a top edge)
+        return a > 0 || (a == 0 && b > 0);
+    }
+}
+
+bool common::sw::WritePng(const std::string& path, const ColorBuffer& color)
+{
+    std::vector<uint8_t> rgba(color.texels.size() * 4);
+    for (size_t i = 0; i < color.texels.size(); i++) {
+        const Vec4& c = color.texels[i];
+        rgba[i * 4 + 0] = static_cast<uint8_t>(Saturate(c.x) * 255.0f + 0.5f);
+        rgba[i * 4 + 1] = static_cast<uint8_t>(Saturate(c.y) * 255.0f + 0.5f);
+        rgba[i * 4 + 2] = static_cast<uint8_t>(Saturate(c.z) * 255.0f + 0.5f);
+        rgba[i * 4 + 3] = static_cast<uint8_t>(Saturate(c.w) * 255.0f + 0.5f);
+    }
+    return stbi_write_png(path.c_str(), static_cast<int>(color.width), static_cast<int>(color.height), 4,
+        rgba.data(), static_cast<int>(color.width * 4)) != 0;
+}
+
+common::sw::Rasterizer::Rasterizer(WorkerPool& workerPool, uint32_t tileSize)
+    :workerPool(workerPool), tileSize(tileSize)
+{
+    assert(tileSize > 0);
+}
+
+void common::sw::Rasterizer::Begin(ColorBuffer* color, DepthBuffer* depth)
+{
+    assert(color != nullptr);
+    assert(depth == nullptr || (depth->width == color->width && depth->height == color->height));
+    this->color = color;
+    this->depth = depth;
+    tilesX = (color->width + tileSize - 1) / tileSize;
+    tilesY = (color->height + tileSize - 1) / tileSize;
+    draws.clear();
+}
+
+void common::sw::Rasterizer::Draw(const DrawCall& drawCall)
+{
+    assert(color != nullptr && "Draw outside of Begin/End");
+    assert(drawCall.indexCount % 3 == 0);
+    assert(drawCall.varyingCount <= MAX_VARYINGS);
+    draws.push_back(drawCall);
+}
+
+void common::sw::Rasterizer::End()
+{
+    stats = RasterizerStats();
+    //setup: clip and project every draw, in parallel, each into its own vector
+    drawTriangles.resize(draws.size());
+    std::vector<uint64_t> culled(draws.size(), 0);
+    workerPool.ParallelFor(static_cast<uint32_t>(draws.size()), [this, &culled](uint32_t i) {
+        drawTriangles[i].clear();
+        SetupDraw(draws[i], drawTriangles[i], culled[i]);
+        });
+    //binning: serial and in submission order, so every bin is ordered too
+    bins.resize(static_cast<size_t>(tilesX) * tilesY);
+    for (std::vector<uint64_t>& bin : bins) {
+        bin.clear();
+    }
+    for (size_t d = 0; d < draws.size(); d++) {
+        stats.trianglesIn += draws[d].indexCount / 3;
+        stats.trianglesCulled += culled[d];
+        for (size_t t = 0; t < drawTriangles[d].size(); t++) {
+            const Triangle& triangle = drawTriangles[d][t];
+            const uint32_t tx0 = static_cast<uint32_t>(triangle.minX) / tileSize;
+            const uint32_t tx1 = static_cast<uint32_t>(triangle.maxX) / tileSize;
+            const uint32_t ty0 = static_cast<uint32_t>(triangle.minY) / tileSize;
+            const uint32_t ty1 = static_cast<uint32_t>(triangle.maxY) / tileSize;
+            for (uint32_t ty = ty0; ty <= ty1; ty++) {
+                for (uint32_t tx = tx0; tx <= tx1; tx++) {
+                    bins[static_cast<size_t>(ty) * tilesX + tx].push_back((static_cast<uint64_t>(d) << 32) | t);
+                }
+            }
+            stats.trianglesBinned++;
+        }
+    }
+    //one tile per task
+    std::vector<uint64_t> pixelsShaded(bins.size(), 0);
+    workerPool.ParallelFor(static_cast<uint32_t>(bins.size()), [this, &pixelsShaded](uint32_t tile) {
+        RasterizeTile(tile, pixelsShaded[tile]);
+        });
+    for (uint64_t count : pixelsShaded) {
+        stats.pixelsShaded += count;
+    }
+    draws.clear();
+    color = nullptr;
+    depth = nullptr;
+}
+
+void common::sw::Rasterizer::SetupDraw(const DrawCall& drawCall, std::vector<Triangle>& triangles, uint64_t& culled) const
+{
+    for (uint32_t i = 0; i + 2 < drawCall.indexCount; i += 3) {
+        const ShadedVertex* in[3] = {
+            &drawCall.vertices[drawCall.indices[i]],
+            &drawCall.vertices[drawCall.indices[i + 1]],
+            &drawCall.vertices[drawCall.indices[i + 2]] };
+        //clip against the near plane, z >= 0. The far plane and the sides are left to the per pixel depth
+        //range test and the viewport bounds.
+        ShadedVertex polygon[4];
+        uint32_t count = 0;
+        for (uint32_t v = 0; v < 3; v++) {
+            const ShadedVertex& a = *in[v];
+            const ShadedVertex& b = *in[(v + 1) % 3];
+            const bool aInside = a.position.z >= 0;
+            const bool bInside = b.position.z >= 0;
+            if (aInside) {
+                polygon[count++] = a;
+            }
+            if (aInside != bInside) {
+                polygon[count++] = aInside ? ClipEdge(a, b, drawCall.varyingCount) : ClipEdge(b, a, drawCall.varyingCount);
+            }
+        }
+        if (count < 3) {
+            culled++;
+            continue;
+        }
+        for (uint32_t v = 1; v + 1 < count; v++) {
+            EmitTriangle(polygon[0], polygon[v], polygon[v + 1], drawCall, triangles, culled);
+        }
+    }
+}
+
+void common::sw::Rasterizer::EmitTriangle(const ShadedVertex& a, const ShadedVertex& b, const ShadedVertex& c,
+    const DrawCall& drawCall, std::vector<Triangle>& triangles, uint64_t& culled) const
+{
+    const ShadedVertex* v[3] = { &a, &b, &c };
+    Triangle t;
+    const float width = static_cast<float>(color->width);
+    const float height = static_cast<float>(color->height);
+    for (int i = 0; i < 3; i++) {
+        const Vec4& p = v[i]->position;
+        if (!(p.w > 0)) {
+            culled++;
+            return;
+        }
+        const float invW = 1.0f / p.w;
+        t.x[i] = (p.x * invW * 0.5f + 0.5f) * width;
+        t.y[i] = (0.5f - p.y * invW * 0.5f) * height;
+        t.z[i] = p.z * invW;
+        t.invW[i] = invW;
+    }
+    //negative area is clockwise on screen, the front face
+    const float area = (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]) - (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]);
+    if (area == 0 || !std::isfinite(area) || (drawCall.cullMode == CullMode::Back && area > 0)) {
+        culled++;
+        return;
+    }
+    //the tile loop wants the inside positive, swap to counter clockwise
+    int order[3] = { 0, 1, 2 };
+    if (area < 0) {
+        std::swap(order[1], order[2]);
+        std::swap(t.x[1], t.x[2]);
+        std::swap(t.y[1], t.y[2]);
+        std::swap(t.z[1], t.z[2]);
+        std::swap(t.invW[1], t.invW[2]);
+    }
+    const float minX = std::min({ t.x[0], t.x[1], t.x[2] });
+    const float maxX = std::max({ t.x[0], t.x[1], t.x[2] });
+    const float minY = std::min({ t.y[0], t.y[1], t.y[2] });
+    const float maxY = std::max({ t.y[0], t.y[1], t.y[2] });
+    if (maxX < 0 || maxY < 0 || minX >= width || minY >= height) {
+        culled++;
+        return;
+    }
+    t.minX = static_cast<int32_t>(std::floor(std::max(minX, 0.0f)));
+    t.minY = static_cast<int32_t>(std::floor(std::max(minY, 0.0f)));
+    t.maxX = static_cast<int32_t>(std::min(std::ceil(maxX), width - 1));
+    t.maxY = static_cast<int32_t>(std::min(std::ceil(maxY), height - 1));
+    t.varyingCount = drawCall.varyingCount;
+    t.shader = drawCall.shader;
+    for (int i = 0; i < 3; i++) {
+        for (uint32_t j = 0; j < drawCall.varyingCount; j++) {
+            t.varyings[i][j] = v[order[i]]->varyings[j] * t.invW[i];
+        }
+    }
+    triangles.push_back(t);
+}
+
+void common::sw::Rasterizer::RasterizeTile(uint32_t tile, uint64_t& pixelsShaded)
+{
+    const int32_t tileX0 = static_cast<int32_t>((tile % tilesX) * tileSize);
+    const int32_t tileY0 = static_cast<int32_t>((tile / tilesX) * tileSize);
+    const int32_t tileX1 = std::min(tileX0 + static_cast<int32_t>(tileSize), static_cast<int32_t>(color->width)) - 1;
+    const int32_t tileY1 = std::min(tileY0 + static_cast<int32_t>(tileSize), static_cast<int32_t>(color->height)) - 1;
+    float varyings[MAX_VARYINGS];
+    for (uint64_t key : bins[tile]) {
+        const Triangle& t = drawTriangles[key >> 32][key & 0xffffffffu];
+        //edge k goes from vertex k to vertex k+1, e = a*x + b*y + c is positive inside
+        float ea[3], eb[3], ec[3];
+        bool topLeft[3];
+        for (int k = 0; k < 3; k++) {
+            const int n = (k + 1) % 3;
+            ea[k] = t.y[n] - t.y[k];
+            eb[k] = -(t.x[n] - t.x[k]);
+            ec[k] = -(ea[k] * t.x[k] + eb[k] * t.y[k]);
+            topLeft[k] = IsTopLeft(ea[k], eb[k]);
+        }
+        const float invArea = 1.0f / ((t.y[1] - t.y[0]) * (t.x[2] - t.x[0]) - (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]));
+        const int32_t x0 = std::max(t.minX, tileX0);
+        const int32_t x1 = std::min(t.maxX, tileX1);
+        const int32_t y0 = std::max(t.minY, tileY0);
+        const int32_t y1 = std::min(t.maxY, tileY1);
+#if SW_RASTERIZER_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        __m128 a4[3], b4[3], c4[3], topLeft4[3];
+        for (int k = 0; k < 3; k++) {
+            a4[k] = _mm_set1_ps(ea[k]);
+            b4[k] = _mm_set1_ps(eb[k]);
+            c4[k] = _mm_set1_ps(ec[k]);
+            topLeft4[k] = topLeft[k] ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+        }
+#endif
+        for (int32_t y = y0; y <= y1; y++) {
+            const float py = static_cast<float>(y) + 0.5f;
+            for (int32_t x = x0; x <= x1; x += 4) {
+                //the edge functions of 4 pixels of the row at once
+                float e[3][4];
+                int mask = 0;
+#if SW_RASTERIZER_SSE2
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+                const __m128 py4 = _mm_set1_ps(py);
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int k = 0; k < 3; k++) {
+                    const __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a4[k], px), _mm_mul_ps(b4[k], py4)), c4[k]);
+                    const __m128 edgeInside = _mm_or_ps(_mm_cmpgt_ps(value, zero),
+                        _mm_and_ps(_mm_cmpeq_ps(value, zero), topLeft4[k]));
+                    inside = _mm_and_ps(inside, edgeInside);
+                    _mm_storeu_ps(e[k], value);
+                }
+                mask = _mm_movemask_ps(inside);
+#else
+                for (int lane = 0; lane < 4; lane++) {
+                    const float px = static_cast<float>(x + lane) + 0.5f;
+                    bool inside = true;
+                    for (int k = 0; k < 3; k++) {
+                        e[k][lane] = (ea[k] * px + eb[k] * py) + ec[k];
+                        inside = inside && (e[k][lane] > 0 || (e[k][lane] == 0 && topLeft[k]));
+                    }
+                    mask |= inside ? (1 << lane) : 0;
+                }
+#endif
+                //lanes past the end of the span
+                mask &= (1 << std::min(4, x1 - x + 1)) - 1;
+                for (int lane = 0; lane < 4; lane++) {
+                    if ((mask & (1 << lane)) == 0) {
+                        continue;
+                    }
+                    //the weight of a vertex is the edge in front of it
+                    const float w0 = e[1][lane] * invArea;
+                    const float w1 = e[2][lane] * invArea;
+                    const float w2 = e[0][lane] * invArea;
+                    const float z = w0 * t.z[0] + w1 * t.z[1] + w2 * t.z[2];
+                    const uint32_t pixelX = static_cast<uint32_t>(x + lane);
+                    const uint32_t pixelY = static_cast<uint32_t>(y);
+                    if (depth != nullptr) {
+                        float& stored = depth->At(pixelX, pixelY);
+                        if (!(z >= 0 && z <= 1 && z < stored)) {
+                            continue;
+                        }
+                        stored = z;
+                    }
+                    const float oneOverW = w0 * t.invW[0] + w1 * t.invW[1] + w2 * t.invW[2];
+                    const float w = 1.0f / oneOverW;
+                    for (uint32_t j = 0; j < t.varyingCount; j++) {
+                        varyings[j] = (w0 * t.varyings[0][j] + w1 * t.varyings[1][j] + w2 * t.varyings[2][j]) * w;
+                    }
+                    color->At(pixelX, pixelY) = t.shader->Shade(varyings);
+                    pixelsShaded++;
+                }
+            }
+        }
+    }
+}
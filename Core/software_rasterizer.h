@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "software_math.h"
+
+namespace common
+{
+	class WorkerPool;
+}
+
+namespace common::sw
+{
+	/// <summary>
+	/// A 2d image in memory, row by row from the top left texel.
+	/// </summary>
+	template<typename T>
+	struct Surface
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<T> texels;
+		Surface() = default;
+		Surface(uint32_t width, uint32_t height, const T& value = T())
+			:width(width), height(height), texels(static_cast<size_t>(width) * height, value)
+		{
+		}
+		T& At(uint32_t x, uint32_t y) { return texels[static_cast<size_t>(y) * width + x]; }
+		const T& At(uint32_t x, uint32_t y) const { return texels[static_cast<size_t>(y) * width + x]; }
+		void Clear(const T& value) { std::fill(texels.begin(), texels.end(), value); }
+	};
+	using ColorBuffer = Surface<Vec4>;
+	using DepthBuffer = Surface<float>;
+
+	inline Vec2 Blend(const Vec2& a, const Vec2& b, float t) { return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t }; }
+	inline Vec4 Blend(const Vec4& a, const Vec4& b, float t)
+	{
+		return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+	}
+	/// <summary>
+	/// Bilinear sample with clamp addressing, like a MIN_MAG_MIP_LINEAR sampler on a texture without mips.
+	/// u and v are in [0,1], v goes down.
+	/// </summary>
+	template<typename T>
+	T SampleBilinear(const Surface<T>& surface, float u, float v)
+	{
+		const float x = u * surface.width - 0.5f;
+		const float y = v * surface.height - 0.5f;
+		const float fx = std::floor(x);
+		const float fy = std::floor(y);
+		const float tx = x - fx;
+		const float ty = y - fy;
+		const int maxX = static_cast<int>(surface.width) - 1;
+		const int maxY = static_cast<int>(surface.height) - 1;
+		const int x0 = std::clamp(static_cast<int>(fx), 0, maxX);
+		const int x1 = std::clamp(static_cast<int>(fx) + 1, 0, maxX);
+		const int y0 = std::clamp(static_cast<int>(fy), 0, maxY);
+		const int y1 = std::clamp(static_cast<int>(fy) + 1, 0, maxY);
+		const T& a = surface.At(x0, y0);
+		const T& b = surface.At(x1, y0);
+		const T& c = surface.At(x0, y1);
+		const T& d = surface.At(x1, y1);
+		return Blend(Blend(a, b, tx), Blend(c, d, tx), ty);
+	}
+
+	/// <summary>
+	/// Writes the color as an 8 bit rgba png, each channel saturated and rounded like a UNORM render target.
+	/// Returns false if the file couldn't be written.
+	/// </summary>
+	bool WritePng(const std::string& path, const ColorBuffer& color);
+
+	constexpr uint32_t MAX_VARYINGS = 16;
+	/// <summary>
+	/// A vertex after the vertex shader: the clip space position and what is interpolated for the pixel shader.
+	/// </summary>
+	struct ShadedVertex
+	{
+		Vec4 position;
+		float varyings[MAX_VARYINGS] = {};
+	};
+
+	/// <summary>
+	/// Runs once per pixel that passed the depth test, with the perspective correct varyings.
+	/// It's called from the worker threads, so it must not write to shared state.
+	/// </summary>
+	class PixelShader
+	{
+	public:
+		virtual ~PixelShader() = default;
+		virtual Vec4 Shade(const float* varyings) const = 0;
+	};
+
+	enum class CullMode
+	{
+		None,
+		/// <summary>
+		/// Clockwise triangles are the front ones, like the pipelines with FrontCounterClockwise = FALSE.
+		/// </summary>
+		Back
+	};
+
+	/// <summary>
+	/// An indexed triangle list. The arrays and the shader have to live until Rasterizer::End.
+	/// </summary>
+	struct DrawCall
+	{
+		const ShadedVertex* vertices = nullptr;
+		const uint32_t* indices = nullptr;
+		uint32_t indexCount = 0;
+		uint32_t varyingCount = 0;
+		const PixelShader* shader = nullptr;
+		CullMode cullMode = CullMode::Back;
+	};
+
+	struct RasterizerStats
+	{
+		uint64_t trianglesIn = 0;
+		uint64_t trianglesCulled = 0;
+		uint64_t trianglesBinned = 0;
+		uint64_t pixelsShaded = 0;
+	};
+
+	/// <summary>
+	/// A tile based rasterizer for triangle lists with a LESS depth test and no blending, the subset of the
+	/// pipeline the samples use. Between Begin and End the draws are only queued; End clips them against the
+	/// near plane, bins them in screen tiles and rasterizes the tiles on the worker pool, one tile per task.
+	/// Each tile runs its triangles in submission order and owns its pixels, so the image is the same whatever
+	/// the number of threads.
+	/// </summary>
+	class Rasterizer
+	{
+	public:
+		explicit Rasterizer(WorkerPool& workerPool, uint32_t tileSize = 64);
+		/// <summary>
+		/// Starts a pass into color and, when it's not null, depth. Both must have the same size.
+		/// </summary>
+		void Begin(ColorBuffer* color, DepthBuffer* depth);
+		void Draw(const DrawCall& drawCall);
+		/// <summary>
+		/// Rasterizes the queued draws and returns when the targets are written.
+		/// </summary>
+		void End();
+		/// <summary>
+		/// Counters of the last End.
+		/// </summary>
+		const RasterizerStats& GetStats() const { return stats; }
+	private:
+		/// <summary>
+		/// A triangle ready for the edge functions. The vertices are in screen space with z/w and 1/w, the
+		/// varyings are premultiplied by 1/w.
+		/// </summary>
+		struct Triangle
+		{
+			float x[3], y[3], z[3], invW[3];
+			float varyings[3][MAX_VARYINGS];
+			uint32_t varyingCount;
+			const PixelShader* shader;
+			int32_t minX, minY, maxX, maxY;
+		};
+		void SetupDraw(const DrawCall& drawCall, std::vector<Triangle>& triangles, uint64_t& culled) const;
+		void EmitTriangle(const ShadedVertex& a, const ShadedVertex& b, const ShadedVertex& c, const DrawCall& drawCall,
+			std::vector<Triangle>& triangles, uint64_t& culled) const;
+		void RasterizeTile(uint32_t tile, uint64_t& pixelsShaded);
+		WorkerPool& workerPool;
+		const uint32_t tileSize;
+		ColorBuffer* color = nullptr;
+		DepthBuffer* depth = nullptr;
+		uint32_t tilesX = 0;
+		uint32_t tilesY = 0;
+		std::vector<DrawCall> draws;
+		std::vector<std::vector<Triangle>> drawTriangles;
+		//per tile, the triangles as indices in drawTriangles: draw in the high bits, triangle in the low
+		std::vector<std::vector<uint64_t>> bins;
+		RasterizerStats stats;
+	};
+}
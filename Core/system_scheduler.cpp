@@ -0,0 +1,145 @@
+#include "pch.h"
+#include "system_scheduler.h"
+#include <algorithm>
+
+namespace
+{
+    bool Contains(const std::vector<std::type_index>& resources, const std::type_index& resource)
+    {
+        return std::find(resources.begin(), resources.end(), resource) != resources.end();
+    }
+
+    void WriteResources(std::ostream& out, const char* label, const std::vector<std::type_index>& resources)
+    {
+        if (resources.empty()) {
+            return;
+        }
+        out << "      " << label << ":";
+        for (const std::type_index& r : resources) {
+            out << " " << r.name();
+        }
+        out << "\n";
+    }
+}
+
+common::SystemScheduler::SystemScheduler(WorkerPool& workerPool)
+    :workerPool(workerPool)
+{
+}
+
+uint32_t common::SystemScheduler::Add(SystemDesc system)
+{
+    const auto named = [this](const std::string& name) {
+        return std::any_of(systems.begin(), systems.end(), [&name](const SystemDesc& s) { return s.name == name; });
+    };
+    if (named(system.name)) {
+        throw std::invalid_argument("there is a system called " + system.name + " already");
+    }
+    for (const std::string& a : system.after) {
+        if (!named(a)) {
+            throw std::invalid_argument(system.name + " comes after " + a + ", which isn't a system yet");
+        }
+    }
+    systems.push_back(std::move(system));
+    dirty = true;
+    return static_cast<uint32_t>(systems.size() - 1);
+}
+
+std::string common::SystemScheduler::Conflict(const SystemDesc& a, const SystemDesc& b) const
+{
+    if (a.exclusive || b.exclusive) {
+        return "exclusive";
+    }
+    if (std::find(b.after.begin(), b.after.end(), a.name) != b.after.end()) {
+        return "after";
+    }
+    for (const std::type_index& w : a.writes) {
+        if (Contains(b.writes, w)) {
+            return std::string("both write ") + w.name();
+        }
+        if (Contains(b.reads, w)) {
+            return std::string("reads ") + w.name();
+        }
+    }
+    for (const std::type_index& w : b.writes) {
+        if (Contains(a.reads, w)) {
+            return std::string("writes ") + w.name();
+        }
+    }
+    return "";
+}
+
+void common::SystemScheduler::Build()
+{
+    //a system waits for every earlier one it conflicts with, and runs one stage after the latest of them
+    dependencies.assign(systems.size(), {});
+    stages.clear();
+    std::vector<uint32_t> stageOf(systems.size(), 0);
+    for (uint32_t b = 0; b < systems.size(); b++) {
+        for (uint32_t a = 0; a < b; a++) {
+            if (!Conflict(systems[a], systems[b]).empty()) {
+                dependencies[b].push_back(a);
+                stageOf[b] = std::max(stageOf[b], stageOf[a] + 1);
+            }
+        }
+        if (stageOf[b] >= stages.size()) {
+            stages.resize(stageOf[b] + 1);
+        }
+        stages[stageOf[b]].push_back(b);
+    }
+    dirty = false;
+}
+
+void common::SystemScheduler::Run()
+{
+    if (dirty) {
+        Build();
+    }
+    for (const std::vector<uint32_t>& stage : stages) {
+        //a lone system runs on the caller, free to use the pool if it's exclusive
+        if (stage.size() == 1) {
+            systems[stage[0]].run();
+            continue;
+        }
+        workerPool.ParallelFor(static_cast<uint32_t>(stage.size()), [this, &stage](uint32_t i) {
+            systems[stage[i]].run();
+            });
+    }
+}
+
+const std::vector<uint32_t>& common::SystemScheduler::GetDependencies(uint32_t system)
+{
+    if (dirty) {
+        Build();
+    }
+    return dependencies[system];
+}
+
+const std::vector<std::vector<uint32_t>>& common::SystemScheduler::GetStages()
+{
+    if (dirty) {
+        Build();
+    }
+    return stages;
+}
+
+void common::SystemScheduler::WriteSchedule(std::ostream& out)
+{
+    if (dirty) {
+        Build();
+    }
+    out << systems.size() << " systems in " << stages.size() << " stages, on " << workerPool.GetConcurrency()
+        << " threads\n";
+    for (size_t s = 0; s < stages.size(); s++) {
+        out << "stage " << s << "\n";
+        for (uint32_t id : stages[s]) {
+            const SystemDesc& system = systems[id];
+            out << "    " << system.name << (system.exclusive ? " (exclusive)" : "") << "\n";
+            WriteResources(out, "reads", system.reads);
+            WriteResources(out, "writes", system.writes);
+            for (uint32_t d : dependencies[id]) {
+                out << "      waits for " << systems[d].name << ": " << Conflict(systems[d], system) << "\n";
+            }
+        }
+    }
+}
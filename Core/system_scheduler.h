@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <vector>
+#include "worker_pool.h"
+
+namespace common
+{
+	/// <summary>
+	/// A system of the frame and what it touches. Resources are types: components, uniform buffers, or tag
+	/// types for state that isn't either. Two systems that write the same resource, or one that writes what
+	/// the other reads, run in the order they were added; the rest may run at the same time.
+	/// </summary>
+	struct SystemDesc
+	{
+		std::string name;
+		std::vector<std::type_index> reads;
+		std::vector<std::type_index> writes;
+		/// <summary>
+		/// Names of systems added before this one that it has to follow, for orderings the resources don't show.
+		/// </summary>
+		std::vector<std::string> after;
+		/// <summary>
+		/// Runs alone on the calling thread, after everything before it and before everything after it. For
+		/// systems that use the worker pool themselves, or touch things they can't declare.
+		/// </summary>
+		bool exclusive = false;
+		std::function<void()> run;
+	};
+
+	/// <summary>
+	/// The resource list of a SystemDesc.
+	/// </summary>
+	template<typename... Types>
+	std::vector<std::type_index> Resources()
+	{
+		return { std::type_index(typeid(Types))... };
+	}
+
+	/// <summary>
+	/// Runs the systems of a frame. From the declared accesses it builds a dependency graph, each system on
+	/// the earlier ones it conflicts with, and groups the systems in stages: a stage runs on the worker pool
+	/// once all the stages before it finished. The graph is rebuilt on the next Run after a system is added,
+	/// adding a system doesn't touch the main loop.
+	/// </summary>
+	class SystemScheduler
+	{
+	public:
+		explicit SystemScheduler(WorkerPool& workerPool);
+		/// <summary>
+		/// Returns the system id. Throws std::invalid_argument if the name is taken or an after isn't a
+		/// system added before.
+		/// </summary>
+		uint32_t Add(SystemDesc system);
+		/// <summary>
+		/// Runs every system once. Not reentrant, and systems that aren't exclusive must not use the worker pool.
+		/// </summary>
+		void Run();
+		/// <summary>
+		/// The systems a system waits for, directly.
+		/// </summary>
+		const std::vector<uint32_t>& GetDependencies(uint32_t system);
+		/// <summary>
+		/// System ids per stage, in run order.
+		/// </summary>
+		const std::vector<std::vector<uint32_t>>& GetStages();
+		const SystemDesc& GetSystem(uint32_t system) const { return systems[system]; }
+		uint32_t GetSystemCount() const { return static_cast<uint32_t>(systems.size()); }
+		/// <summary>
+		/// The stages with their systems, what each one reads and writes, and why it waits for the ones it does.
+		/// </summary>
+		void WriteSchedule(std::ostream& out);
+	private:
+		void Build();
+		/// <summary>
+		/// Why b has to wait for a, added before it. Empty if it doesn't.
+		/// </summary>
+		std::string Conflict(const SystemDesc& a, const SystemDesc& b) const;
+		WorkerPool& workerPool;
+		std::vector<SystemDesc> systems;
+		std::vector<std::vector<uint32_t>> dependencies;
+		std::vector<std::vector<uint32_t>> stages;
+		bool dirty = false;
+	};
+}
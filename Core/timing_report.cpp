@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "timing_report.h"
+#include <iomanip>
+#include <limits>
+
+namespace
+{
+    const char* SCOPES_HEADER = "scope,depth,min_ms,avg_ms,p99_ms,max_ms,calls";
+
+    std::runtime_error ReportError(size_t line, const std::string& what)
+    {
+        return std::runtime_error("timing report, line " + std::to_string(line) + ": " + what);
+    }
+
+    std::vector<std::string> SplitCsv(const std::string& line)
+    {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    double ParseNumber(const std::string& s, size_t line)
+    {
+        try {
+            size_t used = 0;
+            const double value = std::stod(s, &used);
+            if (used == s.size()) {
+                return value;
+            }
+        }
+        catch (const std::logic_error&) {
+        }
+        throw ReportError(line, "'" + s + "' is not a number");
+    }
+
+    /// <summary>
+    /// One line of the comparison: the scope, its baseline and current average and p99, and the change.
+    /// </summary>
+    void WriteComparisonRow(std::ostream& out, const std::string& label, double baseAvg, double avg,
+        double baseP99, double p99, const char* note)
+    {
+        std::stringstream change;
+        if (baseAvg > 0 && avg > 0) {
+            change << std::fixed << std::setprecision(1) << std::showpos << (avg - baseAvg) / baseAvg * 100.0 << "%";
+        }
+        out << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << baseAvg << std::setw(10) << avg << std::setw(11) << change.str()
+            << std::setw(10) << baseP99 << std::setw(10) << p99 << "  " << note << "\n";
+    }
+}
+
+common::TimingReport common::MakeTimingReport(const CpuProfiler& profiler, const FrameStats& frameStats)
+{
+    TimingReport report;
+    report.frames = frameStats.GetSummary();
+    report.profiledFrames = profiler.GetFrameCount();
+    report.scopes = profiler.GetScopeStats();
+    return report;
+}
+
+void common::WriteTimingReport(std::ostream& out, const TimingReport& report)
+{
+    const std::streamsize oldPrecision = out.precision(std::numeric_limits<double>::max_digits10);
+    const FrameStatsSummary& f = report.frames;
+    out << "frames," << f.frameCount << "\n"
+        << "profiled_frames," << report.profiledFrames << "\n"
+        << "frame_min_ms," << f.minMs << "\n"
+        << "frame_mean_ms," << f.meanMs << "\n"
+        << "frame_std_dev_ms," << f.stdDevMs << "\n"
+        << "frame_p50_ms," << f.p50Ms << "\n"
+        << "frame_p95_ms," << f.p95Ms << "\n"
+        << "frame_p99_ms," << f.p99Ms << "\n"
+        << "frame_max_ms," << f.maxMs << "\n"
+        << "frame_jitter_ms," << f.jitterMs << "\n"
+        << "stutters," << f.stutterCount << "\n"
+        << SCOPES_HEADER << "\n";
+    for (const ScopeStats& s : report.scopes) {
+        out << s.name << ',' << s.depth << ',' << s.minMs << ',' << s.avgMs << ',' << s.p99Ms << ','
+            << s.maxMs << ',' << s.callsPerFrame << "\n";
+    }
+    out.precision(oldPrecision);
+}
+
+common::TimingReport common::ReadTimingReport(std::istream& in)
+{
+    TimingReport report;
+    FrameStatsSummary& f = report.frames;
+    std::string line;
+    size_t lineNumber = 0;
+    bool inScopes = false;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line == SCOPES_HEADER) {
+            inScopes = true;
+            continue;
+        }
+        const std::vector<std::string> fields = SplitCsv(line);
+        if (inScopes) {
+            if (fields.size() != 7) {
+                throw ReportError(lineNumber, "expected 7 fields");
+            }
+            ScopeStats s;
+            s.name = fields[0];
+            s.depth = static_cast<uint32_t>(ParseNumber(fields[1], lineNumber));
+            s.minMs = ParseNumber(fields[2], lineNumber);
+            s.avgMs = ParseNumber(fields[3], lineNumber);
+            s.p99Ms = ParseNumber(fields[4], lineNumber);
+            s.maxMs = ParseNumber(fields[5], lineNumber);
+            s.callsPerFrame = ParseNumber(fields[6], lineNumber);
+            report.scopes.push_back(s);
+            continue;
+        }
+        if (fields.size() != 2) {
+            throw ReportError(lineNumber, "expected name,value");
+        }
+        const std::string& name = fields[0];
+        const double value = ParseNumber(fields[1], lineNumber);
+        if (name == "frames") f.frameCount = static_cast<uint64_t>(value);
+        else if (name == "profiled_frames") report.profiledFrames = static_cast<uint32_t>(value);
+        else if (name == "frame_min_ms") f.minMs = value;
+        else if (name == "frame_mean_ms") f.meanMs = value;
+        else if (name == "frame_std_dev_ms") f.stdDevMs = value;
+        else if (name == "frame_p50_ms") f.p50Ms = value;
+        else if (name == "frame_p95_ms") f.p95Ms = value;
+        else if (name == "frame_p99_ms") f.p99Ms = value;
+        else if (name == "frame_max_ms") f.maxMs = value;
+        else if (name == "frame_jitter_ms") f.jitterMs = value;
+        else if (name == "stutters") f.stutterCount = static_cast<uint64_t>(value);
+        //unknown names are from a newer writer, skip them
+    }
+    if (!inScopes) {
+        throw ReportError(lineNumber, "no '" + std::string(SCOPES_HEADER) + "' header");
+    }
+    return report;
+}
+
+uint32_t common::CompareTimingReports(std::ostream& out, const TimingReport& baseline, const TimingReport& current,
+    double thresholdPercent, double minimumMs)
+{
+    const std::ios_base::fmtflags oldFlags = out.flags();
+    const std::streamsize oldPrecision = out.precision();
+    out << "baseline " << baseline.frames.frameCount << " frames (" << baseline.profiledFrames << " profiled), current "
+        << current.frames.frameCount << " frames (" << current.profiledFrames << " profiled), times in ms per frame\n";
+    out << std::left << std::setw(36) << "scope" << std::right << std::setw(10) << "base avg" << std::setw(10) << "avg"
+        << std::setw(11) << "change" << std::setw(10) << "base p99" << std::setw(10) << "p99" << "\n";
+    uint32_t regressions = 0;
+    auto isRegression = [thresholdPercent, minimumMs](double baseMs, double ms) {
+        return ms - baseMs > minimumMs && ms - baseMs > baseMs * thresholdPercent / 100.0;
+    };
+    const bool frameRegression = isRegression(baseline.frames.meanMs, current.frames.meanMs);
+    regressions += frameRegression ? 1 : 0;
+    WriteComparisonRow(out, "frame", baseline.frames.meanMs, current.frames.meanMs, baseline.frames.p99Ms,
+        current.frames.p99Ms, frameRegression ? "REGRESSION" : "");
+    //scopes match by name and depth, the same name can be timed at different levels
+    std::vector<bool> matched(baseline.scopes.size(), false);
+    for (const ScopeStats& s : current.scopes) {
+        const std::string label = std::string(s.depth * 2, ' ') + s.name;
+        size_t b = 0;
+        while (b < baseline.scopes.size() && (matched[b] || baseline.scopes[b].name != s.name ||
+            baseline.scopes[b].depth != s.depth)) {
+            b++;
+        }
+        if (b == baseline.scopes.size()) {
+            WriteComparisonRow(out, label, 0, s.avgMs, 0, s.p99Ms, "only in current");
+            continue;
+        }
+        matched[b] = true;
+        const ScopeStats& base = baseline.scopes[b];
+        const bool regression = isRegression(base.avgMs, s.avgMs);
+        regressions += regression ? 1 : 0;
+        WriteComparisonRow(out, label, base.avgMs, s.avgMs, base.p99Ms, s.p99Ms, regression ? "REGRESSION" : "");
+    }
+    for (size_t b = 0; b < baseline.scopes.size(); b++) {
+        if (!matched[b]) {
+            const ScopeStats& base = baseline.scopes[b];
+            WriteComparisonRow(out, std::string(base.depth * 2, ' ') + base.name, base.avgMs, 0, base.p99Ms, 0,
+                "only in baseline");
+        }
+    }
+    out.flags(oldFlags);
+    out.precision(oldPrecision);
+    out << regressions << " regressions over " << thresholdPercent << "% and " << minimumMs << " ms\n";
+    return regressions;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "cpu_profiler.h"
+#include "frame_stats.h"
+
+namespace common
+{
+	/// <summary>
+	/// The per scope timings of a run, and its frame times, in a form that can be saved and compared with
+	/// the report of another run.
+	/// </summary>
+	struct TimingReport
+	{
+		FrameStatsSummary frames;
+		/// <summary>
+		/// Frames the scope statistics cover, the profiler history may be shorter than the run.
+		/// </summary>
+		uint32_t profiledFrames = 0;
+		std::vector<ScopeStats> scopes;
+	};
+
+	TimingReport MakeTimingReport(const CpuProfiler& profiler, const FrameStats& frameStats);
+	/// <summary>
+	/// CSV. The frame time summary goes first as name,value rows, then the table of scopes under the header
+	/// scope,depth,min_ms,avg_ms,p99_ms,max_ms,calls.
+	/// </summary>
+	void WriteTimingReport(std::ostream& out, const TimingReport& report);
+	/// <summary>
+	/// Reads what WriteTimingReport wrote. Throws std::runtime_error, with the line, if it can't.
+	/// </summary>
+	TimingReport ReadTimingReport(std::istream& in);
+	/// <summary>
+	/// Prints the average and p99 of every scope and of the frame in both runs side by side, with the change.
+	/// Scopes that got slower by more than thresholdPercent of their baseline average, and by more than
+	/// minimumMs, are marked as regressions. Returns how many there were.
+	/// </summary>
+	uint32_t CompareTimingReports(std::ostream& out, const TimingReport& baseline, const TimingReport& current,
+		double thresholdPercent = 10.0, double minimumMs = 0.01);
+}
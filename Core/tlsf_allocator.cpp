@@ -0,0 +1,330 @@
+#include "pch.h"
+#include "tlsf_allocator.h"
+#include <stdexcept>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+    uint32_t MostSignificantBit(uint64_t v)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return static_cast<uint32_t>(idx);
+#else
+        return 63u - static_cast<uint32_t>(__builtin_clzll(v));
+#endif
+    }
+    uint32_t LeastSignificantBit(uint64_t v)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, v);
+        return static_cast<uint32_t>(idx);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(v));
+#endif
+    }
+}
+
+common::TlsfAllocator::TlsfAllocator(uint64_t size, uint64_t granularity)
+    :granularity(granularity), totalUnits(granularity ? size / granularity : 0)
+{
+    if (granularity == 0 || totalUnits == 0) {
+        throw std::invalid_argument("TLSF range must hold at least one granule");
+    }
+    for (auto& fl : freeHeads) {
+        for (auto& head : fl) {
+            head = NIL;
+        }
+    }
+    uint32_t b = NewBlock();
+    blocks[b].offset = 0;
+    blocks[b].size = totalUnits;
+    InsertFree(b);
+}
+
+void common::TlsfAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < SL_COUNT) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+    }
+    else {
+        uint32_t msb = MostSignificantBit(size);
+        fl = msb - SL_COUNT_LOG2 + 1;
+        sl = static_cast<uint32_t>(size >> (msb - SL_COUNT_LOG2)) - SL_COUNT;
+    }
+}
+
+uint32_t common::TlsfAllocator::FindSuitable(uint64_t size) const
+{
+    //round up to the next class so that any block in the class we find is big enough
+    uint64_t rounded = size;
+    if (size >= SL_COUNT) {
+        rounded += (1ull << (MostSignificantBit(size) - SL_COUNT_LOG2)) - 1;
+    }
+    uint32_t fl, sl;
+    Mapping(rounded, fl, sl);
+    if (fl < FL_COUNT) {
+        uint32_t slMap = slBitmap[fl] & (~0u << sl);
+        if (slMap == 0) {
+            const uint64_t flMap = (fl + 1 < 64) ? (flBitmap & (~0ull << (fl + 1))) : 0;
+            if (flMap != 0) {
+                fl = LeastSignificantBit(flMap);
+                slMap = slBitmap[fl];
+            }
+        }
+        if (slMap != 0) {
+            return freeHeads[fl][LeastSignificantBit(slMap)];
+        }
+    }
+    //nothing in the classes above: a block of the class of size itself may still be big enough, like the
+    //single block of an empty heap when all of it is asked for
+    Mapping(size, fl, sl);
+    for (uint32_t b = freeHeads[fl][sl]; b != NIL; b = blocks[b].nextFree) {
+        if (blocks[b].size >= size) {
+            return b;
+        }
+    }
+    return NIL;
+}
+
+uint64_t common::TlsfAllocator::Allocate(uint64_t size)
+{
+    if (size == 0) {
+        return INVALID_OFFSET;
+    }
+    const uint64_t units = (size + granularity - 1) / granularity;
+    if (units > totalUnits) {
+        return INVALID_OFFSET;
+    }
+    uint32_t b = FindSuitable(units);
+    if (b == NIL) {
+        return INVALID_OFFSET;
+    }
+    RemoveFree(b);
+    //split the tail off as a new free block
+    if (blocks[b].size > units) {
+        uint32_t rest = NewBlock(); //can reallocate the vector, don't hold references across it
+        blocks[rest].offset = blocks[b].offset + units;
+        blocks[rest].size = blocks[b].size - units;
+        blocks[rest].prevPhys = b;
+        blocks[rest].nextPhys = blocks[b].nextPhys;
+        if (blocks[b].nextPhys != NIL) {
+            blocks[blocks[b].nextPhys].prevPhys = rest;
+        }
+        blocks[b].nextPhys = rest;
+        blocks[b].size = units;
+        InsertFree(rest);
+    }
+    blocks[b].free = false;
+    allocated[blocks[b].offset] = b;
+    usedUnits += units;
+    allocationCount++;
+    return blocks[b].offset * granularity;
+}
+
+void common::TlsfAllocator::Free(uint64_t offset)
+{
+    auto it = allocated.find(offset / granularity);
+    if (offset % granularity != 0 || it == allocated.end()) {
+        throw std::runtime_error("TLSF free of an offset that isn't allocated");
+    }
+    uint32_t b = it->second;
+    allocated.erase(it);
+    usedUnits -= blocks[b].size;
+    allocationCount--;
+    //merge with the previous block
+    uint32_t prev = blocks[b].prevPhys;
+    if (prev != NIL && blocks[prev].free) {
+        RemoveFree(prev);
+        blocks[prev].size += blocks[b].size;
+        blocks[prev].nextPhys = blocks[b].nextPhys;
+        if (blocks[b].nextPhys != NIL) {
+            blocks[blocks[b].nextPhys].prevPhys = prev;
+        }
+        DeleteBlock(b);
+        b = prev;
+    }
+    //merge with the next block
+    uint32_t next = blocks[b].nextPhys;
+    if (next != NIL && blocks[next].free) {
+        RemoveFree(next);
+        blocks[b].size += blocks[next].size;
+        blocks[b].nextPhys = blocks[next].nextPhys;
+        if (blocks[next].nextPhys != NIL) {
+            blocks[blocks[next].nextPhys].prevPhys = b;
+        }
+        DeleteBlock(next);
+    }
+    InsertFree(b);
+}
+
+uint64_t common::TlsfAllocator::GetLargestFreeRegion() const
+{
+    if (flBitmap == 0) {
+        return 0;
+    }
+    //the biggest blocks are in the highest non empty class, but inside the class they aren't sorted
+    const uint32_t fl = MostSignificantBit(flBitmap);
+    const uint32_t sl = MostSignificantBit(slBitmap[fl]);
+    uint64_t largest = 0;
+    for (uint32_t b = freeHeads[fl][sl]; b != NIL; b = blocks[b].nextFree) {
+        if (blocks[b].size > largest) {
+            largest = blocks[b].size;
+        }
+    }
+    return largest * granularity;
+}
+
+uint32_t common::TlsfAllocator::GetFreeRegionCount() const
+{
+    uint32_t count = 0;
+    for (uint32_t fl = 0; fl < FL_COUNT; fl++) {
+        for (uint32_t sl = 0; sl < SL_COUNT; sl++) {
+            for (uint32_t b = freeHeads[fl][sl]; b != NIL; b = blocks[b].nextFree) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+float common::TlsfAllocator::GetFragmentation() const
+{
+    const uint64_t freeBytes = GetSize() - GetUsed();
+    if (freeBytes == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(GetLargestFreeRegion()) / static_cast<float>(freeBytes);
+}
+
+bool common::TlsfAllocator::Validate() const
+{
+    //find the first physical block
+    uint32_t first = NIL;
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b].size != 0 && blocks[b].offset == 0) {
+            first = b;
+        }
+    }
+    if (first == NIL || blocks[first].prevPhys != NIL) {
+        return false;
+    }
+    uint64_t expectedOffset = 0;
+    uint64_t used = 0;
+    uint64_t count = 0;
+    uint32_t freeBlocks = 0;
+    bool previousWasFree = false;
+    for (uint32_t b = first; b != NIL; b = blocks[b].nextPhys) {
+        const Block& block = blocks[b];
+        if (block.offset != expectedOffset || block.size == 0) {
+            return false;
+        }
+        if (block.nextPhys != NIL && blocks[block.nextPhys].prevPhys != b) {
+            return false;
+        }
+        if (block.free) {
+            //two free neighbours should have been merged
+            if (previousWasFree) {
+                return false;
+            }
+            freeBlocks++;
+        }
+        else {
+            auto it = allocated.find(block.offset);
+            if (it == allocated.end() || it->second != b) {
+                return false;
+            }
+            used += block.size;
+            count++;
+        }
+        previousWasFree = block.free;
+        expectedOffset += block.size;
+    }
+    if (expectedOffset != totalUnits || used != usedUnits || count != allocationCount ||
+        count != allocated.size()) {
+        return false;
+    }
+    //every free block must be in the list of its class, and the bitmaps must agree with the lists
+    uint32_t listed = 0;
+    for (uint32_t fl = 0; fl < FL_COUNT; fl++) {
+        for (uint32_t sl = 0; sl < SL_COUNT; sl++) {
+            const bool bit = (slBitmap[fl] & (1u << sl)) != 0;
+            if (bit != (freeHeads[fl][sl] != NIL)) {
+                return false;
+            }
+            for (uint32_t b = freeHeads[fl][sl]; b != NIL; b = blocks[b].nextFree) {
+                uint32_t bfl, bsl;
+                Mapping(blocks[b].size, bfl, bsl);
+                if (!blocks[b].free || bfl != fl || bsl != sl) {
+                    return false;
+                }
+                listed++;
+            }
+        }
+        if (((flBitmap >> fl) & 1ull) != (slBitmap[fl] != 0 ? 1ull : 0ull)) {
+            return false;
+        }
+    }
+    return listed == freeBlocks;
+}
+
+void common::TlsfAllocator::InsertFree(uint32_t b)
+{
+    uint32_t fl, sl;
+    Mapping(blocks[b].size, fl, sl);
+    blocks[b].free = true;
+    blocks[b].prevFree = NIL;
+    blocks[b].nextFree = freeHeads[fl][sl];
+    if (freeHeads[fl][sl] != NIL) {
+        blocks[freeHeads[fl][sl]].prevFree = b;
+    }
+    freeHeads[fl][sl] = b;
+    flBitmap |= (1ull << fl);
+    slBitmap[fl] |= (1u << sl);
+}
+
+void common::TlsfAllocator::RemoveFree(uint32_t b)
+{
+    uint32_t fl, sl;
+    Mapping(blocks[b].size, fl, sl);
+    if (blocks[b].prevFree != NIL) {
+        blocks[blocks[b].prevFree].nextFree = blocks[b].nextFree;
+    }
+    else {
+        freeHeads[fl][sl] = blocks[b].nextFree;
+    }
+    if (blocks[b].nextFree != NIL) {
+        blocks[blocks[b].nextFree].prevFree = blocks[b].prevFree;
+    }
+    blocks[b].prevFree = NIL;
+    blocks[b].nextFree = NIL;
+    blocks[b].free = false;
+    if (freeHeads[fl][sl] == NIL) {
+        slBitmap[fl] &= ~(1u << sl);
+        if (slBitmap[fl] == 0) {
+            flBitmap &= ~(1ull << fl);
+        }
+    }
+}
+
+uint32_t common::TlsfAllocator::NewBlock()
+{
+    if (!unusedBlocks.empty()) {
+        uint32_t b = unusedBlocks.back();
+        unusedBlocks.pop_back();
+        blocks[b] = Block{};
+        return b;
+    }
+    blocks.emplace_back();
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void common::TlsfAllocator::DeleteBlock(uint32_t b)
+{
+    blocks[b] = Block{};
+    unusedBlocks.push_back(b);
+}
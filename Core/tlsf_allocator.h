@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace common
+{
+	/// <summary>
+	/// Two level segregated fit allocator for a single range of memory. It only does the bookkeeping
+	/// (offsets and sizes), the memory itself lives somewhere else (an ID3D12Heap for instance), so it
+	/// doesn't depend on d3d and can run anywhere.
+	/// Every size and offset is a multiple of the granularity, that's how alignment is guaranteed:
+	/// heaps with different alignment needs use different allocators.
+	/// Allocate and Free are O(1), except for an Allocate that only fits in a block of its own size class,
+	/// which walks the free list of that class.
+	/// </summary>
+	class TlsfAllocator
+	{
+	public:
+		static constexpr uint64_t INVALID_OFFSET = ~0ull;
+		TlsfAllocator(uint64_t size, uint64_t granularity);
+		/// <summary>
+		/// Returns the offset in bytes or INVALID_OFFSET if there is no free region big enough.
+		/// </summary>
+		uint64_t Allocate(uint64_t size);
+		/// <summary>
+		/// Frees the allocation that starts at offset, merging it with its free neighbours.
+		/// </summary>
+		void Free(uint64_t offset);
+		/// <summary>
+		/// Size in bytes that an allocation of size really takes.
+		/// </summary>
+		uint64_t AlignedSize(uint64_t size) const { return ((size + granularity - 1) / granularity) * granularity; }
+		uint64_t GetSize() const { return totalUnits * granularity; }
+		uint64_t GetGranularity() const { return granularity; }
+		uint64_t GetUsed() const { return usedUnits * granularity; }
+		uint64_t GetAllocationCount() const { return allocationCount; }
+		bool IsEmpty() const { return allocationCount == 0; }
+		uint64_t GetLargestFreeRegion() const;
+		uint32_t GetFreeRegionCount() const;
+		/// <summary>
+		/// 0 when all the free memory is a single region, tends to 1 when it's spread in many small holes.
+		/// </summary>
+		float GetFragmentation() const;
+		/// <summary>
+		/// Walks the whole structure checking every invariant. For debugging and fuzzing, it's O(n).
+		/// </summary>
+		bool Validate() const;
+	private:
+		static constexpr uint32_t SL_COUNT_LOG2 = 4;
+		static constexpr uint32_t SL_COUNT = 1u << SL_COUNT_LOG2;
+		static constexpr uint32_t FL_COUNT = 64 - SL_COUNT_LOG2 + 1;
+		static constexpr uint32_t NIL = ~0u;
+		struct Block {
+			uint64_t offset = 0; //in units
+			uint64_t size = 0; //in units
+			uint32_t prevPhys = NIL;
+			uint32_t nextPhys = NIL;
+			uint32_t prevFree = NIL;
+			uint32_t nextFree = NIL;
+			bool free = false;
+		};
+		static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+		uint32_t FindSuitable(uint64_t size) const;
+		void InsertFree(uint32_t b);
+		void RemoveFree(uint32_t b);
+		uint32_t NewBlock();
+		void DeleteBlock(uint32_t b);
+
+		const uint64_t granularity;
+		const uint64_t totalUnits;
+		uint64_t usedUnits = 0;
+		uint64_t allocationCount = 0;
+		uint64_t flBitmap = 0;
+		uint32_t slBitmap[FL_COUNT] = {};
+		uint32_t freeHeads[FL_COUNT][SL_COUNT];
+		std::vector<Block> blocks;
+		std::vector<uint32_t> unusedBlocks;
+		//offset in units -> block, only for allocated blocks
+		std::unordered_map<uint64_t, uint32_t> allocated;
+	};
+}
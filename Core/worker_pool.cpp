@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "worker_pool.h"
+
+common::WorkerPool::WorkerPool(uint32_t workerCount)
+{
+    threads.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        threads.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+common::WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+uint32_t common::WorkerPool::DefaultWorkerCount()
+{
+    const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void common::WorkerPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+{
+    if (count == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> serialize(parallelForMutex);
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->count = count;
+    job->remaining = count;
+    //a single task isn't worth waking anybody
+    if (count > 1 && !threads.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = job;
+            generation++;
+        }
+        wakeWorkers.notify_all();
+    }
+    Work(*job);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobDone.wait(lock, [&job]() { return job->remaining.load() == 0; });
+        currentJob = nullptr;
+    }
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+void common::WorkerPool::WorkerLoop()
+{
+    uint64_t seenGeneration = 0;
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [this, &seenGeneration]() { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+            job = currentJob;
+        }
+        if (job != nullptr) {
+            Work(*job);
+        }
+    }
+}
+
+void common::WorkerPool::Work(Job& job)
+{
+    while (true) {
+        const uint32_t i = job.next.fetch_add(1);
+        if (i >= job.count) {
+            return;
+        }
+        try {
+            (*job.task)(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(job.errorMutex);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+        }
+        if (job.remaining.fetch_sub(1) == 1) {
+            //the last one wakes the caller. Taking the lock makes sure it's either waiting or will see remaining == 0
+            std::lock_guard<std::mutex> lock(mutex);
+            jobDone.notify_all();
+        }
+    }
+}
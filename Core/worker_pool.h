@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace common
+{
+	/// <summary>
+	/// A fixed set of worker threads for fork-join work: ParallelFor hands out the indices to the workers
+	/// and to the calling thread, and returns when all of them ran. One ParallelFor at a time.
+	/// </summary>
+	class WorkerPool
+	{
+	public:
+		/// <summary>
+		/// workerCount threads besides the caller. 0 is valid, then ParallelFor runs everything on the caller.
+		/// </summary>
+		explicit WorkerPool(uint32_t workerCount = DefaultWorkerCount());
+		~WorkerPool();
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+		/// <summary>
+		/// One less than the hardware threads, the caller is the last one.
+		/// </summary>
+		static uint32_t DefaultWorkerCount();
+		/// <summary>
+		/// Runs task(i) for every i in [0, count), in any order and on any thread. If tasks throw, the
+		/// first exception is rethrown after all tasks finished.
+		/// </summary>
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(threads.size()); }
+		/// <summary>
+		/// How many tasks can run at the same time, the workers plus the caller.
+		/// </summary>
+		uint32_t GetConcurrency() const { return GetWorkerCount() + 1; }
+	private:
+		struct Job
+		{
+			const std::function<void(uint32_t)>* task = nullptr;
+			uint32_t count = 0;
+			std::atomic<uint32_t> next = 0;
+			std::atomic<uint32_t> remaining = 0;
+			std::exception_ptr error;
+			std::mutex errorMutex;
+		};
+		void WorkerLoop();
+		void Work(Job& job);
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable wakeWorkers;
+		std::condition_variable jobDone;
+		//workers keep their own reference, a late one may still look at a job that already finished
+		std::shared_ptr<Job> currentJob;
+		uint64_t generation = 0;
+		bool stopping = false;
+		std::mutex parallelForMutex;
+	};
+}
@@ -1,7 +1,7 @@
 #include "pch.h"
 #include "../Common/window.h"
 #include "../Common/mesh.h"
-#include "../Common/mesh_load.h"
+#include "../Core/mesh_load.h"
 #include "direct3d_context.h"
 #include "Pipeline.h"
 #include "view_projection.h"
@@ -2,7 +2,7 @@
 #include "../Common/d3d_utils.h"
 #include "pipeline.h"
 #include "view_projection.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
 using Microsoft::WRL::ComPtr;
 namespace common
 {
@@ -23,7 +23,7 @@
 #include <unordered_map>
 #include <filesystem>
 
-#include "../Common/vertex.h"
+#include "../Core/vertex.h"
 constexpr int FRAMEBUFFER_COUNT = 2;
 constexpr bool FULLSCREEN = false;
 
@@ -12,9 +12,9 @@
 #include "../Common/mesh.h"
 #include "model_matrix.h"
 #include "presentation_pipeline.h"
-#include "../Common/game_timer.h"
-#include "../Common/concatenate.h"
-#include "../Common/mathutils.h"
+#include "../Core/game_timer.h"
+#include "../Core/concatenate.h"
+#include "../Core/mathutils.h"
 #include "instanced_transform_pipeline.h"
 #include "instance_index.h"
 #include "../Common/data_buffer.h"
@@ -1,7 +1,7 @@
 #include "presentation_pipeline.h"
 #include "../Common/d3d_utils.h"
 #include "../Common/mesh.h"
-#include "../Common/mesh_load.h"
+#include "../Core/mesh_load.h"
 #include "../Common/input_layout_service.h"
 using Microsoft::WRL::ComPtr;
 
@@ -1,7 +1,7 @@
 #include "swapchain.h"
 #include "../Common/d3d_utils.h"
 #include "dx_context.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
 rtt::Swapchain::Swapchain(HWND hwnd, int w, int h, DxContext& ctx):
     rtvDescriptorSize(ctx.RtvDescriptorSize())
 {
@@ -0,0 +1,256 @@
+#include "../Core/camera_input_handler.h"
+#include "../Core/components.h"
+#include "../Core/cpu_profiler.h"
+#include "../Core/cpu_uniform_buffer.h"
+#include "../Core/delta_timer.h"
+#include "../Core/frame_capture.h"
+#include "../Core/frame_stats.h"
+#include "../Core/frame_systems.h"
+#include "../Core/point_light_shadow_camera.h"
+#include "../Core/point_shadow_draw.h"
+#include "../Core/recording_gfx_device.h"
+#include "../Core/recording_plan.h"
+#include "../Core/scene_import.h"
+#include "../Core/system_scheduler.h"
+#include "../Core/timing_report.h"
+#include "../Core/worker_pool.h"
+#include "../Core/parallel_command_recorder.h"
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    //what TransformsAndManyObjects runs with: the camera ratio of its window, its frames in flight and buffer sizes
+    constexpr float ASPECT_RATIO = 1024.0f / 768.0f;
+    constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+    constexpr uint32_t MAX_NUMBER_OF_OBJ = 10000;
+    typedef std::shared_ptr<transforms::components::BSDFMaterial> BSDFMaterial_t;
+    typedef std::shared_ptr<transforms::PointLightShadowCamera> ShadowMap_t;
+
+    struct ReplaySettings
+    {
+        std::string replayPath;
+        std::string scenePath = "assets/Map.glb";
+        /// <summary>
+        /// In seconds, 0 replays the captured time steps.
+        /// </summary>
+        float fixedDeltaTime = 1.0f / 60.0f;
+        std::string timingsPath;
+        bool dumpSchedule = false;
+        std::string compareBaselinePath;
+        std::string compareCurrentPath;
+    };
+
+    /// <summary>
+    /// Replays a capture through the cpu side of the frame: scripts, transforms, uniform uploads and command
+    /// recording on the recording backend. Returns the process exit code, 3 if the replay diverged from the capture.
+    /// </summary>
+    int RunHeadlessReplay(const ReplaySettings& settings, common::FrameReplay& replay)
+    {
+        using namespace transforms::components;
+        entt::registry registry;
+        //what the gpu path gives the entities, without the resources: draws from null buffers, shadow maps without textures
+        uint32_t uniformBufferId = 0;
+        transforms::ImportScene(registry, settings.scenePath,
+            [&registry, &uniformBufferId](entt::entity e, const common::MeshData& md) {
+                Renderable renderable;
+                renderable.uniformBufferId = uniformBufferId++;
+                renderable.mNumberOfIndices = static_cast<int>(md.indices.size());
+                registry.emplace<Renderable>(e, renderable);
+            });
+        entt::entity mainCamera = transforms::CreateMainCamera(registry, ASPECT_RATIO);
+        transforms::KeyCodes frameKey = transforms::KeyCodes::None;
+        CreateCameraInputHandler([&frameKey]() { return frameKey; }, registry, mainCamera);
+        int shadowMapId = 0;
+        registry.view<PointLight, Transform>().each([&registry, &shadowMapId](entt::entity e, PointLight&, Transform&) {
+            registry.emplace<ShadowMap_t>(e, std::make_shared<transforms::PointLightShadowCamera>());
+            shadowMapId++;
+        });
+        transforms::CpuUniformBuffer<transforms::PerObjectData> perObjectBuffer(FRAMES_IN_FLIGHT, MAX_NUMBER_OF_OBJ);
+        transforms::CpuUniformBuffer<transforms::ShadowMapConstants> pointShadowBuffer(FRAMES_IN_FLIGHT, MAX_LIGHTS * 6);
+        transforms::CpuUniformBuffer<LightingData> lightingBuffer(FRAMES_IN_FLIGHT, MAX_LIGHTS);
+        transforms::CpuUniformBuffer<PerFrameDataForUnlitDebug> unlitDebugBuffer(FRAMES_IN_FLIGHT, 1);
+        transforms::CpuUniformBuffer<PerFrameDataForSimpleLighting> simpleLightingBuffer(FRAMES_IN_FLIGHT, 1);
+        common::gfx::RecordingDevice device;
+        common::WorkerPool workerPool;
+        common::ParallelCommandRecorder recorder(device, workerPool, FRAMES_IN_FLIGHT);
+        transforms::FrameState frame;
+        common::SystemScheduler scheduler(workerPool);
+        auto scriptRunner = std::make_shared<transforms::systems::ScriptRunner>();
+        scriptRunner->Register<CameraInputHandler>();
+        transforms::AddSimulationSystems(scheduler, registry, frame, scriptRunner);
+        transforms::AddLightingAndPerFrameUploadSystems<ShadowMap_t>(scheduler, registry, frame, &lightingBuffer,
+            &unlitDebugBuffer, &simpleLightingBuffer);
+        transforms::AddObjectAndShadowUploadSystems<ShadowMap_t>(scheduler, registry, frame, &perObjectBuffer,
+            &pointShadowBuffer);
+        if (settings.dumpSchedule) {
+            scheduler.WriteSchedule(std::cout);
+        }
+        common::CpuProfiler::Get().SetThreadName("main");
+        common::FrameStats frameStats;
+        common::DeltaTimer deltaTimer;
+        common::gfx::RecordingStats recordingStats;
+        while (replay.Advance()) {
+            const uint32_t frameIndex = static_cast<uint32_t>(replay.GetFrameNumber() % FRAMES_IN_FLIGHT);
+            frameKey = static_cast<transforms::KeyCodes>(replay.GetFrame().key);
+            frame.frameIndex = frameIndex;
+            frame.deltaTime = replay.GetDeltaTime();
+            {
+                PROFILE_SCOPE("FrameSystems");
+                scheduler.Run();
+            }
+            //WriteReplayResult says where it diverged, once the replay is over
+            replay.CheckState(transforms::HashScriptedState(registry));
+            auto renderables = registry.view<Renderable, Transform, BSDFMaterial_t>();
+            auto shadowProjectors = registry.view<Transform, PointLight, ShadowMap_t>();
+            std::vector<const Renderable*> drawList;
+            renderables.each([&drawList](entt::entity, const Renderable& renderable, const Transform&, const BSDFMaterial_t) {
+                drawList.push_back(&renderable);
+            });
+            size_t shadowFaces = 0;
+            shadowProjectors.each([&shadowFaces](entt::entity, Transform&, PointLight&, const ShadowMap_t&) {
+                shadowFaces += transforms::PointLightShadowCamera::FACE_COUNT;
+            });
+            //the same passes as the gpu frame, minus the bindings that need a device
+            constexpr uint64_t MIN_DRAWS_PER_LIST = 64;
+            const uint32_t maxSegments = workerPool.GetConcurrency();
+            common::RecordingPlan plan;
+            const uint32_t shadowPass = plan.AddParallelPass(
+                std::vector<uint64_t>(shadowFaces, drawList.size()), maxSegments, MIN_DRAWS_PER_LIST);
+            const uint32_t mainPass = plan.AddParallelPass(
+                std::vector<uint64_t>(drawList.size(), 1), maxSegments, MIN_DRAWS_PER_LIST);
+            std::vector<common::gfx::CommandList*> recordedLists;
+            {
+                PROFILE_SCOPE("RecordCommandLists");
+                recordedLists = recorder.Record(frameIndex, plan,
+                    [&](const common::RecordingSegment& segment, common::gfx::CommandList& list) {
+                        using namespace transforms::_PointShadowCalculationSystem;
+                        if (segment.pass == shadowPass) {
+                            PROFILE_SCOPE("ShadowRecording");
+                            for (uint32_t item = segment.firstItem; item < segment.firstItem + segment.itemCount; item++) {
+                                BeginCubeMapEvent(item % transforms::PointLightShadowCamera::FACE_COUNT, list);
+                                SetViewport(list);
+                                for (const Renderable* renderable : drawList) {
+                                    DrawForShadow(*renderable, list, item);
+                                }
+                                list.EndEvent();
+                            }
+                        }
+                        else if (segment.pass == mainPass) {
+                            PROFILE_SCOPE("MainPassRecording");
+                            list.BeginEvent(L"MainRenderPass");
+                            for (uint32_t item = segment.firstItem; item < segment.firstItem + segment.itemCount; item++) {
+                                const Renderable* renderable = drawList[item];
+                                list.SetVertexBuffer(renderable->mVertexBufferView);
+                                list.SetIndexBuffer(renderable->mIndexBufferView);
+                                list.SetGraphicsRoot32BitConstant(1, renderable->uniformBufferId, 0);
+                                list.DrawIndexedInstanced(renderable->mNumberOfIndices, 1, 0, 0, 0);
+                            }
+                            list.EndEvent();
+                        }
+                    });
+            }
+            recordingStats += common::gfx::SumRecordingStats(recordedLists);
+            frameStats.AddFrame(deltaTimer.GetDelta() * 1000.0);
+            common::CpuProfiler::Get().EndFrame();
+        }
+        const common::FrameStatsSummary summary = frameStats.GetSummary();
+        std::cout << "Headless replay: " << summary.frameCount << " frames, " << uniformBufferId << " objects, " << shadowMapId
+            << " lights, " << recordingStats.draws << " draws recorded; frame mean " << summary.meanMs << " ms, p50 "
+            << summary.p50Ms << " ms, p99 " << summary.p99Ms << " ms" << std::endl;
+        common::WriteReplayResult(std::cout, settings.replayPath, replay);
+        if (!settings.timingsPath.empty()) {
+            std::ofstream timings(settings.timingsPath);
+            common::WriteTimingReport(timings, common::MakeTimingReport(common::CpuProfiler::Get(), frameStats));
+            std::cout << "CPU timings written to " << settings.timingsPath << std::endl;
+        }
+        return replay.GetFirstDivergentFrame() < replay.GetFrameCount() ? 3 : 0;
+    }
+
+    /// <summary>
+    /// Prints the comparison of two timings files. Returns the process exit code, 2 if there were regressions.
+    /// </summary>
+    int CompareTimings(const ReplaySettings& settings)
+    {
+        common::TimingReport reports[2];
+        const std::string paths[2] = { settings.compareBaselinePath, settings.compareCurrentPath };
+        for (int i = 0; i < 2; i++) {
+            std::ifstream file(paths[i]);
+            if (!file) {
+                std::cerr << "Could not open " << paths[i] << std::endl;
+                return 1;
+            }
+            try {
+                reports[i] = common::ReadTimingReport(file);
+            }
+            catch (const std::runtime_error& e) {
+                std::cerr << paths[i] << ": " << e.what() << std::endl;
+                return 1;
+            }
+        }
+        return common::CompareTimingReports(std::cout, reports[0], reports[1]) > 0 ? 2 : 0;
+    }
+}
+
+/// <summary>
+/// Replays a capture of TransformsAndManyObjects (its --capture) without window nor gpu, on Core alone.
+/// Replay <capture> [options], it exits with 3 if the replay diverged from the capture
+/// --scene <file>      the scene the capture was made on, assets/Map.glb by default
+/// --fixed-dt <ms>     time step of the simulation, 60 steps per second by default, 0 replays the captured ones
+/// --timings <file>    writes the per scope cpu timings of the run at the end
+/// --dump-schedule     prints the stages of the frame systems, and what each one waits for
+/// Replay --compare <baseline> <current> compares two timings files instead, it exits with 2 on regressions.
+/// </summary>
+int main(int argc, char** argv)
+{
+    ReplaySettings settings;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue) {
+            settings.scenePath = argv[++i];
+        }
+        else if (arg == "--fixed-dt" && hasValue) {
+            settings.fixedDeltaTime = std::max(static_cast<float>(std::atof(argv[++i])), 0.0f) / 1000.0f;
+        }
+        else if (arg == "--timings" && hasValue) {
+            settings.timingsPath = argv[++i];
+        }
+        else if (arg == "--compare" && i + 2 < argc) {
+            settings.compareBaselinePath = argv[++i];
+            settings.compareCurrentPath = argv[++i];
+        }
+        else if (arg == "--dump-schedule") {
+            settings.dumpSchedule = true;
+        }
+        else if (settings.replayPath.empty() && arg.rfind("--", 0) != 0) {
+            settings.replayPath = arg;
+        }
+        else {
+            std::cerr << "unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (!settings.compareBaselinePath.empty()) {
+        return CompareTimings(settings);
+    }
+    if (settings.replayPath.empty()) {
+        std::cerr << "usage: Replay <capture> [--scene file] [--fixed-dt ms] [--timings file] [--dump-schedule]" << std::endl
+            << "       Replay --compare <baseline timings> <current timings>" << std::endl;
+        return 1;
+    }
+    std::optional<common::FrameCapture> capture = common::ReadCaptureFile(settings.replayPath, std::cerr);
+    if (!capture.has_value()) {
+        return 1;
+    }
+    common::FrameReplay replay(std::move(*capture), settings.fixedDeltaTime);
+    //the profiler statistics cover the whole replay
+    common::CpuProfiler::Get().SetFrameHistory(static_cast<uint32_t>(replay.GetFrameCount()));
+    try {
+        return RunHeadlessReplay(settings, replay);
+    }
+    catch (const std::runtime_error& e) {
+        std::cerr << settings.scenePath << ": " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -4,7 +4,10 @@
 #include "../common/swapchain.h"
 #include "../Common/offscreen_rtv.h"
 #include "dx_context.h"
-#include "../Common/mesh_load.h"
+#include "../Core/mesh_load.h"
+#include "../Core/animation_import.h"
+#include "../Core/delta_timer.h"
+#include "../Core/worker_pool.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -55,8 +58,12 @@ int main()
 	//TODO:	model matrix buffer, holds the model matrix for each game object
 	//TODO:	bones matrix buffer, holds the bones matrices for each game object
 	//TODO:	instance id buffer, holds the instance ids
-	window.mOnIdle = [](){
-		//TODO: advance animation based on delta time and update the bones matrix
+	common::DeltaTimer deltaTimer;
+	//the characters are animated in parallel, in groups that play the same clip
+	common::WorkerPool workerPool;
+	window.mOnIdle = [&worldRegistry, &deltaTimer, &workerPool](){
+		//advance the animations and update the skin matrices of each instance
+		skinning::AnimateSkeletons(workerPool, worldRegistry, deltaTimer.GetDelta());
 		//TODO: for each game object update it's model matrix data
 	};
 
@@ -90,7 +97,9 @@ void LoadCapoeira(skinning::DxContext& context, entt::registry& registry)
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile("assets/capoeira.glb", aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_LimitBoneWeights);
 	//load the bones
-	aiNode* armatureRoot = skinning::io::FindArmatureRoot(scene->mRootNode, scene);
+	//the bones of the scene by name, once, instead of a search of all the bones per node
+	const common::SceneBoneIndex boneIndex(*scene);
+	aiNode* armatureRoot = skinning::io::FindArmatureRoot(boneIndex);
 	assert(armatureRoot);
 	std::unordered_map<std::string, entt::entity> boneMap;
 	ProcessNode(armatureRoot, registry, entt::null, scene, boneMap);
@@ -147,30 +156,6 @@ void ProcessNode(aiNode* node, entt::registry& registry, entt::entity parentEnti
 		ProcessNode(node->mChildren[i], registry, currentEntity, scene, boneMap);
 	}
 }
-aiNode* FindArmatureRoot(aiNode* rootNode, const aiScene* scene) {
-	// Traverse the node hierarchy to find the armature root
-	for (unsigned int i = 0; i < rootNode->mNumChildren; i++) {
-		aiNode* child = rootNode->mChildren[i];
-
-		// Check if this child references any bones in the meshes
-		for (unsigned int j = 0; j < scene->mNumMeshes; j++) {
-			aiMesh* mesh = scene->mMeshes[j];
-			for (unsigned int k = 0; k < mesh->mNumBones; k++) {
-				if (std::string(mesh->mBones[k]->mName.C_Str()) == std::string(child->mName.C_Str())) {
-					return child; // Found the armature root
-				}
-			}
-		}
-
-		// Recursively check children
-		aiNode* result = FindArmatureRoot(child, scene);
-		if (result) {
-			return result;
-		}
-	}
-	return nullptr; // No armature root found
-}
-
 // Utility function to load all animations and assign them to entities
 void LoadAnimations(const aiScene* scene, entt::registry& registry,
 	const std::unordered_map<std::string, entt::entity>& boneMap) {
@@ -182,14 +167,13 @@ void LoadAnimations(const aiScene* scene, entt::registry& registry,
 	// Iterate over all animations in the file
 	for (unsigned int i = 0; i < scene->mNumAnimations; ++i) {
 		const aiAnimation* aiAnim = scene->mAnimations[i];
+		// Translation, rotation and scale keys each go to their own track, in seconds
+		common::AnimationClip clip = common::ImportAnimation(*aiAnim);
 
 		// Process each bone's animation channel
-		for (unsigned int j = 0; j < aiAnim->mNumChannels; ++j) {
-			const aiNodeAnim* aiNodeAnim = aiAnim->mChannels[j];
-			std::string boneName = aiNodeAnim->mNodeName.C_Str();
-
+		for (common::AnimationChannel& channel : clip.channels) {
 			// Find the corresponding bone entity in the ECS
-			auto it = boneMap.find(boneName);
+			auto it = boneMap.find(channel.nodeName);
 			if (it == boneMap.end()) {
 				// Bone not found in the ECS registry (skip it)
 				continue;
@@ -203,128 +187,7 @@ void LoadAnimations(const aiScene* scene, entt::registry& registry,
 			// Set global animation properties
 			animation.duration = static_cast<float>(aiAnim->mDuration);
 			animation.ticksPerSecond = static_cast<float>(aiAnim->mTicksPerSecond != 0.0 ? aiAnim->mTicksPerSecond : 25.0);
-
-			// Process position keyframes
-			for (unsigned int k = 0; k < aiNodeAnim->mNumPositionKeys; ++k) {
-				const aiVectorKey& key = aiNodeAnim->mPositionKeys[k];
-				animation.keyframes.push_back({
-					static_cast<float>(key.mTime),
-					DirectX::XMFLOAT3(key.mValue.x, key.mValue.y, key.mValue.z), // Position
-					DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f),                         // Default scale
-					DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f)                  // Default rotation
-					});
-			}
-
-			// Process rotation keyframes
-			for (unsigned int k = 0; k < aiNodeAnim->mNumRotationKeys; ++k) {
-				const aiQuatKey& key = aiNodeAnim->mRotationKeys[k];
-				DirectX::XMFLOAT4 rotation(key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w);
-
-				// Match keyframe time to an existing keyframe or add a new one
-				auto it = std::find_if(animation.keyframes.begin(), animation.keyframes.end(),
-					[&key](const Keyframe& kf) {
-						return std::abs(kf.time - static_cast<float>(key.mTime)) < 0.001f;
-					});
-				if (it != animation.keyframes.end()) {
-					it->rotation = rotation; // Update existing keyframe
-				}
-				else {
-					animation.keyframes.push_back({
-						static_cast<float>(key.mTime),
-						DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), // Default position
-						DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), // Default scale
-						rotation                             // Rotation
-						});
-				}
-			}
-
-			// Process scaling keyframes
-			for (unsigned int k = 0; k < aiNodeAnim->mNumScalingKeys; ++k) {
-				const aiVectorKey& key = aiNodeAnim->mScalingKeys[k];
-				DirectX::XMFLOAT3 scale(key.mValue.x, key.mValue.y, key.mValue.z);
-
-				// Match keyframe time to an existing keyframe or add a new one
-				auto it = std::find_if(animation.keyframes.begin(), animation.keyframes.end(),
-					[&key](const Keyframe& kf) {
-						return std::abs(kf.time - static_cast<float>(key.mTime)) < 0.001f;
-					});
-				if (it != animation.keyframes.end()) {
-					it->scale = scale; // Update existing keyframe
-				}
-				else {
-					animation.keyframes.push_back({
-						static_cast<float>(key.mTime),
-						DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), // Default position
-						scale,                               // Scale
-						DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) // Default rotation
-						});
-				}
-			}
-
-			// Sort keyframes by time to ensure smooth interpolation
-			std::sort(animation.keyframes.begin(), animation.keyframes.end(),
-				[](const Keyframe& a, const Keyframe& b) {
-					return a.time < b.time;
-				});
-		}
-
-
-
-	}
-}
-
-entt::entity skinning::io::clone_root_hierarchy(entt::registry& registry, entt::entity root) {
-	// Verify this is actually a root node (no parent)
-	if (registry.any_of<Parent>(root)) {
-		throw std::runtime_error("Attempted to clone hierarchy from non-root entity");
-	}
-
-	return skinning::io::clone_hierarchy(registry, root);
-}
-
-entt::entity skinning::io::clone_hierarchy(entt::registry& registry, entt::entity source) {
-	// Create new entity with transform
-	entt::entity new_entity = skinning::io::clone_entity_with_transform(registry, source);
-
-	// If source has children, clone them recursively
-	if (auto* children = registry.try_get<Children>(source)) {
-		std::vector<entt::entity> new_children;
-		new_children.reserve(children->children.size());
-
-		// Clone each child
-		for (auto child : children->children) {
-			entt::entity new_child = skinning::io::clone_hierarchy(registry, child);
-
-			// Set up parent-child relationship
-			registry.emplace_or_replace<Parent>(new_child, new_entity);
-			new_children.push_back(new_child);
-		}
-
-		// Add Children component to new entity
-		if (!new_children.empty()) {
-			registry.emplace<Children>(new_entity, std::move(new_children));
+			animation.tracks = std::move(channel.tracks);
 		}
 	}
-
-	return new_entity;
 }
-
-entt::entity skinning::io::clone_entity_with_transform(entt::registry& registry, entt::entity source) {
-	auto new_entity = registry.create();
-
-	// Clone transform if it exists
-	if (auto* transform = registry.try_get<Transform>(source)) {
-		registry.emplace<Transform>(new_entity, *transform);
-	}
-	// Clone TPose it it exists
-	if (auto* tpose = registry.try_get<TPoseMatrix>(source))
-	{
-		registry.emplace<TPoseMatrix>(new_entity, *tpose);
-	}
-	// clone BoneId if it exists
-	if (auto* boneId = registry.try_get<BoneId>(source))
-	{
-		registry.emplace<BoneId>(new_entity, *boneId);
-	}
-	return new_entity;
-}
\ No newline at end of file
@@ -1,5 +1,10 @@
 #pragma once
-#include "pch.h"
+#include <DirectXMath.h>
+#include <entt/entt.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../Core/animation_track.h"
 
 namespace skinning
 {
@@ -47,7 +52,7 @@ namespace skinning
     struct Animation {
         float duration;  // Total duration of the animation in ticks
         float ticksPerSecond;  // Playback speed in ticks per second (default 25 if undefined)
-        std::vector<Keyframe> keyframes; // List of keyframes for this bone
+        common::TransformTracks tracks; // Translation, rotation and scale keys of this bone
         float currentTime;               // Current position in the animation (in seconds)
         bool looping;                    // Whether the animation should loop
         // Constructor
@@ -55,60 +60,67 @@ namespace skinning
         // Reset the animation state
         void Reset() {
             currentTime = 0.0f;
+            cursors = {};
         }
         // Update animation time (call this per frame)
         void Update(float deltaTime) {
             currentTime += deltaTime;
-            if (looping && !keyframes.empty()) {
-                float duration = keyframes.back().time; // Last keyframe's time
-                if (currentTime > duration) {
-                    currentTime = fmod(currentTime, duration);
+            const float endTime = tracks.GetEndTime();
+            if (looping && endTime > 0 && currentTime > endTime) {
+                //a frame is shorter than the clip, the fmod is only for the huge steps
+                currentTime -= endTime;
+                if (currentTime > endTime) {
+                    currentTime = fmod(currentTime, endTime);
                 }
             }
         }
-        // Get the interpolated transform at the current time
-        DirectX::XMMATRIX GetTransform() const {
-            if (keyframes.empty()) {
-                return DirectX::XMMatrixIdentity(); // No keyframes, return identity
-            }
-            // Find the two keyframes surrounding the current time
-            const Keyframe* prevKeyframe = nullptr;
-            const Keyframe* nextKeyframe = nullptr;
-            for (size_t i = 0; i < keyframes.size(); ++i) {
-                if (keyframes[i].time >= currentTime) {
-                    nextKeyframe = &keyframes[i];
-                    if (i > 0) {
-                        prevKeyframe = &keyframes[i - 1];
-                    }
-                    else {
-                        prevKeyframe = &keyframes[0];
-                    }
-                    break;
-                }
+        /// <summary>
+        /// Resamples the tracks at sampleRate samples per second, then sampling is an index computation
+        /// instead of a search. Call again if the tracks change.
+        /// </summary>
+        void Bake(float sampleRate) {
+            baked = common::Resample(tracks, sampleRate);
+        }
+        // Get the interpolated translation, rotation and scale at the current time
+        void Sample(DirectX::XMVECTOR& position, DirectX::XMVECTOR& rotation, DirectX::XMVECTOR& scale) {
+            if (baked) {
+                common::SampleTransform(*baked, currentTime, position, rotation, scale);
             }
-            if (!prevKeyframe || !nextKeyframe) {
-                return DirectX::XMMatrixIdentity(); // Edge case: no valid keyframes
+            else {
+                common::SampleTransform(tracks, currentTime, cursors, position, rotation, scale);
             }
-            // Interpolation factor (time between the two keyframes)
-            float t = (currentTime - prevKeyframe->time) /
-                (nextKeyframe->time - prevKeyframe->time);
-            // Interpolate position, scale, and rotation
-            DirectX::XMVECTOR pos = DirectX::XMVectorLerp(
-                DirectX::XMLoadFloat3(&prevKeyframe->position),
-                DirectX::XMLoadFloat3(&nextKeyframe->position), t);
-            DirectX::XMVECTOR scale = DirectX::XMVectorLerp(
-                DirectX::XMLoadFloat3(&prevKeyframe->scale),
-                DirectX::XMLoadFloat3(&nextKeyframe->scale), t);
-            DirectX::XMVECTOR rot = DirectX::XMQuaternionSlerp(
-                DirectX::XMLoadFloat4(&prevKeyframe->rotation),
-                DirectX::XMLoadFloat4(&nextKeyframe->rotation), t);
+        }
+        // Get the interpolated transform at the current time
+        DirectX::XMMATRIX GetTransform() {
+            DirectX::XMVECTOR pos, rot, scale;
+            Sample(pos, rot, scale);
             // Construct the transform matrix
             return DirectX::XMMatrixScalingFromVector(scale) *
                 DirectX::XMMatrixRotationQuaternion(rot) *
                 DirectX::XMMatrixTranslationFromVector(pos);
         }
+    private:
+        //where each track was sampled last, so that playing forward doesn't search from the first key
+        common::TransformCursors cursors;
+        std::optional<common::UniformTransformTracks> baked;
     };
 
+    /// <summary>
+    /// Splits keyframes that have all three channels into tracks, one key per keyframe in each.
+    /// </summary>
+    inline common::TransformTracks MakeTracks(const std::vector<Keyframe>& keyframes) {
+        common::TransformTracks tracks;
+        for (const Keyframe& keyframe : keyframes) {
+            tracks.position.times.push_back(keyframe.time);
+            tracks.position.values.push_back(keyframe.position);
+            tracks.rotation.times.push_back(keyframe.time);
+            tracks.rotation.values.push_back(keyframe.rotation);
+            tracks.scale.times.push_back(keyframe.time);
+            tracks.scale.values.push_back(keyframe.scale);
+        }
+        return tracks;
+    }
+
     // Utility function to update a Bone component from an Animation component
     static void UpdateBoneFromAnimation(entt::registry& registry, entt::entity entity) {
         // Ensure the entity has both Animation and Bone components
@@ -119,15 +131,13 @@ namespace skinning
         auto& animation = registry.get<Animation>(entity);
         auto& bone = registry.get<Bone>(entity);
 
-        // Get the interpolated transform from the Animation component
-        DirectX::XMMATRIX transform = animation.GetTransform();
-
-        // Decompose the matrix into position, scale, and rotation
+        // Sample the translation, rotation and scale straight from the tracks, no matrix to decompose
         DirectX::XMVECTOR scale, rotation, position;
-        DirectX::XMMatrixDecompose(&scale, &rotation, &position, transform);
+        animation.Sample(position, rotation, scale);
 
         // Update the Bone component
-        bone.offsetMatrix = transform; // Store the full matrix
+        bone.offsetMatrix = DirectX::XMMatrixScalingFromVector(scale) * DirectX::XMMatrixRotationQuaternion(rotation) *
+            DirectX::XMMatrixTranslationFromVector(position); // Store the full matrix
         DirectX::XMStoreFloat3(&bone.localPosition, position);   // Update position
         DirectX::XMStoreFloat3(&bone.localScale, scale);         // Update scale
         bone.localRotation = rotation;                          // Update rotation as XMVECTOR
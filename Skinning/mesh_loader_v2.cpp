@@ -1,113 +1,185 @@
 #include "mesh_loader_v2.h"
+#include "entities.h"
 #include <tiny_gltf.h>
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
+#include "../Core/crowd_animation.h"
+#include "../Core/worker_pool.h"
 #include "../Common/d3d_utils.h"
 namespace skinning::io
 {
-    void PrefabLoader::CreateEntitiesForBoneNodes(std::unordered_set<int>& armatureNodesIds,
-        entt::registry& registry, std::unordered_map<int, entt::entity>& boneEntities)
+    /// <summary>
+    /// If there are warnings they'll be printed to stdout
+    /// </summary>
+    /// <param name="warn"></param>
+    void PrintWarnings(std::string warn)
     {
-        for (const auto& nodeIds : armatureNodesIds)
-        {
-            entt::entity boneEntity = registry.create();
-            BoneId boneId{ nodeIds };
-            registry.emplace<BoneId>(boneEntity, boneId);
-            //links the id to the entity
-            boneEntities.insert({ nodeIds, boneEntity });
+        if (!warn.empty())
+            printf("Warning: %s\n", warn.c_str());
+    }
+    /// <summary>
+    /// If there are errors, they'll be printed to stdout
+    /// </summary>
+    /// <param name="err"></param>
+    void PrintErrs(std::string err)
+    {
+        if (!err.empty())
+            printf("Error: %s\n", err.c_str());
+    }
+    /// <summary>
+    /// Where the elements of an accessor start and how many bytes apart they are. Null if it has no buffer.
+    /// </summary>
+    const unsigned char* GetAccessorData(const tinygltf::Model& model, int accessorId, size_t& byteStride)
+    {
+        const tinygltf::Accessor& accessor = model.accessors[accessorId];
+        if (accessor.bufferView < 0) {
+            return nullptr;
         }
+        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+        const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+        byteStride = accessor.ByteStride(bufferView);
+        return &buffer.data[bufferView.byteOffset + accessor.byteOffset];
     }
+    /// <summary>
+    /// The float data of an accessor and how many floats apart its elements are. Null if the accessor
+    /// isn't made of floats: glTF allows normalized integers for rotations, which the sample files don't use.
+    /// </summary>
+    const float* GetFloatAccessorData(const tinygltf::Model& model, int accessorId, size_t& strideInFloats)
+    {
+        size_t byteStride = 0;
+        const unsigned char* data = GetAccessorData(model, accessorId, byteStride);
+        if (model.accessors[accessorId].componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || !data) {
+            return nullptr;
+        }
+        strideInFloats = byteStride / sizeof(float);
+        return reinterpret_cast<const float*>(data);
+    }
+    /// <summary>
+    /// Copies a float attribute of the primitive into member of each vertex, if the primitive has it.
+    /// </summary>
+    template<typename Value>
+    void ExtractFloatAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+        const std::string& attribute, Value Vertex::* member, Vertex* vertices, size_t vertexCount)
+    {
+        const auto it = primitive.attributes.find(attribute);
+        if (it == primitive.attributes.end()) {
+            return;
+        }
+        size_t stride = 0;
+        const float* data = GetFloatAccessorData(model, it->second, stride);
+        if (!data) {
+            PrintWarnings(attribute + " isn't made of floats, skipped");
+            return;
+        }
+        const size_t count = std::min(vertexCount, model.accessors[it->second].count);
+        for (size_t i = 0; i < count; i++) {
+            memcpy(&(vertices[i].*member), &data[i * stride], sizeof(Value));
+        }
+    }
+    /// <summary>
+    /// Component c of a JOINTS_n element, bytes or shorts.
+    /// </summary>
+    uint16_t ReadJoint(const unsigned char* element, int componentType, int c)
+    {
+        if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+            return element[c];
+        }
+        uint16_t joint;
+        memcpy(&joint, element + c * sizeof(uint16_t), sizeof(uint16_t));
+        return joint;
+    }
+    /// <summary>
+    /// Component c of a WEIGHTS_n element, floats or normalized bytes or shorts.
+    /// </summary>
+    float ReadWeight(const unsigned char* element, int componentType, int c)
+    {
+        if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+            return element[c] / 255.0f;
+        }
+        if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+            uint16_t weight;
+            memcpy(&weight, element + c * sizeof(uint16_t), sizeof(uint16_t));
+            return weight / 65535.0f;
+        }
+        float weight;
+        memcpy(&weight, element + c * sizeof(float), sizeof(float));
+        return weight;
+    }
+    /// <summary>
+    /// The joints and weights of the primitive into the influences of the vertices. All the JOINTS_n/WEIGHTS_n
+    /// sets are read, only the four strongest influences stay and they are normalized.
+    /// </summary>
+    void ExtractInfluences(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+        Vertex* vertices, size_t vertexCount)
+    {
+        for (int set = 0; ; set++) {
+            const auto joints = primitive.attributes.find("JOINTS_" + std::to_string(set));
+            const auto weights = primitive.attributes.find("WEIGHTS_" + std::to_string(set));
+            if (joints == primitive.attributes.end() || weights == primitive.attributes.end()) {
+                break;
+            }
+            size_t jointStride = 0;
+            size_t weightStride = 0;
+            const unsigned char* jointData = GetAccessorData(model, joints->second, jointStride);
+            const unsigned char* weightData = GetAccessorData(model, weights->second, weightStride);
+            if (!jointData || !weightData) {
+                continue;
+            }
+            const int jointType = model.accessors[joints->second].componentType;
+            const int weightType = model.accessors[weights->second].componentType;
+            const size_t count = std::min({ vertexCount, model.accessors[joints->second].count,
+                model.accessors[weights->second].count });
+            for (size_t i = 0; i < count; i++) {
+                const unsigned char* joint = &jointData[i * jointStride];
+                const unsigned char* weight = &weightData[i * weightStride];
+                for (int c = 0; c < 4; c++) {
+                    common::AddInfluence(vertices[i].influences, ReadJoint(joint, jointType, c),
+                        ReadWeight(weight, weightType, c));
+                }
+            }
+        }
+        for (size_t i = 0; i < vertexCount; i++) {
+            common::NormalizeInfluences(vertices[i].influences);
+        }
+    }
+
     void PrefabLoader::ExtractMeshWithWeights(const tinygltf::Model& model,
         const tinygltf::Mesh& mesh,
         std::vector<Vertex>& vertices,
         std::vector<int>& indices) {
         for (const auto& primitive : mesh.primitives) {
-            if (primitive.attributes.empty()) continue;
-
+            if (primitive.attributes.empty() || !primitive.attributes.count("POSITION")) continue;
+            //the vertices of the primitive are made at once and each attribute is copied in a pass
+            //of its own, the vertex is plain data so that's all the allocation there is
+            const size_t firstVertex = vertices.size();
+            const size_t vertexCount = model.accessors[primitive.attributes.at("POSITION")].count;
+            vertices.resize(firstVertex + vertexCount, Vertex{});
+            Vertex* primitiveVertices = vertices.data() + firstVertex;
+            ExtractFloatAttribute(model, primitive, "POSITION", &Vertex::position, primitiveVertices, vertexCount);
+            ExtractFloatAttribute(model, primitive, "NORMAL", &Vertex::normal, primitiveVertices, vertexCount);
+            ExtractFloatAttribute(model, primitive, "TEXCOORD_0", &Vertex::texCoord, primitiveVertices, vertexCount);
+            ExtractInfluences(model, primitive, primitiveVertices, vertexCount);
+
+            if (primitive.indices < 0) continue;
             const tinygltf::Accessor& indicesAccessor = model.accessors[primitive.indices];
             const tinygltf::BufferView& indicesBufferView = model.bufferViews[indicesAccessor.bufferView];
             const tinygltf::Buffer& indicesBuffer = model.buffers[indicesBufferView.buffer];
             const unsigned char* indicesData = &indicesBuffer.data[
                 indicesBufferView.byteOffset + indicesAccessor.byteOffset];
-            indices.resize(indicesAccessor.count);
+            //the primitives share the vertex buffer, their indices are offset by where their vertices start
+            const size_t firstIndex = indices.size();
+            indices.resize(firstIndex + indicesAccessor.count);
             if (indicesAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
             {
                 const uint16_t* shortIndices = reinterpret_cast<const uint16_t*>(indicesData);
                 for (size_t i = 0; i < indicesAccessor.count; i++) {
-                    indices[i] = static_cast<uint32_t>(shortIndices[i]);
+                    indices[firstIndex + i] = static_cast<int>(firstVertex + shortIndices[i]);
                 }
             }
             else if (indicesAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
-                memcpy(indices.data(), indicesData, indicesAccessor.count * sizeof(uint32_t));
-            }
-
-            // Buffers for attributes
-            const auto& positionAccessor = model.accessors[primitive.attributes.at("POSITION")];
-            const auto& positionBufferView = model.bufferViews[positionAccessor.bufferView];
-            const auto& positionBuffer = model.buffers[positionBufferView.buffer];
-            const float* positionData = reinterpret_cast<const float*>(&positionBuffer.data[positionBufferView.byteOffset + positionAccessor.byteOffset]);
-
-            const float* normalData = nullptr;
-            if (primitive.attributes.count("NORMAL")) {
-                const auto& normalAccessor = model.accessors[primitive.attributes.at("NORMAL")];
-                const auto& normalBufferView = model.bufferViews[normalAccessor.bufferView];
-                const auto& normalBuffer = model.buffers[normalBufferView.buffer];
-                normalData = reinterpret_cast<const float*>(&normalBuffer.data[normalBufferView.byteOffset + normalAccessor.byteOffset]);
-            }
-
-            const float* texCoordData = nullptr;
-            if (primitive.attributes.count("TEXCOORD_0")) {
-                const auto& texCoordAccessor = model.accessors[primitive.attributes.at("TEXCOORD_0")];
-                const auto& texCoordBufferView = model.bufferViews[texCoordAccessor.bufferView];
-                const auto& texCoordBuffer = model.buffers[texCoordBufferView.buffer];
-                texCoordData = reinterpret_cast<const float*>(&texCoordBuffer.data[texCoordBufferView.byteOffset + texCoordAccessor.byteOffset]);
-            }
-
-            const uint8_t* jointData = nullptr;
-            if (primitive.attributes.count("JOINTS_0")) {
-                const auto& jointAccessor = model.accessors[primitive.attributes.at("JOINTS_0")];
-                const auto& jointBufferView = model.bufferViews[jointAccessor.bufferView];
-                const auto& jointBuffer = model.buffers[jointBufferView.buffer];
-                jointData = &jointBuffer.data[jointBufferView.byteOffset + jointAccessor.byteOffset];
-            }
-
-            const float* weightData = nullptr;
-            if (primitive.attributes.count("WEIGHTS_0")) {
-                const auto& weightAccessor = model.accessors[primitive.attributes.at("WEIGHTS_0")];
-                const auto& weightBufferView = model.bufferViews[weightAccessor.bufferView];
-                const auto& weightBuffer = model.buffers[weightBufferView.buffer];
-                weightData = reinterpret_cast<const float*>(&weightBuffer.data[weightBufferView.byteOffset + weightAccessor.byteOffset]);
-            }
-
-            // Iterate through vertices
-            for (size_t i = 0; i < positionAccessor.count; ++i) {
-                Vertex vertex;
-                vertex.position = DirectX::XMFLOAT3(
-                    positionData[i * 3],
-                    positionData[i * 3 + 1],
-                    positionData[i * 3 + 2]);
-
-                if (normalData) {
-                    vertex.normal = DirectX::XMFLOAT3(
-                        normalData[i * 3],
-                        normalData[i * 3 + 1],
-                        normalData[i * 3 + 2]);
-                }
-
-                if (texCoordData) {
-                    vertex.texCoord = DirectX::XMFLOAT2(
-                        texCoordData[i * 2],
-                        texCoordData[i * 2 + 1]);
-                }
-
-                if (jointData) {
-                    vertex.jointIDs.assign(&jointData[i * 4], &jointData[i * 4 + 4]);
-                }
-
-                if (weightData) {
-                    vertex.weights.assign(&weightData[i * 4], &weightData[i * 4 + 4]);
+                const uint32_t* intIndices = reinterpret_cast<const uint32_t*>(indicesData);
+                for (size_t i = 0; i < indicesAccessor.count; i++) {
+                    indices[firstIndex + i] = static_cast<int>(firstVertex + intIndices[i]);
                 }
-
-                vertices.push_back(vertex);
             }
         }
     }
@@ -125,75 +197,27 @@ namespace skinning::io
 
 
 
-    /// <summary>
-    /// If there are warnings they'll be printed to stdout
-    /// </summary>
-    /// <param name="warn"></param>
-    void PrintWarnings(std::string warn)
+    void PrefabLoader::ExtractTPoseMatrix(std::vector<DirectX::XMFLOAT4X4>& inverseBindMatrices,
+        const tinygltf::Model& model,
+        const tinygltf::Skin& skin)
     {
-        if (!warn.empty())
-            printf("Warning: %s\n", warn.c_str());
-    }
-    /// <summary>
-    /// If there are errors, they'll be printed to stdout
-    /// </summary>
-    /// <param name="err"></param>
-    void PrintErrs(std::string err)
-    {
-        if (!err.empty())
-            printf("Error: %s\n", err.c_str());
-    }
-    /// <summary>
-    /// Extract the set of armature nodes
-    /// </summary>
-    /// <param name="armatureNodesIds"></param>
-    /// <param name="model"></param>
-    void PrefabLoader::ExtractArmatureNodeIds(std::unordered_set<int>& armatureNodesIds,
-        tinygltf::Model& model)
-    {
-        for (const auto& skin : model.skins)
+        //without the accessor the joints are bound where they are, the matrices are identities
+        DirectX::XMFLOAT4X4 identity;
+        DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+        inverseBindMatrices.assign(skin.joints.size(), identity);
+        if (skin.inverseBindMatrices < 0)
         {
-            for (int joint : skin.joints)
-            {
-                armatureNodesIds.insert(joint);
-            }
-            if (skin.skeleton >= 0)
-            {
-                armatureNodesIds.insert(skin.skeleton);
-            }
+            return;
         }
-    }
-
-    void PrefabLoader::ExtractTPoseMatrix(std::unordered_map<int, DirectX::XMMATRIX>& boneId_offsetMatrix_table,
-        tinygltf::Model& model)
-    {
-        for (const auto& skin : model.skins)
-        {
-            const tinygltf::Accessor& accessor = model.accessors[skin.inverseBindMatrices];
-            const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-            const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
-            const float* data = reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+        const tinygltf::Accessor& accessor = model.accessors[skin.inverseBindMatrices];
+        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+        const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+        const float* data = reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
 
-            for (size_t i = 0; i < accessor.count; ++i) {
-                auto currJointId = skin.joints[i];
-                DirectX::XMFLOAT4X4 mat;
-                memcpy(mat.m, &data[i * 16], sizeof(float) * 16);
-                DirectX::XMMATRIX xmmMat = DirectX::XMLoadFloat4x4(&mat);
-                boneId_offsetMatrix_table.insert({ currJointId, xmmMat });
-            }
+        for (size_t i = 0; i < std::min(accessor.count, skin.joints.size()); ++i) {
+            memcpy(inverseBindMatrices[i].m, &data[i * 16], sizeof(float) * 16);
         }
     }
-    /// <summary>
-    /// Is the node with the given id part of an armature?
-    /// </summary>
-    /// <param name="armatureNodesIds"></param>
-    /// <param name="id"></param>
-    /// <returns></returns>
-    bool NodeIsPartOfArmature(const std::unordered_set<int>& armatureNodesIds,
-        const int id)
-    {
-        return armatureNodesIds.count(static_cast<int>(id)) > 0;
-    }
 
     bool IsRootNode(const tinygltf::Node& node)
     {
@@ -205,33 +229,6 @@ namespace skinning::io
     {
         return node.mesh >= 0;
     }
-    void PrefabLoader::GetNodeIds(std::unordered_map<int, const tinygltf::Node&>& nodes, tinygltf::Model& model)
-    {
-        for (int i = 0; i < model.nodes.size(); ++i)
-        {
-            const tinygltf::Node& n = model.nodes[i];
-            nodes.insert({ i, n });
-        }
-    }
-
-    void PrefabLoader::ExtractBoneHierarchy(std::unordered_map<int, std::unordered_set<int>>& hierarchy, std::unordered_set<int>& armatureNodeIds, std::unordered_map<int, const tinygltf::Node&>& nodes)
-    {
-        for (const auto& kv : nodes)
-        {
-            if (!NodeIsPartOfArmature(armatureNodeIds, kv.first))
-                continue;
-            if (!kv.second.children.empty())
-            {
-                std::unordered_set<int> children;
-                for (auto& id : kv.second.children)
-                {
-                    children.insert(id);
-                }
-                hierarchy.insert({ kv.first, children });
-            }
-        }
-    }
-
     void ExtractLocalTransform(const tinygltf::Node& node,
         DirectX::XMVECTOR& position,
         DirectX::XMVECTOR& scale,
@@ -293,52 +290,140 @@ namespace skinning::io
         assert(success);
     }
 
-    void PrefabLoader::CreateHierarchy(std::unordered_map<int, entt::entity>& boneEntities,
-        std::unordered_map<int, std::unordered_set<int>>& hierarchy,
-        entt::registry& registry)
+    common::Skeleton PrefabLoader::ExtractSkeleton(const tinygltf::Model& model)
     {
-        for (const auto& entities : boneEntities)
+        if (model.skins.empty())
         {
-            const int& id = entities.first;
-            const entt::entity& entity = entities.second;
-            std::unordered_set<int> children = hierarchy[id];
-            //create the relationships
-            std::vector<entt::entity> childrenEntities;
-            for (const auto& childId : children)
+            return {};
+        }
+        const tinygltf::Skin& skin = model.skins[0];
+        //the nodes only know their children, the bones need their parents
+        std::vector<int> nodeParents(model.nodes.size(), -1);
+        for (int i = 0; i < static_cast<int>(model.nodes.size()); ++i)
+        {
+            for (int child : model.nodes[i].children)
+            {
+                nodeParents[child] = i;
+            }
+        }
+        //the joints and every node above them, each once
+        std::unordered_map<int, int32_t> boneOfNode;
+        std::vector<int> boneNodes;
+        for (int joint : skin.joints)
+        {
+            for (int node = joint; node >= 0 && boneOfNode.count(node) == 0; node = nodeParents[node])
             {
-                const entt::entity& childEntity = boneEntities[childId];
-                childrenEntities.push_back(childEntity);
-                //since we got the child here, we create the parent component and attach to the entity.
-                skinning::Parent parentComponent{ entity };
-                registry.emplace<skinning::Parent>(childEntity, parentComponent);
+                boneOfNode.insert({ node, static_cast<int32_t>(boneNodes.size()) });
+                boneNodes.push_back(node);
             }
-            //attach the children component to the entity
-            skinning::Children childrenComponent{ childrenEntities };
-            registry.emplace<skinning::Children>(entity, childrenComponent);
         }
+        std::vector<common::SkeletonBone> bones;
+        bones.reserve(boneNodes.size());
+        for (int node : boneNodes)
+        {
+            common::SkeletonBone bone;
+            bone.name = model.nodes[node].name;
+            const int parent = nodeParents[node];
+            bone.parent = parent >= 0 ? boneOfNode[parent] : -1;
+            DirectX::XMVECTOR position, scale, rotation;
+            ExtractLocalTransform(model.nodes[node], position, scale, rotation);
+            DirectX::XMStoreFloat3(&bone.position, position);
+            DirectX::XMStoreFloat4(&bone.rotation, rotation);
+            DirectX::XMStoreFloat3(&bone.scale, scale);
+            bones.push_back(bone);
+        }
+        std::vector<uint32_t> jointBones;
+        for (int joint : skin.joints)
+        {
+            jointBones.push_back(static_cast<uint32_t>(boneOfNode[joint]));
+        }
+        std::vector<DirectX::XMFLOAT4X4> inverseBindMatrices;
+        ExtractTPoseMatrix(inverseBindMatrices, model, skin);
+        return common::BuildSkeleton(bones, jointBones, inverseBindMatrices);
     }
-    void PrefabLoader::CreateTransformAndTPoseComponents(std::unordered_map<int, entt::entity>& boneEntities,
-        tinygltf::Model& model,
-        std::unordered_map<int, DirectX::XMMATRIX>& tPoseMatrices,
-        entt::registry& registry)
+
+        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+        const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+        strideInFloats = accessor.ByteStride(bufferView) / sizeof(float);
+        return reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+    }
+    /// <summary>
+    /// Reads a sampler into a track, one pass over its keys. The times are already in seconds. Cubic
+    /// splines keep only the values, without their tangents, and step samplers are lerped like the rest.
+    /// </summary>
+    template<typename Value>
+    void ExtractTrack(const tinygltf::Model& model, const tinygltf::AnimationSampler& sampler,
+        common::AnimationTrack<Value>& track)
+    {
+        size_t timeStride = 0;
+        size_t valueStride = 0;
+        const float* times = GetFloatAccessorData(model, sampler.input, timeStride);
+        const float* values = GetFloatAccessorData(model, sampler.output, valueStride);
+        if (!times || !values) {
+            PrintWarnings("animation sampler that isn't made of floats, skipped");
+            return;
+        }
+        const bool cubicSpline = sampler.interpolation == "CUBICSPLINE";
+        //a cubic spline key is the in tangent, the value and the out tangent
+        const size_t valuesPerKey = cubicSpline ? 3 : 1;
+        const size_t valueOffset = cubicSpline ? 1 : 0;
+        const size_t count = std::min(model.accessors[sampler.input].count,
+            model.accessors[sampler.output].count / valuesPerKey);
+        track.times.reserve(count);
+        track.values.reserve(count);
+        for (size_t k = 0; k < count; k++) {
+            const float time = times[k * timeStride];
+            //keys have to go forward in time, the search depends on it
+            if (!track.times.empty() && time < track.times.back()) {
+                continue;
+            }
+            Value value;
+            memcpy(&value, &values[(k * valuesPerKey + valueOffset) * valueStride], sizeof(Value));
+            track.times.push_back(time);
+            track.values.push_back(value);
+        }
+    }
+
+    std::vector<common::AnimationClip> PrefabLoader::ExtractAnimations(const tinygltf::Model& model)
     {
-        for (const auto& entities : boneEntities)
+        std::vector<common::AnimationClip> clips;
+        for (const tinygltf::Animation& gltfAnimation : model.animations)
         {
-            const int& id = entities.first;
-            const entt::entity& entity = entities.second;
-            tinygltf::Node& node = model.nodes[id];
-            //TODO: get the offset matrix and create it's component
-            skinning::TPoseMatrix tposeMatrix{
-                tPoseMatrices[id]
-            };
-            registry.emplace<skinning::TPoseMatrix>(entity, tposeMatrix);
-            //TODO: get local position, scale and rotation
-            DirectX::XMVECTOR position, scale, rotation;
-            ExtractLocalTransform(node, position, scale, rotation);
-            //TODO: create component and add to the entity
-            skinning::Transform boneTransform{ position, scale, rotation };
-            registry.emplace<skinning::Transform>(entity, boneTransform);
+            //a node has a channel per path, each goes to its own track
+            std::map<int, common::TransformTracks> nodeTracks;
+            for (const tinygltf::AnimationChannel& channel : gltfAnimation.channels)
+            {
+                if (channel.target_node < 0 || channel.sampler < 0)
+                {
+                    continue;
+                }
+                const tinygltf::AnimationSampler& sampler = gltfAnimation.samplers[channel.sampler];
+                common::TransformTracks& tracks = nodeTracks[channel.target_node];
+                if (channel.target_path == "translation")
+                {
+                    ExtractTrack(model, sampler, tracks.position);
+                }
+                else if (channel.target_path == "rotation")
+                {
+                    ExtractTrack(model, sampler, tracks.rotation);
+                }
+                else if (channel.target_path == "scale")
+                {
+                    ExtractTrack(model, sampler, tracks.scale);
+                }
+                //weights are morph targets, not bones
+            }
+            //glTF times are in seconds already
+            common::AnimationClip clip;
+            clip.name = gltfAnimation.name;
+            for (auto& kv : nodeTracks)
+            {
+                clip.duration = std::max(clip.duration, kv.second.GetEndTime());
+                clip.channels.push_back({ model.nodes[kv.first].name, std::move(kv.second) });
+            }
+            clips.push_back(std::move(clip));
         }
+        return clips;
     }
 
     skinning::Mesh PrefabLoader::CreateMeshComponent(std::vector<skinning::Vertex>& vertexes,
@@ -347,7 +432,7 @@ namespace skinning::io
         Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue,
         std::string name) {
         using namespace Microsoft::WRL;
-        int vBufferSize = vertexes.size() * sizeof(common::Vertex);
+        int vBufferSize = vertexes.size() * sizeof(skinning::Vertex);
         CD3DX12_HEAP_PROPERTIES vertexHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
         CD3DX12_RESOURCE_DESC vertexResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(vBufferSize);
         Microsoft::WRL::ComPtr<ID3D12Resource> mVertexBuffer = nullptr;
@@ -452,7 +537,7 @@ namespace skinning::io
                 lst->ResourceBarrier(1, &secondIndexBufferResourceBarrier);
             });
         mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
-        mVertexBufferView.StrideInBytes = sizeof(common::Vertex);
+        mVertexBufferView.StrideInBytes = sizeof(skinning::Vertex);
         mVertexBufferView.SizeInBytes = vBufferSize;
 
         mIndexBufferView.BufferLocation = mIndexBuffer->GetGPUVirtualAddress();
@@ -502,4 +587,81 @@ namespace skinning::io
 
 
     
-}
\ No newline at end of file
+}
+
+std::shared_ptr<const skinning::AnimationLodAsset> skinning::MakeAnimationLodAsset(const common::Skeleton& skeleton,
+    const std::vector<std::vector<int32_t>>& clipBones, const common::AnimationLodSettings& settings)
+{
+    auto lod = std::make_shared<AnimationLodAsset>();
+    lod->settings = settings;
+    const std::vector<uint32_t> depths = common::ComputeBoneDepths(skeleton);
+    for (uint32_t tier = 0; tier < common::ANIMATION_LOD_TIER_COUNT; tier++)
+    {
+        if (settings.maxBoneDepth[tier] == UINT32_MAX)
+        {
+            continue;
+        }
+        for (const std::vector<int32_t>& channelBones : clipBones)
+        {
+            lod->tierClipBones[tier].push_back(common::ReduceChannelBones(channelBones, depths,
+                settings.maxBoneDepth[tier]));
+        }
+    }
+    return lod;
+}
+
+void skinning::AnimateSkeletons(common::WorkerPool& workerPool, entt::registry& registry, float deltaTime)
+{
+    //scratch for the characters, rebuilt every frame
+    static std::vector<common::CrowdCharacter> characters;
+    static std::vector<common::LodCrowdCharacter> lodCharacters;
+    characters.clear();
+    lodCharacters.clear();
+    auto view = registry.view<SkeletonAsset, SkeletonPose, SkeletonAnimator>();
+    for (const auto entity : view)
+    {
+        const SkeletonAsset& asset = view.get<SkeletonAsset>(entity);
+        SkeletonPose& pose = view.get<SkeletonPose>(entity);
+        SkeletonAnimator& animator = view.get<SkeletonAnimator>(entity);
+        common::CrowdCharacter character{ asset.skeleton.get(), nullptr, nullptr, 0, &animator.cursors, &pose.pose,
+            &pose.skinMatrices };
+        if (animator.clip < asset.clips->size())
+        {
+            const common::AnimationClip& clip = (*asset.clips)[animator.clip];
+            animator.currentTime += deltaTime;
+            if (animator.looping && clip.duration > 0 && animator.currentTime > clip.duration)
+            {
+                animator.currentTime = fmod(animator.currentTime, clip.duration);
+            }
+            character.clip = &clip;
+            character.channelBones = &(*asset.clipBones)[animator.clip];
+            character.time = animator.currentTime;
+        }
+        AnimationLod* lod = registry.try_get<AnimationLod>(entity);
+        if (!lod || !asset.lod)
+        {
+            characters.push_back(character);
+            continue;
+        }
+        common::LodCrowdCharacter lodCharacter;
+        lodCharacter.character = character;
+        lodCharacter.looping = animator.looping;
+        lodCharacter.settings = &asset.lod->settings;
+        for (uint32_t tier = 0; tier < common::ANIMATION_LOD_TIER_COUNT; tier++)
+        {
+            if (animator.clip < asset.lod->tierClipBones[tier].size())
+            {
+                lodCharacter.tierChannelBones[tier] = &asset.lod->tierClipBones[tier][animator.clip];
+            }
+        }
+        lodCharacter.screenSize = lod->screenSize;
+        lodCharacter.visible = lod->visible;
+        lodCharacter.phase = lod->phase;
+        lodCharacter.state = &lod->state;
+        lodCharacter.previous = &lod->previous;
+        lodCharacter.next = &lod->next;
+        lodCharacters.push_back(lodCharacter);
+    }
+    common::AnimateCrowd(workerPool, characters);
+    common::AnimateCrowdLod(workerPool, lodCharacters, deltaTime);
+}
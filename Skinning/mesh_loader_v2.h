@@ -1,6 +1,13 @@
 #pragma once
 #include "pch.h"
 #include <tiny_gltf.h>
+#include "../Core/skeleton.h"
+#include "../Core/cpu_skinning.h"
+#include "../Core/animation_lod.h"
+namespace common
+{
+    class WorkerPool;
+}
 namespace skinning::gameobjects
 {
     struct Capoeirista
@@ -15,15 +22,17 @@ namespace skinning::gameobjects
 namespace skinning
 {
     /// <summary>
-    /// describes the vertex layout.
+    /// describes the vertex layout. Plain data, the vertex buffer is a copy of an array of these and the
+    /// input layout is common::input_layout_service::SkinnedVertices.
     /// </summary>
     struct Vertex {
         DirectX::XMFLOAT3 position;
         DirectX::XMFLOAT3 normal;
         DirectX::XMFLOAT2 texCoord;
-        std::vector<uint8_t> jointIDs; // Bone IDs
-        std::vector<float> weights;    // Weights
+        common::SkinInfluences influences; // 4 joint ids (uint16) and their weights (float), weakest dropped
     };
+    static_assert(offsetof(Vertex, influences) == 32 && sizeof(Vertex) == 56,
+        "common::input_layout_service::SkinnedVertices has these offsets");
     //TODO: Deprecated
     class SkinnedMeshPrefab
     {
@@ -59,42 +68,67 @@ namespace skinning
     {
     };
     /// <summary>
-    /// Describes a bone joint. Maybe can be used as a generic transform object?
+    /// The animation LOD of a skeleton: the tiers and, for the tiers with a reduced bone set, tierClipBones[t][c]
+    /// is clipBones[c] without the bones the tier drops. Empty for the tiers that keep all the bones.
     /// </summary>
-    struct Transform
+    struct AnimationLodAsset
     {
-        DirectX::XMVECTOR position;
-        DirectX::XMVECTOR scale;
-        DirectX::XMVECTOR rotation;
+        common::AnimationLodSettings settings;
+        std::array<std::vector<std::vector<int32_t>>, common::ANIMATION_LOD_TIER_COUNT> tierClipBones;
     };
     /// <summary>
-    /// I need the T-Pose matrix because the final world position of a vertex in a 
-    /// skin takes that into account
+    /// The reduced bone sets of the settings, for the clips of the asset.
     /// </summary>
-    struct TPoseMatrix
+    std::shared_ptr<const AnimationLodAsset> MakeAnimationLodAsset(const common::Skeleton& skeleton,
+        const std::vector<std::vector<int32_t>>& clipBones, const common::AnimationLodSettings& settings);
+    /// <summary>
+    /// The skeleton and the animations of a skinned prefab. Instances copy the pointers, the bones
+    /// and the keys are never duplicated.
+    /// </summary>
+    struct SkeletonAsset
     {
-        DirectX::XMMATRIX offsetMatrix;
+        std::shared_ptr<const common::Skeleton> skeleton;
+        std::shared_ptr<const std::vector<common::AnimationClip>> clips;
+        /// <summary>
+        /// clipBones[c] is common::BindClip of clips[c], the bone each channel drives.
+        /// </summary>
+        std::shared_ptr<const std::vector<std::vector<int32_t>>> clipBones;
+        /// <summary>
+        /// How the instances of the asset are animated far away, see AnimationLodAsset.
+        /// </summary>
+        std::shared_ptr<const AnimationLodAsset> lod;
     };
     /// <summary>
-    /// Holds the parent.
+    /// What an instance owns of its skeleton: the local transforms of the bones and the matrices its
+    /// vertices are skinned with, one per joint.
     /// </summary>
-    struct Parent
+    struct SkeletonPose
     {
-        entt::entity parent = entt::null;
+        common::Pose pose;
+        std::vector<DirectX::XMFLOAT4X4> skinMatrices;
     };
     /// <summary>
-    /// Holds a list of children
+    /// The clip of the SkeletonAsset an instance plays, and where.
     /// </summary>
-    struct Children
+    struct SkeletonAnimator
     {
-        std::vector<entt::entity> children;
+        uint32_t clip = 0;
+        float currentTime = 0;
+        bool looping = true;
+        std::vector<common::TransformCursors> cursors;
     };
     /// <summary>
-    /// The id of the bone, used by the vertex buffer (jointID)
+    /// The animation LOD of an instance. screenSize and visible are for whoever knows the camera to set, the
+    /// instance is animated at full rate until then. previous and next are the evaluations blended between.
     /// </summary>
-    struct BoneId
+    struct AnimationLod
     {
-        int nodeID;
+        float screenSize = 1;
+        bool visible = true;
+        uint32_t phase = 0;
+        common::AnimationLodState state;
+        std::vector<DirectX::XMFLOAT4X4> previous;
+        std::vector<DirectX::XMFLOAT4X4> next;
     };
 
     struct GameObject
@@ -112,10 +146,12 @@ namespace skinning::io
     /// </summary>
     class PrefabLoader
     {
+        /// <summary>
+        /// The bones below this depth are dropped in the farthest LOD tier. In the mixamo rigs, under the armature
+        /// node, the hands are at 8 and below them are the fingers, 40 of the 65 bones.
+        /// </summary>
+        static constexpr uint32_t MAX_FAR_BONE_DEPTH = 8;
 
-        static void GetNodeIds(
-            std::unordered_map<int, const tinygltf::Node&>& nodes,
-            tinygltf::Model& model);
         /// <summary>
         /// Load the model using a tinyGLTF loader and model.
         /// </summary>
@@ -126,27 +162,20 @@ namespace skinning::io
             tinygltf::Model& model, const std::string& file);
 
         static void ExtractTPoseMatrix(
-            std::unordered_map<int, DirectX::XMMATRIX>& boneId_offsetMatrix_table,
-            tinygltf::Model& model);
+            std::vector<DirectX::XMFLOAT4X4>& inverseBindMatrices,
+            const tinygltf::Model& model,
+            const tinygltf::Skin& skin);
         static void ExtractMeshWithWeights(const tinygltf::Model& model,
             const tinygltf::Mesh& mesh,
             std::vector<Vertex>& vertices,
             std::vector<int>& indices);
-        static void ExtractArmatureNodeIds(std::unordered_set<int>& armatureNodesIds,
-            tinygltf::Model& model);
-        static void CreateEntitiesForBoneNodes(
-            std::unordered_set<int>& armatureNodesIds,
-            entt::registry& registry,
-            std::unordered_map<int, entt::entity>& boneEntities);
         /// <summary>
-        /// Create the parent and children components in the entities.
+        /// The skeleton of the first skin: its joints and the nodes above them, the armature node with
+        /// its scale usually, so that the roots end up where the file puts them.
         /// </summary>
-        /// <param name="boneEntities"></param>
-        /// <param name="hierarchy"></param>
-        /// <param name="registry"></param>
-        static void CreateHierarchy(std::unordered_map<int, entt::entity>& boneEntities,
-            std::unordered_map<int, std::unordered_set<int>>& hierarchy,
-            entt::registry& registry);
+        /// <param name="model"></param>
+        /// <returns></returns>
+        static common::Skeleton ExtractSkeleton(const tinygltf::Model& model);
         /// <summary>
         /// It creates the mesh component. To create the mesh component i have to create the vertex and
         /// index buffers and push data to them (that's why i need the device and queue). In the end
@@ -165,24 +194,20 @@ namespace skinning::io
             Microsoft::WRL::ComPtr<ID3D12Device> device,
             Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue,
             std::string name);
-        static void CreateTransformAndTPoseComponents(std::unordered_map<int, entt::entity>& boneEntities,
-            tinygltf::Model& model,
-            std::unordered_map<int, DirectX::XMMATRIX>& tPoseMatrices,
-            entt::registry& registry);
-        static void ExtractBoneHierarchy(
-            std::unordered_map<int, std::unordered_set<int>>& hierarchy, 
-            std::unordered_set<int>& armatureNodeIds, 
-            std::unordered_map<int, 
-            const tinygltf::Node&>& nodes);
+        /// <summary>
+        /// The glTF animations as clips, each channel read straight into its track. The channels are
+        /// named after their nodes, like the bones of the skeleton.
+        /// </summary>
+        /// <param name="model"></param>
+        /// <returns></returns>
+        static std::vector<common::AnimationClip> ExtractAnimations(const tinygltf::Model& model);
     public:
         /// <summary>
         /// Loads the skin from the file and creates entities from it.
-        /// It'll create the bone hierarchy entities and the meshes entities. 
+        /// It'll create the skeleton entity and the meshes entities. 
         /// All entities will have the Prefab component. Prefab.Name must be unique
         /// or you'll screw up the queries.
-        /// The parent node entities of the hierarchy will have no Parent component. 
-        /// The leaf will node have no Children component. All the others will have both.
-        /// All bone joints will have BoneJoint and TPose components.
+        /// The skeleton entity has the SkeletonAsset, the bones are arrays in it and not entities.
         /// Meshes will have only mesh and prefab components.
         /// </summary>
         /// <param name="file"></param>
@@ -198,46 +223,29 @@ namespace skinning::io
             Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue)
         {
             const Prefab prefabComponent;
-            //type to improve the semantics of the code. WTF is an int? It can be anything. Typedefing to 
-            //NODE_ID makes it more readable.
-            typedef int NODE_ID;
             tinygltf::TinyGLTF loader;
             tinygltf::Model model;
             LoadModel(loader, model, file);
-            //we need the node IDs, but in tinygltf the node object has no id, it's id is its position
-            //in the list of nodes. The node id will be used everywhere else.
-            std::unordered_map<NODE_ID, const tinygltf::Node&> nodes;
-            GetNodeIds(nodes, model);
-            //get the list of armature nodes. Not all nodes are armature nodes, there are mesh nodes and there may
-            //be other things like camera and lights if exported from blender. So i get the node ids that belong to the
-            //armature.
-            std::unordered_set<NODE_ID> armatureNodesIds;
-            ExtractArmatureNodeIds(armatureNodesIds, model);
-            //get the list of offset matrices (aka t-pose matrix), the key is the armature node id, i'll need this to 
-            //build the bone components.
-            std::unordered_map<NODE_ID, DirectX::XMMATRIX> tPoseMatrices;
-            ExtractTPoseMatrix(tPoseMatrices, model);
-            //Each entry is the node as the key an it's children as value
-            std::unordered_map<NODE_ID, std::unordered_set<NODE_ID>> hierarchy;
-            ExtractBoneHierarchy(hierarchy, armatureNodesIds, nodes);
-            //create the bone entities, add to them the BoneId component and the Prefab component. The
-            //bone id is the node id of that bone, and the prefab is a tag that mark the entity as part 
-            //of a prefab
-            std::unordered_map<NODE_ID, entt::entity> boneEntities;
-            CreateEntitiesForBoneNodes(armatureNodesIds, registry, boneEntities);
-            for (auto& kv : boneEntities)
+            //the bones: parents before children, their local transforms and the inverse bind matrices
+            //(aka t-pose matrices) of the joints. One skeleton for the prefab, the instances share it.
+            auto skeleton = std::make_shared<common::Skeleton>(ExtractSkeleton(model));
+            //the animations, with the bone each channel drives found once here and not when playing
+            auto clips = std::make_shared<std::vector<common::AnimationClip>>(ExtractAnimations(model));
+            auto clipBones = std::make_shared<std::vector<std::vector<int32_t>>>();
+            for (const common::AnimationClip& clip : *clips)
             {
-                registry.emplace<Prefab>(kv.second, prefabComponent);
-                registry.emplace<type_t>(kv.second, properties);
+                clipBones->push_back(common::BindClip(*skeleton, clip));
             }
-            //Will navigate the bone components and create the components that describe the hierarchy (
-            //parent and children). 
-            CreateHierarchy(boneEntities, hierarchy, registry);
-            //create the transform components (boneTransform and TPoseMatrix). Remember that the transforms
-            //are local
-            CreateTransformAndTPoseComponents(boneEntities, model, tPoseMatrices, registry);
-            //by now i have the entities with the hierarchy, the transforms, the t-pose matrices, with all entities
-            //tagged as belonging to the prefab. Now it's time to create the mesh components. To create the mesh
+            //far away characters are evaluated every 2nd or 4th frame, the farthest without the fingers
+            common::AnimationLodSettings lodSettings;
+            lodSettings.maxBoneDepth[static_cast<uint32_t>(common::AnimationLodTier::Every4thFrame)] = MAX_FAR_BONE_DEPTH;
+            auto lod = MakeAnimationLodAsset(*skeleton, *clipBones, lodSettings);
+            entt::entity skeletonEntity = registry.create();
+            registry.emplace<SkeletonAsset>(skeletonEntity, SkeletonAsset{ skeleton, clips, clipBones, lod });
+            registry.emplace<Prefab>(skeletonEntity, prefabComponent);
+            registry.emplace<type_t>(skeletonEntity, properties);
+            //by now i have the skeleton entity tagged as belonging to the prefab. Now it's time to create the
+            //mesh components. To create the mesh
             //components i'll load the vertex and index data and create the vertex buffers.
             //first step is to load the data into a better data structure.
             std::map<std::string, std::vector<skinning::Vertex>> meshes;
@@ -278,24 +286,12 @@ namespace skinning::io
     std::string AssembleFilePath(std::string file);
 
 
-    // Forward declaration
-    entt::entity clone_hierarchy(entt::registry& registry, entt::entity source);
-
-    // Helper function to clone a single entity with its transform
-    entt::entity clone_entity_with_transform(entt::registry& registry, entt::entity source);
-
-    // Main recursive function to clone hierarchy
-    entt::entity clone_hierarchy(entt::registry& registry, entt::entity source);
-
-    // Usage function to clone a root node and its entire hierarchy
-    entt::entity clone_root_hierarchy(entt::registry& registry, entt::entity root);
-
     /// <summary>
     /// To instantiate a prefab we find all entities that have a prefab component with id = prefabName,
     /// Then we duplicate the all these entities, with their components, with the exception of the Prefab
     /// component. Finally, we add the GameObject component with name = gameObjectName.
-    /// If we have the Parent and Children components the hierarchy will be recreated for the cloned entities
-    /// based on the relationships
+    /// The skeleton isn't copied: the instance points to the prefab's and gets its own pose, starting
+    /// at the rest pose.
     /// </summary>
     /// <param name="prefabName"></param>
     /// <param name="gameObjectName"></param>
@@ -311,10 +307,38 @@ namespace skinning::io
             registry.emplace<Mesh>(instanceEntity, meshComponent);
             registry.emplace<instance_t>(instanceEntity, instanceProperties);
         }
-        //2) clone the hierarchy
-        auto roots = registry.view<Transform>(entt::exclude<Parent>);
-        entt::entity single_root = *roots.begin();//i assume only one root
-        entt::entity instanceRoot = clone_root_hierarchy(registry, single_root);
+        //2) the skeleton, shared, and the pose, per instance. The assets are copied out first, the
+        //instances go in the same storage that is being iterated.
+        std::vector<SkeletonAsset> prefabSkeletons;
+        auto prefabSkeletonsView = registry.view<Prefab, prefab_t, SkeletonAsset>();
+        for (const auto prefabEntity : prefabSkeletonsView) {
+            prefabSkeletons.push_back(prefabSkeletonsView.template get<SkeletonAsset>(prefabEntity));
+        }
+        for (const SkeletonAsset& asset : prefabSkeletons) {
+            entt::entity instanceEntity = registry.create();
+            registry.emplace<SkeletonAsset>(instanceEntity, asset);
+            registry.emplace<SkeletonPose>(instanceEntity, SkeletonPose{ asset.skeleton->restPose, {} });
+            registry.emplace<SkeletonAnimator>(instanceEntity);
+            if (asset.lod) {
+                //the phase spreads the evaluations of the far instances over the frames
+                AnimationLod lod;
+                lod.phase = static_cast<uint32_t>(GetNextGameObjectId());
+                registry.emplace<AnimationLod>(instanceEntity, lod);
+            }
+            registry.emplace<instance_t>(instanceEntity, instanceProperties);
+        }
     }
 }
-
+namespace skinning
+{
+    /// <summary>
+    /// Plays the clip of every instance forward by deltaTime and evaluates its pose: the clip into the
+    /// local transforms, then one pass to model space and one to the skin matrices. The instances are
+    /// grouped by clip and the groups run on the pool, see common::AnimateCrowd. Instances with an AnimationLod
+    /// go through common::AnimateCrowdLod: the far ones are evaluated less often and the invisible ones not at all.
+    /// </summary>
+    /// <param name="workerPool"></param>
+    /// <param name="registry"></param>
+    /// <param name="deltaTime"></param>
+    void AnimateSkeletons(common::WorkerPool& workerPool, entt::registry& registry, float deltaTime);
+}
@@ -24,7 +24,7 @@
 #include <filesystem>
 #include <entt/entt.hpp>
 #include "../Common/window.h"
-#include "../Common/vertex.h"
+#include "../Core/vertex.h"
 constexpr int FRAMEBUFFER_COUNT = 2;
 constexpr bool FULLSCREEN = false;
 
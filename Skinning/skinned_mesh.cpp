@@ -20,80 +20,40 @@ namespace skinning::io
 		return scene;
 	}
 
-	aiNode* FindArmatureRoot(aiNode* rootNode, const aiScene* scene)
+	aiNode* FindArmatureRoot(const common::SceneBoneIndex& boneIndex)
 	{
-		// Traverse the node hierarchy to find the armature root
-		for (unsigned int i = 0; i < rootNode->mNumChildren; i++) {
-			aiNode* child = rootNode->mChildren[i];
-			// Check if this child references any bones in the meshes
-			for (unsigned int j = 0; j < scene->mNumMeshes; j++) {
-				aiMesh* mesh = scene->mMeshes[j];
-				for (unsigned int k = 0; k < mesh->mNumBones; k++) {
-					if (std::string(mesh->mBones[k]->mName.C_Str()) == 
-						std::string(child->mName.C_Str())) {
-						return child; // Found the armature root
-					}
-				}
-			}
-			// Recursively check children
-			aiNode* result = skinning::io::FindArmatureRoot(child, scene);
-			if (result) {
-				return result;
-			}
-		}
-		return nullptr; // No armature root found
+		return boneIndex.GetArmatureRoot();
 	}
 
 	/// <summary>
 	/// is this node really a bone? If it is it'll exist in a list of bones of a mesh in the scene
 	/// </summary>
 	/// <param name="node"></param>
-	/// <param name="scene"></param>
+	/// <param name="boneIndex"></param>
 	/// <returns></returns>
-	bool IsNodeReallyBone(const aiNode* node, const aiScene* scene)
+	bool IsNodeReallyBone(const aiNode* node, const common::SceneBoneIndex& boneIndex)
 	{
-		for (auto i = 0; i < scene->mNumMeshes; i++)
-		{
-			aiMesh* m = scene->mMeshes[i];
-			for (auto j = 0; j < m->mNumBones; j++)
-			{
-				const std::string meshBoneName = m->mBones[j]->mName.C_Str();
-				const std::string myBoneName = node->mName.C_Str();
-				if (meshBoneName == myBoneName)
-					return true;
-			}
-		}
-		return false;
+		return boneIndex.IsBone(node);
 	}
 	/// <summary>
 	/// Find the aiBone with the given name.
 	/// </summary>
 	/// <param name="name"></param>
-	/// <param name="scene"></param>
+	/// <param name="boneIndex"></param>
 	/// <returns></returns>
-	aiBone* GetBone(const std::string& myBoneName, const aiScene* scene)
+	aiBone* GetBone(const std::string& myBoneName, const common::SceneBoneIndex& boneIndex)
 	{
-		for (auto i = 0; i < scene->mNumMeshes; i++)
-		{
-			aiMesh* m = scene->mMeshes[i];
-			for (auto j = 0; j < m->mNumBones; j++)
-			{
-				const std::string meshBoneName = m->mBones[j]->mName.C_Str();
-				if (meshBoneName == myBoneName)
-					return m->mBones[j];
-			}
-		}
-		return nullptr;
+		return boneIndex.FindBone(myBoneName);
 	}
 	/// <summary>
 	/// load the offset matrix to a directxmath matrix. The offset matrix is the T-Pose matrix.
 	/// </summary>
 	/// <param name="name"></param>
-	/// <param name="scene"></param>
+	/// <param name="boneIndex"></param>
 	/// <returns></returns>
-	DirectX::XMMATRIX CreateOffsetMatrix(std::string name, const aiScene* scene)
+	DirectX::XMMATRIX CreateOffsetMatrix(std::string name, const common::SceneBoneIndex& boneIndex)
 	{
-		aiBone* aiBoneData = GetBone(name, scene);
+		aiBone* aiBoneData = GetBone(name, boneIndex);
 		aiMatrix4x4 aiOffsetMatrix = aiBoneData->mOffsetMatrix.Transpose();
 		DirectX::XMMATRIX transform = DirectX::XMMATRIX(
 			aiOffsetMatrix.a1, aiOffsetMatrix.b1, aiOffsetMatrix.c1, aiOffsetMatrix.d1,
@@ -125,13 +85,13 @@ namespace skinning::io
 		boneComponent.localRotation = rotation;
 	}
 	void LoadBoneHierarchy(aiNode* node, 
-		const aiScene* scene, 
+		const common::SceneBoneIndex& boneIndex, 
 		std::vector<entt::entity>& boneEntitiesList,
 		entt::entity parentEntity,
 		entt::registry& registry)
 	{
 		//is this really a bone?
-		if (!IsNodeReallyBone(node, scene))
+		if (!IsNodeReallyBone(node, boneIndex))
 		{
 			return; //it isn't, halt the process
 		}
@@ -147,7 +107,7 @@ namespace skinning::io
 		Bone boneComponent;
 		boneComponent.id = boneEntitiesList.size();
 		boneComponent.name = name;
-		boneComponent.offsetMatrix = CreateOffsetMatrix(name, scene);
+		boneComponent.offsetMatrix = CreateOffsetMatrix(name, boneIndex);
 		DecomposeLocalTransform(boneComponent, localTransform);
 		entt::entity currentEntity = registry.create();
 		registry.emplace<Bone>(currentEntity, boneComponent);
@@ -158,7 +118,7 @@ namespace skinning::io
 		}
 		boneEntitiesList.push_back(currentEntity);
 		for (unsigned int i = 0; i < node->mNumChildren; i++) {
-			LoadBoneHierarchy(node->mChildren[i], scene,  boneEntitiesList, currentEntity,registry);
+			LoadBoneHierarchy(node->mChildren[i], boneIndex, boneEntitiesList, currentEntity, registry);
 		}
 	}
 
@@ -205,11 +165,42 @@ namespace skinning::io
 //	}
 //
 //////////////////////////////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// The id of each bone entity by its name, built once so that the bones of the meshes aren't searched for.
+	/// </summary>
+	/// <param name="boneEntitiesList"></param>
+	/// <param name="registry"></param>
+	/// <returns></returns>
+	std::unordered_map<std::string, uint16_t> MakeBoneIdTable(const std::vector<entt::entity>& boneEntitiesList,
+		entt::registry& registry)
+	{
+		std::unordered_map<std::string, uint16_t> boneIds;
+		boneIds.reserve(boneEntitiesList.size());
+		for (entt::entity boneEntity : boneEntitiesList)
+		{
+			const skinning::Bone& bone = registry.get<skinning::Bone>(boneEntity);
+			boneIds.emplace(bone.name, static_cast<uint16_t>(bone.id));
+		}
+		return boneIds;
+	}
 	// Helper function to process a single mesh
-	std::shared_ptr<MeshData> ProcessMesh(const aiMesh* mesh, const aiScene* scene, std::vector<entt::entity>& boneEntitiesList, entt::registry& registry) {
+	std::shared_ptr<MeshData> ProcessMesh(const aiMesh* mesh, const std::unordered_map<std::string, uint16_t>& boneIds) {
 		std::shared_ptr<MeshData> meshData = std::make_shared<MeshData>();
 		meshData->name = std::string(mesh->mName.C_Str());
-		aiBone** currentMeshBones = mesh->mBones;
+		//the bone id of each bone of the mesh, one lookup per bone
+		std::vector<uint16_t> meshBoneIds(mesh->mNumBones, 0);
+		for (unsigned int j = 0; j < mesh->mNumBones; j++)
+		{
+			const auto boneId = boneIds.find(mesh->mBones[j]->mName.C_Str());
+			assert(boneId != boneIds.end());
+			if (boneId != boneIds.end())
+			{
+				meshBoneIds[j] = boneId->second;
+			}
+		}
+		//the weights in one pass over the bones, 4 per vertex, the strongest
+		std::vector<common::SkinInfluences> influences;
+		common::ImportInfluences(*mesh, meshBoneIds, influences);
 		// Initialize vertex data
 		meshData->vertices.resize(mesh->mNumVertices);
 		for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
@@ -223,39 +214,7 @@ namespace skinning::io
 				vertex.uv = { 0.0f, 0.0f };
 			}
 			for (int j = 0; j < 4; ++j) {
-				vertex.boneWeights[j] = { 0, 0.0f }; // Initialize bone weights
-			}
-			int weightsSet = 0;
-			for (int j = 0; j < mesh->mNumBones; j++)
-			{
-				assert(weightsSet < 4); //we have only four weights per vertex
-				aiBone* bone_fromAI = currentMeshBones[j];
-				const std::string boneName = bone_fromAI->mName.C_Str();
-				int boneIdInBoneList = INT_MAX;
-				for (int k = 0; k < boneEntitiesList.size(); k++)
-				{
-					skinning::Bone& bone_fromComponent = registry.get<skinning::Bone>(boneEntitiesList[k]);
-					if (bone_fromComponent.name == boneName)
-					{
-						boneIdInBoneList = bone_fromComponent.id;
-						break;
-					}
-				}
-				assert(boneIdInBoneList != INT_MAX);
-				for (int k = 0; k < bone_fromAI->mNumWeights; k++)
-				{
-					aiVertexWeight weight = bone_fromAI->mWeights[k];
-					if (abs(weight.mWeight) - 0.001f < 0.001f)
-					{
-						continue;
-					}
-					if (weight.mVertexId == i)
-					{
-						vertex.boneWeights[weightsSet].boneID = boneIdInBoneList;
-						vertex.boneWeights[weightsSet].weight = weight.mWeight;
-						weightsSet++;
-					}
-				}
+				vertex.boneWeights[j] = { influences[i].joints[j], influences[i].weights[j] };
 			}
 		}
 		// Copy indices
@@ -275,9 +234,10 @@ namespace skinning::io
 	std::vector<std::shared_ptr<MeshData>> LoadMeshes(const aiScene* scene, std::vector<entt::entity>& boneEntitiesList, entt::registry& registry)
 	{
 		std::vector<std::shared_ptr<MeshData>> result;
+		const std::unordered_map<std::string, uint16_t> boneIds = MakeBoneIdTable(boneEntitiesList, registry);
 		for (auto i = 0; i < scene->mNumMeshes; i++)
 		{
-			result.push_back(ProcessMesh(scene->mMeshes[i], scene, boneEntitiesList, registry));
+			result.push_back(ProcessMesh(scene->mMeshes[i], boneIds));
 		}
 		return result;
 	}
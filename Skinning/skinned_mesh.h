@@ -2,6 +2,7 @@
 #include "pch.h"
 #include "entt/entt.hpp"
 #include "entities.h"
+#include "../Core/skin_import.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -31,15 +32,14 @@ namespace skinning::io
 	const aiScene* LoadScene(const std::string& filename);
 	/// <summary>
 	/// Not all nodes in a scene are bone nodes, and the root node certainly isn't. so i
-	/// have to find the bone root node 
+	/// have to find the bone root node. The index found it when it was built.
 	/// </summary>
-	/// <param name="rootNode"></param>
-	/// <param name="scene"></param>
+	/// <param name="boneIndex"></param>
 	/// <returns></returns>
-	aiNode* FindArmatureRoot(aiNode* rootNode, const aiScene* scene);
+	aiNode* FindArmatureRoot(const common::SceneBoneIndex& boneIndex);
 	
 	void LoadBoneHierarchy(aiNode* node,
-		const aiScene* scene,
+		const common::SceneBoneIndex& boneIndex,
 		std::vector<entt::entity>& boneEntitiesList,
 		entt::entity parentEntity,
 		entt::registry& registry);
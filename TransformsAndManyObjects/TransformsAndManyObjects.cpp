@@ -1,7 +1,7 @@
 #include "pch.h"
 
 #include "../Common/mesh.h"
-#include "../Common/mesh_load.h"
+#include "../Core/mesh_load.h"
 #include "direct3d_context.h"
 #include "Pipeline.h"
 #include "view_projection.h"
@@ -11,31 +11,45 @@
 #include <filesystem>
 #include "entt/entt.hpp"
 #include "per_object_uniform_buffer.h"
-#include "components.h"
-#include "../Common/delta_timer.h"
-#include "script_runner_system.h"
+#include "../Core/components.h"
+#include "../Core/delta_timer.h"
+#include "../Core/script_runner_system.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <tuple> 
-#include "per_frame_data_for_simple_lighting.h"
+#include "../Core/monotonic_clock.h"
+#include <algorithm>
+#include <sstream>
+#include "../Core/per_frame_data_for_simple_lighting.h"
 #include "per_object_uniform_buffer.h"
-#include "lighting_data.h"
-#include "per_frame_data_for_unlit_debug.h"
+#include "../Core/lighting_data.h"
+#include "../Core/per_frame_data_for_unlit_debug.h"
 #include "on_esc_handler.h"
-#include "camera_input_handler.h"
+#include "../Core/camera_input_handler.h"
 #include "shared_descriptor_heap_v2.h"
 #include "my_imgui_manager.h"
 #include "game_window.h"
 #include "offscreen_render_target.h"
 #include "rtv_dsv_shared_heap.h"
 #include "cube_map_shadow_map.h"
-#include "ShadowDataUpdateSystem.h"
+#include "../Core/ShadowDataUpdateSystem.h"
+#include "../Core/per_object_data_upload_system.h"
 #include "point_shadow_map_calculation_system.h"
+#include "../Core/parallel_command_recorder.h"
+#include "../Core/reference_renderer.h"
+#include "../Core/cpu_profiler.h"
+#include "../Core/frame_stats.h"
+#include "../Core/frame_capture.h"
+#include "../Core/timing_report.h"
+#include "../Core/frame_systems.h"
+#include "../Core/scene_import.h"
+#include <fstream>
 using Microsoft::WRL::ComPtr;
 
 constexpr int W = 1024;
 constexpr int H = 768;
+constexpr float DEFAULT_EXPOSURE = 0.002f;
 typedef std::shared_ptr<transforms::components::BSDFMaterial> BSDFMaterial_t;
 /// <summary>
 /// Storage for the meshes. Do not repeat IDs.
@@ -43,9 +57,10 @@ typedef std::shared_ptr<transforms::components::BSDFMaterial> BSDFMaterial_t;
 std::unordered_map<int, std::shared_ptr<common::Mesh>> gMeshTable;
 /// <summary>
 /// Load the meshes into gMeshTable. It expects that the context has alredy been created.
+/// Without a context nothing is uploaded, the entities get the cpu copy of their mesh for the reference renderer.
 /// </summary>
 /// <param name="ctx"></param>
-void LoadScene(transforms::Context& ctx);
+void LoadScene(transforms::Context* ctx);
 void LoadMeshForOffscreenPresentation(transforms::Context& ctx);
 entt::registry gRegistry;
 
@@ -57,6 +72,9 @@ std::unique_ptr<transforms::UniformBufferForSRVs<transforms::ShadowMapConstants>
 std::unique_ptr<transforms::UniformBufferForSRVs<LightingData>> gLightingDataUniformBuffer = nullptr;
 std::unique_ptr<transforms::MyImguiManager> gImguiManager = nullptr;
 std::unique_ptr<transforms::RtvDsvDescriptorHeapManager> gRtvDsvSharedHeap = nullptr;
+std::unique_ptr<common::WorkerPool> gWorkerPool = nullptr;
+std::unique_ptr<common::ParallelCommandRecorder> gCommandRecorder = nullptr;
+std::unique_ptr<common::SystemScheduler> gSystemScheduler = nullptr;
 
 transforms::Window* gWindow = nullptr;
 
@@ -77,30 +95,155 @@ void CreatePipelines(transforms::RootSignatureService* rootSignatureService, tra
 template<typename type_t>
 void SetOffscreenTextureAsCurrentRenderTarget(
 	type_t* t, 
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList,
+	common::gfx::CommandList& commandList,
 	uint32_t frameIndex) 
 {
-	t->TransitionToRenderTarget(commandList.Get(), frameIndex);
-	t->SetAsRenderTarget(commandList.Get(), frameIndex);
-	t->Clear(commandList.Get(), frameIndex, { 0.0f, 0,0,1 });
+	t->TransitionToRenderTarget(commandList, frameIndex);
+	t->SetAsRenderTarget(commandList, frameIndex);
+	t->Clear(commandList, frameIndex, { 0.0f, 0,0,1 });
 }
 
-int main()
+/// <summary>
+/// --reference out.png renders the first frame with the cpu reference renderer into out.png and quits.
+/// Returns the path, or an empty string to run the gpu renderer.
+/// </summary>
+std::string ParseReferenceArgs(int argc, char** argv)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::string(argv[i]) == "--reference") {
+			return argv[i + 1];
+		}
+	}
+	return "";
+}
+
+/// <summary>
+/// Renders the scene without a gpu: no window, no context, the same camera, lights and materials as the first
+/// frame of the gpu renderer. Returns the process exit code.
+/// </summary>
+int RenderReference(const std::string& outputPath);
+
+/// <summary>
+/// --capture file records the key, time step and state changes of every frame into file.
+/// --replay file drives the frames from a capture instead of the keyboard and quits at its end, the Replay tool
+/// runs it without window nor gpu. --fixed-dt ms is the time step of the simulation, 0 is the real frame time;
+/// captures and replays default to 60 steps per second, so that a replay takes the captured steps and its state
+/// can be checked. --timings file writes the per scope cpu timings of the run at the end, Replay --compare
+/// compares two of them.
+/// </summary>
+struct CaptureSettings
+{
+	std::string capturePath;
+	std::string replayPath;
+	/// <summary>
+	/// In seconds, 0 steps by the real frame time.
+	/// </summary>
+	float fixedDeltaTime = 0;
+	std::string timingsPath;
+};
+CaptureSettings ParseCaptureArgs(int argc, char** argv)
+{
+	CaptureSettings settings;
+	float fixedDeltaTimeMs = -1;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			break;
+		}
+		else if (arg == "--capture") {
+			settings.capturePath = argv[++i];
+		}
+		else if (arg == "--replay") {
+			settings.replayPath = argv[++i];
+		}
+		else if (arg == "--fixed-dt") {
+			fixedDeltaTimeMs = std::max(static_cast<float>(std::atof(argv[++i])), 0.0f);
+		}
+		else if (arg == "--timings") {
+			settings.timingsPath = argv[++i];
+		}
+	}
+	if (fixedDeltaTimeMs < 0) {
+		const bool steppedRun = !settings.replayPath.empty() || !settings.capturePath.empty();
+		fixedDeltaTimeMs = steppedRun ? 1000.0f / 60.0f : 0.0f;
+	}
+	settings.fixedDeltaTime = fixedDeltaTimeMs / 1000.0f;
+	return settings;
+}
+/// <summary>
+/// Writes the timings of the run if the settings ask for them, and says where a replay diverged from its capture.
+/// </summary>
+void ReportRun(const CaptureSettings& settings, const common::FrameStats& frameStats, const common::FrameReplay* replay);
+
+/// <summary>
+/// The systems of a frame on the gpu: the simulation, then the uploads to the uniform buffers, which the
+/// command lists of the frame copy to the gpu.
+/// </summary>
+void AddFrameSystems(common::SystemScheduler& scheduler, transforms::FrameState& frame);
+/// <summary>
+/// --dump-schedule prints the stages of the frame systems, and what each one waits for, at startup.
+/// </summary>
+bool ParseScheduleArgs(int argc, char** argv)
 {
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--dump-schedule") {
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// --frames N sets the frames in flight (2 to 4), --pacing latency|throughput how far the cpu may run ahead.
+/// </summary>
+void ParseFramePacingArgs(int argc, char** argv, UINT& frameCount, transforms::FramePacing& pacing)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--frames") {
+			frameCount = static_cast<UINT>(std::clamp(std::atoi(argv[++i]), MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT));
+		}
+		else if (arg == "--pacing") {
+			pacing = std::string(argv[++i]) == "latency" ? transforms::FramePacing::Latency : transforms::FramePacing::Throughput;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	UINT frameCount = DEFAULT_FRAMES_IN_FLIGHT;
+	transforms::FramePacing framePacing = transforms::FramePacing::Throughput;
+	ParseFramePacingArgs(argc, argv, frameCount, framePacing);
+	const std::string referenceOutput = ParseReferenceArgs(argc, argv);
+	if (!referenceOutput.empty()) {
+		return RenderReference(referenceOutput);
+	}
+	const CaptureSettings captureSettings = ParseCaptureArgs(argc, argv);
+	std::unique_ptr<common::FrameReplay> replay = nullptr;
+	if (!captureSettings.replayPath.empty()) {
+		std::optional<common::FrameCapture> capture = common::ReadCaptureFile(captureSettings.replayPath, std::cerr);
+		if (!capture.has_value()) {
+			return 1;
+		}
+		replay = std::make_unique<common::FrameReplay>(std::move(*capture), captureSettings.fixedDeltaTime);
+		//the profiler statistics cover the whole replay
+		common::CpuProfiler::Get().SetFrameHistory(static_cast<uint32_t>(replay->GetFrameCount()));
+	}
 	HINSTANCE hInstance = GetModuleHandle(NULL);
 	transforms::Window window(hInstance, L"transforms_t", L"Transforms", W, H);
 	window.Show();
 	gWindow = &window;
-	std::unique_ptr<transforms::Context> ctx = std::make_unique<transforms::Context>(W, H, window.Hwnd());
+	std::unique_ptr<transforms::Context> ctx = std::make_unique<transforms::Context>(W, H, window.Hwnd(), frameCount);
+	ctx->SetFramePacing(framePacing);
 	LoadMeshes(ctx.get());
 	std::unique_ptr<transforms::RootSignatureService> rootSignatureService = std::make_unique<transforms::RootSignatureService>();
 	CreateRootSignatures(rootSignatureService.get(), ctx.get());
 	CreatePipelines(rootSignatureService.get(), ctx.get());
 	//create the shared heaps
 	
-	gSharedDescriptors = std::make_unique<transforms::SharedDescriptorHeapV2>(ctx->GetDevice().Get(), 1000);
+	gSharedDescriptors = std::make_unique<transforms::SharedDescriptorHeapV2>(ctx->GetDevice().Get(), 1000, ctx->GetFrameCount());
 	gRtvDsvSharedHeap = std::make_unique<transforms::RtvDsvDescriptorHeapManager>();
-	gRtvDsvSharedHeap->Initialize(ctx->GetDevice().Get(), 1024, 1024);
+	gRtvDsvSharedHeap->Initialize(ctx->GetDevice().Get(), 128, 128);
 	gPerObjectUniformBuffer = std::make_unique<transforms::UniformBufferForSRVs<transforms::PerObjectData>>(*ctx, 
 		gSharedDescriptors.get(), 0, 10000); 
 	gPerFrameUnlitDebugUniformBuffer = std::make_unique<transforms::UniformBufferForSRVs<PerFrameDataForUnlitDebug>>(*ctx, 
@@ -118,25 +261,16 @@ int main()
 	transforms::components::CreateEscHandler(gRegistry, ctx.get(), gWindow);
 	//TODO lighting: create an entity to get keyboard event to switch between unlit debug and simple lighting;
 	/////////////Add a camera to the scene/////////////
-	entt::entity mainCamera = gRegistry.create();
-	transforms::components::Transform cameraTransform;
-	cameraTransform.position = DirectX::XMFLOAT3(-6, 21.f, -12);
-	cameraTransform.LookAt(DirectX::XMFLOAT3(-6, 0.f, 0));
-	transforms::components::Perspective cameraPerspective;
-	cameraPerspective.fovDegrees = 45.0f;
-	cameraPerspective.ratio = (float)W/ (float)H;
-	cameraPerspective.zNear = 0.1f;
-	cameraPerspective.zFar = 500.f;
-	gRegistry.emplace<transforms::components::Transform>(mainCamera, cameraTransform);
-	gRegistry.emplace<transforms::components::Perspective>(mainCamera, cameraPerspective);
-	gRegistry.emplace<transforms::components::tags::MainCamera>(mainCamera, transforms::components::tags::MainCamera{});
-	transforms::components::CreateCameraInputHandler(gWindow, gRegistry, mainCamera);
+	entt::entity mainCamera = transforms::CreateMainCamera(gRegistry, (float)W / (float)H);
+	//the camera sees the key sampled at the start of the frame, from the window or from the replay
+	transforms::KeyCodes frameKey = transforms::KeyCodes::None;
+	transforms::components::CreateCameraInputHandler([&frameKey]() { return frameKey; }, gRegistry, mainCamera);
 	//add shadow map components to the lights
 	int shadowMapId = 0;
 	gRegistry.view<transforms::components::PointLight, transforms::components::Transform>()
 		.each([&ctx, &shadowMapId](entt::entity e, transforms::components::PointLight& pt, transforms::components::Transform& t) {
 		auto shadowMap = std::make_shared<transforms::CubeMapShadowMap>(pt.name, shadowMapId);
-		shadowMap->Initialize(ctx->GetDevice().Get(), gRtvDsvSharedHeap.get(),gSharedDescriptors.get(), SHADOW_MAP_SIZE);
+		shadowMap->Initialize(ctx->GetDevice().Get(), gRtvDsvSharedHeap.get(),gSharedDescriptors.get(), ctx->GetMemoryAllocator(), SHADOW_MAP_SIZE);
 		gRegistry.emplace<std::shared_ptr<transforms::CubeMapShadowMap>>(e, shadowMap);
 		shadowMapId++;
 	});
@@ -151,162 +285,154 @@ int main()
 		unlitDebugPipeline->scissorRect.bottom = newH;
 	};
 	common::DeltaTimer deltaTimer;
+	common::FrameStats frameStats;
 	std::shared_ptr<transforms::OffscreenRenderTarget> mainRenderPassTarget = std::make_shared<transforms::OffscreenRenderTarget>(W,
 		H, ctx.get(), gSharedDescriptors.get(), gRtvDsvSharedHeap.get());
+	common::CpuProfiler::Get().SetThreadName("main");
 	gImguiManager = std::make_unique<transforms::MyImguiManager>(gWindow->Hwnd(), ctx->GetDevice().Get(),
-		ctx->GetCommandQueue().Get(), gSharedDescriptors.get());
-	float exposure = 0.002f;
+		ctx->GetCommandQueue().Get(), gSharedDescriptors.get(), ctx->GetFrameCount());
+	transforms::FrameState frame;
+	frame.exposure = DEFAULT_EXPOSURE;
+	gWorkerPool = std::make_unique<common::WorkerPool>();
+	gSystemScheduler = std::make_unique<common::SystemScheduler>(*gWorkerPool);
+	AddFrameSystems(*gSystemScheduler, frame);
+	if (ParseScheduleArgs(argc, argv)) {
+		gSystemScheduler->WriteSchedule(std::cout);
+	}
+	gCommandRecorder = std::make_unique<common::ParallelCommandRecorder>(ctx->GetGfxDevice(), *gWorkerPool, ctx->GetFrameCount());
+	const bool capturing = !captureSettings.capturePath.empty();
+	common::FrameCapture capture;
 
 	//set onIdle handle to deal with rendering
-	window.mOnIdle = [&ctx, &exposure, &rootSignatureService, &deltaTimer, &mainRenderPassTarget]() {
-		const float deltaTime = deltaTimer.GetDelta();
-		//A rudimentary animation to test the transform
-		transforms::systems::RunScripts(gRegistry, deltaTime);
-		//Update matrices
-		transforms::components::UpdateAllTransforms(gRegistry);
-		//wait until i can interact with this frame again
-		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList = ctx->ResetFrame();
-
-		//Update the per-object uniform buffer
+	window.mOnIdle = [&ctx, &frame, &rootSignatureService, &deltaTimer, &frameStats, &mainRenderPassTarget,
+		&captureSettings, &replay, capturing, &capture, &frameKey]() {
+		//the window closes after the last replayed frame, idle calls until it's gone have nothing to do
+		if (replay != nullptr && !replay->Advance()) {
+			return;
+		}
+		//wait until i can interact with this frame again. It's done before the update so that in latency
+		//mode the scripts see the most recent input.
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+		{
+			PROFILE_SCOPE("WaitForFrame");
+			commandList = ctx->ResetFrame();
+		}
+		const float frameTime = deltaTimer.GetDelta();
+		frameStats.AddFrame(frameTime * 1000.0);
+		//the simulation steps by the replayed or the fixed time step if there is one, by the frame time otherwise
+		float deltaTime = captureSettings.fixedDeltaTime > 0 ? captureSettings.fixedDeltaTime : frameTime;
+		if (replay != nullptr) {
+			deltaTime = replay->GetDeltaTime();
+			frameKey = static_cast<transforms::KeyCodes>(replay->GetFrame().key);
+		}
+		else {
+			frameKey = transforms::Window::GetLastKey();
+		}
+		if (capturing) {
+			capture.BeginFrame(deltaTime, frameKey);
+		}
+		frame.frameIndex = ctx->GetFrameIndex();
+		frame.deltaTime = deltaTime;
+		//scripts, transforms and uniform uploads, see AddFrameSystems
+		{
+			PROFILE_SCOPE("FrameSystems");
+			gSystemScheduler->Run();
+		}
+		if (capturing) {
+			capture.SetStateHash(transforms::HashScriptedState(gRegistry));
+		}
+		if (replay != nullptr) {
+			//ReportRun says where it diverged, once the replay is over
+			replay->CheckState(transforms::HashScriptedState(gRegistry));
+		}
+		const UINT frameIndex = frame.frameIndex;
 		auto renderables = gRegistry.view<transforms::components::Renderable, transforms::components::Transform, BSDFMaterial_t>();
-		renderables.each([&ctx](entt::entity entity,
-			const transforms::components::Renderable& renderable,
-			const transforms::components::Transform& transform,
-			const BSDFMaterial_t mat) {
-				//TODO PBR: transfer PBR data
-				transforms::PerObjectData pod{};
-				pod.modelMatrix = DirectX::XMMatrixTranspose(transform.worldMatrix);
-				pod.inverseTransposeModelMat = DirectX::XMMatrixInverse(nullptr, transform.worldMatrix);
-
-				pod.baseColor = DirectX::XMLoadFloat4(&mat->baseColor);
-				pod.metallicFactor = mat->metallicFactor;
-				pod.roughnessFactor = mat->roughnessFactor;
-				pod.opacity = mat->opacity;
-				pod.refracti = mat->refracti;
-				pod.emissiveColor = DirectX::XMVectorSet(mat->emissiveColor.x, mat->emissiveColor.y, mat->emissiveColor.z, 1);
-
-				gPerObjectUniformBuffer->SetValue(ctx->GetFrameIndex(),
-					renderable.uniformBufferId, pod);
-			});
-		gPerObjectUniformBuffer->CopyToGPU(ctx->GetFrameIndex(), commandList.Get());
-		
-		auto frameIndex = ctx->GetFrameIndex();
-		
-		//TODO REFACTOR: Move this to a better place to clean up the main loop.
-		auto lights = gRegistry.view<transforms::components::Transform, transforms::components::PointLight, std::shared_ptr<transforms::CubeMapShadowMap>>();
-		//TODO REFACTOR: Create the light data upload system to process the light entities and clean up the main loop code.
-		uint32_t numLights = 0;
-		lights.each([&numLights, &ctx](
-			entt::entity e, 
-			transforms::components::Transform t, 
-			transforms::components::PointLight l, 
-			std::shared_ptr<transforms::CubeMapShadowMap> shadowMap) {
-			LightingData ld;
-			ld.attenuationConstant = l.attenuationConstant;
-			ld.attenuationLinear = l.attenuationLinear;
-			ld.attenuationQuadratic = l.attenuationQuadratic;
-			ld.ColorAmbient = l.ColorAmbient;
-			ld.ColorDiffuse = l.ColorDiffuse;
-			ld.ColorSpecular = l.ColorSpecular;
-			auto _p = t.GetWorldPosition();
-			ld.position.x = _p.x;
-			ld.position.y = _p.y;
-			ld.position.z = _p.z;
-			ld.position.w = 0;
-			//copy shadow map data.
-			DirectX::XMStoreFloat4x4(&ld.projectionMatrix, DirectX::XMMatrixTranspose(shadowMap->GetProjectionMatrix()));
-			ld.shadowFarPlane = shadowMap->GetFarPlane();
-			ld.shadowMapIndex = numLights;
-			
-			gLightingDataUniformBuffer->SetValue(ctx->GetFrameIndex(), numLights, ld);
-			numLights++;
-			});
-		gLightingDataUniformBuffer->CopyToGPU(ctx->GetFrameIndex(), commandList.Get());
-		//TODO REFACTOR: Move this to a system somewhere to clean up the main loop
-		auto mainCameraView = gRegistry.view<transforms::components::Transform,
-			transforms::components::Perspective,
-			transforms::components::tags::MainCamera>();
-		mainCameraView.each([&exposure, numLights, &ctx, &commandList](auto entity, transforms::components::Transform transform, auto perspective) {
-			//For now i assume that there's only one camera that matters, the one with the MainCamera tag.
-			using namespace DirectX;
-			XMMATRIX viewMatrix = XMMatrixInverse(nullptr, transform.worldMatrix);
-			XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(perspective.fovDegrees), perspective.ratio, perspective.zNear, perspective.zFar);
-			DirectX::XMMATRIX viewProjectionMatrix = XMMatrixTranspose(XMMatrixMultiply(viewMatrix, projectionMatrix));
-
-			PerFrameDataForUnlitDebug pfd{ viewProjectionMatrix };
-			gPerFrameUnlitDebugUniformBuffer->SetValue(ctx->GetFrameIndex(), 0, pfd);
-			gPerFrameUnlitDebugUniformBuffer->CopyToGPU(ctx->GetFrameIndex(), commandList.Get());
-
-			PerFrameDataForSimpleLighting _sl;
-			_sl.cameraPosition = transform.GetWorldPosition();
-			_sl.projMatrix = DirectX::XMMatrixTranspose(projectionMatrix);
-			_sl.viewMatrix = DirectX::XMMatrixTranspose(viewMatrix);
-			_sl.viewProjMatrix = viewProjectionMatrix;
-			_sl.numberOfPointLights = numLights;
-			_sl.exposure.x = exposure;
-			gPerFrameSimpleLightingUniformBuffer->SetValue(ctx->GetFrameIndex(), 0, _sl);
-			gPerFrameSimpleLightingUniformBuffer->CopyToGPU(ctx->GetFrameIndex(), commandList.Get());
-			});
-		
 		auto shadowProjectors = gRegistry.view<transforms::components::Transform, transforms::components::PointLight, std::shared_ptr<transforms::CubeMapShadowMap>>(); //list of shadow projectors
-		//Fill the shadow data structured buffer and copy to gpu
-		transforms::ShadowDataDataUploadSystem(shadowProjectors, gPointShadowUniformBuffer.get(), frameIndex);
-		gPointShadowUniformBuffer->CopyToGPU(frameIndex, commandList.Get());
-		///POINT LIGHT SHADOW MAP RENDER PASS
-		transforms::PointShadowMapCalculationSystem(
-			shadowProjectors,
-			renderables,
-			frameIndex,
-			rootSignatureService->Get(shadowMapRootSignature).Get(),
-			commandList.Get(),
-			ctx->GetShadowMapPipeline(),
-			gSharedDescriptors.get(),
-			gPerObjectUniformBuffer.get(),
-			gPointShadowUniformBuffer.get()
-		);
-		commandList->BeginEvent(0, L"MainRenderPass", sizeof(L"MainRenderPass"));
-		SetOffscreenTextureAsCurrentRenderTarget<transforms::OffscreenRenderTarget>(mainRenderPassTarget.get(),commandList, ctx->GetFrameIndex());
-		//Bind the root descriptor
-		commandList->SetGraphicsRootSignature(rootSignatureService->Get(simpleLightingRootSignature).Get());
-		//Bind the "descriptor sets"
-		ID3D12DescriptorHeap* heaps[] = { gSharedDescriptors->GetHeap() };
-		commandList->SetDescriptorHeaps(_countof(heaps), heaps);
-		// Bind descriptor tables
-
-		std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> shadowMapDescriptorStart = gSharedDescriptors->GetShadowMapDescriptorRangeStart();
-		// Root parameter 0: per-object data SRV (t0)
-		commandList->SetGraphicsRootDescriptorTable(0,
-			gPerObjectUniformBuffer->GetGPUHandle(ctx->GetFrameIndex()));
-		//lighting: bind the light buffer	
-		commandList->SetGraphicsRootDescriptorTable(2,
-			gPerFrameSimpleLightingUniformBuffer->GetGPUHandle(ctx->GetFrameIndex()));
-		commandList->SetGraphicsRootDescriptorTable(3,
-			gLightingDataUniformBuffer->GetGPUHandle(ctx->GetFrameIndex()));
-		commandList->SetGraphicsRootDescriptorTable(4, shadowMapDescriptorStart.second);
-		// Fill out the Viewport
-		SetViewportAndScissors(unlitDebugPipeline, W, H);
-		SetViewportAndScissors(BSDFPipeline, W, H);
-		BSDFPipeline->Bind(ctx->GetCommandList());
-		//Draw, in the same order that we passed the data
-		renderables.each([&ctx](entt::entity entity,
-			const transforms::components::Renderable& renderable,
-			const transforms::components::Transform& transform,
-			const BSDFMaterial_t material)
-			{
-				ctx->GetCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-				ctx->GetCommandList()->IASetVertexBuffers(0, 1, &renderable.mVertexBufferView);
-				ctx->GetCommandList()->IASetIndexBuffer(&renderable.mIndexBufferView);
-				ctx->GetCommandList()->SetGraphicsRoot32BitConstant(1, renderable.uniformBufferId, 0);
-				ctx->GetCommandList()->DrawIndexedInstanced(
-					renderable.mNumberOfIndices,     // number of indices
-					1,              // instance count
-					0,              // start index
-					0,              // base vertex
-					0               // start instance
-				);
+		//Snapshot what the parallel passes read, the workers must not touch the registry
+		std::vector<const transforms::components::Renderable*> drawList;
+		renderables.each([&drawList](entt::entity, const transforms::components::Renderable& renderable,
+			const transforms::components::Transform&, const BSDFMaterial_t) {
+				drawList.push_back(&renderable);
 			});
-
-		commandList->EndEvent();
+		std::vector<transforms::CubeMapShadowMap*> shadowMaps;
+		shadowProjectors.each([&shadowMaps](entt::entity, transforms::components::Transform&, transforms::components::PointLight&,
+			std::shared_ptr<transforms::CubeMapShadowMap> sm) {
+				shadowMaps.push_back(sm.get());
+			});
+		//The frame as passes in gpu order: uploads and barriers, one item per shadow face, the main pass target
+		//setup, slices of the main draw list. Parallel passes are split in about one segment per core, recording
+		//cost is per draw call.
+		constexpr uint64_t MIN_DRAWS_PER_LIST = 64;
+		const uint32_t maxSegments = gWorkerPool->GetConcurrency();
+		common::RecordingPlan plan;
+		const uint32_t prologuePass = plan.AddSerialPass();
+		const uint32_t shadowPass = plan.AddParallelPass(
+			std::vector<uint64_t>(shadowMaps.size() * 6, drawList.size()), maxSegments, MIN_DRAWS_PER_LIST);
+		const uint32_t mainSetupPass = plan.AddSerialPass();
+		const uint32_t mainPass = plan.AddParallelPass(
+			std::vector<uint64_t>(drawList.size(), 1), maxSegments, MIN_DRAWS_PER_LIST);
+		ID3D12RootSignature* shadowRootSignature = rootSignatureService->Get(shadowMapRootSignature).Get();
+		ID3D12RootSignature* lightingRootSignature = rootSignatureService->Get(simpleLightingRootSignature).Get();
+		std::vector<common::gfx::CommandList*> recordedLists;
+		{
+			PROFILE_SCOPE("RecordCommandLists");
+			recordedLists = gCommandRecorder->Record(frameIndex, plan,
+				[&](const common::RecordingSegment& segment, common::gfx::CommandList& list) {
+					if (segment.pass == prologuePass) {
+						PROFILE_SCOPE("UniformCopies");
+						gPerObjectUniformBuffer->CopyToGPU(frameIndex, list);
+						gLightingDataUniformBuffer->CopyToGPU(frameIndex, list);
+						gPerFrameUnlitDebugUniformBuffer->CopyToGPU(frameIndex, list);
+						gPerFrameSimpleLightingUniformBuffer->CopyToGPU(frameIndex, list);
+						gPointShadowUniformBuffer->CopyToGPU(frameIndex, list);
+						for (transforms::CubeMapShadowMap* sm : shadowMaps) {
+							sm->TransitionToRenderTarget(list, 0);
+						}
+					}
+					else if (segment.pass == shadowPass) {
+						///POINT LIGHT SHADOW MAP RENDER PASS, a slice of the faces of all lights
+						PROFILE_SCOPE("ShadowRecording");
+						transforms::BeginPointShadowPass(list, shadowRootSignature, ctx->GetShadowMapPipeline(), gSharedDescriptors.get());
+						for (uint32_t item = segment.firstItem; item < segment.firstItem + segment.itemCount; item++) {
+							transforms::RecordPointShadowFace(shadowMaps[item / 6], item % 6, item, drawList, frameIndex, list,
+								gPerObjectUniformBuffer.get(), gPointShadowUniformBuffer.get());
+						}
+					}
+					else if (segment.pass == mainSetupPass) {
+						for (transforms::CubeMapShadowMap* sm : shadowMaps) {
+							sm->TransitionToPixelShaderResource(list, 0);
+						}
+						SetOffscreenTextureAsCurrentRenderTarget<transforms::OffscreenRenderTarget>(mainRenderPassTarget.get(), list, frameIndex);
+					}
+					else if (segment.pass == mainPass) {
+						PROFILE_SCOPE("MainPassRecording");
+						using common::gfx::ToHandle;
+						list.BeginEvent(L"MainRenderPass");
+						mainRenderPassTarget->SetAsRenderTarget(list, frameIndex);
+						//Bind the root descriptor
+						list.SetGraphicsRootSignature(ToHandle(lightingRootSignature));
+						//Bind the "descriptor sets"
+						list.SetDescriptorHeap(ToHandle(gSharedDescriptors->GetHeap()));
+						// Bind descriptor tables
+						// Root parameter 0: per-object data SRV (t0)
+						list.SetGraphicsRootDescriptorTable(0, ToHandle(gPerObjectUniformBuffer->GetGPUHandle(frameIndex)));
+						//lighting: bind the light buffer
+						list.SetGraphicsRootDescriptorTable(2, ToHandle(gPerFrameSimpleLightingUniformBuffer->GetGPUHandle(frameIndex)));
+						list.SetGraphicsRootDescriptorTable(3, ToHandle(gLightingDataUniformBuffer->GetGPUHandle(frameIndex)));
+						list.SetGraphicsRootDescriptorTable(4, ToHandle(gSharedDescriptors->GetShadowMapDescriptorRangeStart().second));
+						BSDFPipeline->Bind(list);
+						//Draw, in the same order that we passed the data
+						for (uint32_t item = segment.firstItem; item < segment.firstItem + segment.itemCount; item++) {
+							const transforms::components::Renderable* renderable = drawList[item];
+							list.SetVertexBuffer(renderable->mVertexBufferView);
+							list.SetIndexBuffer(renderable->mIndexBufferView);
+							list.SetGraphicsRoot32BitConstant(1, renderable->uniformBufferId, 0);
+							list.DrawIndexedInstanced(renderable->mNumberOfIndices, 1, 0, 0, 0);
+						}
+						list.EndEvent();
+					}
+				});
+		}
 		commandList->BeginEvent(0, L"PresentationPass", sizeof(L"PresentationPass"));
 		///The main render pass is finished. We get the offscreen texture that was used as target and draw it 
 		///over a quad.
@@ -316,34 +442,148 @@ int main()
 		ctx->SetCurrentOutputMergerTarget();;
 		// Clear the render target by using the ClearRenderTargetView command
 		ctx->ClearRenderTargetView({ 0.4f, 0.2f, 0.4f, 1.0f });
-		mainRenderPassTarget->TransitionToPixelShaderResource(commandList.Get(), ctx->GetFrameIndex());
+		mainRenderPassTarget->TransitionToPixelShaderResource(ctx->GetGfxCommandList(), ctx->GetFrameIndex());
 		commandList->SetGraphicsRootSignature(rootSignatureService->Get(quadRenderRootSignature).Get());
+		//this list doesn't inherit anything from the parallel ones
+		ID3D12DescriptorHeap* heaps[] = { gSharedDescriptors->GetHeap() };
+		commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+		commandList->RSSetViewports(1, &BSDFPipeline->viewport);
+		commandList->RSSetScissorRects(1, &BSDFPipeline->scissorRect);
 		commandList->SetPipelineState(ctx->GetFullscreenQuadPSO().Get());
 		commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 		commandList->SetGraphicsRootDescriptorTable(0, mainRenderPassTarget->GetSRVHandle(ctx->GetFrameIndex()));
 		commandList->DrawInstanced(3, 1, 0, 0);
 #pragma region "imgui"
-		gImguiManager->BeginFrame();
-		gImguiManager->PushImguiWindow("foo", 300, 200);
-		gImguiManager->FloatInput("Exposure", exposure, 0.001f, 0.010f);
-		//gImguiManager->PushButton("click me", []() {
-		//	std::cout << "Button was clicked!" << std::endl;
-		//});
-		gImguiManager->PopImguiWindow();
-		gImguiManager->EndFrame(commandList.Get());
+		{
+			PROFILE_SCOPE("Imgui");
+			gImguiManager->BeginFrame();
+			gImguiManager->PushImguiWindow("foo", 300, 200);
+			const float previousExposure = frame.exposure;
+			gImguiManager->FloatInput("Exposure", frame.exposure, 0.001f, 0.010f);
+			if (replay != nullptr) {
+				//the replayed changes happen where the captured ones did, after this frame's uploads
+				for (const common::CapturedEvent& e : replay->GetFrame().events) {
+					if (e.name == "exposure") {
+						frame.exposure = static_cast<float>(e.value);
+					}
+					else if (e.name == "latency_pacing") {
+						ctx->SetFramePacing(e.value != 0 ? transforms::FramePacing::Latency : transforms::FramePacing::Throughput);
+					}
+				}
+			}
+			if (capturing && frame.exposure != previousExposure) {
+				capture.AddEvent("exposure", frame.exposure);
+			}
+			{
+				const transforms::FrameTimings& timings = ctx->GetFrameTimings();
+				const bool latency = ctx->GetFramePacing() == transforms::FramePacing::Latency;
+				std::stringstream ss;
+				ss.precision(2);
+				ss << std::fixed << ctx->GetFrameCount() << " frames in flight, " << (latency ? "latency" : "throughput") << " mode\n"
+					<< "cpu wait " << timings.cpuWaitMs << " ms, gpu idle " << timings.gpuIdleMs
+					<< " ms, gpu busy " << timings.gpuBusyMs << " ms";
+				gImguiManager->Text(ss.str());
+				gImguiManager->PushButton(latency ? "Switch to throughput mode" : "Switch to latency mode", [&ctx, latency, capturing, &capture]() {
+					ctx->SetFramePacing(latency ? transforms::FramePacing::Throughput : transforms::FramePacing::Latency);
+					if (capturing) {
+						capture.AddEvent("latency_pacing", latency ? 0 : 1);
+					}
+					});
+			}
+			{
+				const common::FrameStatsSummary summary = frameStats.GetSummary();
+				std::stringstream ss;
+				ss.precision(2);
+				ss << std::fixed << "frame p50 " << summary.p50Ms << " ms, p95 " << summary.p95Ms << " ms, p99 " << summary.p99Ms << " ms\n"
+					<< "jitter " << summary.jitterMs << " ms, " << summary.stutterCount << " stutters";
+				gImguiManager->Text(ss.str());
+				gImguiManager->PushButton("Save frame times", [&frameStats]() {
+					std::ofstream frames("frame_times.csv");
+					frameStats.WriteFramesCsv(frames);
+					std::ofstream histogram("frame_time_histogram.csv");
+					frameStats.WriteHistogramCsv(histogram);
+					std::cout << "Frame times written to frame_times.csv and frame_time_histogram.csv" << std::endl;
+					});
+			}
+			//gImguiManager->PushButton("click me", []() {
+			//	std::cout << "Button was clicked!" << std::endl;
+			//});
+			gImguiManager->PopImguiWindow();
+			gImguiManager->PushImguiWindow("CPU profiler", 420, 320);
+			{
+				common::CpuProfiler& profiler = common::CpuProfiler::Get();
+				std::vector<std::vector<std::string>> rows;
+				for (const common::ScopeStats& stats : profiler.GetScopeStats()) {
+					std::stringstream min, avg, p99, max, calls;
+					min.precision(3);
+					avg.precision(3);
+					p99.precision(3);
+					max.precision(3);
+					calls.precision(1);
+					min << std::fixed << stats.minMs;
+					avg << std::fixed << stats.avgMs;
+					p99 << std::fixed << stats.p99Ms;
+					max << std::fixed << stats.maxMs;
+					calls << std::fixed << stats.callsPerFrame;
+					rows.push_back({ std::string(stats.depth * 2, ' ') + stats.name, min.str(), avg.str(), p99.str(), max.str(), calls.str() });
+				}
+				gImguiManager->Text("last " + std::to_string(profiler.GetFrameCount()) + " frames, times in ms per frame");
+				gImguiManager->Table("cpu scopes", { "scope", "min", "avg", "p99", "max", "calls" }, rows);
+				const bool enabled = profiler.IsEnabled();
+				gImguiManager->PushButton(enabled ? "Pause" : "Resume", [&profiler, enabled]() {
+					profiler.SetEnabled(!enabled);
+					});
+				gImguiManager->PushButton("Save chrome trace", [&profiler]() {
+					std::ofstream trace("cpu_trace.json");
+					profiler.WriteChromeTrace(trace);
+					std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+					});
+			}
+			gImguiManager->PopImguiWindow();
+			gImguiManager->EndFrame(commandList.Get());
+		}
 #pragma endregion
 
 		//now that we drew everything, transition the rtv to presentation
 		ctx->TransitionCurrentRenderTarget(D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 		commandList->EndEvent();
 		//Submit the commands and present
-		ctx->Present();
+		{
+			PROFILE_SCOPE("Present");
+			ctx->Present(recordedLists);
+		}
+		common::CpuProfiler::Get().EndFrame();
+		if (replay != nullptr && replay->GetFrameNumber() + 1 >= replay->GetFrameCount()) {
+			DestroyWindow(gWindow->Hwnd());
+		}
 		};
 	//fire main loop
 	window.MainLoop();
+	{
+		const common::FrameStatsSummary summary = frameStats.GetSummary();
+		std::cout << summary.frameCount << " frames (" << common::MonotonicClock::GetSourceName() << "): mean " << summary.meanMs
+			<< " ms, p50 " << summary.p50Ms << " ms, p95 " << summary.p95Ms << " ms, p99 " << summary.p99Ms
+			<< " ms, jitter " << summary.jitterMs << " ms, " << summary.stutterCount << " stutters" << std::endl;
+	}
+	if (capturing) {
+		std::ofstream captureFile(captureSettings.capturePath);
+		capture.Write(captureFile);
+		std::cout << capture.GetFrames().size() << " frames captured to " << captureSettings.capturePath << std::endl;
+	}
+	ReportRun(captureSettings, frameStats, replay.get());
 	ctx->WaitForPreviousFrame();
+	ctx->WaitAllFrames();
+	//the shadow maps live in the registry and give their descriptors back when destroyed,
+	//so the registry has to go before the heaps
+	gRegistry.clear();
+	mainRenderPassTarget.reset();
+	std::cout << "RTV high water mark: " << gRtvDsvSharedHeap->GetRTVHighWaterMark() << "/" << gRtvDsvSharedHeap->GetRTVCapacity()
+		<< ", DSV high water mark: " << gRtvDsvSharedHeap->GetDSVHighWaterMark() << "/" << gRtvDsvSharedHeap->GetDSVCapacity() << std::endl;
 
 	rootSignatureService.reset();
+	gSystemScheduler.reset();
+	gCommandRecorder.reset();
+	gWorkerPool.reset();
 	ctx.reset();
 	for (auto& m : gMeshTable) {
 		m.second = nullptr;
@@ -357,247 +597,33 @@ DirectX::XMFLOAT3 _aiVec3ToDirectXVector(aiVector3D& vec)
 	return v;
 }
 
-DirectX::XMFLOAT4 _aiColor3DToDirectXVector4(aiColor3D& vec)
-{
-	DirectX::XMFLOAT4 v(vec.r, vec.g, vec.b, 1.0f);
-	return v;
-}
 DirectX::XMFLOAT2 _removeZ(DirectX::XMFLOAT3 vec)
 {
 	DirectX::XMFLOAT2 v(vec.x, vec.y);
 	return v;
 }
-std::tuple<DirectX::XMFLOAT3, DirectX::XMFLOAT4, DirectX::XMFLOAT3> GetLocalTransform(aiMatrix4x4 transform) {
-	aiVector3D position;
-	aiQuaternion rotation;
-	aiVector3D scale;
-	transform.Decompose(scale, rotation, position);
-	DirectX::XMFLOAT3 p(position.x, position.y, position.z);
-	DirectX::XMFLOAT4 r(rotation.x, rotation.y, rotation.z, rotation.w);
-	DirectX::XMFLOAT3 s(scale.x, scale.y, scale.z);
-	return std::make_tuple(p, r, s); 
-}
-entt::entity ProcessNode(aiNode* node, const aiScene* scene, 
-	transforms::Context& ctx, 
-	std::vector<BSDFMaterial_t> materials,
-	entt::entity parent = entt::null) {
-	using namespace transforms::components;
-	std::string name = node->mName.C_Str();
-	std::cout << "Processing node " << name << std::endl;
-	entt::entity e = gRegistry.create();
-	// Decompose the matrix into components and create the transform component.
-	auto prs = GetLocalTransform(node->mTransformation);
-	Transform transform;
-	transform.position = std::get<0>(prs);
-	transform.rotation = std::get<1>(prs);
-	transform.scale = std::get<2>(prs);
-	transform.updateEulers();
-	gRegistry.emplace<Transform>(e, transform);
-	// Create the hierarchy component and set the parent received as param as the parent of the hierarchy
-	Hierarchy hierarchy;
-	hierarchy.parent = parent;
-	//Get the meshes
-	for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-		aiMesh* currMesh = scene->mMeshes[node->mMeshes[i]];
-		common::MeshData md;
-		md.normals.resize(currMesh->mNumVertices);
-		md.vertices.resize(currMesh->mNumVertices);
-		md.uv.resize(currMesh->mNumVertices);
-		md.tg.resize(currMesh->mNumVertices);
-		md.cotg.resize(currMesh->mNumVertices);
-		for (uint32_t i = 0; i < currMesh->mNumVertices; i++) {
-			md.vertices[i] = _aiVec3ToDirectXVector(currMesh->mVertices[i]);
-			md.normals[i] = _aiVec3ToDirectXVector(currMesh->mNormals[i]);
-			md.uv[i] = _removeZ(_aiVec3ToDirectXVector(currMesh->mTextureCoords[0][i]));
-			//PBR: get tangent and bitangent
-			md.tg[i] = _aiVec3ToDirectXVector(currMesh->mTangents[i]);
-			md.cotg[i] = _aiVec3ToDirectXVector(currMesh->mBitangents[i]);
-			currMesh->mTangents[i];
-		}
-		std::vector<uint16_t> indexData;
-		for (unsigned int j = 0; j < currMesh->mNumFaces; j++) {
-			aiFace face = currMesh->mFaces[j];
-			for (unsigned int k = 0; k < face.mNumIndices; k++) {
-				indexData.push_back(face.mIndices[k]);
-			}
+void LoadScene(transforms::Context* ctx) {
+	///////path setup
+	std::filesystem::path executionPath = std::filesystem::current_path();
+	std::cout << "executionPath: " << executionPath << '\n';
+	transforms::ImportScene(gRegistry, "assets/Map.glb", [ctx](entt::entity e, const common::MeshData& md) {
+		if (ctx == nullptr) {
+			//reference renderer: keep the mesh on the cpu
+			gRegistry.emplace<std::shared_ptr<transforms::ReferenceMesh>>(e, transforms::MakeReferenceMesh(md));
+			return;
 		}
-		md.name = std::string(currMesh->mName.C_Str());
-		md.indices = indexData;
-		std::shared_ptr<common::Mesh> dxMesh = std::make_shared<common::Mesh>(md,ctx.GetDevice(), ctx.GetCommandQueue());
+		std::shared_ptr<common::Mesh> dxMesh = std::make_shared<common::Mesh>(md, ctx->GetDevice(), *ctx->GetRecycler(), ctx->GetMemoryAllocator());
 		auto meshIdx = gMeshTable.size();
 		gMeshTable.insert({ meshIdx, dxMesh });
-		std::cout << " Has mesh, added at index " << meshIdx << " " << currMesh->mName.C_Str() << std::endl;
+		std::cout << " Has mesh, added at index " << meshIdx << " " << md.name << std::endl;
 		//now that i have the mesh, create the renderable
-		Renderable renderable;
-		renderable.mIndexBufferView = dxMesh->IndexBufferView();
+		transforms::components::Renderable renderable;
+		renderable.mIndexBufferView = common::gfx::ToView(dxMesh->IndexBufferView());
 		renderable.mNumberOfIndices = dxMesh->NumberOfIndices();
-		renderable.mVertexBufferView = dxMesh->VertexBufferView();
+		renderable.mVertexBufferView = common::gfx::ToView(dxMesh->VertexBufferView());
 		renderable.uniformBufferId = GetNumberOfRenderables(gRegistry);
-		gRegistry.emplace<Renderable>(e, renderable);
-		//PBR: Add the material component to the meshes based on the material id
-		auto material = materials[currMesh->mMaterialIndex];
-		gRegistry.emplace<BSDFMaterial_t>(e, material);
-	}
-
-	//lighting: Get the lights
-	for (unsigned int i = 0; i < scene->mNumLights; ++i) {
-		aiLight* light = scene->mLights[i];
-		if (strcmp(light->mName.C_Str(), node->mName.C_Str()) == 0) {
-			//I assume one light per node.
-			transforms::components::PointLight pl{}; 
-			
-			std::string str(light->mName.C_Str());
-			std::wstring wstr(str.begin(), str.end());
-			
-			pl.name = wstr;
-			pl.attenuationConstant = light->mAttenuationConstant;
-			pl.attenuationLinear = light->mAttenuationLinear;
-			pl.attenuationQuadratic = light->mAttenuationQuadratic;
-			pl.ColorAmbient = _aiColor3DToDirectXVector4(light->mColorAmbient);
-			pl.ColorDiffuse = _aiColor3DToDirectXVector4(light->mColorDiffuse);
-			pl.ColorSpecular = _aiColor3DToDirectXVector4(light->mColorSpecular);
-			gRegistry.emplace<transforms::components::PointLight>(e, pl);
-		}
-	}
-	for (unsigned int i = 0; i < node->mNumChildren; i++) {
-		entt::entity child = ProcessNode(node->mChildren[i], scene,ctx,materials, e);
-		hierarchy.AddChild(child);
-	}
-	gRegistry.emplace<Hierarchy>(e, hierarchy);
-	return e;
-}
-std::string GetMaterialName(aiMaterial* material) {
-	aiString ai_name;
-	material->Get(AI_MATKEY_NAME, ai_name);
-	std::string str_name = ai_name.C_Str();
-	return str_name;
-}
-DirectX::XMFLOAT4 GetBaseColor(aiMaterial* material) {
-	aiColor4D c;
-	material->Get(AI_MATKEY_BASE_COLOR, c);
-	DirectX::XMFLOAT4 dx_color(c.r, c.g, c.b, c.a);
-	return dx_color;
-}
-float GetMetallicFactor(aiMaterial* material) {
-	float f;
-	material->Get(AI_MATKEY_METALLIC_FACTOR, f);
-	return f;
-}
-float GetRoughnessFactor(aiMaterial* material) {
-	float f;
-	material->Get(AI_MATKEY_ROUGHNESS_FACTOR, f);
-	return f;
-}
-DirectX::XMFLOAT3 GetColorEmissive(aiMaterial* m) {
-	aiColor3D c;
-	m->Get(AI_MATKEY_COLOR_EMISSIVE, c);
-	DirectX::XMFLOAT3 dx_color(c.r, c.g, c.b);
-	return dx_color;
-}
-float GetOpacity(aiMaterial* m) {
-	float f;
-	m->Get(AI_MATKEY_OPACITY, f);
-	return f;
-}
-float GetRefracti(aiMaterial* m) {
-	//TODO PBR FIXME: Blender aint exporting the index of refraction
-	float f = 2.5f; // Default IOR for most materials (air-glass boundary)
-	if (AI_SUCCESS != m->Get(AI_MATKEY_REFRACTI, f)) {
-		std::cout << "No IOR (Refracti) in material" << std::endl;
-		f = 2.5f; // fallback
-	}
-	return f;
-}
-std::string GetBaseColorTexturePath(aiMaterial* m) {
-	aiString ai_name;
-	// GetTexture needs 3 parameters: texture type, index, and output string
-	if (m->GetTexture(aiTextureType_BASE_COLOR, 0, &ai_name) == AI_SUCCESS) {
-		return std::string(ai_name.C_Str());
-	}
-	return ""; 
-}
-std::string GetMetalnessTexturePath(aiMaterial* m) {
-	aiString ai_name;
-	// GetTexture needs 3 parameters: texture type, index, and output string
-	if (m->GetTexture(aiTextureType_METALNESS, 0, &ai_name) == AI_SUCCESS) {
-		return std::string(ai_name.C_Str());
-	}
-	return "";
-}
-std::string GetDiffuseRoughnessTexturePath(aiMaterial* m) {
-	aiString ai_name;
-	// GetTexture needs 3 parameters: texture type, index, and output string
-	if (m->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &ai_name) == AI_SUCCESS) {
-		return std::string(ai_name.C_Str());
-	}
-	return "";
-	
-}
-std::string GetNormalsTexturePath(aiMaterial* m) {
-	aiString ai_name;
-	// GetTexture needs 3 parameters: texture type, index, and output string
-	if (m->GetTexture(aiTextureType_NORMALS, 0, &ai_name) == AI_SUCCESS) {
-		return std::string(ai_name.C_Str());
-	}
-	return "";
-}
-std::string GetEmissiveTexturePath(aiMaterial* m) {
-	aiString ai_name;
-	// GetTexture needs 3 parameters: texture type, index, and output string
-	if (m->GetTexture(aiTextureType_EMISSIVE, 0, &ai_name) == AI_SUCCESS) {
-		return std::string(ai_name.C_Str());
-	}
-	return "";
-}
-void LoadScene(transforms::Context& ctx) {
-	///////path setup
-	std::filesystem::path executionPath = std::filesystem::current_path();
-	std::cout << "executionPath: " << executionPath << '\n';
-	const std::string path = "assets/Map.glb";
-	Assimp::Importer importer;
-	///////read the file and throws if something bad happens
-	const aiScene* scene = importer.ReadFile(path.c_str(),
-		aiProcess_Triangulate 
-		|aiProcess_JoinIdenticalVertices 
-		| aiProcess_CalcTangentSpace //PBR: need this to generate tangents and bitangents
-		|aiProcess_MakeLeftHanded 
-		|aiProcess_FlipWindingOrder
-	);
-	std::vector<BSDFMaterial_t> bsdfMaterials;
-	const char* err = importer.GetErrorString();
-	if (!scene) {
-		throw std::runtime_error(importer.GetErrorString());
-	}
-	//Material: read all materials
-	for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
-		aiMaterial* material = scene->mMaterials[i];
-		std::string name = GetMaterialName(material);
-		DirectX::XMFLOAT4 baseColor = GetBaseColor(material);
-		float metallicFactor = GetMetallicFactor(material);
-		float roughnessFactor = GetRoughnessFactor(material);
-		DirectX::XMFLOAT3 emissiveColor = GetColorEmissive(material);
-		float opacity = GetOpacity(material);
-		float refracti = GetRefracti(material);
-		//TODO PBR: Use the textures if they are present
-		std::string baseColorTexture = GetBaseColorTexturePath(material); 
-		std::string metalnessTexture = GetMetalnessTexturePath(material);
-		std::string diffuseRoughnessTexture = GetDiffuseRoughnessTexturePath(material);
-		std::string normalsTexture = GetNormalsTexturePath(material);
-		std::string emissiveTexture = GetEmissiveTexturePath(material);
-		auto m = std::make_shared<transforms::components::BSDFMaterial>();
-		m->baseColor = baseColor;
-		m->emissiveColor = emissiveColor;
-		m->idInFile = i;
-		m->metallicFactor = metallicFactor;
-		m->name = name;
-		m->opacity = opacity;
-		m->refracti = refracti;
-		m->roughnessFactor = roughnessFactor;
-		bsdfMaterials.push_back(m);
-		
-	}
-	//entt::entity child = ProcessNode(node->mChildren[i], scene,ctx,materials, e);
-	entt::entity rootEntity = ProcessNode(scene->mRootNode, scene, ctx, bsdfMaterials);
+		gRegistry.emplace<transforms::components::Renderable>(e, renderable);
+	});
 }
 void LoadMeshForOffscreenPresentation(transforms::Context& ctx) {
 	///////path setup
@@ -651,16 +677,16 @@ void LoadMeshForOffscreenPresentation(transforms::Context& ctx) {
 	}
 	md.name = std::string(currMesh->mName.C_Str());
 	md.indices = indexData;
-	std::shared_ptr<common::Mesh> dxMesh = std::make_shared<common::Mesh>(md, ctx.GetDevice(), ctx.GetCommandQueue());
+	std::shared_ptr<common::Mesh> dxMesh = std::make_shared<common::Mesh>(md, ctx.GetDevice(), *ctx.GetRecycler(), ctx.GetMemoryAllocator());
 	auto meshIdx = gMeshTable.size();
 	gMeshTable.insert({ meshIdx, dxMesh });
 	std::cout << " Has mesh, added at index " << meshIdx << " " << currMesh->mName.C_Str() << std::endl;
 	//now that i have the mesh, create the renderable
 	entt::entity e = gRegistry.create();
 	transforms::components::Renderable renderable;
-	renderable.mIndexBufferView = dxMesh->IndexBufferView();
+	renderable.mIndexBufferView = common::gfx::ToView(dxMesh->IndexBufferView());
 	renderable.mNumberOfIndices = dxMesh->NumberOfIndices();
-	renderable.mVertexBufferView = dxMesh->VertexBufferView();
+	renderable.mVertexBufferView = common::gfx::ToView(dxMesh->VertexBufferView());
 	renderable.uniformBufferId = GetNumberOfRenderables(gRegistry);
 	gRegistry.emplace<transforms::components::Renderable>(e, renderable);
 	//this entity won't have a transform because it'll not be trasformed. It exists to be a surface for drawing a quad
@@ -670,7 +696,7 @@ void LoadMeshForOffscreenPresentation(transforms::Context& ctx) {
 
 }
 void LoadMeshes(transforms::Context* ctx) {
-	LoadScene(*ctx);
+	LoadScene(ctx);
 	LoadMeshForOffscreenPresentation(*ctx); //offscreen: Load a quad from the disk to serve as mesh. it'll have the tag SceneOffscreenRenderResult and a renderable component
 }
 
@@ -700,4 +726,108 @@ void CreatePipelines(transforms::RootSignatureService* rootSignatureService, tra
 	);
 	ctx->CreateFullscreenQuadPipeline(rootSignatureService->Get(quadRenderRootSignature).Get());
 	ctx->CreateShadowMapPipeline(rootSignatureService->Get(shadowMapRootSignature).Get());
-}
\ No newline at end of file
+}
+
+common::sw::Mat4 ToReferenceMatrix(const DirectX::XMMATRIX& m) {
+	DirectX::XMFLOAT4X4 stored;
+	DirectX::XMStoreFloat4x4(&stored, m);
+	common::sw::Mat4 r;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			r.m[i][j] = stored.m[i][j];
+		}
+	}
+	return r;
+}
+
+int RenderReference(const std::string& outputPath) {
+	using namespace transforms::components;
+	LoadScene(nullptr);
+	transforms::CreateMainCamera(gRegistry, (float)W / (float)H);
+	UpdateAllTransforms(gRegistry);
+	//the same data the first gpu frame uploads to the per object, lighting and per frame buffers
+	transforms::ReferenceScene scene;
+	scene.exposure = DEFAULT_EXPOSURE;
+	gRegistry.view<std::shared_ptr<transforms::ReferenceMesh>, Transform, BSDFMaterial_t>().each(
+		[&scene](entt::entity, const std::shared_ptr<transforms::ReferenceMesh>& mesh, const Transform& transform,
+			const BSDFMaterial_t mat) {
+			transforms::ReferenceObject object;
+			object.mesh = mesh;
+			object.world = ToReferenceMatrix(transform.worldMatrix);
+			object.baseColor = { mat->baseColor.x, mat->baseColor.y, mat->baseColor.z, mat->baseColor.w };
+			object.metallicFactor = mat->metallicFactor;
+			object.roughnessFactor = mat->roughnessFactor;
+			object.opacity = mat->opacity;
+			object.emissiveColor = { mat->emissiveColor.x, mat->emissiveColor.y, mat->emissiveColor.z };
+			scene.objects.push_back(object);
+		});
+	gRegistry.view<Transform, PointLight>().each([&scene](entt::entity, Transform& t, const PointLight& l) {
+		transforms::ReferenceLight light;
+		const DirectX::XMFLOAT3 p = t.GetWorldPosition();
+		light.position = { p.x, p.y, p.z };
+		light.attenuationConstant = l.attenuationConstant;
+		light.attenuationLinear = l.attenuationLinear;
+		light.attenuationQuadratic = l.attenuationQuadratic;
+		light.colorDiffuse = { l.ColorDiffuse.x, l.ColorDiffuse.y, l.ColorDiffuse.z, l.ColorDiffuse.w };
+		scene.lights.push_back(light);
+	});
+	gRegistry.view<Transform, Perspective, tags::MainCamera>().each([&scene](entt::entity, Transform& t, const Perspective& perspective) {
+		using namespace DirectX;
+		scene.view = ToReferenceMatrix(XMMatrixInverse(nullptr, t.worldMatrix));
+		scene.projection = ToReferenceMatrix(XMMatrixPerspectiveFovLH(XMConvertToRadians(perspective.fovDegrees),
+			perspective.ratio, perspective.zNear, perspective.zFar));
+		const XMFLOAT3 p = t.GetWorldPosition();
+		scene.cameraPosition = { p.x, p.y, p.z };
+	});
+	common::WorkerPool workerPool;
+	transforms::ReferenceRenderer renderer(workerPool, SHADOW_MAP_SIZE);
+	common::sw::ColorBuffer frame(W, H);
+	const uint64_t start = common::MonotonicClock::Now();
+	renderer.Render(scene, frame);
+	const double ms = common::MonotonicClock::ToNanoseconds(common::MonotonicClock::Now() - start) * 1.0e-6;
+	const common::sw::RasterizerStats& stats = renderer.GetStats();
+	std::cout << "Reference frame: " << scene.objects.size() << " objects, " << scene.lights.size() << " lights, "
+		<< stats.trianglesBinned << "/" << stats.trianglesIn << " triangles rasterized, " << stats.pixelsShaded
+		<< " pixels shaded in " << ms << " ms on " << workerPool.GetConcurrency() << " threads" << std::endl;
+	gRegistry.clear();
+	//the presentation pass is a 1:1 copy, the png is the offscreen target as the window would show it
+	if (!common::sw::WritePng(outputPath, frame)) {
+		std::cerr << "Could not write " << outputPath << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+void AddFrameSystems(common::SystemScheduler& scheduler, transforms::FrameState& frame)
+{
+	using namespace transforms::components;
+	auto scriptRunner = std::make_shared<transforms::systems::ScriptRunner>();
+	scriptRunner->Register<CameraInputHandler>();
+	scriptRunner->Register<EscHandler>();
+	transforms::AddSimulationSystems(scheduler, gRegistry, frame, scriptRunner);
+	common::SystemDesc descriptors;
+	descriptors.name = "DescriptorsBeginFrame";
+	descriptors.writes = common::Resources<transforms::SharedDescriptorHeapV2>();
+	descriptors.run = [&frame]() {
+		//the gpu is done with this frame, its transient descriptors can be reused
+		gSharedDescriptors->BeginFrame(frame.frameIndex);
+	};
+	scheduler.Add(descriptors);
+	transforms::AddLightingAndPerFrameUploadSystems<std::shared_ptr<transforms::CubeMapShadowMap>>(scheduler, gRegistry,
+		frame, gLightingDataUniformBuffer.get(), gPerFrameUnlitDebugUniformBuffer.get(),
+		gPerFrameSimpleLightingUniformBuffer.get());
+	transforms::AddObjectAndShadowUploadSystems<std::shared_ptr<transforms::CubeMapShadowMap>>(scheduler, gRegistry, frame,
+		gPerObjectUniformBuffer.get(), gPointShadowUniformBuffer.get());
+}
+
+void ReportRun(const CaptureSettings& settings, const common::FrameStats& frameStats, const common::FrameReplay* replay)
+{
+	if (replay != nullptr) {
+		common::WriteReplayResult(std::cout, settings.replayPath, *replay);
+	}
+	if (!settings.timingsPath.empty()) {
+		std::ofstream timings(settings.timingsPath);
+		common::WriteTimingReport(timings, common::MakeTimingReport(common::CpuProfiler::Get(), frameStats));
+		std::cout << "CPU timings written to " << settings.timingsPath << std::endl;
+	}
+}
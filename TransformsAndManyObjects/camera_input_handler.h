@@ -1,9 +0,0 @@
-#pragma once
-#include <entt/entt.hpp>
-namespace transforms {
-    class Window;
-}
-namespace transforms::components {
-    void CreateCameraInputHandler(transforms::Window* gWindow, entt::registry& gRegistry,
-        entt::entity mainCamera);
-}
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include "cube_map_shadow_map.h"
 #include "shared_descriptor_heap_v2.h"
 #include "rtv_dsv_shared_heap.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
+#include "../Common/gpu_memory_allocator.h"
+#include "../Common/d3d12_gfx_device.h"
 namespace transforms {
     
     CubeMapShadowMap::CubeMapShadowMap(std::wstring& name, UINT id) :
@@ -12,6 +14,7 @@ namespace transforms {
         m_descriptorManager(nullptr),
         m_name(name),
         m_srvHeapManager(nullptr),
+        m_memoryAllocator(nullptr),
         m_id(id){
         // Initialize handles to invalid values
         for (auto& handle : m_rtvHandles)
@@ -21,65 +24,38 @@ namespace transforms {
         m_srvHandle.first.ptr = 0;
         m_srvHandle.second.ptr = 0;
     }
-    void CubeMapShadowMap::TransitionToRenderTarget(ID3D12GraphicsCommandList* commandList, int frameIndex)
+    CubeMapShadowMap::~CubeMapShadowMap()
     {
-        CD3DX12_RESOURCE_BARRIER barrierBack = CD3DX12_RESOURCE_BARRIER::Transition(
-            m_cubeMapTexture.Get(),
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_RENDER_TARGET);
-        commandList->ResourceBarrier(1, &barrierBack);
+        if (m_descriptorManager == nullptr)
+            return;
+        for (int face = 0; face < 6; ++face) {
+            m_descriptorManager->FreeRTV(m_rtvSlots[face]);
+            m_descriptorManager->FreeDSV(m_dsvSlots[face]);
+        }
     }
-    void CubeMapShadowMap::TransitionToPixelShaderResource(ID3D12GraphicsCommandList* commandList, int frameIndex)
+    void CubeMapShadowMap::TransitionToRenderTarget(common::gfx::CommandList& commandList, int frameIndex)
     {
-        CD3DX12_RESOURCE_BARRIER barrierBack = CD3DX12_RESOURCE_BARRIER::Transition(
-            m_cubeMapTexture.Get(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-        commandList->ResourceBarrier(1, &barrierBack);
+        commandList.ResourceBarrier(common::gfx::ToHandle(m_cubeMapTexture.Get()),
+            common::gfx::ResourceState::PixelShaderResource,
+            common::gfx::ResourceState::RenderTarget);
     }
-    void CubeMapShadowMap::SetAsRenderTarget(ID3D12GraphicsCommandList* commandList, int faceIndex)
+    void CubeMapShadowMap::TransitionToPixelShaderResource(common::gfx::CommandList& commandList, int frameIndex)
     {
-        commandList->OMSetRenderTargets(
-            1,
-            &m_rtvHandles[faceIndex],
-            FALSE,
-            &m_dsvHandles[faceIndex]);
+        commandList.ResourceBarrier(common::gfx::ToHandle(m_cubeMapTexture.Get()),
+            common::gfx::ResourceState::RenderTarget,
+            common::gfx::ResourceState::PixelShaderResource);
     }
-    void CubeMapShadowMap::Clear(ID3D12GraphicsCommandList* commandList, int faceIndex, 
-        std::array<float, 4> clearColor)
+    void CubeMapShadowMap::SetAsRenderTarget(common::gfx::CommandList& commandList, int faceIndex)
     {
-        commandList->ClearRenderTargetView(m_rtvHandles[faceIndex], clearColor.data(), 0, nullptr);
-        commandList->ClearDepthStencilView(m_dsvHandles[faceIndex], D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+        commandList.SetRenderTarget(common::gfx::ToHandle(m_rtvHandles[faceIndex]),
+            common::gfx::ToHandle(m_dsvHandles[faceIndex]));
     }
-    void CubeMapShadowMap::SetupViewMatrices(const DirectX::XMFLOAT3& lightPos)
+    void CubeMapShadowMap::Clear(common::gfx::CommandList& commandList, int faceIndex, 
+        std::array<float, 4> clearColor)
     {
-        using namespace DirectX;
-
-        XMVECTOR eyePos = XMLoadFloat3(&lightPos);
-
-        // Cube face directions and up vectors
-        struct CubeFace
-        {
-            XMVECTOR target;
-            XMVECTOR up;
-        };
-
-        std::array<CubeFace, 6> faces = { {
-            { XMVectorSet(1, 0, 0, 0),  XMVectorSet(0, 1, 0, 0) },  // +X
-            { XMVectorSet(-1, 0, 0, 0), XMVectorSet(0, 1, 0, 0) },  // -X
-            { XMVectorSet(0, 1, 0, 0),  XMVectorSet(0, 0, -1, 0) }, // +Y
-            { XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0) },  // -Y
-            { XMVectorSet(0, 0, 1, 0),  XMVectorSet(0, 1, 0, 0) },  // +Z
-            { XMVectorSet(0, 0, -1, 0), XMVectorSet(0, 1, 0, 0) }   // -Z
-        } };
-
-        for (UINT i = 0; i < 6; ++i)
-        {
-            XMVECTOR target = XMVectorAdd(eyePos, faces[i].target);
-            m_viewMatrices[i] = XMMatrixLookAtLH(eyePos, target, faces[i].up);
-        }
+        commandList.ClearRenderTarget(common::gfx::ToHandle(m_rtvHandles[faceIndex]), clearColor);
+        commandList.ClearDepth(common::gfx::ToHandle(m_dsvHandles[faceIndex]), 1.0f);
     }
-
     bool CubeMapShadowMap::CreateShaderResourceView(ID3D12Device* device)
     {
         // Use the SAME heap that will be used for the descriptor table
@@ -101,7 +77,8 @@ namespace transforms {
     {
         // In CreateDepthStencilView, replace the loop with:
         for (int face = 0; face < 6; ++face) {
-            m_dsvHandles[face] = m_descriptorManager->AllocateDSV();
+            m_dsvSlots[face] = m_descriptorManager->AllocateDSVSlot();
+            m_dsvHandles[face] = m_descriptorManager->GetDSVHandle(m_dsvSlots[face]);
             if (m_dsvHandles[face].ptr == 0)
                 return false;
 
@@ -128,7 +105,8 @@ namespace transforms {
         // Create one RTV per cube face
         for (UINT i = 0; i < 6; ++i)
         {
-            m_rtvHandles[i] = m_descriptorManager->AllocateRTV();
+            m_rtvSlots[i] = m_descriptorManager->AllocateRTVSlot();
+            m_rtvHandles[i] = m_descriptorManager->GetRTVHandle(m_rtvSlots[i]);
             if (m_rtvHandles[i].ptr == 0)
                 return false;
 
@@ -153,22 +131,20 @@ namespace transforms {
         cubeDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;  // Add this line for completeness
         cubeDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
 
-        D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-
         D3D12_CLEAR_VALUE clearValue = {};
         clearValue.Format = m_depthFormat;
         clearValue.DepthStencil.Depth = 1.0f;
         clearValue.DepthStencil.Stencil = 0;
 
-        bool r = SUCCEEDED(device->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &cubeDesc,
+        bool r = SUCCEEDED(m_memoryAllocator->CreateResource(
+            cubeDesc,
+            D3D12_HEAP_TYPE_DEFAULT,
             D3D12_RESOURCE_STATE_DEPTH_WRITE,
             &clearValue,
-            IID_PPV_ARGS(&m_depthBuffer)
+            m_depthBuffer
         ));
+        if (!r)
+            return false;
         auto n = Concatenate(m_name, "DepthBuffer");
         m_depthBuffer->SetName(n.c_str());
         return r;
@@ -188,9 +164,6 @@ namespace transforms {
         textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
         textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
 
-        D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-
         D3D12_CLEAR_VALUE clearValue = {};
         clearValue.Format = m_colorFormat;
         clearValue.Color[0] = 1.0f; // Clear to white (max depth for shadow maps)
@@ -198,14 +171,15 @@ namespace transforms {
         clearValue.Color[2] = 1.0f;
         clearValue.Color[3] = 1.0f;
 
-        bool r = SUCCEEDED(device->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &textureDesc,
+        bool r = SUCCEEDED(m_memoryAllocator->CreateResource(
+            textureDesc,
+            D3D12_HEAP_TYPE_DEFAULT,
             D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             &clearValue,
-            IID_PPV_ARGS(&m_cubeMapTexture)
+            m_cubeMapTexture
         ));
+        if (!r)
+            return false;
         auto n = Concatenate(m_name, "CubeMapTexture");
         m_cubeMapTexture->SetName(n.c_str());
         return r;
@@ -214,6 +188,7 @@ namespace transforms {
     bool CubeMapShadowMap::Initialize(ID3D12Device* device,
         RtvDsvDescriptorHeapManager* descriptorManager,
         SharedDescriptorHeapV2* srvHeapManager,
+        common::GpuMemoryAllocator* memoryAllocator,
         UINT resolution,
         DXGI_FORMAT colorFormat,
         DXGI_FORMAT depthFormat)
@@ -223,6 +198,7 @@ namespace transforms {
         m_depthFormat = depthFormat;
         m_descriptorManager = descriptorManager;
         m_srvHeapManager = srvHeapManager;
+        m_memoryAllocator = memoryAllocator;
 
         // Create cube map texture (color target)
         if (!CreateCubeMapTexture(device))
@@ -244,12 +220,8 @@ namespace transforms {
         if (!CreateShaderResourceView(device))
             return false;
 
-        // Setup view matrices for cube faces
-        SetupViewMatrices();
-
-        // Setup projection matrix (90 degree FOV for cube faces)
-        m_projectionMatrix = DirectX::XMMatrixPerspectiveFovLH(
-            DirectX::XM_PIDIV2, 1.0f, 0.1f, m_farPlane);
+        // Back to the origin until the shadow data upload moves it to the light
+        UpdateLightPosition(DirectX::XMFLOAT3(0, 0, 0));
 
         return true;
     }
@@ -1,29 +1,27 @@
 #pragma once
 #include "pch.h"
+#include "../Core/slot_allocator.h"
+#include "../Core/gfx_device.h"
+#include "../Core/point_light_shadow_camera.h"
 using Microsoft::WRL::ComPtr;
+namespace common {
+    class GpuMemoryAllocator;
+}
 namespace transforms {
     class SharedDescriptorHeapV2;
     class RtvDsvDescriptorHeapManager;
 
-    // Structure that matches the HLSL cbuffer ShadowMapConstants
-    struct alignas(16) ShadowMapConstants
-    {
-        DirectX::XMFLOAT4X4 viewMatrix;
-        DirectX::XMFLOAT4X4 projMatrix;
-        DirectX::XMFLOAT3 lightPosition;
-        float farPlane;
-    };
-
-    class CubeMapShadowMap
+    class CubeMapShadowMap : public PointLightShadowCamera
     {
     private:
-        float m_farPlane = 500.0f;
         ComPtr<ID3D12Resource> m_cubeMapTexture;
         ComPtr<ID3D12Resource> m_depthBuffer;
 
         // Descriptor handles
         std::array<D3D12_CPU_DESCRIPTOR_HANDLE, 6> m_rtvHandles; // One RTV per cube face
         std::array<D3D12_CPU_DESCRIPTOR_HANDLE, 6> m_dsvHandles;
+        std::array<SlotHandle, 6> m_rtvSlots; // to give the descriptors back when destroyed
+        std::array<SlotHandle, 6> m_dsvSlots;
         std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> m_srvHandle; // SRV for sampling
 
         // Shadow map properties
@@ -34,26 +32,24 @@ namespace transforms {
         // References to descriptor managers (not owned)
         RtvDsvDescriptorHeapManager* m_descriptorManager;
         SharedDescriptorHeapV2* m_srvHeapManager;
+        common::GpuMemoryAllocator* m_memoryAllocator;
 
-        // View matrices for each cube face (for shadow rendering)
-        std::array<DirectX::XMMATRIX, 6> m_viewMatrices;
-        DirectX::XMMATRIX m_projectionMatrix;
         std::wstring m_name;
         static bool shadowTableIsCreated;
 
     public:
         const UINT m_id;
         CubeMapShadowMap(std::wstring& name, UINT id);
-        ~CubeMapShadowMap() = default;
-        float GetFarPlane()const { return m_farPlane; }
-        void TransitionToRenderTarget(ID3D12GraphicsCommandList* commandList, int frameIndex);
-        void TransitionToPixelShaderResource(ID3D12GraphicsCommandList* commandList, int frameIndex);
-        void SetAsRenderTarget(ID3D12GraphicsCommandList* commandList, int faceIndex);
-        void Clear(ID3D12GraphicsCommandList* commandList, int faceIndex, std::array<float, 4> clearColor);
+        ~CubeMapShadowMap();
+        void TransitionToRenderTarget(common::gfx::CommandList& commandList, int frameIndex);
+        void TransitionToPixelShaderResource(common::gfx::CommandList& commandList, int frameIndex);
+        void SetAsRenderTarget(common::gfx::CommandList& commandList, int faceIndex);
+        void Clear(common::gfx::CommandList& commandList, int faceIndex, std::array<float, 4> clearColor);
         // Initialize the cube map shadow map
         bool Initialize(ID3D12Device* device,
             RtvDsvDescriptorHeapManager* descriptorManager,
             SharedDescriptorHeapV2* srvHeapManager,
+            common::GpuMemoryAllocator* memoryAllocator,
             UINT resolution = SHADOW_MAP_SIZE,
             DXGI_FORMAT colorFormat = DXGI_FORMAT_R32G32B32A32_FLOAT,
             DXGI_FORMAT depthFormat = DXGI_FORMAT_D32_FLOAT);
@@ -71,19 +67,6 @@ namespace transforms {
         DXGI_FORMAT GetColorFormat() const { return m_colorFormat; }
         DXGI_FORMAT GetDepthFormat() const { return m_depthFormat; }
 
-        // Get view/projection matrices for shadow rendering
-        DirectX::XMMATRIX GetViewMatrix(UINT faceIndex) const
-        {
-            return (faceIndex < 6) ? m_viewMatrices[faceIndex] : DirectX::XMMatrixIdentity();
-        }
-        DirectX::XMMATRIX GetProjectionMatrix() const { return m_projectionMatrix; }
-
-        // Update light position (recalculates view matrices)
-        void UpdateLightPosition(const DirectX::XMFLOAT3& lightPos)
-        {
-            SetupViewMatrices(lightPos);
-        }
-
     private:
         bool CreateCubeMapTexture(ID3D12Device* device);
 
@@ -94,8 +77,6 @@ namespace transforms {
         bool CreateDepthStencilView(ID3D12Device* device);
 
         bool CreateShaderResourceView(ID3D12Device* device);
-
-        void SetupViewMatrices(const DirectX::XMFLOAT3& lightPos = DirectX::XMFLOAT3(0, 0, 0));
     };
 }
 
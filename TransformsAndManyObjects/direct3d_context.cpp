@@ -4,8 +4,9 @@
 #include "pipeline.h"
 #include "view_projection.h"
 #include "model_matrix.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
 #include "../Common/input_layout_service.h"
+#include "../Core/monotonic_clock.h"
 using Microsoft::WRL::ComPtr;
 using namespace common;
 namespace transforms
@@ -185,26 +186,23 @@ namespace transforms
         const std::wstring& name)
     {
         assert(_gpuBuffer == nullptr);
-        CD3DX12_HEAP_PROPERTIES stagingHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
         CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
-        device->CreateCommittedResource(
-            &stagingHeapProperties, // a default heap
-            D3D12_HEAP_FLAG_NONE, // no flags
-            &resourceDesc, // resource description for a buffer
+        HRESULT hr = memoryAllocator->CreateResource(
+            resourceDesc, // resource description for a buffer
+            D3D12_HEAP_TYPE_DEFAULT, // a default heap
             D3D12_RESOURCE_STATE_COMMON,//the initial state of vertex buffer is D3D12_RESOURCE_STATE_COMMON. Before we use them i'll have to transition it to the correct state
             nullptr, // optimized clear value must be null for this type of resource. used for render targets and depth/stencil buffers
-            IID_PPV_ARGS(&_gpuBuffer));
+            _gpuBuffer);
+        assert(hr == S_OK);
         // we can give resource heaps a name so when we debug with the graphics debugger we know what resource we are looking at
         _gpuBuffer->SetName(name.c_str());
-        CD3DX12_HEAP_PROPERTIES uploadHeapProperties = 
-            CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        device->CreateCommittedResource(
-            &uploadHeapProperties, // upload heap
-            D3D12_HEAP_FLAG_NONE, // no flags
-            &resourceDesc, // resource description for a buffer
+        hr = memoryAllocator->CreateResource(
+            resourceDesc, // resource description for a buffer
+            D3D12_HEAP_TYPE_UPLOAD, // upload heap
             D3D12_RESOURCE_STATE_GENERIC_READ, // GPU will read from this buffer and copy its contents to the default heap
             nullptr,
-            IID_PPV_ARGS(&_stagingBuffer));
+            _stagingBuffer);
+        assert(hr == S_OK);
         auto sb_name = Concatenate(name, "_staging");
         _stagingBuffer->SetName(sb_name.c_str());
         _gpuBufferView.BufferLocation = _gpuBuffer->GetGPUVirtualAddress();
@@ -219,49 +217,36 @@ namespace transforms
         assert(_vertexBuffer == nullptr);
         //size IN BYTES of the buffer
         int vBufferSize = static_cast<int>(_vertices.size()) * sizeof(Vertex);
-        CD3DX12_HEAP_PROPERTIES stagingHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
         CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(vBufferSize);
-        device->CreateCommittedResource(
-            &stagingHeapProperties, // a default heap
-            D3D12_HEAP_FLAG_NONE, // no flags
-            &resourceDesc, // resource description for a buffer
+        HRESULT hr = memoryAllocator->CreateResource(
+            resourceDesc, // resource description for a buffer
+            D3D12_HEAP_TYPE_DEFAULT, // a default heap
             D3D12_RESOURCE_STATE_COMMON,//the initial state of vertex buffer is D3D12_RESOURCE_STATE_COMMON. Before we use them i'll have to transition it to the correct state
             nullptr, // optimized clear value must be null for this type of resource. used for render targets and depth/stencil buffers
-            IID_PPV_ARGS(&_vertexBuffer));
+            _vertexBuffer);
+        assert(hr == S_OK);
         // we can give resource heaps a name so when we debug with the graphics debugger we know what resource we are looking at
         _vertexBuffer->SetName(name.c_str());
-        // create upload heap
         // upload heaps are used to upload data to the GPU. CPU can write to it, GPU can read from it
-        // We will upload the vertex buffer using this heap to the default heap
-        ComPtr<ID3D12Resource> vBufferUploadHeap;
-        CD3DX12_HEAP_PROPERTIES uploadHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        device->CreateCommittedResource(
-            &uploadHeapProperties, // upload heap
-            D3D12_HEAP_FLAG_NONE, // no flags
-            &resourceDesc, // resource description for a buffer
-            D3D12_RESOURCE_STATE_COMMON, //D3D12_RESOURCE_STATE_GENERIC_READ, // GPU will read from this buffer and copy its contents to the default heap
-            nullptr,
-            IID_PPV_ARGS(&vBufferUploadHeap));
-        vBufferUploadHeap->SetName(L"Vertex Buffer Upload Resource Heap");
+        // We will upload the vertex buffer using this heap to the default heap. It comes from the recycler's
+        // pool, so it may be bigger than the data.
+        ComPtr<ID3D12Resource> vBufferUploadHeap = recycler->AcquireUploadBuffer(vBufferSize);
         // store vertex buffer in upload heap
         D3D12_SUBRESOURCE_DATA vertexData = {};
         vertexData.pData = reinterpret_cast<BYTE*>(_vertices.data()); // pointer to our vertex array
         vertexData.RowPitch = vBufferSize; // size of all our triangle vertex data
         vertexData.SlicePitch = vBufferSize; // also the size of our triangle vertex data
-        //move _vertexBuffer and vBufferUploadHeap from D3D12_RESOURCE_STATE_COMMON to their states, then copy the content
-        //to _vertexBuffer
-        common::RunCommands(
+        //move _vertexBuffer from D3D12_RESOURCE_STATE_COMMON to copy dest, then copy the content
+        //to _vertexBuffer. We don't wait for it: the frames that use the buffer are submitted to the same queue,
+        //after the copy.
+        const UINT64 uploadDone = common::SubmitCommands(
             device.Get(),
-            commandQueue.Get(),
+            *recycler,
             [&_vertexBuffer, &vBufferUploadHeap, &vertexData](ComPtr<ID3D12GraphicsCommandList> lst) {
                 //vertexBuffer will go from common to copy destination
                 CD3DX12_RESOURCE_BARRIER vertexBufferResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
                     _vertexBuffer.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
                 lst->ResourceBarrier(1, &vertexBufferResourceBarrier);
-                //staging buffer will go from common to read origin
-                CD3DX12_RESOURCE_BARRIER stagingBufferResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-                    vBufferUploadHeap.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_GENERIC_READ);
-                lst->ResourceBarrier(1, &stagingBufferResourceBarrier);
                 //copy the vertex data from RAM to the vertex buffer, thru vBufferUploadHeap
                 UpdateSubresources(lst.Get(), _vertexBuffer.Get(), vBufferUploadHeap.Get(), 0, 0, 1, &vertexData);
                 //now that the data is in _vertexBuffer i transition _vertexBuffer to D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, so that
@@ -270,32 +255,46 @@ namespace transforms
                     D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
                 lst->ResourceBarrier(1, &secondVertexBufferResourceBarrier);
             });
+        //the upload buffer goes back to the pool once the copy is done
+        recycler->RecycleUploadBuffer(vBufferUploadHeap, uploadDone);
         _vertexBufferView.BufferLocation = _vertexBuffer->GetGPUVirtualAddress();
         _vertexBufferView.StrideInBytes = sizeof(Vertex);
         _vertexBufferView.SizeInBytes = vBufferSize;
     }
     void Context::WaitForPreviousFrame()
     {
-        HRESULT hr;
-        // if the current fence value is still less than "fenceValue", then we know the GPU has not finished executing
-        // the command queue since it has not reached the "commandQueue->Signal(fence, fenceValue)" command
-        if (fence[frameIndex]->GetCompletedValue() < fenceValue[frameIndex])
-        {
-            // a handle to an event when our fence is unlocked by the gpu
-            HANDLE fenceEvent;
-            fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-            assert(fenceEvent != nullptr);
-            // we have the fence create an event which is signaled once the fence's current value is "fenceValue"
-            hr = fence[frameIndex]->SetEventOnCompletion(fenceValue[frameIndex], fenceEvent);
-            assert(hr == S_OK);
-            // We will wait until the fence has triggered the event that it's current value has reached "fenceValue". once it's value
-            // has reached "fenceValue", we know the command queue has finished executing
-            WaitForSingleObject(fenceEvent, INFINITE);
-        }
-        // increment fenceValue for next frame
-        fenceValue[frameIndex]++;
         // swap the current rtv buffer index so we draw on the correct buffer
         frameIndex = swapChain->GetCurrentBackBufferIndex();
+        // the frame's allocator and buffers are free once the gpu reached the value signaled by the last submission
+        // that used them. If it already did there's nothing to wait for. In latency mode we also wait
+        // for the previous frame, so nothing is queued when this one starts.
+        const UINT64 required = framePacing == FramePacing::Latency ? lastFrameFenceValue : frameFenceValue[frameIndex];
+        const uint64_t waitBegin = common::MonotonicClock::Now();
+        fence->WaitFor(required);
+        frameTimings.cpuWaitMs = common::MonotonicClock::ToNanoseconds(common::MonotonicClock::Now() - waitBegin) * 1.0e-6;
+        if (frameFenceValue[frameIndex] != 0) {
+            ReadFrameTimestamps(frameIndex);
+        }
+    }
+    void Context::ReadFrameTimestamps(UINT slot)
+    {
+        //the slot was resolved at the end of its last frame, and that frame is done
+        const SIZE_T begin = slot * 2 * sizeof(UINT64);
+        D3D12_RANGE readRange{ begin, begin + 2 * sizeof(UINT64) };
+        void* mapped = nullptr;
+        HRESULT hr = timestampReadback->Map(0, &readRange, &mapped);
+        assert(hr == S_OK);
+        const UINT64* ticks = reinterpret_cast<const UINT64*>(static_cast<const BYTE*>(mapped) + begin);
+        const UINT64 frameBegin = ticks[0];
+        const UINT64 frameEnd = ticks[1];
+        D3D12_RANGE writtenRange{ 0, 0 };
+        timestampReadback->Unmap(0, &writtenRange);
+        const double msPerTick = 1000.0 / static_cast<double>(timestampFrequency);
+        frameTimings.gpuBusyMs = frameEnd > frameBegin ? (frameEnd - frameBegin) * msPerTick : 0.0;
+        //the gpu was idle between the end of the previous frame and the beginning of this one
+        frameTimings.gpuIdleMs = (lastGpuFrameEnd != 0 && frameBegin > lastGpuFrameEnd) ?
+            (frameBegin - lastGpuFrameEnd) * msPerTick : 0.0;
+        lastGpuFrameEnd = frameEnd;
     }
     void Context::ResetCurrentCommandList()
     {
@@ -305,6 +304,14 @@ namespace transforms
         //when we reset the command list we put it back to the recording state
         hr = commandList->Reset(commandAllocator[frameIndex].Get(), NULL);
         assert(hr == S_OK);
+        //the begin timestamp goes in its own list, submitted first, so that it's before the parallel lists too
+        hr = frameBeginAllocator[frameIndex]->Reset();
+        assert(hr == S_OK);
+        hr = frameBeginList->Reset(frameBeginAllocator[frameIndex].Get(), NULL);
+        assert(hr == S_OK);
+        frameBeginList->EndQuery(timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameIndex * 2);
+        hr = frameBeginList->Close();
+        assert(hr == S_OK);
     }
     void Context::TransitionCurrentRenderTarget(D3D12_RESOURCE_STATES from, D3D12_RESOURCE_STATES to)
     {
@@ -367,14 +374,28 @@ namespace transforms
     }
     void Context::Present()
     {
+        Present({});
+    }
+    void Context::Present(const std::vector<common::gfx::CommandList*>& before)
+    {
+        //the timestamps of the frame go to its slot of the readback buffer, they are read when the slot is reused
+        commandList->EndQuery(timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameIndex * 2 + 1);
+        commandList->ResolveQueryData(timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameIndex * 2, 2,
+            timestampReadback.Get(), frameIndex * 2 * sizeof(UINT64));
         HRESULT hr = commandList->Close();
         assert(hr == S_OK);
-        std::array<ID3D12CommandList*, 1> ppCommandLists{ commandList.Get() };
-        //execute the array of command lists
+        std::vector<ID3D12CommandList*> ppCommandLists;
+        ppCommandLists.reserve(before.size() + 2);
+        ppCommandLists.push_back(frameBeginList.Get());
+        for (common::gfx::CommandList* list : before) {
+            ppCommandLists.push_back(static_cast<common::gfx::D3D12CommandList*>(list)->GetNative());
+        }
+        ppCommandLists.push_back(commandList.Get());
+        //execute the array of command lists, the gpu runs them in this order
         commandQueue->ExecuteCommandLists(static_cast<UINT>(ppCommandLists.size()),
             ppCommandLists.data());
-        hr = commandQueue->Signal(fence[frameIndex].Get(), fenceValue[frameIndex]);
-        assert(hr == S_OK);
+        frameFenceValue[frameIndex] = fence->Signal();
+        lastFrameFenceValue = frameFenceValue[frameIndex];
         hr = swapChain->Present(0, 0);
         assert(hr == S_OK);
     }
@@ -409,19 +430,11 @@ namespace transforms
             x.ReleaseAndGetAddressOf();
         }
         swapChainRenderTargets.clear();
-        swapChain->ResizeBuffers(FRAMEBUFFER_COUNT, w, h, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
+        swapChain->ResizeBuffers(frameCount, w, h, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
         swapChainRenderTargets = common::CreateRenderTargets(rtvData, swapChain, device);
         //recreate depth buffer
-        for (auto& x : dsDescriptorHeap) {
-            x.ReleaseAndGetAddressOf();
-        }
-        dsDescriptorHeap.clear();
-        dsDescriptorHeap.resize(FRAMEBUFFER_COUNT);
-        for (auto& x : depthStencilBuffer) {
-            x.ReleaseAndGetAddressOf();
-        }
-        depthStencilBuffer.clear();
-        depthStencilBuffer.resize(FRAMEBUFFER_COUNT);
+        dsDescriptorHeap.Reset(frameCount);
+        depthStencilBuffer.Reset(frameCount);
         D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
         depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
         depthStencilDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
@@ -431,7 +444,7 @@ namespace transforms
         depthOptimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
         depthOptimizedClearValue.DepthStencil.Depth = 1.0f;
         depthOptimizedClearValue.DepthStencil.Stencil = 0;
-        for (int i = 0; i < FRAMEBUFFER_COUNT; i++)
+        for (UINT i = 0; i < frameCount; i++)
         {
             // create a depth stencil descriptor heap so we can get a pointer to the depth stencil buffer
             D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
@@ -443,23 +456,22 @@ namespace transforms
             std::wstring name = Concatenate(L"depthStencilDescriptorHeap", i);
             dsDescriptorHeap[i]->SetName(name.c_str());
         }
-        CD3DX12_HEAP_PROPERTIES depthStencilHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
 
         CD3DX12_RESOURCE_DESC depthStencilResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, //format
             w, h, // w/h 
             1, //array size 
             1, //mip levels 
             1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-        for (int i = 0; i < FRAMEBUFFER_COUNT; i++)
+        for (UINT i = 0; i < frameCount; i++)
         {
-            device->CreateCommittedResource(
-                &depthStencilHeapProperties,
-                D3D12_HEAP_FLAG_NONE,
-                &depthStencilResourceDesc,
+            HRESULT hr = memoryAllocator->CreateResource(
+                depthStencilResourceDesc,
+                D3D12_HEAP_TYPE_DEFAULT,
                 D3D12_RESOURCE_STATE_DEPTH_WRITE,
                 &depthOptimizedClearValue,
-                IID_PPV_ARGS(&depthStencilBuffer[i])
+                depthStencilBuffer[i]
             );
+            assert(hr == S_OK);
             std::wstring name = Concatenate(L"depthBuffer", i);
             depthStencilBuffer[i]->SetName(name.c_str());
             device->CreateDepthStencilView(depthStencilBuffer[i].Get(),
@@ -471,31 +483,29 @@ namespace transforms
 
     void Context::WaitAllFrames()
     {
-        std::vector<HANDLE> fenceEvents(FRAMEBUFFER_COUNT);
-        for (UINT i = 0; i < FRAMEBUFFER_COUNT; ++i) {
-            const UINT64 currentFenceValue = fenceValue[i];
-            commandQueue->Signal(fence[i].Get(), currentFenceValue);
-            fenceValue[i]++;
-
-            if (fence[i]->GetCompletedValue() < currentFenceValue) {
-                fence[i]->SetEventOnCompletion(currentFenceValue, fenceEvents[i]);
-                WaitForSingleObject(fenceEvents[i], INFINITE);
-            }
-        }
+        //a single signal covers every frame in flight, the timeline only grows
+        fence->WaitIdle();
+        recycler->Collect();
     }
 
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> Context::ResetFrame()
     {
         //wait until i can interact with this frame again
         WaitForPreviousFrame();
+        //release what the gpu finished using
+        recycler->Collect();
         //reset the allocator and the command list
         ResetCurrentCommandList();
         auto commandList = GetCommandList();
         return commandList;
     }
 
-    Context::Context(int w, int h, HWND hwnd)
+    Context::Context(int w, int h, HWND hwnd, UINT frameCount)
+        :frameCount(frameCount)
     {
+        if (frameCount < static_cast<UINT>(MIN_FRAMES_IN_FLIGHT) || frameCount > static_cast<UINT>(MAX_FRAMES_IN_FLIGHT)) {
+            throw std::out_of_range("Frames in flight must be between MIN_FRAMES_IN_FLIGHT and MAX_FRAMES_IN_FLIGHT");
+        }
         HRESULT hr;
         //the factory is used to create DXGI objects.
         ComPtr<IDXGIFactory4> dxgiFactory = common::CreateDXGIFactory();
@@ -508,6 +518,7 @@ namespace transforms
 #endif
         //ID3D12Device is equivalent do VkDevice
         device = common::CreateDevice(adapter);
+        memoryAllocator = std::make_unique<common::GpuMemoryAllocator>(device.Get());
 #if defined(_DEBUG)
         device->QueryInterface(IID_PPV_ARGS(&debugDevice));
         assert(debugDevice != nullptr);
@@ -515,23 +526,25 @@ namespace transforms
         //We'll need a command queue to run the commands, it's equivalent to vkCommandQueue
         commandQueue = common::CreateDirectCommandQueue(device, L"MainCommandQueue");
         //The swap chain, created with the size of the screenm using dxgi to fabricate the objects
-        swapChain = common::CreateSwapChain(hwnd, w, h, FRAMEBUFFER_COUNT, true,
+        swapChain = common::CreateSwapChain(hwnd, w, h, frameCount, true,
             commandQueue,
             dxgiFactory);
         frameIndex = swapChain->GetCurrentBackBufferIndex();
         //create a heap for render target view descriptors and get the size of it's descriptors. We have to get the
         //size because it can vary from device to device.
         rtvData = std::make_shared<common::RenderTargetViewData>(
-            common::CreateRenderTargetViewDescriptorHeap(FRAMEBUFFER_COUNT, device),
+            common::CreateRenderTargetViewDescriptorHeap(frameCount, device),
             device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV),
-            FRAMEBUFFER_COUNT
+            frameCount
         );
         // now we create the render targets for the swap chain, linking the swap chain buffers to render target view descriptors
         swapChainRenderTargets = common::CreateRenderTargets(rtvData,
             swapChain, device);
         // We need a command allocator for each frame because if we use a single allocator each frame will mess with the other frames
         // allocations due to the fact that we need to reset the allocator before using it.
-        commandAllocator = common::CreateCommandAllocators(FRAMEBUFFER_COUNT, device);
+        auto allocators = common::CreateCommandAllocators(frameCount, device);
+        commandAllocator = common::FrameRing<ComPtr<ID3D12CommandAllocator>>(frameCount,
+            [&allocators](UINT i) { return allocators[i]; });
         // We are using single thread. If we were using multiple threads we'd need to have a list for each thread.
         hr = device->CreateCommandList(0,//default gpu 
             D3D12_COMMAND_LIST_TYPE_DIRECT, //type of commands - direct means that the commands can be executed by the gpu
@@ -539,20 +552,35 @@ namespace transforms
             NULL, IID_PPV_ARGS(&commandList));
         assert(hr == S_OK);
         commandList->Close();
-        //now we create the ring buffer for fences, one per frame
-        assert(fence.size() == 0);
-        fence.resize(FRAMEBUFFER_COUNT);
-        fenceValue.resize(FRAMEBUFFER_COUNT);
-        // create the fences
-        for (int i = 0; i < FRAMEBUFFER_COUNT; i++)
-        {
-            hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence[i]));
-            assert(hr == S_OK);
-            fenceValue[i] = 0; // set the initial fence value to 0
-        }
+        //the same device and list behind the gfx interface, for the code that also runs on the recording backend
+        gfxDevice = std::make_unique<common::gfx::D3D12Device>(device.Get());
+        gfxCommandList = std::make_unique<common::gfx::D3D12CommandList>(commandList.Get());
+        frameBeginAllocator = common::FrameRing<ComPtr<ID3D12CommandAllocator>>(frameCount,
+            [this](UINT) { return common::CreateCommandAllocators(1, device)[0]; });
+        hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frameBeginAllocator[0].Get(),
+            NULL, IID_PPV_ARGS(&frameBeginList));
+        assert(hr == S_OK);
+        frameBeginList->SetName(L"FrameBeginList");
+        frameBeginList->Close();
+        //one timeline fence for the queue, frames remember the value they signaled
+        fence = std::make_unique<common::TimelineFence>(device.Get(), commandQueue.Get(), L"MainQueueTimeline");
+        frameFenceValue.Reset(frameCount); //all 0, nothing was submitted yet
+        recycler = std::make_unique<common::ResourceRecycler>(device.Get(), *fence, memoryAllocator.get());
+        //the timestamps that measure how long the gpu works on each frame and how long it waits for us
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = frameCount * 2;
+        hr = device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&timestampHeap));
+        assert(hr == S_OK);
+        hr = memoryAllocator->CreateResource(CD3DX12_RESOURCE_DESC::Buffer(frameCount * 2 * sizeof(UINT64)),
+            D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, timestampReadback);
+        assert(hr == S_OK);
+        timestampReadback->SetName(L"FrameTimestampsReadback");
+        hr = commandQueue->GetTimestampFrequency(&timestampFrequency);
+        assert(hr == S_OK);
         //create the depth-stencil buffer, one for each frame
-        depthStencilBuffer.resize(FRAMEBUFFER_COUNT);
-        dsDescriptorHeap.resize(FRAMEBUFFER_COUNT);
+        depthStencilBuffer.Reset(frameCount);
+        dsDescriptorHeap.Reset(frameCount);
         D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
         depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
         depthStencilDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
@@ -562,7 +590,7 @@ namespace transforms
         depthOptimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
         depthOptimizedClearValue.DepthStencil.Depth = 1.0f;
         depthOptimizedClearValue.DepthStencil.Stencil = 0;
-        for (int i = 0; i < FRAMEBUFFER_COUNT; i++)
+        for (UINT i = 0; i < frameCount; i++)
         {
             // create a depth stencil descriptor heap so we can get a pointer to the depth stencil buffer
             D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
@@ -574,23 +602,22 @@ namespace transforms
             std::wstring name = Concatenate(L"depthStencilDescriptorHeap", i);
             dsDescriptorHeap[i]->SetName(name.c_str());
         }
-        CD3DX12_HEAP_PROPERTIES depthStencilHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
 
         CD3DX12_RESOURCE_DESC depthStencilResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, //format
             w, h, // w/h 
             1, //array size 
             1, //mip levels 
             1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-        for (int i = 0; i < FRAMEBUFFER_COUNT; i++)
+        for (UINT i = 0; i < frameCount; i++)
         {
-            device->CreateCommittedResource(
-                &depthStencilHeapProperties,
-                D3D12_HEAP_FLAG_NONE,
-                &depthStencilResourceDesc,
+            HRESULT hr = memoryAllocator->CreateResource(
+                depthStencilResourceDesc,
+                D3D12_HEAP_TYPE_DEFAULT,
                 D3D12_RESOURCE_STATE_DEPTH_WRITE,
                 &depthOptimizedClearValue,
-                IID_PPV_ARGS(&depthStencilBuffer[i])
+                depthStencilBuffer[i]
             );
+            assert(hr == S_OK);
             std::wstring name = Concatenate(L"depthBuffer", i);
             depthStencilBuffer[i]->SetName(name.c_str());
             device->CreateDepthStencilView(depthStencilBuffer[i].Get(),
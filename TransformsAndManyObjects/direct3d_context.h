@@ -1,41 +1,91 @@
 #pragma once
 #include "pch.h"
 #include "../Common/d3d_utils.h"
+#include "../Common/gpu_memory_allocator.h"
+#include "../Common/timeline_fence.h"
+#include "../Common/resource_recycler.h"
+#include "../Common/d3d12_gfx_device.h"
 //using Microsoft::WRL::ComPtr;
 namespace transforms
 {
     class Pipeline;
     class ViewProjection;
     class ModelMatrix;
+    /// <summary>
+    /// How far the cpu may run ahead of the gpu.
+    /// Latency: a frame starts only when the gpu finished the previous one, so input is sampled as late as possible.
+    /// Throughput: a frame starts when its own slot is free, up to the frame count minus one frames stay queued.
+    /// </summary>
+    enum class FramePacing
+    {
+        Latency,
+        Throughput
+    };
+    /// <summary>
+    /// Where the time of a frame went. cpuWaitMs is the time ResetFrame blocked waiting for the gpu (gpu bound).
+    /// gpuIdleMs is the time the gpu spent with nothing to do between this frame and the previous one (cpu bound).
+    /// The gpu values come from timestamps, they are known only when the slot comes around again, so they
+    /// lag the cpu value by the number of frames in flight.
+    /// </summary>
+    struct FrameTimings
+    {
+        double cpuWaitMs = 0;
+        double gpuIdleMs = 0;
+        double gpuBusyMs = 0;
+    };
     class Context
     {
     private:
 
         // direct3d device
         Microsoft::WRL::ComPtr<ID3D12Device> device = nullptr;;
+        // sub-allocates the buffers and textures from big heaps instead of one committed resource each
+        std::unique_ptr<common::GpuMemoryAllocator> memoryAllocator = nullptr;
         //contais the command lists.
         Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue = nullptr;
         // swapchain used to switch between render targets
         Microsoft::WRL::ComPtr<IDXGISwapChain3> swapChain = nullptr;
         // current render target view we are on
         int frameIndex = INT_MAX;
+        // number of frames in flight, it's also the number of swap chain buffers
+        UINT frameCount = DEFAULT_FRAMES_IN_FLIGHT;
+        FramePacing framePacing = FramePacing::Throughput;
 
         std::shared_ptr<common::RenderTargetViewData> rtvData = nullptr;
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle;
         std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> swapChainRenderTargets;
         //Represents the allocations of storage for graphics processing unit (GPU) commands, one per frame
-        std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocator;
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocator;
         // a command list we can record commands into, then execute them to render the frame. We need one
         // per cpu thread. Since our app will be single threaded we create just one.
         Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList = nullptr;
-        // fences for each frame. We need to wait on these fences until the gpu finishes it's job
-        std::vector<Microsoft::WRL::ComPtr<ID3D12Fence>> fence; 
-        // this value is incremented each frame. each fence will have its own value
-        std::vector<uint64_t> fenceValue;
+        // the device and the main list through the gfx interface
+        std::unique_ptr<common::gfx::D3D12Device> gfxDevice = nullptr;
+        std::unique_ptr<common::gfx::D3D12CommandList> gfxCommandList = nullptr;
+        // a tiny list that goes before everything else in the frame, it holds the frame's begin timestamp. The
+        // main list is the last one submitted when there are parallel recorded lists.
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> frameBeginAllocator;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> frameBeginList = nullptr;
+        // the command queue's timeline. Every frame signals the next value when it's submitted
+        std::unique_ptr<common::TimelineFence> fence = nullptr;
+        // the value signaled by the last submission of each frame. We wait for it before reusing the frame
+        common::FrameRing<UINT64> frameFenceValue;
+        // the value signaled by the last frame, whatever its index. Latency pacing waits for it
+        UINT64 lastFrameFenceValue = 0;
+        // releases things when the gpu is done with them and keeps the upload buffers for reuse
+        std::unique_ptr<common::ResourceRecycler> recycler = nullptr;
         // This is the memory for our depth buffer. it will also be used for a stencil buffer in a later tutorial
-        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> depthStencilBuffer; 
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> depthStencilBuffer; 
         // This is a heap for our depth/stencil buffer descriptor
-        std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> dsDescriptorHeap; 
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> dsDescriptorHeap; 
+        // two timestamps per frame, at the beginning and at the end of its command list
+        Microsoft::WRL::ComPtr<ID3D12QueryHeap> timestampHeap;
+        Microsoft::WRL::ComPtr<ID3D12Resource> timestampReadback;
+        UINT64 timestampFrequency = 1;
+        // the end of the last frame read back, to know how long the gpu was idle before the next
+        UINT64 lastGpuFrameEnd = 0;
+        FrameTimings frameTimings;
+        void ReadFrameTimestamps(UINT slot);
     
         Microsoft::WRL::ComPtr<ID3D12PipelineState> fullscreenQuadPSO;
         Microsoft::WRL::ComPtr<ID3D12PipelineState> shadowMapPSO;
@@ -47,7 +97,17 @@ namespace transforms
         Microsoft::WRL::ComPtr<ID3D12DebugDevice> debugDevice;
 #endif
         int GetFrameIndex()const { return frameIndex; }
-        Context(int w, int h, HWND hwnd);
+        /// <summary>
+        /// frameCount is the number of frames in flight, from MIN_FRAMES_IN_FLIGHT to MAX_FRAMES_IN_FLIGHT.
+        /// </summary>
+        Context(int w, int h, HWND hwnd, UINT frameCount = DEFAULT_FRAMES_IN_FLIGHT);
+        UINT GetFrameCount()const { return frameCount; }
+        FramePacing GetFramePacing()const { return framePacing; }
+        /// <summary>
+        /// Can be changed at any time, it takes effect on the next ResetFrame.
+        /// </summary>
+        void SetFramePacing(FramePacing pacing) { framePacing = pacing; }
+        const FrameTimings& GetFrameTimings()const { return frameTimings; }
         Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateUnlitDebugRootSignature(const std::wstring& name);
         Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateSimpleLightingRootSignature(const std::wstring& name);
         Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateQuadRenderRootSignature();
@@ -55,6 +115,22 @@ namespace transforms
         Microsoft::WRL::ComPtr<ID3D12Device> GetDevice()const {
             return device;
         }
+        common::GpuMemoryAllocator* GetMemoryAllocator()const {
+            return memoryAllocator.get();
+        }
+        common::TimelineFence* GetTimelineFence()const {
+            return fence.get();
+        }
+        common::ResourceRecycler* GetRecycler()const {
+            return recycler.get();
+        }
+        /// <summary>
+        /// Keeps object alive until the gpu finishes the work recorded so far, use it instead of dropping
+        /// things that the frames in flight may still use.
+        /// </summary>
+        void DeferRelease(Microsoft::WRL::ComPtr<IUnknown> object) {
+            recycler->DeferRelease(object);
+        }
         ID3D12PipelineState* GetShadowMapPipeline() {
             return shadowMapPSO.Get();
         }
@@ -82,10 +158,24 @@ namespace transforms
         Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> GetCommandList()const {
             return commandList;
         }
+        common::gfx::Device& GetGfxDevice() {
+            return *gfxDevice;
+        }
+        /// <summary>
+        /// The main command list through the gfx interface, it's open between ResetFrame and Present.
+        /// </summary>
+        common::gfx::CommandList& GetGfxCommandList() {
+            return *gfxCommandList;
+        }
         Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetCommandQueue()const {
             return commandQueue;
         }
         void Present();
+        /// <summary>
+        /// Submits the lists in before and then the main command list, in a single ExecuteCommandLists, and presents.
+        /// before are the lists recorded in parallel, in dependency order, created with GetGfxDevice.
+        /// </summary>
+        void Present(const std::vector<common::gfx::CommandList*>& before);
         void CreateConstantBufferView(
             Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& descriptorHeap,
             D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvDesc,
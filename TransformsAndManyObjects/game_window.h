@@ -1,10 +1,8 @@
 #pragma once
 #include "pch.h"
+#include "../Core/key_codes.h"
 namespace transforms
 {
-	enum KeyCodes {
-		W, A, S, D, Q, E, Esc, None
-	};
 	/// <summary>
 	/// A window.
 	/// </summary>
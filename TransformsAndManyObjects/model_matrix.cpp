@@ -1,6 +1,6 @@
 #include "model_matrix.h"
 #include "direct3d_context.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
 using namespace DirectX;
 using namespace Microsoft::WRL;
 /// <summary>
@@ -20,9 +20,10 @@ transforms::ModelMatrix::ModelMatrix(Context& ctx)
     CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
     CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(
         bufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-    structuredBuffer.resize(FRAMEBUFFER_COUNT);
-    srvHeap.resize(FRAMEBUFFER_COUNT);
-    for (auto i = 0; i < FRAMEBUFFER_COUNT; i++)
+    const UINT frameCount = ctx.GetFrameCount();
+    structuredBuffer.Reset(frameCount);
+    srvHeap.Reset(frameCount);
+    for (UINT i = 0; i < frameCount; i++)
     {
         HRESULT r = ctx.GetDevice()->CreateCommittedResource(
             &heapProperties,
@@ -61,9 +62,9 @@ transforms::ModelMatrix::ModelMatrix(Context& ctx)
     //create the staging buffers
     CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
     CD3DX12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
-    uploadBuffer.resize(FRAMEBUFFER_COUNT);
-    mappedData.resize(FRAMEBUFFER_COUNT);
-    for (auto i = 0; i < FRAMEBUFFER_COUNT; i++)
+    uploadBuffer.Reset(frameCount);
+    mappedData.Reset(frameCount);
+    for (UINT i = 0; i < frameCount; i++)
     {
         ctx.GetDevice()->CreateCommittedResource(
             &uploadHeapProps,
@@ -19,13 +19,13 @@ namespace transforms
 			return srvHeap[frameId];
 		}
 	private:
-		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> structuredBuffer;
+		common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> structuredBuffer;
 		//Shader Resource View heap
-		std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> srvHeap;
+		common::FrameRing<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> srvHeap;
 		//staging buffer resource
-		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> uploadBuffer;
+		common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> uploadBuffer;
 		//maps the uploadBuffer
-		std::vector<void*> mappedData;
+		common::FrameRing<void*> mappedData;
 
 	};
 }
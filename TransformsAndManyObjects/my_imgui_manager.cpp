@@ -6,7 +6,7 @@
 #include "shared_descriptor_heap_v2.h"
 transforms::SharedDescriptorHeapV2* gSharedHeap = nullptr;
 transforms::MyImguiManager::MyImguiManager(HWND hwnd,
-	ID3D12Device* device, ID3D12CommandQueue* queue, SharedDescriptorHeapV2* sharedHeap)
+	ID3D12Device* device, ID3D12CommandQueue* queue, SharedDescriptorHeapV2* sharedHeap, UINT framesInFlight)
 	:hwnd(hwnd), device(device), sharedHeap(sharedHeap)
 {
 	assert(gSharedHeap == nullptr);
@@ -22,7 +22,7 @@ transforms::MyImguiManager::MyImguiManager(HWND hwnd,
 	ImGui_ImplDX12_InitInfo init_info = {};
 	init_info.Device = device;
 	init_info.CommandQueue = queue;
-	init_info.NumFramesInFlight = 2;
+	init_info.NumFramesInFlight = framesInFlight;
 	init_info.RTVFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 	init_info.SrvDescriptorHeap = sharedHeap->GetHeap();
 	init_info.SrvDescriptorAllocFn = [](ImGui_ImplDX12_InitInfo*, D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu)
@@ -32,9 +32,10 @@ transforms::MyImguiManager::MyImguiManager(HWND hwnd,
 			*out_cpu = cpu;
 			*out_gpu = gpu;
 		};
-	init_info.SrvDescriptorFreeFn = [](ImGui_ImplDX12_InitInfo*, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE)
+	init_info.SrvDescriptorFreeFn = [](ImGui_ImplDX12_InitInfo*, D3D12_CPU_DESCRIPTOR_HANDLE cpu, D3D12_GPU_DESCRIPTOR_HANDLE)
 		{
-			// No-op (we never free)
+			assert(gSharedHeap != nullptr);
+			gSharedHeap->Free(cpu);
 		};
 
 	ImGui_ImplDX12_Init(&init_info);
@@ -71,6 +72,36 @@ void transforms::MyImguiManager::FloatInput(const std::string& name, float& valu
 	ImGui::InputFloat(name.c_str(), &value, inc, fastInc, "%.5f");
 }
 
+void transforms::MyImguiManager::Text(const std::string& text)
+{
+	ImGui::TextUnformatted(text.c_str());
+}
+
+void transforms::MyImguiManager::Table(const std::string& id, const std::vector<std::string>& headers,
+	const std::vector<std::vector<std::string>>& rows)
+{
+	const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+	if (!ImGui::BeginTable(id.c_str(), static_cast<int>(headers.size()), flags))
+	{
+		return;
+	}
+	for (const auto& header : headers)
+	{
+		ImGui::TableSetupColumn(header.c_str());
+	}
+	ImGui::TableHeadersRow();
+	for (const auto& row : rows)
+	{
+		ImGui::TableNextRow();
+		for (size_t i = 0; i < row.size() && i < headers.size(); i++)
+		{
+			ImGui::TableSetColumnIndex(static_cast<int>(i));
+			ImGui::TextUnformatted(row[i].c_str());
+		}
+	}
+	ImGui::EndTable();
+}
+
 void transforms::MyImguiManager::PopImguiWindow()
 {
 	//TODO imgui: be able to create child windows
@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.h"
 #include <string>
+#include <vector>
 namespace transforms {
     class SharedDescriptorHeapV2;
     class MyImguiManager
@@ -8,11 +9,17 @@ namespace transforms {
     public:
         MyImguiManager(HWND hwnd,
             ID3D12Device* device, ID3D12CommandQueue* queue,
-            SharedDescriptorHeapV2* sharedHeap);
+            SharedDescriptorHeapV2* sharedHeap, UINT framesInFlight);
         void BeginFrame();
         void PushImguiWindow(const std::string& name, int w, int h);
         void PushButton(const std::string& name, std::function<void()> onClick);
         void FloatInput(const std::string& name, float& value, float inc=1.0f, float fastInc=10.0f);
+        void Text(const std::string& text);
+        /// <summary>
+        /// A table with a header row; every row has one cell per header.
+        /// </summary>
+        void Table(const std::string& id, const std::vector<std::string>& headers,
+            const std::vector<std::vector<std::string>>& rows);
         void PopImguiWindow();
         void EndFrame(ID3D12GraphicsCommandList* commandList);
        
@@ -20,21 +20,18 @@ D3D12_RESOURCE_DESC CreateDesc(int w, int h, DXGI_FORMAT format, D3D12_RESOURCE_
 
 transforms::OffscreenRenderTarget::OffscreenRenderTarget(int w, int h, 
     transforms::Context* ctx, transforms::SharedDescriptorHeapV2* descriptorHeap,
-    RtvDsvDescriptorHeapManager* rtvDsvHeap)
+    RtvDsvDescriptorHeapManager* rtvDsvHeap):descriptorHeap(descriptorHeap), rtvDsvHeap(rtvDsvHeap)
 {
-    srvCPUHandle.resize(FRAMEBUFFER_COUNT);
-    srvGPUHandle.resize(FRAMEBUFFER_COUNT);
-    renderTargetTexture.resize(FRAMEBUFFER_COUNT);
-    depthTexture.resize(FRAMEBUFFER_COUNT);
-    rtvHandle.resize(FRAMEBUFFER_COUNT);
-    dsvHandle.resize(FRAMEBUFFER_COUNT);
-    D3D12_HEAP_PROPERTIES heapProps = {};
-    heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-    heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heapProps.CreationNodeMask = 1;
-    heapProps.VisibleNodeMask = 1;
-    for (int i = 0; i < FRAMEBUFFER_COUNT; i++) {
+    const UINT frameCount = ctx->GetFrameCount();
+    srvCPUHandle.Reset(frameCount);
+    srvGPUHandle.Reset(frameCount);
+    renderTargetTexture.Reset(frameCount);
+    depthTexture.Reset(frameCount);
+    rtvHandle.Reset(frameCount);
+    dsvHandle.Reset(frameCount);
+    rtvSlot.Reset(frameCount);
+    dsvSlot.Reset(frameCount);
+    for (UINT i = 0; i < frameCount; i++) {
         //create the color texture
         D3D12_RESOURCE_DESC descForColorTexture = CreateDesc(w, h, DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
         D3D12_CLEAR_VALUE clearValueForColorTexture = {};
@@ -44,26 +41,26 @@ transforms::OffscreenRenderTarget::OffscreenRenderTarget(int w, int h,
         clearValueForColorTexture.Color[2] = 0.0f;
         clearValueForColorTexture.Color[3] = 1.0f;
 
-        HRESULT hr = ctx->GetDevice()->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &descForColorTexture,
+        HRESULT hr = ctx->GetMemoryAllocator()->CreateResource(
+            descForColorTexture,
+            D3D12_HEAP_TYPE_DEFAULT,
             D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             &clearValueForColorTexture,
-            IID_PPV_ARGS(&renderTargetTexture[i]));
+            renderTargetTexture[i]);
+        assert(hr == S_OK);
         //create the depth texture
         D3D12_RESOURCE_DESC depthDesc = CreateDesc(w, h, DXGI_FORMAT_D32_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
         D3D12_CLEAR_VALUE depthClearValue = {};
         depthClearValue.Format = DXGI_FORMAT_D32_FLOAT;
         depthClearValue.DepthStencil.Depth = 1.0f;
         depthClearValue.DepthStencil.Stencil = 0;
-        hr = ctx->GetDevice()->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &depthDesc,
+        hr = ctx->GetMemoryAllocator()->CreateResource(
+            depthDesc,
+            D3D12_HEAP_TYPE_DEFAULT,
             D3D12_RESOURCE_STATE_DEPTH_WRITE,
             &depthClearValue,
-            IID_PPV_ARGS(&depthTexture[i]));
+            depthTexture[i]);
+        assert(hr == S_OK);
         //create the RTV descriptr
         D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
         rtvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -72,8 +69,9 @@ transforms::OffscreenRenderTarget::OffscreenRenderTarget(int w, int h,
         rtvDesc.Texture2D.PlaneSlice = 0;
         
         
-        D3D12_CPU_DESCRIPTOR_HANDLE _rtvHandle = rtvDsvHeap->AllocateRTV();
-        ctx->GetDevice()->CreateRenderTargetView(renderTargetTexture[i], &rtvDesc, _rtvHandle);
+        rtvSlot[i] = rtvDsvHeap->AllocateRTVSlot();
+        D3D12_CPU_DESCRIPTOR_HANDLE _rtvHandle = rtvDsvHeap->GetRTVHandle(rtvSlot[i]);
+        ctx->GetDevice()->CreateRenderTargetView(renderTargetTexture[i].Get(), &rtvDesc, _rtvHandle);
         rtvHandle[i] = _rtvHandle;
 
         //create the DSV descriptor
@@ -82,9 +80,10 @@ transforms::OffscreenRenderTarget::OffscreenRenderTarget(int w, int h,
         dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
         dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
         // Get the handle to the start of the heap.
-        D3D12_CPU_DESCRIPTOR_HANDLE _dsvHandle = rtvDsvHeap->AllocateDSV(); //dsvHeap->GetCPUDescriptorHandleForHeapStart();
+        dsvSlot[i] = rtvDsvHeap->AllocateDSVSlot();
+        D3D12_CPU_DESCRIPTOR_HANDLE _dsvHandle = rtvDsvHeap->GetDSVHandle(dsvSlot[i]); //dsvHeap->GetCPUDescriptorHandleForHeapStart();
         // Offset the handle by the correct number of descriptors.
-        ctx->GetDevice()->CreateDepthStencilView(depthTexture[i], &dsvDesc, _dsvHandle);
+        ctx->GetDevice()->CreateDepthStencilView(depthTexture[i].Get(), &dsvDesc, _dsvHandle);
         dsvHandle[i] = _dsvHandle;
 
         auto [colorCPUSrvDescriptor, colorGPUSrvDescriptor] = descriptorHeap->AllocateDescriptor();
@@ -99,7 +98,7 @@ transforms::OffscreenRenderTarget::OffscreenRenderTarget(int w, int h,
         srvDesc.Texture2D.MostDetailedMip = 0;
         srvDesc.Texture2D.PlaneSlice = 0;
         srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-        ctx->GetDevice()->CreateShaderResourceView(renderTargetTexture[i], &srvDesc, srvCPUHandle[i]);
+        ctx->GetDevice()->CreateShaderResourceView(renderTargetTexture[i].Get(), &srvDesc, srvCPUHandle[i]);
  
         std::wstringstream ssname;
         ssname << "OffsceeenColor" << i;
@@ -108,35 +107,38 @@ transforms::OffscreenRenderTarget::OffscreenRenderTarget(int w, int h,
     }
 }
 
-void transforms::OffscreenRenderTarget::SetAsRenderTarget(ID3D12GraphicsCommandList* commandList, int frameIndex)
+transforms::OffscreenRenderTarget::~OffscreenRenderTarget()
 {
-    commandList->OMSetRenderTargets(
-        1,                                // one render target
-        &rtvHandle[frameIndex],           // from your OffscreenRenderTarget instance
-        FALSE,                            // no RTVs in a descriptor array
-        &dsvHandle[frameIndex]);          // depth stencil
+    for (UINT i = 0; i < rtvSlot.GetFrameCount(); i++) {
+        rtvDsvHeap->FreeRTV(rtvSlot[i]);
+        rtvDsvHeap->FreeDSV(dsvSlot[i]);
+        descriptorHeap->Free(srvCPUHandle[i]);
+    }
+}
+
+void transforms::OffscreenRenderTarget::SetAsRenderTarget(common::gfx::CommandList& commandList, int frameIndex)
+{
+    commandList.SetRenderTarget(
+        common::gfx::ToHandle(rtvHandle[frameIndex]),     // from your OffscreenRenderTarget instance
+        common::gfx::ToHandle(dsvHandle[frameIndex]));    // depth stencil
 }
 
-void transforms::OffscreenRenderTarget::Clear(ID3D12GraphicsCommandList* commandList, int frameIndex, std::array<float, 4> clearColor)
+void transforms::OffscreenRenderTarget::Clear(common::gfx::CommandList& commandList, int frameIndex, std::array<float, 4> clearColor)
 {
-    commandList->ClearRenderTargetView(rtvHandle[frameIndex], clearColor.data(), 0, nullptr);
-    commandList->ClearDepthStencilView(dsvHandle[frameIndex], D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    commandList.ClearRenderTarget(common::gfx::ToHandle(rtvHandle[frameIndex]), clearColor);
+    commandList.ClearDepth(common::gfx::ToHandle(dsvHandle[frameIndex]), 1.0f);
 }
 
-void transforms::OffscreenRenderTarget::TransitionToRenderTarget(ID3D12GraphicsCommandList* commandList, int frameIndex)
+void transforms::OffscreenRenderTarget::TransitionToRenderTarget(common::gfx::CommandList& commandList, int frameIndex)
 {
-    CD3DX12_RESOURCE_BARRIER barrierBack = CD3DX12_RESOURCE_BARRIER::Transition(
-        renderTargetTexture[frameIndex],
-        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-        D3D12_RESOURCE_STATE_RENDER_TARGET);
-    commandList->ResourceBarrier(1, &barrierBack);
+    commandList.ResourceBarrier(common::gfx::ToHandle(renderTargetTexture[frameIndex].Get()),
+        common::gfx::ResourceState::PixelShaderResource,
+        common::gfx::ResourceState::RenderTarget);
 }
 
-void transforms::OffscreenRenderTarget::TransitionToPixelShaderResource(ID3D12GraphicsCommandList* commandList, int frameIndex)
+void transforms::OffscreenRenderTarget::TransitionToPixelShaderResource(common::gfx::CommandList& commandList, int frameIndex)
 {
-    CD3DX12_RESOURCE_BARRIER barrierBack = CD3DX12_RESOURCE_BARRIER::Transition(
-        renderTargetTexture[frameIndex],
-        D3D12_RESOURCE_STATE_RENDER_TARGET,
-        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    commandList->ResourceBarrier(1, &barrierBack);
+    commandList.ResourceBarrier(common::gfx::ToHandle(renderTargetTexture[frameIndex].Get()),
+        common::gfx::ResourceState::RenderTarget,
+        common::gfx::ResourceState::PixelShaderResource);
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include "pch.h"
+#include "../Core/slot_allocator.h"
+#include "../Core/gfx_device.h"
 namespace transforms {
     class Context;
     class SharedDescriptorHeapV2;
@@ -9,21 +11,29 @@ namespace transforms {
     public:
         OffscreenRenderTarget(int w, int h, Context* ctx,
             SharedDescriptorHeapV2* descriptorHeap, RtvDsvDescriptorHeapManager* rtvDsvHeap);
-        void SetAsRenderTarget(ID3D12GraphicsCommandList* commandList, int frameIndex);
-        void Clear(ID3D12GraphicsCommandList* commandList, int frameIndex, std::array<float,4> clearColor);
-        void TransitionToRenderTarget(ID3D12GraphicsCommandList* commandList, int frameIndex);
-        void TransitionToPixelShaderResource(ID3D12GraphicsCommandList* commandList, int frameIndex);
+        /// <summary>
+        /// Gives the descriptors back and releases the textures. The gpu must be done with them.
+        /// </summary>
+        ~OffscreenRenderTarget();
+        void SetAsRenderTarget(common::gfx::CommandList& commandList, int frameIndex);
+        void Clear(common::gfx::CommandList& commandList, int frameIndex, std::array<float,4> clearColor);
+        void TransitionToRenderTarget(common::gfx::CommandList& commandList, int frameIndex);
+        void TransitionToPixelShaderResource(common::gfx::CommandList& commandList, int frameIndex);
         D3D12_GPU_DESCRIPTOR_HANDLE GetSRVHandle(int frameIndex) {
             return srvGPUHandle[frameIndex];
         };
     private:
-        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srvCPUHandle;
-        std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> srvGPUHandle;
+        common::FrameRing<D3D12_CPU_DESCRIPTOR_HANDLE> srvCPUHandle;
+        common::FrameRing<D3D12_GPU_DESCRIPTOR_HANDLE> srvGPUHandle;
 
-        std::vector<ID3D12Resource*> renderTargetTexture;
-        std::vector<ID3D12Resource*> depthTexture;
-        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> rtvHandle;
-        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> dsvHandle;
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> renderTargetTexture;
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> depthTexture;
+        common::FrameRing<D3D12_CPU_DESCRIPTOR_HANDLE> rtvHandle;
+        common::FrameRing<D3D12_CPU_DESCRIPTOR_HANDLE> dsvHandle;
+        common::FrameRing<SlotHandle> rtvSlot;
+        common::FrameRing<SlotHandle> dsvSlot;
+        SharedDescriptorHeapV2* descriptorHeap;
+        RtvDsvDescriptorHeapManager* rtvDsvHeap;
 
     };
 }
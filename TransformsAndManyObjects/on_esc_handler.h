@@ -6,7 +6,16 @@ namespace transforms {
 }
 
 namespace transforms::components {
+    /// <summary>
+    /// Asks to quit when esc is pressed, and closes the window if the answer is yes. A behavior for
+    /// systems::ScriptRunner.
+    /// </summary>
+    struct EscHandler {
+        transforms::Context* ctx = nullptr;
+        transforms::Window* window = nullptr;
+        void Update(float deltaTime, entt::entity self, entt::registry& registry);
+    };
     void CreateEscHandler(entt::registry& gRegistry,
 		transforms::Context* ctx,
 		transforms::Window* gWindow);
-}
\ No newline at end of file
+}
@@ -24,10 +24,13 @@
 #include <filesystem>
 #include <string>
 
-#include "../Common/vertex.h"
-constexpr int FRAMEBUFFER_COUNT = 2;
+#include "../Core/vertex.h"
+#include "../Core/frame_ring.h"
+#include "../Core/point_light_shadow_camera.h"
+//frames in flight (and swap chain buffers) are chosen at startup, in this range
+constexpr int MIN_FRAMES_IN_FLIGHT = 2;
+constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+constexpr int DEFAULT_FRAMES_IN_FLIGHT = 2;
 constexpr int MAX_NUMBER_OF_OBJ = 10000;
 constexpr bool FULLSCREEN = false;
-constexpr int MAX_LIGHTS = 16;
-constexpr int SHADOW_MAP_SIZE = 2048;
 
@@ -1,8 +1,8 @@
 ﻿#pragma once
 #include "pch.h"
-#include "per_object_data.h"
+#include "../Core/per_object_data.h"
 #include "direct3d_context.h"
-#include "../Common/concatenate.h"
+#include "../Core/concatenate.h"
 #include "shared_descriptor_heap_v2.h"
 namespace transforms
 {
@@ -71,13 +71,14 @@ namespace transforms
         {
             //structured buffers do not need alignment to 256 bytes
             bufferSize = sizeof(model_data_t) * maxNumberOfObjs;
-            structuredBuffer.resize(FRAMEBUFFER_COUNT);
-            uploadBuffer.resize(FRAMEBUFFER_COUNT);
-            mappedData.resize(FRAMEBUFFER_COUNT);
-            firstTimeUse.resize(FRAMEBUFFER_COUNT);
-            gpuDescriptorHandle.resize(FRAMEBUFFER_COUNT);
-            cpuDescriptorHandle.resize(FRAMEBUFFER_COUNT);
-            for (UINT i = 0; i < FRAMEBUFFER_COUNT; i++) {
+            const UINT frameCount = ctx.GetFrameCount();
+            structuredBuffer.Reset(frameCount);
+            uploadBuffer.Reset(frameCount);
+            mappedData.Reset(frameCount);
+            firstTimeUse.Reset(frameCount);
+            gpuDescriptorHandle.Reset(frameCount);
+            cpuDescriptorHandle.Reset(frameCount);
+            for (UINT i = 0; i < frameCount; i++) {
                 firstTimeUse[i] = true;
 
                 // 1. Create GPU and upload buffer
@@ -88,19 +89,10 @@ namespace transforms
                 ctx.CreateStagingAndGPUBuffer(bufferSize, _gpuBuffer, _stagingBuffer,
                     _gpuBufferView, name);
 
-                // 2. Create SRV in the shared descriptor heap
-                D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-                srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-                srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-                srvDesc.Buffer.FirstElement = 0;
-                srvDesc.Buffer.NumElements = maxNumberOfObjs;
-                srvDesc.Buffer.StructureByteStride = sizeof(model_data_t);
-                srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-
+                // 2. Create SRV in the shared descriptor heap, at the assigned index
                 auto [cpuHandle, gpuHandle] = sharedDescriptorHeap->AllocateDescriptor();
-                // Create SRV in shared heap at the assigned index
-                ctx.GetDevice()->CreateShaderResourceView(_gpuBuffer.Get(), &srvDesc, cpuHandle);
+                ctx.GetGfxDevice().CreateStructuredBufferView(common::gfx::ToHandle(cpuHandle),
+                    common::gfx::ToHandle(_gpuBuffer.Get()), maxNumberOfObjs, sizeof(model_data_t));
                 cpuDescriptorHandle[i] = cpuHandle;
                 gpuDescriptorHandle[i] = gpuHandle;
                 // 3. Map staging buffer
@@ -148,31 +140,21 @@ namespace transforms
             return srvDescriptorIndex;
         }
 
-        void CopyToGPU(UINT frameIndex, ID3D12GraphicsCommandList* commandList) {
-            assert(commandList);
-            auto* gpuBuffer = structuredBuffer[frameIndex].Get();
-            auto* upload = uploadBuffer[frameIndex].Get();
+        void CopyToGPU(UINT frameIndex, common::gfx::CommandList& commandList) {
+            using common::gfx::ResourceState;
+            const common::gfx::ResourceHandle gpuBuffer = common::gfx::ToHandle(structuredBuffer[frameIndex].Get());
+            const common::gfx::ResourceHandle upload = common::gfx::ToHandle(uploadBuffer[frameIndex].Get());
             if (firstTimeUse[frameIndex] == true) {
                 // COMMON -> COPY_DEST
-                CD3DX12_RESOURCE_BARRIER toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(
-                    gpuBuffer,
-                    D3D12_RESOURCE_STATE_COMMON,
-                    D3D12_RESOURCE_STATE_COPY_DEST
-                );
-                commandList->ResourceBarrier(1, &toCopyDest);
+                commandList.ResourceBarrier(gpuBuffer, ResourceState::Common, ResourceState::CopyDest);
                 firstTimeUse[frameIndex] = false;
             }
             else {
                 // NON_PIXEL_SHADER_RESOURCE -> COPY_DEST
-                CD3DX12_RESOURCE_BARRIER toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(
-                    gpuBuffer,
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_COPY_DEST
-                );
-                commandList->ResourceBarrier(1, &toCopyDest);
+                commandList.ResourceBarrier(gpuBuffer, ResourceState::NonPixelShaderResource, ResourceState::CopyDest);
             }
             // Copy from staging to GPU buffer
-            commandList->CopyBufferRegion(
+            commandList.CopyBufferRegion(
                 gpuBuffer,
                 0,
                 upload,
@@ -181,12 +163,7 @@ namespace transforms
             );
 
             // COPY_DEST -> NON_PIXEL_SHADER_RESOURCE (for SRV usage in shader)
-            CD3DX12_RESOURCE_BARRIER toShaderRead = CD3DX12_RESOURCE_BARRIER::Transition(
-                gpuBuffer,
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
-            );
-            commandList->ResourceBarrier(1, &toShaderRead);
+            commandList.ResourceBarrier(gpuBuffer, ResourceState::CopyDest, ResourceState::NonPixelShaderResource);
         }
 
         void SetValue(UINT frameIndex, UINT id, const model_data_t& data) {
@@ -197,13 +174,13 @@ namespace transforms
         }
 
     private:
-        std::vector<bool> firstTimeUse;
+        common::FrameRing<bool> firstTimeUse;
         UINT64 bufferSize;
-        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> structuredBuffer;
-        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> uploadBuffer;
-        std::vector<void*> mappedData;
-        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> cpuDescriptorHandle;
-        std::vector< D3D12_GPU_DESCRIPTOR_HANDLE> gpuDescriptorHandle;
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> structuredBuffer;
+        common::FrameRing<Microsoft::WRL::ComPtr<ID3D12Resource>> uploadBuffer;
+        common::FrameRing<void*> mappedData;
+        common::FrameRing<D3D12_CPU_DESCRIPTOR_HANDLE> cpuDescriptorHandle;
+        common::FrameRing<D3D12_GPU_DESCRIPTOR_HANDLE> gpuDescriptorHandle;
         // Reference to shared descriptor heap and our assigned index
         SharedDescriptorHeapV2* sharedDescriptorHeap;
         UINT srvDescriptorIndex;
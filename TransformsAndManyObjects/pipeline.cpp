@@ -110,11 +110,16 @@ void transforms::Pipeline::DrawInstanced(Microsoft::WRL::ComPtr<ID3D12GraphicsCo
 
 void transforms::Pipeline::Bind(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList)
 {
-    commandList->SetPipelineState(mPipeline.Get());
-    commandList->RSSetViewports(1, &viewport);
-    commandList->RSSetScissorRects(1, &scissorRect);
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    common::gfx::D3D12CommandList list(commandList.Get());
+    Bind(list);
+}
 
+void transforms::Pipeline::Bind(common::gfx::CommandList& commandList)
+{
+    commandList.SetPipelineState(common::gfx::ToHandle(mPipeline.Get()));
+    commandList.SetViewport(common::gfx::ToViewport(viewport));
+    commandList.SetScissorRect(common::gfx::ToRect(scissorRect));
+    commandList.SetPrimitiveTopology(common::gfx::PrimitiveTopology::TriangleList);
 }
 
 void SetViewportAndScissors(std::shared_ptr<transforms::Pipeline> pipeline, uint32_t W, uint32_t H)
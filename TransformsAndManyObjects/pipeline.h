@@ -1,5 +1,6 @@
 #pragma once
 #include "pch.h"
+#include "../Core/gfx_device.h"
 //using Microsoft::WRL::ComPtr;
 
 
@@ -39,6 +40,7 @@ namespace transforms
 			int numberOfIndices);
 
 		void Bind(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList);
+		void Bind(common::gfx::CommandList& commandList);
 
 	private:
 		Microsoft::WRL::ComPtr<ID3D12PipelineState> mPipeline;
@@ -2,77 +2,79 @@
 #include "pch.h"
 #include "cube_map_shadow_map.h"
 #include "per_object_uniform_buffer.h"
-#include "components.h"
+#include "../Core/components.h"
+#include "../Core/point_shadow_draw.h"
 namespace transforms {
     namespace _PointShadowCalculationSystem {
-        inline void BeginCubeMapEvent(UINT i,
-            ID3D12GraphicsCommandList* commandList)
-        {
-            std::wstring label = L"";
-            switch (i) {
-            case 0:
-                commandList->BeginEvent(0, L"+X", sizeof(L"+X"));
-                break;
-            case 1:
-                commandList->BeginEvent(0, L"-X", sizeof(L"-X"));
-                break;
-            case 2:
-                commandList->BeginEvent(0, L"+Y", sizeof(L"+Y"));
-                break;
-            case 3:
-                commandList->BeginEvent(0, L"-Y", sizeof(L"-Y"));
-                break;
-            case 4:
-                commandList->BeginEvent(0, L"+Z", sizeof(L"+Z"));
-                break;
-            case 5:
-                commandList->BeginEvent(0, L"-Z", sizeof(L"-Z"));
-                break;
-            }
-        }
         inline void Clear(std::shared_ptr<transforms::CubeMapShadowMap> sm,
-            ID3D12GraphicsCommandList* commandList, int i) {
+            common::gfx::CommandList& commandList, int i) {
             sm->SetAsRenderTarget(commandList, i);
             sm->Clear(commandList, i, { 1.f,1.f,1.f,1.f });
         }
-
-        inline void SetViewport(ID3D12GraphicsCommandList* commandList) {
-            D3D12_VIEWPORT viewport = {};
-            viewport.Width = static_cast<float>(SHADOW_MAP_SIZE);
-            viewport.Height = static_cast<float>(SHADOW_MAP_SIZE);
-            viewport.MinDepth = 0.0f;
-            viewport.MaxDepth = 1.0f;
-            commandList->RSSetViewports(1, &viewport);
-            D3D12_RECT scissorRect = {};
-            scissorRect.left = 0;
-            scissorRect.top = 0;
-            scissorRect.right = static_cast<float>(SHADOW_MAP_SIZE);
-            scissorRect.bottom = static_cast<float>(SHADOW_MAP_SIZE);
-            commandList->RSSetScissorRects(1, &scissorRect);
-        }
     }
     template<typename RenderablesView>
     void DrawRenderablesForPointLightShadowMapSystem(
         RenderablesView&& renderables, 
-        ID3D12GraphicsCommandList* commandList, 
+        common::gfx::CommandList& commandList, 
         UINT& shadowDataId) {
         renderables.each([&commandList, &shadowDataId](entt::entity entity, const transforms::components::Renderable& renderable, const transforms::components::Transform& transform, const std::shared_ptr<transforms::components::BSDFMaterial> material)
             {
-                commandList->IASetVertexBuffers(0, 1, &renderable.mVertexBufferView);
-                commandList->IASetIndexBuffer(&renderable.mIndexBufferView);
-                commandList->SetGraphicsRoot32BitConstant(0, renderable.uniformBufferId, 0);
-                commandList->SetGraphicsRoot32BitConstant(1, shadowDataId, 0);
-                commandList->DrawIndexedInstanced(renderable.mNumberOfIndices, 1, 0, 0, 0);
+                _PointShadowCalculationSystem::DrawForShadow(renderable, commandList, shadowDataId);
             });
     }
 
+    /// <summary>
+    /// The state every list that draws shadow faces needs. Lists recorded in parallel don't inherit it.
+    /// </summary>
+    inline void BeginPointShadowPass(common::gfx::CommandList& commandList,
+        ID3D12RootSignature* rootSignature,
+        ID3D12PipelineState* shadowPipeline,
+        transforms::SharedDescriptorHeapV2* gSharedDescriptors)
+    {
+        commandList.SetGraphicsRootSignature(common::gfx::ToHandle(rootSignature));
+        commandList.SetDescriptorHeap(common::gfx::ToHandle(gSharedDescriptors->GetHeap()));
+        commandList.SetPrimitiveTopology(common::gfx::PrimitiveTopology::TriangleList);
+        commandList.SetPipelineState(common::gfx::ToHandle(shadowPipeline));
+    }
+
+    /// <summary>
+    /// Renders one face of a cube shadow map. The faces don't depend on each other, so they can be
+    /// recorded in different lists at the same time. The map must already be a render target.
+    /// shadowDataId is the index of the face's data in the point shadow buffer.
+    /// </summary>
+    inline void RecordPointShadowFace(transforms::CubeMapShadowMap* sm,
+        int face,
+        UINT shadowDataId,
+        const std::vector<const transforms::components::Renderable*>& drawList,
+        UINT frameIndex,
+        common::gfx::CommandList& commandList,
+        transforms::UniformBufferForSRVs<transforms::PerObjectData>* gPerObjectUniformBuffer,
+        transforms::UniformBufferForSRVs<transforms::ShadowMapConstants>* gPointShadowUniformBuffer)
+    {
+        using namespace _PointShadowCalculationSystem;
+        BeginCubeMapEvent(face, commandList);
+        sm->SetAsRenderTarget(commandList, face);
+        sm->Clear(commandList, face, { 1.f,1.f,1.f,1.f });
+        //bind per-object srv at t0
+        commandList.SetGraphicsRootDescriptorTable(2,
+            common::gfx::ToHandle(gPerObjectUniformBuffer->GetGPUHandle(frameIndex)));
+        //bind shadow data srv at t1
+        commandList.SetGraphicsRootDescriptorTable(3,
+            common::gfx::ToHandle(gPointShadowUniformBuffer->GetGPUHandle(frameIndex)));
+        SetViewport(commandList);
+        for (const transforms::components::Renderable* renderable : drawList) {
+            DrawForShadow(*renderable, commandList, shadowDataId);
+        }
+        commandList.EndEvent();
+    }
+
     template<typename ShadowProjectorsView, typename RenderablesView>
     void PointShadowMapCalculationSystem(
         ShadowProjectorsView&& shadowProjectors,
         RenderablesView&& renderables,
         UINT frameIndex, 
         ID3D12RootSignature* rootSignature,
-        ID3D12GraphicsCommandList* commandList,
+        common::gfx::CommandList& commandList,
         ID3D12PipelineState* shadowPipeline,
         transforms::SharedDescriptorHeapV2* gSharedDescriptors,
         transforms::UniformBufferForSRVs<transforms::PerObjectData>* gPerObjectUniformBuffer,
@@ -82,11 +84,7 @@ namespace transforms {
         using namespace DirectX;
         using namespace _PointShadowCalculationSystem;
         UINT shadowDataId = 0;
-        commandList->SetGraphicsRootSignature(rootSignature);
-        ID3D12DescriptorHeap* heaps[] = { gSharedDescriptors->GetHeap() };
-        commandList->SetDescriptorHeaps(_countof(heaps), heaps);
-        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        commandList->SetPipelineState(shadowPipeline);
+        BeginPointShadowPass(commandList, rootSignature, shadowPipeline, gSharedDescriptors);
 
         shadowProjectors.each(
             [&commandList, frameIndex, &rootSignature, &renderables, &shadowDataId, &gPerObjectUniformBuffer,
@@ -101,14 +99,14 @@ namespace transforms {
 
                     Clear(sm, commandList, i);
                     //bind per-object srv at t0
-                    commandList->SetGraphicsRootDescriptorTable(2,
-                        gPerObjectUniformBuffer->GetGPUHandle(frameIndex));
+                    commandList.SetGraphicsRootDescriptorTable(2,
+                        common::gfx::ToHandle(gPerObjectUniformBuffer->GetGPUHandle(frameIndex)));
                     //bind shadow data srv at t1
-                    commandList->SetGraphicsRootDescriptorTable(3,
-                        gPointShadowUniformBuffer->GetGPUHandle(frameIndex));
+                    commandList.SetGraphicsRootDescriptorTable(3,
+                        common::gfx::ToHandle(gPointShadowUniformBuffer->GetGPUHandle(frameIndex)));
                     SetViewport(commandList);
                     DrawRenderablesForPointLightShadowMapSystem(renderables, commandList, shadowDataId);
-                    commandList->EndEvent();
+                    commandList.EndEvent();
                     shadowDataId++;
                 }
                 sm->TransitionToPixelShaderResource(commandList, 0);
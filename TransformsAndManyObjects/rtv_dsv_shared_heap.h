@@ -1,122 +1,147 @@
 #pragma once
 #include <d3d12.h>
 #include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "../Core/slot_allocator.h"
 
 using Microsoft::WRL::ComPtr;
 namespace transforms {
+    /// <summary>
+    /// Owns the cpu-only RTV and DSV heaps. Descriptors are given as generational slot handles and can
+    /// be freed, so render targets can be created and destroyed at runtime. When a heap fills up
+    /// another heap of the same size is created, up to maxHeapsPerType.
+    /// </summary>
     class RtvDsvDescriptorHeapManager
     {
     private:
-        ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
-        ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
-
-        UINT m_rtvDescriptorSize;
-        UINT m_dsvDescriptorSize;
-
-        UINT m_rtvCount;
-        UINT m_dsvCount;
-        UINT m_rtvUsed;
-        UINT m_dsvUsed;
+        /// <summary>
+        /// Slots + the heaps backing them, one heap per slot allocator block.
+        /// </summary>
+        struct Pool {
+            D3D12_DESCRIPTOR_HEAP_TYPE type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+            UINT descriptorSize = 0;
+            std::unique_ptr<SlotAllocator> slots;
+            std::vector<ComPtr<ID3D12DescriptorHeap>> heaps;
+
+            bool AddHeap(ID3D12Device* device)
+            {
+                D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+                desc.Type = type;
+                desc.NumDescriptors = slots->GetSlotsPerBlock();
+                desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+                ComPtr<ID3D12DescriptorHeap> heap;
+                if (FAILED(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap))))
+                    return false;
+                heaps.push_back(heap);
+                return true;
+            }
+
+            bool Initialize(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE _type, UINT count, UINT maxHeaps)
+            {
+                type = _type;
+                slots = std::make_unique<SlotAllocator>(count, maxHeaps);
+                heaps.clear();
+                descriptorSize = device->GetDescriptorHandleIncrementSize(type);
+                return AddHeap(device);
+            }
+
+            SlotHandle Allocate(ID3D12Device* device)
+            {
+                SlotHandle handle = slots->Allocate();
+                //the slot allocator opened a new block, back it with a new heap
+                if (handle.IsValid() && slots->GetBlockCount() > heaps.size()) {
+                    if (!AddHeap(device)) {
+                        slots->Free(handle);
+                        return {};
+                    }
+                }
+                return handle;
+            }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE HandleAt(UINT index) const
+            {
+                const UINT block = index / slots->GetSlotsPerBlock();
+                if (block >= heaps.size())
+                    return {};
+                D3D12_CPU_DESCRIPTOR_HANDLE handle = heaps[block]->GetCPUDescriptorHandleForHeapStart();
+                handle.ptr += (index % slots->GetSlotsPerBlock()) * descriptorSize;
+                return handle;
+            }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE HandleOf(const SlotHandle& slot) const
+            {
+                if (!slots->IsAlive(slot))
+                    return {};
+                return HandleAt(slot.index);
+            }
+        };
+
+        ID3D12Device* m_device;
+        Pool m_rtv;
+        Pool m_dsv;
 
     public:
         RtvDsvDescriptorHeapManager() :
-            m_rtvDescriptorSize(0),
-            m_dsvDescriptorSize(0),
-            m_rtvCount(0),
-            m_dsvCount(0),
-            m_rtvUsed(0),
-            m_dsvUsed(0) {}
-
-        // Initialize the heaps
-        bool Initialize(ID3D12Device* device, UINT rtvCount = 256, UINT dsvCount = 64)
-        {
-            // Create RTV heap
-            D3D12_DESCRIPTOR_HEAP_DESC rtvDesc = {};
-            rtvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-            rtvDesc.NumDescriptors = rtvCount;
-            rtvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+            m_device(nullptr) {}
 
-            if (FAILED(device->CreateDescriptorHeap(&rtvDesc, IID_PPV_ARGS(&m_rtvHeap))))
+        // Initialize the heaps. rtvCount and dsvCount are the size of each heap.
+        bool Initialize(ID3D12Device* device, UINT rtvCount = 256, UINT dsvCount = 64, UINT maxHeapsPerType = 4)
+        {
+            m_device = device;
+            if (!m_rtv.Initialize(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, rtvCount, maxHeapsPerType))
                 return false;
-
-            // Create DSV heap
-            D3D12_DESCRIPTOR_HEAP_DESC dsvDesc = {};
-            dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-            dsvDesc.NumDescriptors = dsvCount;
-            dsvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-
-            if (FAILED(device->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&m_dsvHeap))))
+            if (!m_dsv.Initialize(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, dsvCount, maxHeapsPerType))
                 return false;
+            return true;
+        }
 
-            // Get descriptor sizes
-            m_rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-            m_dsvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+        // Get the first heap of each type. More heaps exist only if the first one overflowed.
+        ID3D12DescriptorHeap* GetRTVHeap() const { return m_rtv.heaps[0].Get(); }
+        ID3D12DescriptorHeap* GetDSVHeap() const { return m_dsv.heaps[0].Get(); }
 
-            m_rtvCount = rtvCount;
-            m_dsvCount = dsvCount;
+        // Allocate descriptors. Invalid handle when out of space.
+        SlotHandle AllocateRTVSlot() { return m_rtv.Allocate(m_device); }
+        SlotHandle AllocateDSVSlot() { return m_dsv.Allocate(m_device); }
 
-            return true;
-        }
+        // Return descriptors to the free list. False if the handle was stale.
+        bool FreeRTV(const SlotHandle& slot) { return m_rtv.slots->Free(slot); }
+        bool FreeDSV(const SlotHandle& slot) { return m_dsv.slots->Free(slot); }
 
-        // Get heap pointers for sharing
-        ID3D12DescriptorHeap* GetRTVHeap() const { return m_rtvHeap.Get(); }
-        ID3D12DescriptorHeap* GetDSVHeap() const { return m_dsvHeap.Get(); }
+        // Resolve slot handles, a zero handle if it is stale.
+        D3D12_CPU_DESCRIPTOR_HANDLE GetRTVHandle(const SlotHandle& slot) const { return m_rtv.HandleOf(slot); }
+        D3D12_CPU_DESCRIPTOR_HANDLE GetDSVHandle(const SlotHandle& slot) const { return m_dsv.HandleOf(slot); }
 
-        // Allocate descriptors
+        // Allocate descriptors that are never given back.
         D3D12_CPU_DESCRIPTOR_HANDLE AllocateRTV()
         {
-            if (m_rtvUsed >= m_rtvCount)
-                return {}; // Invalid handle
-
-            D3D12_CPU_DESCRIPTOR_HANDLE handle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-            handle.ptr += m_rtvUsed * m_rtvDescriptorSize;
-            m_rtvUsed++;
-            return handle;
+            return GetRTVHandle(AllocateRTVSlot());
         }
 
         D3D12_CPU_DESCRIPTOR_HANDLE AllocateDSV()
         {
-            if (m_dsvUsed >= m_dsvCount)
-                return {}; // Invalid handle
-
-            D3D12_CPU_DESCRIPTOR_HANDLE handle = m_dsvHeap->GetCPUDescriptorHandleForHeapStart();
-            handle.ptr += m_dsvUsed * m_dsvDescriptorSize;
-            m_dsvUsed++;
-            return handle;
+            return GetDSVHandle(AllocateDSVSlot());
         }
 
         // Get handles at specific indices
-        D3D12_CPU_DESCRIPTOR_HANDLE GetRTVHandle(UINT index) const
-        {
-            if (index >= m_rtvCount)
-                return {};
-
-            D3D12_CPU_DESCRIPTOR_HANDLE handle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-            handle.ptr += index * m_rtvDescriptorSize;
-            return handle;
-        }
-
-        D3D12_CPU_DESCRIPTOR_HANDLE GetDSVHandle(UINT index) const
-        {
-            if (index >= m_dsvCount)
-                return {};
-
-            D3D12_CPU_DESCRIPTOR_HANDLE handle = m_dsvHeap->GetCPUDescriptorHandleForHeapStart();
-            handle.ptr += index * m_dsvDescriptorSize;
-            return handle;
-        }
+        D3D12_CPU_DESCRIPTOR_HANDLE GetRTVHandle(UINT index) const { return m_rtv.HandleAt(index); }
+        D3D12_CPU_DESCRIPTOR_HANDLE GetDSVHandle(UINT index) const { return m_dsv.HandleAt(index); }
 
-        // Reset allocation counters (doesn't clear the descriptors)
+        // Free everything, every slot handle becomes stale (doesn't clear the descriptors)
         void Reset()
         {
-            m_rtvUsed = 0;
-            m_dsvUsed = 0;
+            m_rtv.slots->Reset();
+            m_dsv.slots->Reset();
         }
 
         // Get usage info
-        UINT GetRTVUsed() const { return m_rtvUsed; }
-        UINT GetDSVUsed() const { return m_dsvUsed; }
-        UINT GetRTVCapacity() const { return m_rtvCount; }
-        UINT GetDSVCapacity() const { return m_dsvCount; }
+        UINT GetRTVUsed() const { return m_rtv.slots->GetUsed(); }
+        UINT GetDSVUsed() const { return m_dsv.slots->GetUsed(); }
+        UINT GetRTVCapacity() const { return m_rtv.slots->GetCapacity(); }
+        UINT GetDSVCapacity() const { return m_dsv.slots->GetCapacity(); }
+        UINT GetRTVHighWaterMark() const { return m_rtv.slots->GetHighWaterMark(); }
+        UINT GetDSVHighWaterMark() const { return m_dsv.slots->GetHighWaterMark(); }
+        UINT GetRTVHeapCount() const { return static_cast<UINT>(m_rtv.heaps.size()); }
+        UINT GetDSVHeapCount() const { return static_cast<UINT>(m_dsv.heaps.size()); }
     };
-}
\ No newline at end of file
+}
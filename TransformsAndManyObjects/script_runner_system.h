@@ -1,5 +0,0 @@
-#pragma once
-#include <entt/entt.hpp>
-namespace transforms::systems {
-    void RunScripts(entt::registry& gRegistry,const float deltaTime);
-}
\ No newline at end of file
@@ -1,23 +1,32 @@
 #include "shared_descriptor_heap_v2.h"
 
-transforms::SharedDescriptorHeapV2::SharedDescriptorHeapV2(ID3D12Device* device, 
-    UINT numDescriptors):currentCapacity(numDescriptors), device(device)
+namespace {
+    constexpr UINT DESCRIPTORS_PER_PAGE = 256;
+    constexpr UINT SHADOW_MAP_DESCRIPTOR_COUNT = MAX_LIGHTS * 6;
+}
+
+transforms::SharedDescriptorHeapV2::SharedDescriptorHeapV2(ID3D12Device* device,
+    UINT numDescriptors, UINT frameCount, UINT transientPerFrame):
+    //there are some SRVs that have to be pre-allocated, like the ones for shadow maps, they are the reserved region.
+    allocator(SHADOW_MAP_DESCRIPTOR_COUNT, DESCRIPTORS_PER_PAGE,
+        (numDescriptors + DESCRIPTORS_PER_PAGE - 1) / DESCRIPTORS_PER_PAGE,
+        transientPerFrame, frameCount),
+    device(device)
 {
-    // Create GPU-visible heap
+    // Create GPU-visible heap, big enough for every region, it'll never be resized
     D3D12_DESCRIPTOR_HEAP_DESC desc = {};
     desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    desc.NumDescriptors = numDescriptors;
+    desc.NumDescriptors = allocator.GetCapacity();
     desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap));
+    HRESULT hr = device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap));
+    assert(hr == S_OK);
 
     // Get starting handles and size
     cpuStart = heap->GetCPUDescriptorHandleForHeapStart();
     gpuStart = heap->GetGPUDescriptorHandleForHeapStart();
     descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    nextFreeIndex = 0;
 
-    //there are some SRVs that have to be pre-allocated, like the ones for shadow maps.
-    shadowMapDescriptorRangeStart = AllocateDescriptorRange(MAX_LIGHTS * 6);
+    shadowMapDescriptorRangeStart = HandlesAt(0);
 }
 
 std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::SharedDescriptorHeapV2::DescriptorForShadowMap(UINT idx)
@@ -35,68 +44,53 @@ std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::
 
 std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::SharedDescriptorHeapV2::AllocateDescriptor()
 {
-    // Check if we need to expand
-    if (nextFreeIndex >= currentCapacity) {
-        ExpandPool();
-    }
-
-    UINT index = nextFreeIndex++;
+    return HandlesAt(allocator.Allocate().index);
+}
 
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = cpuStart;
-    cpuHandle.ptr += (index * descriptorSize);
+std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::SharedDescriptorHeapV2::AllocateDescriptorRange(UINT count)
+{
+    return HandlesAt(allocator.AllocateRange(count).index);
+}
 
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = gpuStart;
-    gpuHandle.ptr += (index * descriptorSize);
+void transforms::SharedDescriptorHeapV2::Free(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+{
+    assert(cpuHandle.ptr >= cpuStart.ptr);
+    UINT index = static_cast<UINT>((cpuHandle.ptr - cpuStart.ptr) / descriptorSize);
+    DescriptorHandle handle = allocator.HandleAt(index);
+    if (!handle.IsValid()) {
+        throw std::runtime_error("Freeing a descriptor that isn't allocated");
+    }
+    allocator.Free(handle);
+}
 
-    return { cpuHandle, gpuHandle };
+D3D12_CPU_DESCRIPTOR_HANDLE transforms::SharedDescriptorHeapV2::GetCPUHandle(const DescriptorHandle& handle) const
+{
+    if (!allocator.IsAlive(handle)) {
+        throw std::runtime_error("Stale descriptor handle");
+    }
+    return HandlesAt(handle.index).first;
 }
 
-std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::SharedDescriptorHeapV2::AllocateDescriptorRange(UINT count)
+D3D12_GPU_DESCRIPTOR_HANDLE transforms::SharedDescriptorHeapV2::GetGPUHandle(const DescriptorHandle& handle) const
 {
-    if (nextFreeIndex + count > currentCapacity) {
-        ExpandPool();  // You might want to make ExpandPool smarter for large count
+    if (!allocator.IsAlive(handle)) {
+        throw std::runtime_error("Stale descriptor handle");
     }
+    return HandlesAt(handle.index).second;
+}
 
-    UINT index = nextFreeIndex;
-    nextFreeIndex += count;
+std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::SharedDescriptorHeapV2::AllocateTransient(UINT count)
+{
+    return HandlesAt(allocator.AllocateTransient(count));
+}
 
+std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> transforms::SharedDescriptorHeapV2::HandlesAt(UINT index) const
+{
     D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = cpuStart;
-    cpuHandle.ptr += (index * descriptorSize);
+    cpuHandle.ptr += (static_cast<SIZE_T>(index) * descriptorSize);
 
     D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = gpuStart;
-    gpuHandle.ptr += (index * descriptorSize);
+    gpuHandle.ptr += (static_cast<UINT64>(index) * descriptorSize);
 
     return { cpuHandle, gpuHandle };
 }
-
-void transforms::SharedDescriptorHeapV2::ExpandPool()
-{
-    UINT newCapacity = currentCapacity * 2; // Double the size
-
-    // Create new larger heap
-    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-    desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    desc.NumDescriptors = newCapacity;
-    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-
-    ID3D12DescriptorHeap* newHeap;
-    device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&newHeap));
-
-    // Copy existing descriptors to new heap
-    D3D12_CPU_DESCRIPTOR_HANDLE oldCpuStart = heap->GetCPUDescriptorHandleForHeapStart();
-    D3D12_CPU_DESCRIPTOR_HANDLE newCpuStart = newHeap->GetCPUDescriptorHandleForHeapStart();
-
-    device->CopyDescriptorsSimple(
-        nextFreeIndex,  // Copy all used descriptors
-        newCpuStart,
-        oldCpuStart,
-        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
-    );
-
-    // Update to use new heap
-    heap->Release();
-    heap = newHeap;
-    cpuStart = newCpuStart;
-    gpuStart = newHeap->GetGPUDescriptorHandleForHeapStart();
-    currentCapacity = newCapacity;
-}
@@ -1,35 +1,64 @@
 #pragma once
 #include "pch.h"
+#include "../Core/descriptor_allocator.h"
 
 namespace transforms {
     /// <summary>
     /// A shared heap, for shader visible resources. I need this because commandList->SetDescriptorHeaps
     /// demands that all shader resource views come from the same heap.
+    /// The heap is created once with its final size and never rebuilt, so the gpu handles it gives
+    /// out stay valid for its whole life. The bookkeeping is done by DescriptorAllocator.
     /// </summary>
     class SharedDescriptorHeapV2
     {
     public:
-        SharedDescriptorHeapV2(ID3D12Device* device, UINT numDescriptors);
+        /// <summary>
+        /// numDescriptors is the persistent capacity, rounded up to whole pages. On top of it the heap
+        /// has the shadow map range and transientPerFrame descriptors for each of the frameCount frames in flight.
+        /// </summary>
+        SharedDescriptorHeapV2(ID3D12Device* device, UINT numDescriptors, UINT frameCount, UINT transientPerFrame = 256);
         std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> GetShadowMapDescriptorRangeStart() const {
             return shadowMapDescriptorRangeStart;
         }
         std::pair< D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> DescriptorForShadowMap(UINT idx);
         std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> AllocateDescriptor();
         std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> AllocateDescriptorRange(UINT count);
+        /// <summary>
+        /// Same as AllocateDescriptor but returns the stable handle, that's what you need to free it later.
+        /// </summary>
+        DescriptorHandle Allocate() { return allocator.Allocate(); }
+        DescriptorHandle AllocateRange(UINT count) { return allocator.AllocateRange(count); }
+        void Free(const DescriptorHandle& handle) { allocator.Free(handle); }
+        /// <summary>
+        /// Frees the allocation that starts at cpuHandle. For code that only kept the d3d handles, like imgui.
+        /// </summary>
+        void Free(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle);
+        bool IsAlive(const DescriptorHandle& handle) const { return allocator.IsAlive(handle); }
+        D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(const DescriptorHandle& handle) const;
+        D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(const DescriptorHandle& handle) const;
+        /// <summary>
+        /// Rewinds the transient region of frameIndex. Call after the frame fence was waited on.
+        /// </summary>
+        void BeginFrame(UINT frameIndex) { allocator.BeginFrame(frameIndex); }
+        /// <summary>
+        /// count contiguous descriptors that live until this frame index comes around again. Meant
+        /// for descriptor tables that are built every frame.
+        /// </summary>
+        std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> AllocateTransient(UINT count);
+        const DescriptorAllocator& GetAllocator() const { return allocator; }
         const UINT GetDescriptorSize()const { return descriptorSize; }
         ID3D12DescriptorHeap* GetHeap() {
             return heap;
         }
     private:
-        void ExpandPool();
+        std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> HandlesAt(UINT index) const;
+        DescriptorAllocator allocator;
         std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> shadowMapDescriptorRangeStart;
         ID3D12DescriptorHeap* heap;
         ID3D12Device* device;
         D3D12_CPU_DESCRIPTOR_HANDLE cpuStart;
         D3D12_GPU_DESCRIPTOR_HANDLE gpuStart;
         UINT descriptorSize;
-        UINT currentCapacity;
-        UINT nextFreeIndex;
     };
-}   
+}
 